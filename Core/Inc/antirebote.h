@@ -4,6 +4,9 @@
  * @defgroup ANTIREBOTE Módulo Antirebote
  * @{
  * @details Este módulo implementa una función genérica de antirebote para cualquier pin GPIO.
+ * Ninguna función espera: el tiempo entra como ahora_ms (HAL_GetTick() en el
+ * micro, el reloj virtual del HAL simulado en la PC) y el cambio se confirma
+ * en la llamada en que ya pasó el tiempo de filtrado.
  * @author demianmozo
  * @date 2025-06-08
  * @version 1.0
@@ -16,13 +19,46 @@
 #include <stdbool.h>
 
 #define TREBOTES 50 ///< Tiempo de filtrado antirebote en milisegundos
+#define TREBOTES_SENSOR 20 ///< Tiempo que un sensor tiene que sostener una lectura nueva para darla por válida (ms)
+
+/**
+ * @brief Estado del antirebote no bloqueante de un sensor
+ */
+typedef struct
+{
+    GPIO_PinState estable; ///< Última lectura confirmada
+    uint32_t inicio;       ///< Tiempo en que apareció la lectura sin confirmar
+    bool esperando;        ///< true mientras haya una lectura nueva sin confirmar
+} antirebote_sensor_t;
+
+/** @brief Valor inicial de un antirebote_sensor_t (sensores activos en bajo) */
+#define ANTIREBOTE_SENSOR_INIT {GPIO_PIN_SET, 0, false}
 
 /**
  * @brief Función genérica de antirebote para cualquier pin GPIO
  * @param puerto Puntero al puerto GPIO (ej: GPIOA, GPIOB, etc.)
  * @param pin Máscara del pin GPIO (ej: GPIO_PIN_0, GPIO_PIN_1, etc.)
- * @return true si se detectó una pulsación válida (transición HIGH→LOW), false en caso contrario
+ * @param ahora_ms Tiempo actual en milisegundos (HAL_GetTick())
+ * @return true si en esta llamada se confirmó una pulsación (transición HIGH→LOW
+ *         sostenida TREBOTES ms), false en caso contrario
+ * @note Llamar seguido (en cada vuelta del bucle): la confirmación llega en la
+ *       primera llamada después de TREBOTES ms
+ */
+bool antirebote(GPIO_TypeDef *puerto, uint16_t pin, uint32_t ahora_ms);
+
+/**
+ * @brief Antirebote sin espera para sensores que se leen en cada vuelta del bucle
+ * @param sensor Estado del antirebote de ese sensor
+ * @param lectura Lectura actual del pin
+ * @param ahora_ms Tiempo actual en milisegundos (HAL_GetTick())
+ * @return true si en esta llamada se confirmó un paso a GPIO_PIN_RESET (detección)
+ */
+bool antirebote_sensor(antirebote_sensor_t *sensor, GPIO_PinState lectura, uint32_t ahora_ms);
+
+/**
+ * @brief Olvida la última lectura confirmada de un sensor
+ * @details La próxima detección vuelve a necesitar TREBOTES_SENSOR ms de lectura estable
  */
-bool antirebote(GPIO_TypeDef *puerto, uint16_t pin);
+void antirebote_sensor_reiniciar(antirebote_sensor_t *sensor);
 
 #endif /* __ANTIREBOTE_H */
\ No newline at end of file
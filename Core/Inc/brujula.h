@@ -0,0 +1,21 @@
+/**
+ * @file brujula.h
+ * @brief Orientaciones del robot en el laberinto
+ * @author demianmozo
+ *
+ * Está aparte de control_motor.h para que laberinto y navegacion se puedan
+ * compilar sin el HAL (por ejemplo en la PC); control_motor.h lo incluye.
+ */
+
+#ifndef __BRUJULA_H
+#define __BRUJULA_H
+
+typedef enum // enumeracion para variable de brujula
+{
+    norte = 0,
+    este,
+    sur,
+    oeste
+} brujula;
+
+#endif /* __BRUJULA_H */
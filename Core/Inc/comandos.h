@@ -0,0 +1,64 @@
+/**
+ * @file comandos.h
+ * @brief Intérprete de comandos por UART5 para ajustar el robot entre corridas
+ * @author demianmozo
+ *
+ * Los comandos son líneas de texto terminadas en '\n' (o "\r\n"):
+ *
+ * | Comando                   | Respuesta                          |
+ * |---------------------------|------------------------------------|
+ * | get                       | "nombre=valor" de cada parámetro   |
+ * | get <nombre>              | "nombre=valor"                     |
+ * | set <nombre> <valor>      | "ok" o "error ..."                 |
+ * | laberinto                 | una línea "m" por fila y "ok"      |
+ * | m <fila> <muros>          | "ok"; carga los muros de una fila  |
+ * | volcar                    | tramas de registro_volcar()        |
+ * | control                   | mediciones del lazo de TIM6        |
+ * | odo                       | pulsos, distancia y rumbo medidos  |
+ * | guardar                   | "ok"; mapa y ajustes a la flash    |
+ * | borrar                    | "ok"; el próximo arranque calibra  |
+ * | pos                       | "ok"; vuelve al inicio, detenido   |
+ * | sprint                    | "ok"; igual que el botón I AM SPEED|
+ *
+ * En "m", muros tiene un dígito hexadecimal por columna con un bit por
+ * dirección (DIRECCION_BIT() de laberinto.h: norte 1, este 2, sur 4, oeste 8).
+ * Lo que imprime "laberinto" se puede volver a mandar tal cual para cargar
+ * el mapa en otro arranque.
+ *
+ * "m", "guardar", "borrar", "pos" y "sprint" solo se aceptan con el robot
+ * quieto (corrida terminada y sin giro ni avance en curso); en marcha
+ * responden "error ocupado". En marcha tampoco se espera lugar en la cola de
+ * transmisión: una respuesta que no entra se descarta.
+ */
+
+#ifndef __COMANDOS_H
+#define __COMANDOS_H
+
+#include <stdint.h>
+
+#ifndef LARGO_LINEA_COMANDO
+#define LARGO_LINEA_COMANDO 48 ///< Caracteres máximos de una línea de comando
+#endif
+
+/**
+ * @brief Acciones que tiene que hacer el bucle principal por un comando
+ * @details Los comandos que tocan el estado de la corrida (posición, ruta,
+ *          antirebotes) los resuelve recorrido.c, que es dueño de ese estado
+ */
+typedef enum
+{
+    ACCION_NINGUNA = 0, ///< Nada pendiente
+    ACCION_POSICION,    ///< Volver a la posición de inicio mirando al norte y detenerse
+    ACCION_SPRINT       ///< Arrancar el sprint como con el botón
+} accion_comando_t;
+
+/**
+ * @brief Procesa los bytes recibidos por UART5 y ejecuta las líneas completas
+ * @return Acción que debe hacer el bucle principal, ACCION_NINGUNA si ninguna
+ * @note Llamar en cada vuelta del bucle principal. Con el robot en marcha no
+ *       bloquea; quieto, las respuestas esperan lugar en la cola de transmisión
+ *       y "guardar" y "borrar" esperan a la flash
+ */
+accion_comando_t comandos_procesar(void);
+
+#endif /* __COMANDOS_H */
@@ -2,6 +2,7 @@
 #define CONTROL_LINEARECTA_H
 
 #include "main.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 // Definiciones
@@ -9,15 +10,64 @@
 #define BUFFER_MINIMO 100
 #define MUESTRAS 20
 
+/* Lazo de control lateral (se puede pisar desde los símbolos del compilador) */
+#ifndef CONTROL_POR_TIMER
+#define CONTROL_POR_TIMER 1 ///< 1 = control_lazo_paso() en la interrupción de TIM6; 0 = en el bucle principal
+#endif
+#ifndef FRECUENCIA_CONTROL_HZ
+#define FRECUENCIA_CONTROL_HZ 1000 ///< Ejecuciones por segundo del lazo (TIM6 cuenta a 1 MHz)
+#endif
+
+/* Control lateral PID (ver controlar_linea_recta()) */
+#ifndef CONTROL_PID
+#define CONTROL_PID 1 ///< 1 = PID en punto fijo; 0 = correcciones fijas de control_motor.c
+#endif
+#ifndef PID_KP
+#define PID_KP 40 ///< PWM de diferencia por error a escala completa
+#endif
+#ifndef PID_KI
+#define PID_KI 0 ///< Idem por ejecución con error a escala completa (depende de FRECUENCIA_CONTROL_HZ)
+#endif
+#ifndef PID_KD
+#define PID_KD 20000 ///< Idem por cambio de error a escala completa en un período del lazo (entre promedios del ADC, llevado a ese período)
+#endif
+#ifndef PID_SALIDA_MAXIMA
+#define PID_SALIDA_MAXIMA 300 ///< Máxima diferencia de PWM respecto de la base, por rueda
+#endif
+#ifndef PID_FEEDFORWARD
+#define PID_FEEDFORWARD 0 ///< Diferencia fija que compensa motores desparejos (+ = gira a la izquierda)
+#endif
+
+#define PID_ESCALA 4096 ///< Error normalizado a escala completa (pared a la distancia de calibración)
+
+extern uint16_t pid_kp, pid_ki, pid_kd, pid_salida_maxima;
+
+/**
+ * @brief Mediciones del lazo de control por timer
+ * @details Todo en ciclos de CPU (DWT->CYCCNT, 168 por microsegundo)
+ */
+typedef struct
+{
+    uint32_t ejecuciones;   ///< Interrupciones de TIM6 atendidas
+    uint32_t ciclos_ultimo; ///< Duración de la última ejecución
+    uint32_t ciclos_maximo; ///< Duración más larga
+    uint32_t jitter_maximo; ///< Mayor desvío entre dos ejecuciones respecto del período
+} estadisticas_control_t;
+
 // Variables externas
 extern uint16_t dma_buffer[BUFFER_TOTAL];
 extern uint16_t sensor_izq_avg;
 extern uint16_t sensor_der_avg;
+extern TIM_HandleTypeDef htim6;
 
 // Declaraciones de funciones
 void auto_calibracion(void);
 void promediar_sensores(uint16_t *buffer);
-void controlar_linea_recta(void);
+bool controlar_linea_recta(uint16_t base_izq, uint16_t base_der);
+void control_lazo_paso(uint32_t ahora_ms);
+void control_lazo_iniciar(void);
+void control_lazo_get_estadisticas(estadisticas_control_t *estadisticas);
+void control_lazo_reiniciar_estadisticas(void);
 void correccion_izquierda(void);
 void correccion_derecha(void);
 
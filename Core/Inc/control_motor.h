@@ -15,28 +15,120 @@
 #define __CONTROL_MOTOR_H
 
 #include "main.h"
+#include "brujula.h"
+#include "odometria.h"
+#include <stdbool.h>
 
 extern uint16_t velocidad_actual_izq;
 extern uint16_t velocidad_actual_der;
 extern uint16_t velocidad_giro_actual_izq;
 extern uint16_t velocidad_giro_actual_der;
+extern uint16_t velocidad_sprint_izq;
+extern uint16_t velocidad_sprint_der;
+extern uint16_t tiempo_giro_90_izq;
+extern uint16_t tiempo_giro_90_der;
+extern uint16_t tiempo_giro_180;
+extern uint16_t tiempo_correccion;
+extern uint16_t distancia_avance_linea;
+extern uint16_t angulo_giro_90;
+extern uint16_t angulo_giro_180;
+extern uint16_t perfil_velocidad;
 
 /* Definiciones para control de motores */
 // #define VELOCIDAD_AVANCE 700 // 70% de 1000 (período del timer)
 
 void activar_modo_sprint(void);  // Declaración
+
+/*
+ * Parámetros de ajuste: todos se pueden pisar desde los símbolos del compilador
+ * (-DTIEMPO_GIRO_90_DER=530) o con un header de parámetros incluido antes de
+ * todo (-include parametros_robot.h), sin tocar este archivo. Las velocidades de
+ * sprint y los tiempos de giro y corrección además se copian a variables que se
+ * pueden cambiar por UART entre corridas (ver comandos.h).
+ */
+#ifndef VELOCIDAD_AVANCE_IZQ
 #define VELOCIDAD_AVANCE_IZQ 700 // Motor izquierdo avance
+#endif
+#ifndef VELOCIDAD_AVANCE_DER
 #define VELOCIDAD_AVANCE_DER 700 // Motor derecho avance
+#endif
+#ifndef VELOCIDAD_SPRINT_IZQ
 #define VELOCIDAD_SPRINT_IZQ 900 // 90% - Motor izq modo velocidad máxima
+#endif
+#ifndef VELOCIDAD_SPRINT_DER
 #define VELOCIDAD_SPRINT_DER 900 // 90% - Motor der modo velocidad máxima
+#endif
+#ifndef VELOCIDAD_GIRO_IZQ
 #define VELOCIDAD_GIRO_IZQ 700   // Motor izquierdo giro a la izquierda
+#endif
+#ifndef VELOCIDAD_GIRO_DER
 #define VELOCIDAD_GIRO_DER 700   // Motor derecho giro a la derecha
+#endif
+#ifndef VELOCIDAD_CORRECCION_LENTA
+#define VELOCIDAD_CORRECCION_LENTA 100  // Motor del lado hacia el que se corrige
+#endif
+#ifndef VELOCIDAD_CORRECCION_NORMAL
+#define VELOCIDAD_CORRECCION_NORMAL 700 // Motor del otro lado durante la corrección
+#endif
 
 /* Tiempos de giro en milisegundos (ajustar según calibración) */
+#ifndef TIEMPO_GIRO_90_IZQ
 #define TIEMPO_GIRO_90_IZQ 500  // Tiempo para giro de 90 grados a la izquierda
+#endif
+#ifndef TIEMPO_GIRO_90_DER
 #define TIEMPO_GIRO_90_DER 550  // Tiempo para giro de 90 grados a la derecha
-
+#endif
+#ifndef TIEMPO_GIRO_180
 #define TIEMPO_GIRO_180 1100 // Tiempo para giro de 180 grados
+#endif
+
+#ifndef TIEMPO_CORRECCION
+#define TIEMPO_CORRECCION 70 // Duración de una corrección de trayectoria (ms)
+#endif
+
+/* Objetivos medidos con los encoders (solo con ODOMETRIA_ENCODERS, ver odometria.h) */
+#ifndef ANGULO_GIRO_90
+#define ANGULO_GIRO_90 880   // Décimas de grado; las ruedas tardan en frenar y el robot gira unos 2 grados más
+#endif
+#ifndef ANGULO_GIRO_180
+#define ANGULO_GIRO_180 1800 // Décimas de grado
+#endif
+#ifndef DISTANCIA_AVANCE_LINEA
+#define DISTANCIA_AVANCE_LINEA 90 // Milímetros de la línea al centro de la casilla
+#endif
+
+/* Avance desde la línea hasta el centro de la casilla, en milisegundos */
+#ifndef TIEMPO_AVANCE_LINEA_EXPLORACION
+#define TIEMPO_AVANCE_LINEA_EXPLORACION 250 // Con VELOCIDAD_AVANCE_*
+#endif
+#ifndef TIEMPO_AVANCE_LINEA_SPRINT
+/* Con VELOCIDAD_SPRINT_*: la misma distancia que el de exploración, más rápido (194 ms) */
+#define TIEMPO_AVANCE_LINEA_SPRINT (TIEMPO_AVANCE_LINEA_EXPLORACION * VELOCIDAD_AVANCE_IZQ / VELOCIDAD_SPRINT_IZQ)
+#endif
+
+/* Perfil de velocidad del avance (rampas con aceleración y jerk limitados) */
+#ifndef PERFIL_VELOCIDAD
+#define PERFIL_VELOCIDAD 0 ///< Valor inicial de perfil_velocidad; 0 hasta recalibrar los tiempos con el perfil
+#endif
+#ifndef PERFIL_ACELERACION_MAXIMA
+#define PERFIL_ACELERACION_MAXIMA 2 ///< PWM por ms (0 a 900 en 450 ms)
+#endif
+#ifndef PERFIL_TIEMPO_JERK
+#define PERFIL_TIEMPO_JERK 20 ///< ms para pasar de 0 a la aceleración máxima
+#endif
+#ifndef PERFIL_VELOCIDAD_INICIAL
+#define PERFIL_VELOCIDAD_INICIAL 300 ///< PWM con que arranca el avance después de un giro o parada
+#endif
+#ifndef PERFIL_VELOCIDAD_MAXIMA
+#define PERFIL_VELOCIDAD_MAXIMA 1000 ///< Tope de PWM en rectas largas
+#endif
+#ifndef PERFIL_LARGO_CASILLA_MM
+#define PERFIL_LARGO_CASILLA_MM 180 ///< Distancia entre dos líneas seguidas
+#endif
+#ifndef PERFIL_VELOCIDAD_1000_MM_S
+/** mm/s con PWM 1000: lo que supone el avance de exploración (DISTANCIA_AVANCE_LINEA en TIEMPO_AVANCE_LINEA_EXPLORACION) */
+#define PERFIL_VELOCIDAD_1000_MM_S (DISTANCIA_AVANCE_LINEA * 1000000u / (TIEMPO_AVANCE_LINEA_EXPLORACION * VELOCIDAD_AVANCE_IZQ))
+#endif
 
 /**
  * @brief Estados de motor según tabla de control
@@ -59,13 +151,20 @@ typedef enum // Un enum es un tipo de dato que define un conjunto de
     MOTOR_FRENADO     // M1=0, M0=0 o M1=1, M0=1
 } motor_estado_t;
 
-typedef enum // enumeracion para variable de brujula
+/**
+ * @brief Estados del ejecutor de movimientos
+ * @details Los giros, avances con plazo y correcciones ya no bloquean: se
+ *          arrancan, quedan en uno de estos estados y movimiento_actualizar()
+ *          los termina cuando vence su plazo (o, con ODOMETRIA_ENCODERS, cuando
+ *          los encoders miden el ángulo o la distancia pedidos)
+ */
+typedef enum
 {
-    norte = 0,
-    este,
-    sur,
-    oeste
-} brujula;
+    MOVIMIENTO_LIBRE = 0,  // Sin movimiento con plazo (avanzando o detenido)
+    MOVIMIENTO_AVANCE,     // Avance recto con plazo (centrarse en la casilla)
+    MOVIMIENTO_GIRO,       // Giro en el lugar; al terminar sigue avanzando
+    MOVIMIENTO_CORRECCION  // Corrección de trayectoria; se puede pisar con otro movimiento
+} estado_movimiento_t;
 
 /**
  * @defgroup ControlMotor Control de Motores
@@ -87,52 +186,154 @@ void control_motor_init(void);
 void avanza(void);
 
 /**
- * @brief Gira 90 grados a la izquierda y continúa avanzando
- * @details Motor izquierdo retrocede, motor derecho avanza, al 100%
+ * @brief Arranca un giro de 90 grados a la izquierda
+ * @details Motor izquierdo retrocede, motor derecho avanza. No bloquea: el giro
+ *          termina en movimiento_actualizar() y ahí sigue avanzando
+ * @return Sentido en el que queda el robot al terminar el giro
  */
 brujula gira90izq(brujula sentido);
 
 /**
- * @brief Gira 90 grados a la derecha y continúa avanzando
- * @details Motor derecho retrocede, motor izquierdo avanza, al 100%
+ * @brief Arranca un giro de 90 grados a la derecha
+ * @details Motor derecho retrocede, motor izquierdo avanza. No bloquea
+ * @return Sentido en el que queda el robot al terminar el giro
  */
 brujula gira90der(brujula sentido);
 
 /**
- * @brief Gira 180 grados y continúa avanzando
- * @details Motor derecho retrocede, motor izquierdo avanza, al 100%
+ * @brief Arranca un giro de 180 grados
+ * @details Motor derecho retrocede, motor izquierdo avanza. No bloquea
+ * @return Sentido en el que queda el robot al terminar el giro
  */
 brujula gira180(brujula sentido);
 
 /**
  * @brief Detiene ambos motores completamente
- * @details Usado cuando el robot gana
+ * @details Usado cuando el robot gana. Cancela cualquier movimiento en curso
  */
 void termino(void);
 
 /** @} */ // fin grupo ControlMotor
 
 /**
- * @defgroup ControlMotorAux Funciones Auxiliares de Control
- * @brief Funciones de bajo nivel para control individual de motores
+ * @defgroup EjecutorMovimiento Ejecutor de movimientos
+ * @brief Movimientos con plazo que avanza el bucle principal
+ * @details Uso: se arranca un movimiento (giro, avance o corrección), se llama a
+ *          movimiento_actualizar() con el tiempo actual en cada vuelta del bucle
+ *          (o desde una interrupción de timer) y su valor de retorno indica qué
+ *          movimiento terminó en esa llamada
+ * @{
+ */
+
+/**
+ * @brief Avanza en recta durante un tiempo sin bloquear
+ * @param duracion_ms Duración del avance en milisegundos
+ * @note Con ODOMETRIA_ENCODERS termina a los distancia_avance_linea mm y la
+ *       duración queda de tope
+ */
+void movimiento_iniciar_avance(uint32_t duracion_ms);
+
+/**
+ * @brief Avanza el movimiento en curso según el tiempo actual
+ * @param ahora_ms Tiempo actual en milisegundos (HAL_GetTick() en el robot)
+ * @return Movimiento que terminó en esta llamada, MOVIMIENTO_LIBRE si ninguno
+ */
+estado_movimiento_t movimiento_actualizar(uint32_t ahora_ms);
+
+/**
+ * @brief Estado actual del ejecutor
+ */
+estado_movimiento_t movimiento_get_estado(void);
+
+/**
+ * @brief Indica si hay un giro o avance con plazo en curso
+ * @note Las correcciones no cuentan: cualquier otro movimiento las reemplaza
+ */
+bool movimiento_en_curso(void);
+
+/**
+ * @brief Descarta el movimiento en curso sin tocar los motores
+ */
+void movimiento_cancelar(void);
+
+/** @} */ // fin grupo EjecutorMovimiento
+
+/**
+ * @defgroup PerfilVelocidad Perfil de velocidad
+ * @brief Rampas de la velocidad de avance
+ * @details Con perfil_velocidad en 1 la velocidad de avance no salta de golpe:
+ *          cada rueda se acerca a su objetivo con aceleración limitada a
+ *          PERFIL_ACELERACION_MAXIMA y cambios de aceleración suaves
+ *          (PERFIL_TIEMPO_JERK). Al empezar un tramo recto de la ruta se
+ *          planifica con su largo la velocidad pico (acelerar y frenar en la
+ *          misma distancia, con tope PERFIL_VELOCIDAD_MAXIMA); después, con la
+ *          distancia que queda hasta la última línea, el objetivo baja para
+ *          llegar a ella a velocidad_actual_*, que es con la que se calibraron
+ *          el avance hasta el centro y el giro. La distancia se integra con la
+ *          velocidad (PERFIL_VELOCIDAD_1000_MM_S) y se corrige en cada línea.
+ *          Giros y frenadas vuelven a arrancar desde PERFIL_VELOCIDAD_INICIAL.
+ *          Con perfil_velocidad en 0 los motores van directo a la base.
+ * @note Los giros no se encadenan con las rectas: el robot se detiene a
+ *       girar igual que sin perfil
  * @{
  */
 
 /**
- * @brief Configura el motor izquierdo
- * @param estado Estado del motor (MOTOR_AVANCE, MOTOR_RETROCESO, MOTOR_FRENADO)
- * @param pwm Valor PWM de velocidad (0-1000)
- * @details Controla pines MI0/MI1 para dirección y Vel_I para velocidad
+ * @brief Avanza las rampas según el tiempo actual
+ * @param ahora_ms Tiempo actual en milisegundos (HAL_GetTick())
+ * @return true si el robot avanza en recta y la velocidad cambió: hay que
+ *         volver a escribir los motores con la base nueva
+ * @note No toca los motores; lo llama control_lazo_paso(), que los escribe
+ *       una sola vez por ejecución
+ */
+bool perfil_actualizar(uint32_t ahora_ms);
+
+/**
+ * @brief Planifica un tramo recto que empieza en el centro de una casilla
+ * @param casillas Casillas del tramo; 0 = sin tramo: el objetivo es la base
+ */
+void perfil_planificar_recta(uint8_t casillas);
+
+/**
+ * @brief Corrige la distancia que queda al cruzar una línea del tramo
+ * @param casillas Casillas que faltan hasta la última línea; 0 = se terminó
+ *                 el tramo: el objetivo vuelve a la base
+ */
+void perfil_set_casillas_restantes(uint8_t casillas);
+
+/**
+ * @brief Velocidad de avance del motor izquierdo según el perfil
+ */
+uint16_t perfil_get_velocidad_izq(void);
+
+/**
+ * @brief Velocidad de avance del motor derecho según el perfil
+ */
+uint16_t perfil_get_velocidad_der(void);
+
+/** @} */ // fin grupo PerfilVelocidad
+
+/**
+ * @defgroup ControlMotorAux Funciones Auxiliares de Control
+ * @brief Funciones de bajo nivel para control de los motores
+ * @details set_motores() es la única que escribe los pines de dirección y el
+ *          PWM de TIM3: todo lo demás pasa por ella con el comando de las dos
+ *          ruedas, así cambian siempre en el mismo período de PWM. No hay
+ *          funciones para una sola rueda: leer el comando de la otra fuera de
+ *          la sección crítica podría pisar uno más nuevo de la interrupción
+ * @{
  */
-void set_motor_izq(motor_estado_t estado, uint16_t pwm);
 
 /**
- * @brief Configura el motor derecho
- * @param estado Estado del motor (MOTOR_AVANCE, MOTOR_RETROCESO, MOTOR_FRENADO)
- * @param pwm Valor PWM de velocidad (0-1000)
- * @details Controla pines MD0/MD1 para dirección y Vel_D para velocidad
+ * @brief Configura los dos motores en una sola actualización
+ * @param estado_izq Estado del motor izquierdo
+ * @param pwm_izq PWM del motor izquierdo (0-1000)
+ * @param estado_der Estado del motor derecho
+ * @param pwm_der PWM del motor derecho (0-1000)
+ * @details Un solo acceso a BSRR para MI0/MI1/MD0/MD1 y los dos compare de
+ *          TIM3 con UDIS activo, dentro de una sección crítica
  */
-void set_motor_der(motor_estado_t estado, uint16_t pwm);
+void set_motores(motor_estado_t estado_izq, uint16_t pwm_izq, motor_estado_t estado_der, uint16_t pwm_der);
 
 void correccion_izquierda(void);
 void correccion_derecha(void);
@@ -5,9 +5,15 @@
  * @date 2025-06-10
  * @version 1.0
  *
- * Implementa un laberinto de 4x4 casillas con algoritmo de llenado para
- * encontrar el camino óptimo desde la posición inicial (4,4) hasta
- * la meta (1,1).
+ * Implementa un laberinto de FILAS_LABERINTO x COLUMNAS_LABERINTO casillas
+ * (4x4 por defecto, hasta 32x32) con algoritmo de llenado para encontrar el
+ * camino óptimo desde la posición inicial hasta la meta.
+ *
+ * Las dimensiones, el inicio y la meta se eligen al compilar, por ejemplo
+ * agregando -DFILAS_LABERINTO=16 -DCOLUMNAS_LABERINTO=16 en los símbolos del
+ * proyecto. Sin definir nada se usa la cancha 4x4 con inicio (4,4) y meta (1,1).
+ * Con -DMETA_CENTRAL la meta por defecto son las cuatro casillas centrales, y
+ * en ejecución se pueden cargar otras con laberinto_agregar_meta().
  */
 
 #ifndef __LABERINTO_H
@@ -15,34 +21,100 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-#include "control_motor.h" // Para usar el tipo brujula del colo
-
-/* Configuración del laberinto */
-#define TAMAÑO_LABERINTO 4        ///< Dimensión del laberinto (4x4)
-#define PESO_MAXIMO 255           ///< Peso máximo para muros
-#define POSICION_INICIO_FILA 4    ///< Fila de inicio (4,4) LO DEJAMOS GENERICO PARA EL SASE
-#define POSICION_INICIO_COLUMNA 4 ///< Columna de inicio (4,4)
-#define POSICION_META_FILA 1      ///< Fila de meta (1,1)
-#define POSICION_META_COLUMNA 1   ///< Columna de meta (1,1)
+#include "brujula.h" // Para usar el tipo brujula del colo (sin depender del HAL)
+
+/* Configuración del laberinto (se puede pisar desde los símbolos del compilador) */
+#ifndef FILAS_LABERINTO
+#define FILAS_LABERINTO 4 ///< Cantidad de filas (1 a 32)
+#endif
+#ifndef COLUMNAS_LABERINTO
+#define COLUMNAS_LABERINTO 4 ///< Cantidad de columnas (1 a 32)
+#endif
+#ifndef POSICION_INICIO_FILA
+#define POSICION_INICIO_FILA FILAS_LABERINTO ///< Fila de inicio (esquina sur por defecto)
+#endif
+#ifndef POSICION_INICIO_COLUMNA
+#define POSICION_INICIO_COLUMNA COLUMNAS_LABERINTO ///< Columna de inicio (esquina este por defecto)
+#endif
+#ifndef POSICION_META_FILA
+#define POSICION_META_FILA 1 ///< Fila de meta
+#endif
+#ifndef POSICION_META_COLUMNA
+#define POSICION_META_COLUMNA 1 ///< Columna de meta
+#endif
+
+#ifndef MAX_METAS
+#define MAX_METAS 8 ///< Cantidad máxima de casillas meta simultáneas
+#endif
+
+#if FILAS_LABERINTO < 1 || FILAS_LABERINTO > 32 || COLUMNAS_LABERINTO < 1 || COLUMNAS_LABERINTO > 32
+#error "El laberinto admite entre 1 y 32 filas y columnas"
+#endif
+
+#define PESO_MAXIMO 0xFFFF ///< Peso de casilla inalcanzable o posición inválida
+#define CANTIDAD_CASILLAS (FILAS_LABERINTO * COLUMNAS_LABERINTO) ///< Casillas del laberinto
+#define TAMAÑO_COLA_FLOOD CANTIDAD_CASILLAS ///< Una entrada por casilla
+
+/** @brief Índice plano de una casilla: (fila - 1) * COLUMNAS_LABERINTO + (columna - 1) */
+#define LABERINTO_INDICE(fila, columna) ((indice_t)(((fila) - 1) * COLUMNAS_LABERINTO + ((columna) - 1)))
+
+/** @brief Bit de una dirección dentro de una máscara de direcciones */
+#define DIRECCION_BIT(direccion) ((uint8_t)(1u << (direccion)))
+
+#ifndef VERIFICAR_FLOOD_INCREMENTAL
+#define VERIFICAR_FLOOD_INCREMENTAL 0 ///< 1 = contrastar cada muro nuevo con el Flood Fill completo
+#endif
+#ifndef ZONA_MAXIMA_INCREMENTAL
+#define ZONA_MAXIMA_INCREMENTAL (CANTIDAD_CASILLAS / 8) ///< Casillas afectadas desde las que conviene el Flood Fill completo
+#endif
+#ifndef FLOOD_BITBOARD
+#define FLOOD_BITBOARD 0 ///< 1 = Flood Fill completo por palabras de fila en vez de casilla por casilla
+#endif
 
 /**
  * @brief Estructura que representa una posición en el laberinto
  */
 typedef struct
 {
-    uint8_t fila;    ///< Fila (1-4)
-    uint8_t columna; ///< Columna (1-4)
+    uint8_t fila;    ///< Fila (1 a FILAS_LABERINTO)
+    uint8_t columna; ///< Columna (1 a COLUMNAS_LABERINTO)
 } posicion_t;
 
 /**
- * @brief Estructura que representa una casilla con todas sus características
+ * @brief Distancia de una casilla a la meta
+ * @details 16 bits alcanzan para cualquier camino de hasta 32x32 casillas y dejan
+ *          PESO_MAXIMO libre como marca de "inalcanzable"
  */
-typedef struct
-{
-    posicion_t posicion; ///< Identificación de la casilla (fila, columna)
-    uint8_t peso;        ///< Peso actual de la casilla (distancia a meta)
-    bool muros[4];       ///< Muros en cada dirección [norte, este, sur, oeste]
-} casilla_t;
+typedef uint16_t peso_t;
+
+/**
+ * @brief Índice plano de casilla (0 a CANTIDAD_CASILLAS - 1), ver LABERINTO_INDICE()
+ */
+typedef uint16_t indice_t;
+
+/**
+ * @brief Palabra de muros horizontales: un bit por columna
+ * @details Se elige el tipo más chico que alcanza para COLUMNAS_LABERINTO tramos
+ */
+#if COLUMNAS_LABERINTO <= 8
+typedef uint8_t mascara_fila_t;
+#elif COLUMNAS_LABERINTO <= 16
+typedef uint16_t mascara_fila_t;
+#else
+typedef uint32_t mascara_fila_t;
+#endif
+
+/**
+ * @brief Palabra de muros verticales: un bit por fila
+ * @details Se elige el tipo más chico que alcanza para FILAS_LABERINTO tramos
+ */
+#if FILAS_LABERINTO <= 8
+typedef uint8_t mascara_columna_t;
+#elif FILAS_LABERINTO <= 16
+typedef uint16_t mascara_columna_t;
+#else
+typedef uint32_t mascara_columna_t;
+#endif
 
 /**
  * @defgroup Laberinto Control del Laberinto
@@ -53,34 +125,98 @@ typedef struct
 /**
  * @brief Inicializa el laberinto con pesos ideales y sin muros
  * @details Configura el laberinto con pesos calculados como distancia Manhattan
- *          desde cada casilla hasta la meta (1,1). Inicialmente no hay muros.
+ *          desde cada casilla hasta la meta más cercana. Inicialmente no hay muros.
  */
 void laberinto_init(void);
 
+/**
+ * @brief Borra todas las metas
+ * @details Deja todos los pesos en PESO_MAXIMO hasta que se agregue una meta
+ */
+void laberinto_limpiar_metas(void);
+
+/**
+ * @brief Agrega una casilla al conjunto de metas y recalcula los pesos
+ * @param fila Fila de la meta
+ * @param columna Columna de la meta
+ * @return true si quedó como meta, false si la posición es inválida o no hay lugar
+ * @details El Flood Fill arranca desde todas las metas a la vez, así el robot
+ *          va a la más cercana (ej. el centro 2x2 o varias salidas)
+ */
+bool laberinto_agregar_meta(uint8_t fila, uint8_t columna);
+
+/**
+ * @brief Indica si una casilla es meta
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
+ * @return true si la casilla pertenece al conjunto de metas
+ */
+bool laberinto_es_meta(uint8_t fila, uint8_t columna);
+
 /**
  * @brief Obtiene el peso de una casilla específica
- * @param fila Fila de la casilla (1-4)
- * @param columna Columna de la casilla (1-4)
- * @return Peso de la casilla, PESO_MAXIMO si hay muro o posición inválida
+ * @param fila Fila de la casilla (1 a FILAS_LABERINTO)
+ * @param columna Columna de la casilla (1 a COLUMNAS_LABERINTO)
+ * @return Peso de la casilla, PESO_MAXIMO si es inalcanzable o posición inválida
+ */
+peso_t laberinto_get_peso(uint8_t fila, uint8_t columna);
+
+/**
+ * @brief Obtiene el peso de la casilla vecina en una dirección
+ * @param fila Fila de la casilla de referencia
+ * @param columna Columna de la casilla de referencia
+ * @param direccion Dirección de la vecina (usando tipo brujula)
+ * @return Peso de la vecina, PESO_MAXIMO si hay muro, borde o posición inválida
+ */
+peso_t laberinto_get_peso_adyacente(uint8_t fila, uint8_t columna, brujula direccion);
+
+/**
+ * @brief Devuelve las direcciones transitables desde una casilla
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
+ * @return Máscara de DIRECCION_BIT() con las vecinas dentro del laberinto y sin muro
  */
-uint8_t laberinto_get_peso(uint8_t fila, uint8_t columna);
+uint8_t laberinto_get_direcciones_libres(uint8_t fila, uint8_t columna);
 
 /**
  * @brief Registra un muro entre dos casillas adyacentes
  * @param fila Fila de la casilla actual
  * @param columna Columna de la casilla actual
  * @param direccion Dirección donde se detectó el muro (usando tipo brujula)
- * @details Actualiza los muros en ambas casillas afectadas y recalcula pesos
+ * @details Actualiza los muros en ambas casillas afectadas y repropaga los pesos
+ *          solo en las casillas cuya distancia puede cambiar por el muro nuevo
+ *          (con el Flood Fill completo si son más de ZONA_MAXIMA_INCREMENTAL)
  */
 void laberinto_set_muro(uint8_t fila, uint8_t columna, brujula direccion);
 
 /**
  * @brief Recalcula todos los pesos del laberinto usando Flood Fill
  * @details Propaga los pesos desde la meta hacia todas las casillas,
- *          respetando los muros conocidos
+ *          respetando los muros conocidos. Por defecto es un recorrido en
+ *          anchura (BFS) que visita cada casilla una sola vez; con
+ *          FLOOD_BITBOARD en 1 crece el frente de a una fila entera por operación.
  */
 void laberinto_recalcular_pesos(void);
 
+/**
+ * @brief Devuelve los ciclos de CPU que tardó el último Flood Fill
+ * @return Ciclos medidos con DWT->CYCCNT en la última llamada a laberinto_recalcular_pesos()
+ */
+uint32_t laberinto_get_ciclos_flood(void);
+
+/**
+ * @brief Devuelve los ciclos de CPU que tardó la última actualización por muro
+ * @return Ciclos medidos con DWT->CYCCNT en la última repropagación incremental
+ */
+uint32_t laberinto_get_ciclos_muro(void);
+
+/**
+ * @brief Devuelve las discrepancias entre la actualización incremental y la completa
+ * @return Cantidad de muros donde hubo que corregir con el Flood Fill completo
+ * @note Solo cuenta si VERIFICAR_FLOOD_INCREMENTAL vale 1
+ */
+uint32_t laberinto_get_fallos_incremental(void);
+
 
 /**
  * @brief Verifica si hay un muro en una dirección específica
@@ -103,7 +239,7 @@ posicion_t laberinto_get_posicion_adyacente(posicion_t pos_actual, brujula direc
  * @brief Verifica si una posición es válida dentro del laberinto PARA HACERLO SIN MUROS EN LOS BORDES
  * @param fila Fila a verificar
  * @param columna Columna a verificar
- * @return true si la posición es válida (1-4, 1-4)
+ * @return true si la posición es válida (1 a FILAS_LABERINTO, 1 a COLUMNAS_LABERINTO)
  */
 bool laberinto_posicion_valida(uint8_t fila, uint8_t columna);
 
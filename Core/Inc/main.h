@@ -75,6 +75,8 @@ void Error_Handler(void);
 #define PDM_OUT_GPIO_Port GPIOC
 #define i_am_speed_Pin GPIO_PIN_0
 #define i_am_speed_GPIO_Port GPIOA
+#define EncI_B_Pin GPIO_PIN_1
+#define EncI_B_GPIO_Port GPIOA
 #define I2S3_WS_Pin GPIO_PIN_4
 #define I2S3_WS_GPIO_Port GPIOA
 #define SPI1_SCK_Pin GPIO_PIN_5
@@ -89,6 +91,10 @@ void Error_Handler(void);
 #define LeftSensor_GPIO_Port GPIOB
 #define BOOT1_Pin GPIO_PIN_2
 #define BOOT1_GPIO_Port GPIOB
+#define EncD_A_Pin GPIO_PIN_9
+#define EncD_A_GPIO_Port GPIOE
+#define EncD_B_Pin GPIO_PIN_11
+#define EncD_B_GPIO_Port GPIOE
 #define CLK_IN_Pin GPIO_PIN_10
 #define CLK_IN_GPIO_Port GPIOB
 #define MI0_Pin GPIO_PIN_11
@@ -128,6 +134,8 @@ void Error_Handler(void);
 #define SWDIO_GPIO_Port GPIOA
 #define SWCLK_Pin GPIO_PIN_14
 #define SWCLK_GPIO_Port GPIOA
+#define EncI_A_Pin GPIO_PIN_15
+#define EncI_A_GPIO_Port GPIOA
 #define I2S3_SCK_Pin GPIO_PIN_10
 #define I2S3_SCK_GPIO_Port GPIOC
 #define Audio_RST_Pin GPIO_PIN_4
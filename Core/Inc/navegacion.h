@@ -2,17 +2,95 @@
 #define __NAVEGACION_H
 
 #include <stdint.h>
-#include "control_motor.h"
+#include "brujula.h"
 #include "laberinto.h"
 
+/* Desempate entre direcciones con el mismo peso (o el mismo costo) */
+#ifndef ORDEN_EVALUACION
+#define ORDEN_EVALUACION oeste, norte, sur, este ///< Primero la que gana los empates; ej. -D'ORDEN_EVALUACION=norte,este,sur,oeste'
+#endif
+
+/* Planificador con costo de giros */
+/* Los tiempos salen de control_motor.h: una casilla son PERFIL_LARGO_CASILLA_MM
+ * a la velocidad de avance actual, un giro su tiempo_giro_* más, con el perfil,
+ * lo que se pierde al volver a acelerar desde PERFIL_VELOCIDAD_INICIAL.
+ * Queda en 0: en montecarlo contra simular_16x16 (10 laberintos por tipo,
+ * semillas 7 y 11) explora 2.6 y 8.0 s más rápido en promedio, pero el total
+ * no mejora (+2.8 y +0.1 s): el sprint sale más lento */
+#ifndef PLANIFICAR_CON_GIROS
+#define PLANIFICAR_CON_GIROS 0 ///< 1 = elegir el movimiento de menor tiempo estimado (cuenta los giros)
+#endif
+
+/** @brief Costo acumulado en milisegundos hasta la meta */
+typedef uint32_t costo_t;
+
+#define COSTO_INFINITO 0xFFFFFFFFu ///< Estado desde el que no se llega a ninguna meta
+
+/* Ruta compilada para el sprint */
+/* En zigzag cada casilla lleva un giro y un avance: hasta dos comandos por paso */
+#ifndef MAX_COMANDOS_RUTA
+#define MAX_COMANDOS_RUTA (2 * CANTIDAD_CASILLAS) ///< Capacidad de la lista de comandos de la ruta
+#endif
+
+/** @brief Tipos de comando de la ruta de sprint */
+typedef enum
+{
+    COMANDO_AVANZAR = 0, ///< Avanzar en recta la cantidad de casillas indicada
+    COMANDO_GIRO_DER,    ///< Girar 90° a la derecha
+    COMANDO_GIRO_IZQ,    ///< Girar 90° a la izquierda
+    COMANDO_GIRO_180     ///< Media vuelta
+} tipo_comando_t;
+
+/** @brief Un comando de la ruta (2 bytes) */
+typedef struct
+{
+    uint8_t tipo;     ///< Valor de tipo_comando_t
+    uint8_t casillas; ///< Casillas a avanzar (solo COMANDO_AVANZAR)
+} comando_t;
+
 /**
  * @brief Calcula la mejor dirección basándose en los pesos del laberinto
  */
 brujula calcular_mejor_direccion(uint8_t fila_actual, uint8_t columna_actual);
 
+/**
+ * @brief Calcula la mejor dirección teniendo en cuenta hacia dónde mira el robot
+ * @details Con PLANIFICAR_CON_GIROS en 1 minimiza el tiempo estimado (avances y
+ *          giros con los tiempos de control_motor.h); si no, equivale a
+ *          calcular_mejor_direccion()
+ */
+brujula calcular_mejor_direccion_orientada(uint8_t fila_actual, uint8_t columna_actual, brujula sentido_actual);
+
+#if PLANIFICAR_CON_GIROS
+/**
+ * @brief Tiempo estimado hasta la meta desde una casilla y orientación
+ * @return Milisegundos según el último plan calculado, COSTO_INFINITO si no hay camino
+ */
+costo_t navegacion_get_costo_estimado(uint8_t fila, uint8_t columna, brujula sentido);
+#endif
+
 /**
  * @brief Ejecuta el movimiento necesario para ir del sentido actual al deseado
  */
 brujula ejecutar_movimiento(brujula sentido_actual, brujula sentido_deseado);
 
+/**
+ * @brief Compila el camino a la meta en una lista de comandos
+ * @details Recorre el mapa actual con la misma elección de dirección que la
+ *          exploración y junta las casillas seguidas en recta en un solo comando
+ * @return Cantidad de comandos, 0 si no hay camino conocido o no entra en la lista
+ */
+uint16_t navegacion_compilar_ruta(uint8_t fila, uint8_t columna, brujula sentido);
+
+/**
+ * @brief Lista de comandos de la última ruta compilada
+ */
+const comando_t *navegacion_get_ruta(void);
+
+/**
+ * @brief Ejecuta un comando de giro de la ruta
+ * @return Nuevo sentido del robot (el mismo si el comando no es un giro)
+ */
+brujula ejecutar_comando_giro(brujula sentido_actual, comando_t comando);
+
 #endif /* __NAVEGACION_H */
\ No newline at end of file
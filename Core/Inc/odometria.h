@@ -0,0 +1,92 @@
+/**
+ * @file odometria.h
+ * @brief Odometría con encoders de cuadratura en las dos ruedas
+ * @author demianmozo
+ *
+ * Cada rueda tiene un encoder en un timer en modo encoder (cuenta por los
+ * cuatro flancos de A y B):
+ * - Rueda izquierda: TIM2, PA15 (A) y PA1 (B)
+ * - Rueda derecha: TIM1, PE9 (A) y PE11 (B)
+ *
+ * odometria_actualizar() lee los contadores y acumula los pulsos de cada
+ * rueda; de ahí salen la distancia recorrida (promedio de las dos ruedas) y
+ * el rumbo (diferencia entre las ruedas sobre la trocha). Se llama en la
+ * interrupción de TIM6 junto al control lateral, o en el bucle si
+ * CONTROL_POR_TIMER es 0.
+ *
+ * Con ODOMETRIA_ENCODERS en 1 los giros terminan al medir el ángulo y el
+ * avance hasta el centro de la casilla al medir la distancia (ver
+ * movimiento_actualizar()); el plazo en ms queda como tope por si un encoder
+ * no cuenta. En 0 todo sigue terminando por tiempo, como antes.
+ *
+ * Fuera del micro (sin USE_HAL_DRIVER) los contadores son simulados y se
+ * mueven con odometria_simular_pulsos(), para probar la lógica en la PC.
+ */
+
+#ifndef __ODOMETRIA_H
+#define __ODOMETRIA_H
+
+#include <stdint.h>
+
+#ifndef ODOMETRIA_ENCODERS
+#define ODOMETRIA_ENCODERS 0 ///< 1 = giros y avances terminan por lo medido con los encoders
+#endif
+#ifndef ODOMETRIA_PULSOS_POR_VUELTA
+#define ODOMETRIA_PULSOS_POR_VUELTA 1440 ///< Pulsos por vuelta de rueda (x4, con la reducción)
+#endif
+#ifndef ODOMETRIA_DIAMETRO_RUEDA_UM
+#define ODOMETRIA_DIAMETRO_RUEDA_UM 32000 ///< Diámetro de la rueda en micrómetros
+#endif
+#ifndef ODOMETRIA_TROCHA_UM
+#define ODOMETRIA_TROCHA_UM 85000 ///< Distancia entre los puntos de apoyo de las ruedas, en micrómetros
+#endif
+#ifndef ODOMETRIA_SIGNO_IZQ
+#define ODOMETRIA_SIGNO_IZQ 1 ///< -1 si el encoder izquierdo cuenta hacia atrás al avanzar
+#endif
+#ifndef ODOMETRIA_SIGNO_DER
+#define ODOMETRIA_SIGNO_DER 1 ///< -1 si el encoder derecho cuenta hacia atrás al avanzar
+#endif
+#ifndef ODOMETRIA_FACTOR_PLAZO
+#define ODOMETRIA_FACTOR_PLAZO 2 ///< Con encoders, el plazo en ms se multiplica por esto y queda de tope
+#endif
+
+/**
+ * @brief Arranca los dos timers en modo encoder y pone la odometría a cero
+ * @note Llamar después de MX_TIM1_Init() y MX_TIM2_Init()
+ */
+void odometria_iniciar(void);
+
+/**
+ * @brief Lee los contadores y acumula los pulsos de cada rueda
+ * @note Llamar al menos una vez cada 32768 pulsos por rueda (los contadores
+ *       son de 16 bits); a 1 kHz sobra
+ */
+void odometria_actualizar(void);
+
+/**
+ * @brief Distancia recorrida por el centro del robot desde odometria_iniciar()
+ * @return Micrómetros; negativa si retrocedió
+ */
+int32_t odometria_get_distancia_um(void);
+
+/**
+ * @brief Rumbo acumulado desde odometria_iniciar()
+ * @return Milésimas de grado; positivo hacia la izquierda (antihorario)
+ */
+int32_t odometria_get_angulo_mgrados(void);
+
+/**
+ * @brief Pulsos acumulados de cada rueda, ya con el signo corregido
+ */
+void odometria_get_pulsos(int32_t *izq, int32_t *der);
+
+#ifndef USE_HAL_DRIVER
+/**
+ * @brief Mueve los contadores simulados, como si giraran las ruedas
+ * @param izq Pulsos a sumar al contador izquierdo (con su signo)
+ * @param der Pulsos a sumar al contador derecho
+ */
+void odometria_simular_pulsos(int16_t izq, int16_t der);
+#endif
+
+#endif /* __ODOMETRIA_H */
@@ -0,0 +1,68 @@
+/**
+ * @file persistencia.h
+ * @brief Guardado del mapa, la calibración y los parámetros en la flash
+ * @author demianmozo
+ *
+ * Usa el último sector de la flash (sector 11, 128 KB en 0x080E0000), que el
+ * linker script deja fuera del programa. Cada guardado agrega un registro
+ * completo con número de secuencia y CRC32 a continuación del anterior; el
+ * sector se borra solo cuando se llena, así se borra una vez cada cientos de
+ * guardados. Al arrancar vale el registro íntegro con la secuencia más alta:
+ * uno cortado por un reset a mitad de escritura no pasa el CRC y se ignora,
+ * igual que uno guardado con otro formato (otra versión del registro).
+ *
+ * Fuera del micro (sin USE_HAL_DRIVER) el sector es un arreglo en RAM que
+ * imita la flash: borrar deja todo en 0xFF y escribir solo puede bajar bits.
+ */
+
+#ifndef __PERSISTENCIA_H
+#define __PERSISTENCIA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef TAMAÑO_SECTOR_PERSISTENCIA
+#define TAMAÑO_SECTOR_PERSISTENCIA (128u * 1024u) ///< Bytes del sector reservado
+#endif
+
+/** @brief Qué se encontró guardado al arrancar */
+typedef enum
+{
+    DATOS_NINGUNO = 0, ///< Nada válido: hay que calibrar
+    DATOS_CALIBRACION, ///< Calibración y parámetros; el mapa no está explorado
+    DATOS_MAPA         ///< Además un mapa explorado: listo para el sprint
+} datos_guardados_t;
+
+/**
+ * @brief Busca el último registro válido y lo aplica
+ * @details Restaura los umbrales de los sensores IR, las velocidades y tiempos
+ *          ajustables, las ganancias del PID, los ángulos de giro y el avance
+ *          hasta el centro de la casilla, y carga los muros con laberinto_set_muro()
+ * @return Qué se restauró
+ * @note Llamar después de laberinto_init()
+ */
+datos_guardados_t persistencia_cargar(void);
+
+/**
+ * @brief Guarda el estado actual en un registro nuevo
+ * @param mapa_explorado true si el mapa ya sirve para el sprint
+ * @return false si falló la escritura o el borrado de la flash
+ * @warning Si el sector está lleno lo borra (1 a 2 s con la CPU detenida):
+ *          llamar solo con el robot quieto
+ */
+bool persistencia_guardar(bool mapa_explorado);
+
+/**
+ * @brief Borra el sector: el próximo arranque vuelve a calibrar
+ * @warning Detiene la CPU mientras borra
+ */
+bool persistencia_borrar(void);
+
+#ifndef USE_HAL_DRIVER
+/**
+ * @brief Imagen de la flash simulada, para revisarla o dañarla en la PC
+ */
+uint8_t *persistencia_get_imagen(void);
+#endif
+
+#endif /* __PERSISTENCIA_H */
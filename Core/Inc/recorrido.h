@@ -0,0 +1,76 @@
+/**
+ * @file recorrido.h
+ * @brief Lógica de la corrida: exploración, sprint y respuesta a los sensores
+ * @author demianmozo
+ *
+ * Lo que antes estaba en main.c alrededor del bucle principal: la posición
+ * del robot en el laberinto, el procesamiento de líneas y muros, el botón de
+ * sprint y los comandos por UART. main.c inicializa los periféricos, llama
+ * una vez a recorrido_iniciar() y después a recorrido_paso() en cada vuelta
+ * del bucle. Así la misma lógica corre en la PC sobre el HAL simulado de Host/.
+ */
+
+#ifndef __RECORRIDO_H
+#define __RECORRIDO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "brujula.h"
+
+#ifndef ESPERA_LARGADA_MS
+#define ESPERA_LARGADA_MS 3000 ///< Espera antes de arrancar cuando la calibración vino de la flash
+#endif
+
+/* Estado de la corrida (lo leen comandos.c, persistencia.c y el simulador) */
+extern uint8_t fila_actual, columna_actual;
+extern brujula sentido_actual;
+extern bool terminado;
+extern uint16_t TIEMPO_AVANCE_LINEA;
+extern uint16_t tiempo_avance_sprint;
+
+/**
+ * @brief Carga lo guardado en la flash, calibra si hace falta y arranca los módulos
+ * @note Llamar con los periféricos ya inicializados y el ADC corriendo
+ */
+void recorrido_iniciar(void);
+
+/**
+ * @brief Una vuelta del bucle principal
+ * @details Avanza el movimiento en curso, confirma línea y muro con sus
+ *          antirebotes, atiende el botón de sprint y los comandos por UART
+ */
+void recorrido_paso(void);
+
+/**
+ * @brief Actualiza la posición del robot en el laberinto
+ * @param fila Puntero a la fila actual (se modifica)
+ * @param columna Puntero a la columna actual (se modifica)
+ * @param sentido Orientación actual del robot
+ */
+void actualizar_posicion(uint8_t *fila, uint8_t *columna, brujula sentido);
+
+/**
+ * @brief Procesa la detección de una línea
+ * @details Actualiza posición, verifica meta, calcula nueva dirección y ejecuta movimiento
+ */
+void chequeolinea(void);
+
+/**
+ * @brief Sigue el procesamiento de una línea al llegar al centro de la casilla
+ * @details Actualiza posición, verifica meta, calcula nueva dirección y arranca el movimiento
+ */
+void llegada_centro_casilla(void);
+
+/**
+ * @brief Procesa la detección de un muro
+ * @details Registra el muro, repropaga pesos y ejecuta nuevo movimiento
+ */
+void chequeomuro(void);
+
+/**
+ * @brief Maneja el botón para modo sprint
+ * @details Reinicia posición y activa modo de alta velocidad
+ */
+void reset_posicion_pushbutton(void);
+
+#endif /* __RECORRIDO_H */
@@ -0,0 +1,110 @@
+/**
+ * @file registro.h
+ * @brief Registro de sensores, eventos y motores en la CCMRAM
+ * @author demianmozo
+ *
+ * Guarda en un buffer circular de la CCMRAM (64 KB que no usa nadie más) lo
+ * que pasó durante la corrida: promedios de los sensores IR, líneas y muros
+ * detectados, posiciones y comandos de motor, cada uno con su HAL_GetTick().
+ * Al terminar se vuelca por UART en tramas COBS + CRC16 (ver telemetria.h) para
+ * analizar o reproducir la corrida; Host/herramientas/decodificar las pasa a CSV
+ * y Host/herramientas/reproducir vuelve a correr el firmware con ese CSV.
+ *
+ * Los promedios del ADC solo se guardan mientras algún motor anda (quieto el
+ * control lateral no los usa) y de a 1 cada REGISTRO_DIVISOR_ADC: todos
+ * (REGISTRO_DIVISOR_ADC en 1) llenarían las 4096 entradas en unos 5 s de
+ * corrida. Con el divisor la reproducción interpola entre los promedios
+ * guardados, así que el PID no ve exactamente lo mismo.
+ */
+
+#ifndef __REGISTRO_H
+#define __REGISTRO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Configuración del registro (se puede pisar desde los símbolos del compilador) */
+#ifndef REGISTRO_SENSORES
+#define REGISTRO_SENSORES 1 ///< 0 = no registrar nada (las funciones quedan vacías)
+#endif
+#ifndef CANTIDAD_REGISTROS
+#define CANTIDAD_REGISTROS 4096 ///< Entradas del buffer circular (12 bytes cada una)
+#endif
+#ifndef REGISTRO_DIVISOR_ADC
+#define REGISTRO_DIVISOR_ADC 8 ///< Se guarda 1 de cada N medios buffers del ADC (con motores andando)
+#endif
+#ifndef REGISTRO_DELTA_PWM
+#define REGISTRO_DELTA_PWM 50 ///< Cambio mínimo de PWM que se guarda (el sentido siempre se guarda)
+#endif
+
+/** @brief Tipos de entrada del registro */
+typedef enum
+{
+    REGISTRO_ADC = 0,    ///< a = sensor izquierdo, b = sensor derecho (promedios)
+    REGISTRO_LINEA,      ///< Línea confirmada; a = fila, b = columna antes de avanzar
+    REGISTRO_MURO,       ///< Muro confirmado; extra = sentido, a = fila, b = columna
+    REGISTRO_POSICION,   ///< Llegada a una casilla; extra = sentido, a = fila, b = columna
+    REGISTRO_MOTOR,      ///< Cambio de un motor; extra = motor (0 izq, 1 der), a = estado, b = PWM
+    REGISTRO_CALIBRACION ///< Umbrales de los IR al empezar; extra = 0 cerca, 1 lejos, 2 centrado, a = izq, b = der
+} tipo_registro_t;
+
+/** @brief Una entrada del registro */
+typedef struct
+{
+    uint32_t tiempo_ms; ///< HAL_GetTick() al registrar
+    uint8_t tipo;       ///< Valor de tipo_registro_t
+    uint8_t extra;      ///< Dato chico según el tipo
+    uint16_t a;         ///< Primer dato según el tipo
+    uint16_t b;         ///< Segundo dato según el tipo
+    uint16_t reservado; ///< Relleno hasta 12 bytes
+} registro_t;
+
+/**
+ * @brief Vacía el registro y empieza a grabar
+ */
+void registro_init(void);
+
+/**
+ * @brief Agrega una entrada al registro
+ * @note Se puede llamar desde interrupciones
+ */
+void registro_agregar(tipo_registro_t tipo, uint8_t extra, uint16_t a, uint16_t b);
+
+/**
+ * @brief Registra un medio buffer del ADC (ya promediado), 1 de cada REGISTRO_DIVISOR_ADC
+ *        mientras algún motor anda
+ */
+void registro_sensores(uint16_t izq, uint16_t der);
+
+/**
+ * @brief Registra un comando de motor solo si cambió respecto del anterior
+ */
+void registro_motor(uint8_t motor, uint8_t estado, uint16_t pwm);
+
+/**
+ * @brief Cantidad de entradas guardadas (como máximo CANTIDAD_REGISTROS)
+ */
+uint16_t registro_get_cantidad(void);
+
+/**
+ * @brief Entrada guardada número indice, contando desde la más vieja
+ * @return NULL si no hay tantas
+ */
+const registro_t *registro_get_entrada(uint16_t indice);
+
+/**
+ * @brief Empieza a enviar el registro por UART, de la entrada más vieja a la más nueva
+ * @details No bloquea: encola lo que entra y registro_volcar_paso() sigue con
+ *          el resto a medida que el DMA vacía la cola. Deja de grabar hasta
+ *          terminar; registro_init() corta un volcado en curso
+ */
+void registro_volcar(void);
+
+/**
+ * @brief Encola lo que entre del volcado en curso
+ * @return true mientras quede algo por encolar
+ * @note Llamar en cada vuelta del bucle principal
+ */
+bool registro_volcar_paso(void);
+
+#endif /* __REGISTRO_H */
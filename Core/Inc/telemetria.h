@@ -0,0 +1,118 @@
+/**
+ * @file telemetria.h
+ * @brief Telemetría de la corrida por UART, en texto o en tramas binarias
+ * @author demianmozo
+ *
+ * Por defecto cada registro sale como una trama binaria:
+ *
+ *   COBS( tipo | secuencia | tiempo_ms (4) | datos (0..16) | CRC16 (2) ) 0x00
+ *
+ * - Los números van en little endian
+ * - CRC16-CCITT (polinomio 0x1021, valor inicial 0xFFFF) sobre todo lo anterior
+ * - COBS saca los ceros, así que el 0x00 final separa tramas sin ambigüedad
+ * - secuencia aumenta en 1 por trama para detectar tramas perdidas
+ *
+ * Así entran muchos más registros por segundo a 115200 (muros, giros, tiempos
+ * y fotos de los sensores, que en texto no se mandan).
+ * Host/herramientas/decodificar las pasa a CSV o JSON.
+ *
+ * -DTELEMETRIA_BINARIA=0 es solo para depurar con una terminal serie: manda el
+ * texto de antes, "fila,columna" por casilla y "Finalizado" en la meta, y nada
+ * más. No ahorra flash: comandos.c usa snprintf() y strtoul() igual, así que
+ * printf queda enlazado en los dos modos.
+ *
+ * El volcado del registro de la corrida (registro_volcar()) sale siempre en
+ * tramas, aunque TELEMETRIA_BINARIA sea 0: un 0x00 suelto para separarlo del
+ * texto anterior, TELEMETRIA_VOLCADO de inicio, un TELEMETRIA_REGISTRO por
+ * entrada (con el tiempo de la entrada en tiempo_ms) y TELEMETRIA_VOLCADO de fin.
+ */
+
+#ifndef __TELEMETRIA_H
+#define __TELEMETRIA_H
+
+#include <stdint.h>
+#include "brujula.h"
+#include "laberinto.h"
+#include "registro.h"
+#include <stdbool.h>
+
+/* Configuración (se puede pisar desde los símbolos del compilador) */
+#ifndef TELEMETRIA_BINARIA
+#define TELEMETRIA_BINARIA 1 ///< 0 = texto para depurar con una terminal (ver arriba)
+#endif
+#ifndef TELEMETRIA_PERIODO_SENSORES
+#define TELEMETRIA_PERIODO_SENSORES 50 ///< ms entre fotos de los sensores (solo binaria)
+#endif
+
+/** @brief Tipos de registro de la telemetría binaria (primer byte de la trama) */
+typedef enum
+{
+    TELEMETRIA_CASILLA = 1, ///< fila (1), columna (1), sentido (1), peso (2)
+    TELEMETRIA_MURO,        ///< fila (1), columna (1), dirección (1), ciclos de repropagación (4)
+    TELEMETRIA_GIRO,        ///< sentido anterior (1), sentido nuevo (1)
+    TELEMETRIA_SENSORES,    ///< sensor izquierdo (2), sensor derecho (2)
+    TELEMETRIA_TIEMPO,      ///< etapa (1), ciclos de CPU (4)
+    TELEMETRIA_EVENTO,      ///< evento (1)
+    TELEMETRIA_REGISTRO,    ///< Entrada de registro.h: tipo (1), extra (1), a (2), b (2)
+    TELEMETRIA_VOLCADO      ///< fin (1: 0 = empieza, 1 = terminó), cantidad de entradas (2)
+} tipo_telemetria_t;
+
+/** @brief Etapas medidas con TELEMETRIA_TIEMPO */
+typedef enum
+{
+    ETAPA_DECISION = 0, ///< Desde llegar al centro de la casilla hasta arrancar el movimiento
+    ETAPA_RUTA          ///< Compilación de la ruta de sprint
+} etapa_telemetria_t;
+
+/** @brief Eventos de TELEMETRIA_EVENTO */
+typedef enum
+{
+    EVENTO_INICIO = 0, ///< Arranque de la exploración
+    EVENTO_META,       ///< Llegó a la meta ("Finalizado" en modo texto)
+    EVENTO_SPRINT      ///< Se presionó I AM SPEED
+} evento_telemetria_t;
+
+/**
+ * @brief Llegada a una casilla
+ */
+void telemetria_casilla(uint8_t fila, uint8_t columna, brujula sentido, peso_t peso);
+
+/**
+ * @brief Muro nuevo en el mapa
+ */
+void telemetria_muro(uint8_t fila, uint8_t columna, brujula direccion, uint32_t ciclos);
+
+/**
+ * @brief Cambio de orientación
+ */
+void telemetria_giro(brujula desde, brujula hacia);
+
+/**
+ * @brief Duración de una etapa del procesamiento, en ciclos de CPU
+ */
+void telemetria_tiempo(etapa_telemetria_t etapa, uint32_t ciclos);
+
+/**
+ * @brief Evento de la corrida
+ */
+void telemetria_evento(evento_telemetria_t evento);
+
+/**
+ * @brief Inicio o fin del volcado del registro
+ * @return false si la trama no entraba en la cola de la UART (no se mandó nada)
+ */
+bool telemetria_volcado(bool fin, uint16_t cantidad);
+
+/**
+ * @brief Una entrada del registro
+ * @return false si la trama no entraba en la cola de la UART (no se mandó nada)
+ */
+bool telemetria_registro(const registro_t *registro);
+
+/**
+ * @brief Manda una foto de los sensores cada TELEMETRIA_PERIODO_SENSORES ms
+ * @param ahora_ms Tiempo actual (HAL_GetTick())
+ */
+void telemetria_actualizar(uint32_t ahora_ms);
+
+#endif /* __TELEMETRIA_H */
@@ -9,14 +9,57 @@
 #define INC_UART_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "main.h"
 
-extern char mensaje[16];
+#ifndef TAMAÑO_COLA_TX
+#define TAMAÑO_COLA_TX 1024 ///< Bytes de la cola de transmisión que vacía el DMA
+#endif
+#ifndef TAMAÑO_COLA_RX
+#define TAMAÑO_COLA_RX 128 ///< Bytes de la cola de recepción que llena la interrupción
+#endif
+
+extern char mensaje[24];
 extern const uint8_t delay;
-extern uint8_t buffer[16];
 extern UART_HandleTypeDef huart5;
 
 void Transmision(void);
 void Inicializar_UART(void);
 
+/**
+ * @brief Copia datos a la cola de transmisión; el DMA de UART5 los envía solo
+ * @return false si no entraban (se descartan enteros y se cuentan)
+ * @note No bloquea; se puede llamar desde el bucle principal o desde interrupciones
+ */
+bool uart_encolar(const uint8_t *datos, uint16_t largo);
+
+/**
+ * @brief Espera hasta que entren largo bytes en la cola de transmisión
+ * @warning Bloquea; no llamar desde interrupciones
+ */
+void uart_esperar_espacio(uint16_t largo);
+
+/**
+ * @brief Bytes que entran ahora en la cola de transmisión
+ * @note Para encolar de a partes sin bloquear (ver registro_volcar_paso())
+ */
+uint16_t uart_get_espacio_libre(void);
+
+/**
+ * @brief Bytes descartados desde el arranque por tener la cola llena
+ */
+uint32_t uart_get_bytes_descartados(void);
+
+/**
+ * @brief Saca un byte de la cola de recepción de UART5
+ * @return false si no había nada recibido
+ * @note Un solo consumidor: llamar solo desde el bucle principal
+ */
+bool uart_leer(uint8_t *dato);
+
+/**
+ * @brief Bytes recibidos que se perdieron por cola llena o error de la UART
+ */
+uint32_t uart_get_bytes_perdidos_rx(void);
+
 #endif /* INC_UART_H_ */
\ No newline at end of file
@@ -4,15 +4,52 @@
  */
 
 #include "antirebote.h"
+
+/**
+ * @brief Confirma una lectura nueva si se sostuvo filtro_ms
+ * @return true si en esta llamada se confirmó un paso a GPIO_PIN_RESET
+ */
+static bool confirmar_lectura(antirebote_sensor_t *sensor, GPIO_PinState lectura, uint32_t ahora_ms, uint32_t filtro_ms)
+{
+    // Misma lectura que la confirmada: no hay nada que confirmar
+    if (lectura == sensor->estable)
+    {
+        sensor->esperando = false;
+        return false;
+    }
+
+    // Lectura nueva: empezar a contar
+    if (!sensor->esperando)
+    {
+        sensor->esperando = true;
+        sensor->inicio = ahora_ms;
+        return false;
+    }
+
+    // Todavía no pasó el tiempo de filtrado
+    if ((uint32_t)(ahora_ms - sensor->inicio) < filtro_ms)
+    {
+        return false;
+    }
+
+    // Se sostuvo: es válida
+    sensor->estable = lectura;
+    sensor->esperando = false;
+
+    return lectura == GPIO_PIN_RESET; // Activos en bajo
+}
+
 /**
  * @brief Función genérica de antirebote para cualquier pin GPIO
  * @ingroup ANTIREBOTE
+ * @details No espera: guarda un estado por pin y confirma el cambio en una
+ *          llamada posterior, cuando la lectura se sostuvo TREBOTES ms según
+ *          ahora_ms
  */
-bool antirebote(GPIO_TypeDef *puerto, uint16_t pin)
+bool antirebote(GPIO_TypeDef *puerto, uint16_t pin, uint32_t ahora_ms)
 {
-    // Variables estáticas para guardar el último estado y si fue inicializado
-    static GPIO_PinState
-        ultimas_lecturas[16]; // Para hasta 16 pines distintos uso un array, god
+    // Un estado por pin (hasta 16), sin importar el puerto
+    static antirebote_sensor_t estados[16];
     static uint8_t inicializado[16] = {
         0}; // se inicializan en cero solo la 1era vez que llamas la funcion
 
@@ -25,42 +62,39 @@ bool antirebote(GPIO_TypeDef *puerto, uint16_t pin)
         index++;    // Contar cuántos desplazamientos hicimos
     }
 
-    GPIO_PinState lectura1, lectura2;
-    bool pulsado = false;
+    GPIO_PinState lectura = HAL_GPIO_ReadPin(puerto, pin);
 
-    // Leer el estado actual del pin
-    lectura1 =
-        HAL_GPIO_ReadPin(puerto, pin); //  xq puerto es el puntero al pueertooo
-
-    // Si no se había inicializado antes, guardar lectura inicial y salir
+    // Si no se había inicializado antes, tomar la lectura actual como estable y salir
     if (!inicializado[index])
-    { // se ejecuta solo la primera vez que se llama a
-      // la función para ese pin.
-        ultimas_lecturas[index] = lectura1;
+    { // Un botón apretado al arrancar no cuenta como pulsación
+        estados[index].estable = lectura;
+        estados[index].esperando = false;
         inicializado[index] = 1;
         return false;
     }
 
-    // Si detectamos un cambio respecto a la última lectura válida
-    if (lectura1 != ultimas_lecturas[index])
-    {
-        HAL_Delay(TREBOTES); // Esperar para filtrar rebotes
-
-        // Leer el pin otra vez para confirmar que la lectura es estable
-        lectura2 = HAL_GPIO_ReadPin(puerto, pin);
-
-        // Si la segunda lectura coincide con la primera, es válida
-        if (lectura1 == lectura2)
-        {
-            ultimas_lecturas[index] = lectura2; // Guardar lectura válida
+    return confirmar_lectura(&estados[index], lectura, ahora_ms, TREBOTES);
+}
 
-            // Detectar si el botón fue presionado (activo en bajo)
-            if (lectura2 == GPIO_PIN_RESET)
-            {
-                pulsado = true;
-            }
-        }
-    }
+/**
+ * @brief Antirebote sin espera para sensores
+ * @ingroup ANTIREBOTE
+ * @details En vez de esperar con HAL_Delay y volver a leer, guarda cuándo
+ *          apareció la lectura nueva y la confirma en una llamada posterior si
+ *          se sostuvo TREBOTES_SENSOR ms. Si antes vuelve a la lectura estable,
+ *          se descarta como rebote.
+ */
+bool antirebote_sensor(antirebote_sensor_t *sensor, GPIO_PinState lectura, uint32_t ahora_ms)
+{
+    return confirmar_lectura(sensor, lectura, ahora_ms, TREBOTES_SENSOR);
+}
 
-    return pulsado;
-}
\ No newline at end of file
+/**
+ * @brief Olvida la última lectura confirmada de un sensor
+ * @ingroup ANTIREBOTE
+ */
+void antirebote_sensor_reiniciar(antirebote_sensor_t *sensor)
+{
+    sensor->estable = GPIO_PIN_SET;
+    sensor->esperando = false;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file comandos.c
+ * @brief Implementación del intérprete de comandos por UART5
+ * @author demianmozo
+ */
+
+#include "comandos.h"
+#include "uart.h"
+#include "control_motor.h"
+#include "control_linearecta.h"
+#include "laberinto.h"
+#include "registro.h"
+#include "persistencia.h"
+#include "odometria.h"
+#include "recorrido.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief Un parámetro ajustable por UART */
+typedef struct
+{
+    const char *nombre; ///< Nombre en los comandos get/set
+    uint16_t *valor;    ///< Variable que lo guarda
+    uint16_t maximo;    ///< Mayor valor aceptado (el menor es 0)
+} parametro_t;
+
+/** @brief Parámetros que se pueden leer y cambiar */
+static const parametro_t parametros[] = {
+    {"vel_izq", &velocidad_actual_izq, 1000},
+    {"vel_der", &velocidad_actual_der, 1000},
+    {"vel_sprint_izq", &velocidad_sprint_izq, 1000},
+    {"vel_sprint_der", &velocidad_sprint_der, 1000},
+    {"vel_giro_izq", &velocidad_giro_actual_izq, 1000},
+    {"vel_giro_der", &velocidad_giro_actual_der, 1000},
+    {"giro_izq", &tiempo_giro_90_izq, 5000},
+    {"giro_der", &tiempo_giro_90_der, 5000},
+    {"giro_180", &tiempo_giro_180, 5000},
+    {"correccion", &tiempo_correccion, 1000},
+    {"avance", &TIEMPO_AVANCE_LINEA, 5000},
+    {"avance_sprint", &tiempo_avance_sprint, 5000},
+    {"angulo_90", &angulo_giro_90, 3600},
+    {"angulo_180", &angulo_giro_180, 3600},
+    {"avance_mm", &distancia_avance_linea, 1000},
+    {"pid_kp", &pid_kp, 10000},
+    {"pid_ki", &pid_ki, 1000},
+    {"pid_kd", &pid_kd, 60000},
+    {"pid_max", &pid_salida_maxima, 1000},
+    {"perfil", &perfil_velocidad, 1},
+};
+
+#define CANTIDAD_PARAMETROS (sizeof(parametros) / sizeof(parametros[0]))
+
+/** @brief Línea que se está recibiendo */
+static char linea[LARGO_LINEA_COMANDO + 1];
+
+/** @brief Caracteres recibidos de la línea actual */
+static uint8_t largo_linea = 0;
+
+/** @brief La línea actual se pasó de largo: se descarta hasta el próximo '\n' */
+static bool linea_descartada = false;
+
+/**
+ * @brief Indica si el robot está quieto: corrida terminada y sin giro ni avance
+ * @details Solo así se aceptan los comandos que borran la flash (la CPU queda
+ *          frenada 1 a 2 s), cambian el mapa o mueven la posición
+ */
+static bool robot_detenido(void)
+{
+    return terminado && !movimiento_en_curso();
+}
+
+/**
+ * @brief Manda una línea de respuesta con su "\r\n"
+ * @note Con el robot quieto espera lugar en la cola y la respuesta no se
+ *       pierde; en marcha no bloquea el bucle principal: si no entra entera se
+ *       descarta
+ */
+static void responder(const char *texto)
+{
+    uint16_t largo = strlen(texto);
+
+    if (robot_detenido())
+    {
+        uart_esperar_espacio(largo + 2);
+    }
+    else if (uart_get_espacio_libre() < largo + 2)
+    {
+        return;
+    }
+    uart_encolar((const uint8_t *)texto, largo);
+    uart_encolar((const uint8_t *)"\r\n", 2);
+}
+
+/**
+ * @brief Busca un parámetro por nombre
+ * @return El parámetro, NULL si no existe
+ */
+static const parametro_t *buscar_parametro(const char *nombre)
+{
+    for (uint8_t i = 0; i < CANTIDAD_PARAMETROS; i++)
+    {
+        if (strcmp(parametros[i].nombre, nombre) == 0)
+        {
+            return &parametros[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Responde "nombre=valor"
+ */
+static void responder_parametro(const parametro_t *parametro)
+{
+    char respuesta[32];
+
+    snprintf(respuesta, sizeof(respuesta), "%s=%u", parametro->nombre, *parametro->valor);
+    responder(respuesta);
+}
+
+/**
+ * @brief Convierte un número decimal sin signo
+ * @return false si texto no es un número o se pasa de maximo
+ */
+static bool leer_numero(const char *texto, uint32_t maximo, uint32_t *numero)
+{
+    char *fin;
+
+    if (texto == NULL || *texto == '\0')
+    {
+        return false;
+    }
+
+    unsigned long valor = strtoul(texto, &fin, 10);
+    if (*fin != '\0' || valor > maximo)
+    {
+        return false;
+    }
+
+    *numero = valor;
+    return true;
+}
+
+/**
+ * @brief get [nombre]
+ */
+static void comando_get(const char *nombre)
+{
+    if (nombre == NULL)
+    {
+        for (uint8_t i = 0; i < CANTIDAD_PARAMETROS; i++)
+        {
+            responder_parametro(&parametros[i]);
+        }
+        return;
+    }
+
+    const parametro_t *parametro = buscar_parametro(nombre);
+    if (parametro == NULL)
+    {
+        responder("error parametro");
+        return;
+    }
+
+    responder_parametro(parametro);
+}
+
+/**
+ * @brief set nombre valor
+ * @note Los cambios valen desde el próximo movimiento que los use
+ */
+static void comando_set(const char *nombre, const char *texto_valor)
+{
+    const parametro_t *parametro = (nombre != NULL) ? buscar_parametro(nombre) : NULL;
+    uint32_t valor;
+
+    if (parametro == NULL)
+    {
+        responder("error parametro");
+        return;
+    }
+    if (!leer_numero(texto_valor, parametro->maximo, &valor))
+    {
+        responder("error valor");
+        return;
+    }
+
+    *parametro->valor = (uint16_t)valor;
+    responder_parametro(parametro);
+}
+
+/**
+ * @brief laberinto: una línea "m fila muros" por fila, del norte al sur
+ * @details Borde incluido: un muro de borde se carga sin efecto
+ */
+static void comando_laberinto(void)
+{
+    static const char hexadecimal[] = "0123456789abcdef";
+    char respuesta[8 + COLUMNAS_LABERINTO];
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        uint8_t largo = (uint8_t)snprintf(respuesta, sizeof(respuesta), "m %u ", fila);
+
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            uint8_t muros = (uint8_t)~laberinto_get_direcciones_libres(fila, columna) & 0x0F;
+            respuesta[largo++] = hexadecimal[muros];
+        }
+        respuesta[largo] = '\0';
+
+        responder(respuesta);
+    }
+
+    responder("ok");
+}
+
+/**
+ * @brief Valor de un dígito hexadecimal
+ * @return 0 a 15, -1 si c no es un dígito hexadecimal
+ */
+static int8_t valor_hexadecimal(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief m fila muros: carga los muros de una fila
+ * @details Cada muro pasa por laberinto_set_muro(), que ya repropaga los pesos
+ */
+static void comando_muros(const char *texto_fila, const char *muros)
+{
+    uint32_t fila;
+
+    if (!leer_numero(texto_fila, FILAS_LABERINTO, &fila) || fila == 0 ||
+        muros == NULL || strlen(muros) != COLUMNAS_LABERINTO)
+    {
+        responder("error muros");
+        return;
+    }
+
+    // Validar la fila entera antes de tocar el mapa
+    for (uint8_t columna = 0; columna < COLUMNAS_LABERINTO; columna++)
+    {
+        if (valor_hexadecimal(muros[columna]) < 0)
+        {
+            responder("error muros");
+            return;
+        }
+    }
+
+    for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+    {
+        uint8_t mascara = (uint8_t)valor_hexadecimal(muros[columna - 1]);
+
+        for (brujula direccion = norte; direccion <= oeste; direccion++)
+        {
+            if (mascara & DIRECCION_BIT(direccion))
+            {
+                laberinto_set_muro((uint8_t)fila, columna, direccion);
+            }
+        }
+    }
+
+    responder("ok");
+}
+
+/**
+ * @brief control: mediciones del lazo por timer, en ciclos de CPU
+ * @details Responde y las vuelve a cero para medir el tramo siguiente
+ */
+static void comando_control(void)
+{
+    estadisticas_control_t estadisticas;
+    char respuesta[64]; // Cuatro uint32_t completos con sus nombres
+
+    control_lazo_get_estadisticas(&estadisticas);
+    control_lazo_reiniciar_estadisticas();
+
+    snprintf(respuesta, sizeof(respuesta), "n=%lu ciclos=%lu max=%lu jitter=%lu",
+             (unsigned long)estadisticas.ejecuciones, (unsigned long)estadisticas.ciclos_ultimo,
+             (unsigned long)estadisticas.ciclos_maximo, (unsigned long)estadisticas.jitter_maximo);
+    responder(respuesta);
+}
+
+/**
+ * @brief odo: pulsos de cada rueda, distancia en mm y rumbo en décimas de grado
+ * @details Para calibrar: empujar el robot una distancia o girarlo a mano y
+ *          comparar con lo medido
+ */
+static void comando_odometria(void)
+{
+    int32_t pulsos_izq, pulsos_der;
+    char respuesta[64]; // Cuatro int32_t completos con sus nombres
+
+    odometria_get_pulsos(&pulsos_izq, &pulsos_der);
+    snprintf(respuesta, sizeof(respuesta), "izq=%ld der=%ld mm=%ld angulo=%ld",
+             (long)pulsos_izq, (long)pulsos_der, (long)(odometria_get_distancia_um() / 1000),
+             (long)(odometria_get_angulo_mgrados() / 100));
+    responder(respuesta);
+}
+
+/**
+ * @brief Ejecuta una línea completa
+ * @return Acción para el bucle principal
+ */
+static accion_comando_t ejecutar_linea(char *texto)
+{
+    char *comando = strtok(texto, " \t");
+    char *argumento_1 = strtok(NULL, " \t");
+    char *argumento_2 = strtok(NULL, " \t");
+
+    if (comando == NULL)
+    {
+        return ACCION_NINGUNA; // Línea vacía
+    }
+
+    if (!robot_detenido() && (strcmp(comando, "m") == 0 || strcmp(comando, "guardar") == 0 ||
+                              strcmp(comando, "borrar") == 0 || strcmp(comando, "pos") == 0 ||
+                              strcmp(comando, "sprint") == 0))
+    {
+        responder("error ocupado");
+        return ACCION_NINGUNA;
+    }
+
+    if (strcmp(comando, "get") == 0)
+    {
+        comando_get(argumento_1);
+    }
+    else if (strcmp(comando, "set") == 0)
+    {
+        comando_set(argumento_1, argumento_2);
+    }
+    else if (strcmp(comando, "laberinto") == 0)
+    {
+        comando_laberinto();
+    }
+    else if (strcmp(comando, "m") == 0)
+    {
+        comando_muros(argumento_1, argumento_2);
+    }
+    else if (strcmp(comando, "volcar") == 0)
+    {
+        registro_volcar();
+    }
+    else if (strcmp(comando, "control") == 0)
+    {
+        comando_control();
+    }
+    else if (strcmp(comando, "odo") == 0)
+    {
+        comando_odometria();
+    }
+    else if (strcmp(comando, "guardar") == 0)
+    {
+        responder(persistencia_guardar(true) ? "ok" : "error flash");
+    }
+    else if (strcmp(comando, "borrar") == 0)
+    {
+        responder(persistencia_borrar() ? "ok" : "error flash");
+    }
+    else if (strcmp(comando, "pos") == 0)
+    {
+        responder("ok");
+        return ACCION_POSICION;
+    }
+    else if (strcmp(comando, "sprint") == 0)
+    {
+        responder("ok");
+        return ACCION_SPRINT;
+    }
+    else
+    {
+        responder("error comando");
+    }
+
+    return ACCION_NINGUNA;
+}
+
+/**
+ * @brief Procesa los bytes recibidos y ejecuta las líneas completas
+ * @details Junta caracteres hasta '\n' (ignora '\r'). Si la línea no entra en
+ *          LARGO_LINEA_COMANDO se descarta entera y se responde con error.
+ *          Vuelve apenas un comando pide una acción, así el bucle principal
+ *          la hace antes de seguir con lo que quede en la cola
+ */
+accion_comando_t comandos_procesar(void)
+{
+    uint8_t dato;
+
+    while (uart_leer(&dato))
+    {
+        if (dato == '\r')
+        {
+            continue;
+        }
+
+        if (dato != '\n')
+        {
+            if (largo_linea < LARGO_LINEA_COMANDO)
+            {
+                linea[largo_linea++] = (char)dato;
+            }
+            else
+            {
+                linea_descartada = true;
+            }
+            continue;
+        }
+
+        linea[largo_linea] = '\0';
+        largo_linea = 0;
+
+        if (linea_descartada)
+        {
+            linea_descartada = false;
+            responder("error largo");
+            continue;
+        }
+
+        accion_comando_t accion = ejecutar_linea(linea);
+        if (accion != ACCION_NINGUNA)
+        {
+            return accion;
+        }
+    }
+
+    return ACCION_NINGUNA;
+}
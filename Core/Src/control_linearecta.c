@@ -6,6 +6,7 @@
 
 #include "control_linearecta.h"
 #include "control_motor.h"
+#include "registro.h"
 #include <stdbool.h>
 
 /** @defgroup ControlLinea_Variables Variables de control de línea
@@ -20,6 +21,7 @@ uint16_t sensor_der_avg = 0;
 
 extern volatile bool flag_linea_detectada; ///< Flag de interrupción de línea
 extern volatile bool flag_muro_detectado;  ///< Flag de interrupción de muro
+extern bool terminado;                     ///< Robot detenido (meta o esperando el sprint)
 
 /** @brief Umbrales dinámicos para sensor izquierdo */
 uint16_t izq_cerca = 400, izq_lejos = 4000, izq_centrado = 2200;
@@ -29,6 +31,44 @@ uint16_t der_cerca = 400, der_lejos = 4000, der_centrado = 2200;
 /** @brief Flag que indica si la calibración fue completada */
 bool calibrado = false;
 
+/** @brief Ganancias y límite del PID (ajustables por UART, ver comandos.c) */
+uint16_t pid_kp = PID_KP, pid_ki = PID_KI, pid_kd = PID_KD, pid_salida_maxima = PID_SALIDA_MAXIMA;
+
+#if CONTROL_PID
+/** @brief Suma de los errores (ya limitada por el anti-windup) */
+static int32_t pid_integral = 0;
+
+/** @brief Error con el promedio anterior de los sensores, para la derivada */
+static int32_t pid_error_anterior = 0;
+
+/** @brief Término derivativo del último promedio; se mantiene hasta el siguiente */
+static int64_t pid_derivada = 0;
+
+/** @brief muestras_sensores con la que se calculó la última derivada */
+static uint32_t pid_muestra_anterior = 0;
+
+/** @brief ciclos_muestra de ese promedio */
+static uint32_t pid_ciclos_anterior = 0;
+
+/** @brief false después de un giro o avance: la derivada arranca de cero */
+static bool pid_activo = false;
+#endif
+
+/** @brief Promedios nuevos de los sensores desde el arranque (los cuentan los callbacks del ADC) */
+static volatile uint32_t muestras_sensores = 0;
+
+/** @brief DWT->CYCCNT al completarse el último promedio */
+static volatile uint32_t ciclos_muestra = 0;
+
+/** @brief Mediciones del lazo por timer (las escribe la interrupción de TIM6) */
+static volatile estadisticas_control_t estadisticas_control = {0};
+
+/** @brief DWT->CYCCNT al entrar a la interrupción anterior */
+static uint32_t ciclos_entrada_anterior = 0;
+
+/** @brief false hasta la primera interrupción después de reiniciar las estadísticas */
+static volatile bool entrada_anterior_valida = false;
+
 /**
  * @}
  */
@@ -40,16 +80,130 @@ bool calibrado = false;
 void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
 {
     promediar_sensores(&dma_buffer[0]);
+    ciclos_muestra = DWT->CYCCNT;
+    muestras_sensores++;
+    registro_sensores(sensor_izq_avg, sensor_der_avg);
 }
 
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
 {
     promediar_sensores(&dma_buffer[BUFFER_MINIMO]);
+    ciclos_muestra = DWT->CYCCNT;
+    muestras_sensores++;
+    registro_sensores(sensor_izq_avg, sensor_der_avg);
+}
+
+/**
+ * @brief Período de TIM6: ejecuta el lazo de control lateral
+ * @details Mide cuánto se corrió la interrupción respecto del período ideal
+ *          (jitter) y cuántos ciclos tarda el control
+ * @note Con CONTROL_POR_TIMER en 0 el timer no se arranca y esto no se llama
+ */
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance != TIM6)
+    {
+        return;
+    }
+
+    uint32_t entrada = DWT->CYCCNT;
+
+    if (entrada_anterior_valida)
+    {
+        uint32_t periodo = SystemCoreClock / FRECUENCIA_CONTROL_HZ;
+        uint32_t intervalo = entrada - ciclos_entrada_anterior;
+        uint32_t desvio = (intervalo > periodo) ? intervalo - periodo : periodo - intervalo;
+
+        if (desvio > estadisticas_control.jitter_maximo)
+        {
+            estadisticas_control.jitter_maximo = desvio;
+        }
+    }
+    ciclos_entrada_anterior = entrada;
+    entrada_anterior_valida = true;
+
+    control_lazo_paso(HAL_GetTick());
+
+    uint32_t ciclos = DWT->CYCCNT - entrada;
+    estadisticas_control.ciclos_ultimo = ciclos;
+    if (ciclos > estadisticas_control.ciclos_maximo)
+    {
+        estadisticas_control.ciclos_maximo = ciclos;
+    }
+    estadisticas_control.ejecuciones++;
 }
 /**
  * @}
  */
 
+/**
+ * @brief Una ejecución del lazo: encoders, rampas y control lateral
+ * @details La base de la rampa se calcula primero y se le pasa al control
+ *          lateral, que la usa para su salida; así los motores se escriben
+ *          una sola vez por ejecución. Si el control lateral no escribió (giro,
+ *          avance al centro de la casilla, robot detenido) y la rampa cambió,
+ *          se aplica la base sola con avanza().
+ * @param ahora_ms Tiempo actual en milisegundos (HAL_GetTick())
+ */
+void control_lazo_paso(uint32_t ahora_ms)
+{
+    odometria_actualizar(); // Encoders a la misma frecuencia fija
+    bool base_cambiada = perfil_actualizar(ahora_ms);
+    uint16_t base_izq = perfil_get_velocidad_izq();
+    uint16_t base_der = perfil_get_velocidad_der();
+
+    bool escrito = !terminado && controlar_linea_recta(base_izq, base_der);
+    if (!escrito && base_cambiada)
+    {
+        avanza();
+    }
+}
+
+/**
+ * @brief Arranca el lazo de control por timer
+ * @details Deja TIM6 en FRECUENCIA_CONTROL_HZ y habilita su interrupción
+ * @note Sin efecto con CONTROL_POR_TIMER en 0: el bucle principal llama a
+ *       control_lazo_paso() como siempre
+ */
+void control_lazo_iniciar(void)
+{
+#if CONTROL_POR_TIMER
+    __HAL_TIM_SET_AUTORELOAD(&htim6, (1000000u / FRECUENCIA_CONTROL_HZ) - 1u);
+    control_lazo_reiniciar_estadisticas();
+    HAL_TIM_Base_Start_IT(&htim6);
+#endif
+}
+
+/**
+ * @brief Copia las mediciones del lazo de control por timer
+ * @param estadisticas Destino
+ */
+void control_lazo_get_estadisticas(estadisticas_control_t *estadisticas)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    estadisticas->ejecuciones = estadisticas_control.ejecuciones;
+    estadisticas->ciclos_ultimo = estadisticas_control.ciclos_ultimo;
+    estadisticas->ciclos_maximo = estadisticas_control.ciclos_maximo;
+    estadisticas->jitter_maximo = estadisticas_control.jitter_maximo;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Vuelve a cero las mediciones (por ejemplo al empezar el sprint)
+ */
+void control_lazo_reiniciar_estadisticas(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    estadisticas_control.ejecuciones = 0;
+    estadisticas_control.ciclos_ultimo = 0;
+    estadisticas_control.ciclos_maximo = 0;
+    estadisticas_control.jitter_maximo = 0;
+    entrada_anterior_valida = false;
+    __set_PRIMASK(primask);
+}
+
 /**
  * @brief Calcula el promedio filtrado de los sensores IR
  * @param buffer Puntero al segmento del buffer DMA a procesar
@@ -136,9 +290,143 @@ void auto_calibracion(void)
     calibrado = true;
 }
 
+#if CONTROL_PID
+/**
+ * @brief Distancia a una pared normalizada con la calibración
+ * @param lectura Promedio del sensor
+ * @param cerca Lectura pegado a la pared
+ * @param centrado Lectura con el robot centrado en el pasillo
+ * @return 0 pegado a la pared, PID_ESCALA centrado; más si la pared está lejos o no hay
+ */
+static int32_t normalizar_sensor(uint16_t lectura, uint16_t cerca, uint16_t centrado)
+{
+    if (centrado <= cerca)
+    {
+        return PID_ESCALA; // Calibración inválida: como si estuviera centrado
+    }
+
+    int32_t distancia = ((int32_t)lectura - cerca) * PID_ESCALA / (centrado - cerca);
+    return (distancia < 0) ? 0 : distancia;
+}
+
+/**
+ * @brief Limita un valor a [-limite, limite]
+ */
+static int32_t limitar(int32_t valor, int32_t limite)
+{
+    if (valor > limite)
+        return limite;
+    if (valor < -limite)
+        return -limite;
+    return valor;
+}
+
+/**
+ * @brief Limita un PWM al período de TIM3 (0 a 1000)
+ */
+static uint16_t limitar_pwm(int32_t pwm)
+{
+    if (pwm < 0)
+        return 0;
+    if (pwm > 1000)
+        return 1000;
+    return (uint16_t)pwm;
+}
+
+/**
+ * @brief Un paso del PID lateral en punto fijo
+ * @details El error es la diferencia de las distancias normalizadas a cada
+ *          pared (izquierda - derecha): 0 centrado, negativo cerca de la pared
+ *          izquierda. Si falta una pared (lectura más allá de 1.5 veces la de
+ *          centrado) se usa solo la otra, y sin ninguna se va derecho.
+ *
+ *          La salida se aplica como diferencia sobre la velocidad de avance
+ *          del perfil (ver control_motor.h): izquierda = base - u,
+ *          derecha = base + u. Anti-windup:
+ *          la integral no crece mientras la salida está saturada en el mismo
+ *          sentido y además se limita a lo que puede aportar la salida máxima.
+ *
+ *          Los promedios del ADC llegan cada 1.2 ms más o menos y el lazo corre
+ *          cada 1 ms: la derivada se calcula solo cuando hay un promedio nuevo,
+ *          con el cambio de error llevado a un período del lazo según cuánto
+ *          pasó desde el promedio anterior (DWT->CYCCNT de cada uno), y se
+ *          mantiene en las ejecuciones sin promedio nuevo. Así no alterna entre
+ *          cero y el doble.
+ */
+static void controlar_pid(uint16_t base_izq, uint16_t base_der)
+{
+    const int32_t sin_pared = PID_ESCALA * 3 / 2;
+    // *_lejos es la lectura de la etapa "centrado en pasillo" de auto_calibracion()
+    int32_t distancia_izq = normalizar_sensor(sensor_izq_avg, izq_cerca, izq_lejos);
+    int32_t distancia_der = normalizar_sensor(sensor_der_avg, der_cerca, der_lejos);
+    int32_t error;
+
+    if (distancia_izq < sin_pared && distancia_der < sin_pared)
+    {
+        error = distancia_izq - distancia_der;
+    }
+    else if (distancia_izq < sin_pared)
+    {
+        error = 2 * (distancia_izq - PID_ESCALA);
+    }
+    else if (distancia_der < sin_pared)
+    {
+        error = 2 * (PID_ESCALA - distancia_der);
+    }
+    else
+    {
+        error = 0; // Sin paredes: ir derecho sin acumular
+    }
+
+    uint32_t muestra = muestras_sensores;
+    uint32_t ciclos = ciclos_muestra;
+
+    if (!pid_activo)
+    {
+        pid_error_anterior = error; // Sin salto de derivada al salir de un giro
+        pid_derivada = 0;
+        pid_muestra_anterior = muestra;
+        pid_ciclos_anterior = ciclos;
+        pid_activo = true;
+    }
+    else if (muestra != pid_muestra_anterior)
+    {
+        const uint32_t ciclos_periodo = SystemCoreClock / FRECUENCIA_CONTROL_HZ;
+        uint32_t edad = ciclos - pid_ciclos_anterior;
+
+        if (edad == 0)
+        {
+            edad = ciclos_periodo; // Sin reloj de ciclos: un período del lazo
+        }
+        pid_derivada = (int64_t)pid_kd * (error - pid_error_anterior) * ciclos_periodo / edad;
+        pid_error_anterior = error;
+        pid_muestra_anterior = muestra;
+        pid_ciclos_anterior = ciclos;
+    }
+
+    int32_t salida_maxima = pid_salida_maxima;
+    int64_t suma = (int64_t)pid_kp * error + (int64_t)pid_ki * pid_integral + pid_derivada;
+    int32_t salida = (int32_t)(suma / PID_ESCALA) + PID_FEEDFORWARD;
+
+    // Anti-windup: integrar solo si eso no empuja más una salida ya saturada
+    bool saturada = (salida >= salida_maxima && error > 0) || (salida <= -salida_maxima && error < 0);
+    if (!saturada && pid_ki > 0)
+    {
+        int32_t integral_maxima = (int32_t)(((int64_t)salida_maxima * PID_ESCALA) / pid_ki);
+        pid_integral = limitar(pid_integral + error, integral_maxima);
+    }
+
+    salida = limitar(salida, salida_maxima);
+
+    set_motores(MOTOR_AVANCE, limitar_pwm((int32_t)base_izq - salida),
+                MOTOR_AVANCE, limitar_pwm((int32_t)base_der + salida));
+}
+#endif
+
 /**
  * @brief Controla el seguimiento de línea recta usando sensores IR
- * @details Algoritmo de control reactivo:
+ * @details Con CONTROL_PID en 1 (por defecto) aplica el PID de controlar_pid()
+ * en cada llamada. Con CONTROL_PID en 0 usa el control reactivo original:
  * 1. Verifica que la calibración esté completa
  * 2. Evalúa la proximidad a las paredes laterales
  * 3. Aplica correcciones direccionales según la situación:
@@ -146,14 +434,36 @@ void auto_calibracion(void)
  *    - Muy cerca de pared derecha → Corrección izquierda
  *    - Centrado → Avance recto
  *
+ * @param base_izq Velocidad de avance del perfil para la rueda izquierda
+ * @param base_der Idem derecha
+ * @return true si escribió los motores
+ *
  * @note Utiliza umbrales dinámicos calculados en calibración
- * @note Margen de seguridad de 200 unidades sobre valores de calibración
+ * @note Margen de seguridad de 100 unidades sobre valores de calibración
+ * @note No hace nada mientras haya un giro, avance o corrección en curso
+ * @note Con CONTROL_POR_TIMER en 1 corre en la interrupción de TIM6; los
+ *       movimientos del bucle principal marcan su estado antes de tocar los
+ *       motores para que la interrupción no los pise
  * @warning No opera sin calibración previa (calibrado = false)
  */
-void controlar_linea_recta(void)
+bool controlar_linea_recta(uint16_t base_izq, uint16_t base_der)
 {
     if (!calibrado)
-        return;
+        return false;
+
+    if (movimiento_get_estado() != MOVIMIENTO_LIBRE)
+    {
+#if CONTROL_PID
+        pid_activo = false;
+#endif
+        return false; // Dejar terminar el movimiento en curso
+    }
+
+#if CONTROL_PID
+    controlar_pid(base_izq, base_der);
+#else
+    (void)base_izq; // avanza() toma la misma base del perfil
+    (void)base_der;
 
     // Determinar posición relativa
     bool muy_cerca_izq = (sensor_izq_avg < izq_cerca + 100);
@@ -167,12 +477,10 @@ void controlar_linea_recta(void)
     {
         correccion_izquierda(); // Alejarse de pared derecha
     }
-    else if (muy_cerca_izq)
-    {
-        correccion_derecha(); // Alejarse de pared izquierda
-    }
     else
     {
         avanza(); // Ir recto si está centrado
     }
+#endif
+    return true;
 }
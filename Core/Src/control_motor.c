@@ -4,11 +4,10 @@
  * @author demianmozo
  */
 #include "control_motor.h"
+#include "registro.h"
 #include <stdbool.h>
 
 extern TIM_HandleTypeDef htim3;            // usa el timer 3 para PWM
-extern volatile bool flag_linea_detectada; // flag linea
-extern volatile bool flag_muro_detectado;  // flag muro
 
 
 uint16_t velocidad_actual_izq = VELOCIDAD_AVANCE_IZQ;
@@ -16,6 +15,306 @@ uint16_t velocidad_actual_der = VELOCIDAD_AVANCE_DER;
 uint16_t velocidad_giro_actual_izq = VELOCIDAD_GIRO_IZQ;
 uint16_t velocidad_giro_actual_der = VELOCIDAD_GIRO_DER;
 
+/* Parámetros ajustables en marcha (ver comandos.c); arrancan con los valores de compilación */
+uint16_t velocidad_sprint_izq = VELOCIDAD_SPRINT_IZQ;
+uint16_t velocidad_sprint_der = VELOCIDAD_SPRINT_DER;
+uint16_t tiempo_giro_90_izq = TIEMPO_GIRO_90_IZQ;
+uint16_t tiempo_giro_90_der = TIEMPO_GIRO_90_DER;
+uint16_t tiempo_giro_180 = TIEMPO_GIRO_180;
+uint16_t tiempo_correccion = TIEMPO_CORRECCION;
+uint16_t distancia_avance_linea = DISTANCIA_AVANCE_LINEA;
+uint16_t angulo_giro_90 = ANGULO_GIRO_90;
+uint16_t angulo_giro_180 = ANGULO_GIRO_180;
+uint16_t perfil_velocidad = PERFIL_VELOCIDAD;
+
+/* Ejecutor de movimientos: volatile para poder avanzarlo desde una interrupción */
+static volatile estado_movimiento_t estado_movimiento = MOVIMIENTO_LIBRE; // Movimiento en curso
+static volatile uint32_t inicio_movimiento = 0;                           // HAL_GetTick() al arrancarlo
+static volatile uint32_t duracion_movimiento = 0;                         // Plazo en ms desde el inicio
+#if ODOMETRIA_ENCODERS
+static volatile int32_t objetivo_movimiento = 0; // um (avance) o milésimas de grado (giro); 0 = solo plazo
+static volatile int32_t distancia_inicio = 0;    // Odometría al arrancar el movimiento
+static volatile int32_t angulo_inicio = 0;
+#endif
+
+/** @brief Rampa de la velocidad de una rueda, en PWM * 256 */
+typedef struct
+{
+    int32_t velocidad;   ///< Velocidad actual
+    int32_t aceleracion; ///< Cambio de velocidad por ms
+} rampa_t;
+
+/* Perfil de velocidad: lo avanza perfil_actualizar() (interrupción o bucle) */
+static volatile rampa_t rampa_izq = {0, 0};
+static volatile rampa_t rampa_der = {0, 0};
+static volatile uint16_t pico_perfil = 0;      // PWM sobre velocidad_actual_* planificado para el tramo
+static volatile uint32_t distancia_perfil = 0; // Hasta la última línea del tramo, en PWM * ms
+static volatile bool en_avance = false;       // El último comando a los motores fue avanza()
+static uint32_t ultima_actualizacion_perfil = 0;
+
+/**
+ * @brief Registra el movimiento que se arranca y su plazo
+ * @param objetivo Distancia en um (avance) o ángulo en milésimas de grado
+ *                 (giro) que lo termina con ODOMETRIA_ENCODERS; 0 = solo plazo
+ * @note Se llama antes de mover los motores: si el control lateral corre en
+ *       una interrupción (CONTROL_POR_TIMER) ya ve el movimiento y no los pisa
+ */
+static void iniciar_movimiento(estado_movimiento_t estado, uint32_t duracion_ms, int32_t objetivo)
+{
+    inicio_movimiento = HAL_GetTick();
+#if ODOMETRIA_ENCODERS
+    if (objetivo > 0)
+    {
+        duracion_ms *= ODOMETRIA_FACTOR_PLAZO; // Tope por si un encoder no cuenta
+    }
+    objetivo_movimiento = objetivo;
+    distancia_inicio = odometria_get_distancia_um();
+    angulo_inicio = odometria_get_angulo_mgrados();
+#else
+    (void)objetivo;
+#endif
+    duracion_movimiento = duracion_ms;
+    estado_movimiento = estado;
+}
+
+/**
+ * @brief Indica si los encoders ya midieron el objetivo del movimiento en curso
+ * @details Giro: ángulo girado en cualquier sentido. Avance: distancia hacia adelante
+ */
+static bool objetivo_alcanzado(estado_movimiento_t estado)
+{
+#if ODOMETRIA_ENCODERS
+    int32_t objetivo = objetivo_movimiento;
+
+    if (objetivo <= 0)
+    {
+        return false;
+    }
+
+    if (estado == MOVIMIENTO_GIRO)
+    {
+        int32_t girado = odometria_get_angulo_mgrados() - angulo_inicio;
+        return (girado < 0 ? -girado : girado) >= objetivo;
+    }
+
+    return odometria_get_distancia_um() - distancia_inicio >= objetivo;
+#else
+    (void)estado;
+    return false;
+#endif
+}
+
+/**
+ * @brief Pasa milímetros a la unidad de distancia del perfil (PWM * ms)
+ */
+static uint32_t distancia_perfil_mm(uint32_t mm)
+{
+    return mm * (1000000u / PERFIL_VELOCIDAD_1000_MM_S);
+}
+
+/**
+ * @brief Raíz cuadrada entera (hacia abajo), bit a bit
+ */
+static uint32_t raiz_cuadrada(uint32_t valor)
+{
+    uint32_t raiz = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > valor)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (valor >= raiz + bit)
+        {
+            valor -= raiz + bit;
+            raiz = (raiz >> 1) + bit;
+        }
+        else
+        {
+            raiz >>= 1;
+        }
+        bit >>= 2;
+    }
+    return raiz;
+}
+
+/**
+ * @brief Objetivo del perfil para una rueda
+ * @param base Velocidad de avance del modo para esa rueda
+ * @param velocidad Velocidad actual de su rampa (PWM * 256)
+ * @details La base más el pico planificado, pero nunca más de lo que deja
+ *          frenar hasta la base en la distancia que queda. A esa distancia se
+ *          le descuenta lo que se recorre en 2 * PERFIL_TIEMPO_JERK: lo que la
+ *          rampa tarda en llegar a la aceleración y en alcanzar al objetivo
+ */
+static int32_t objetivo_perfil(uint16_t base, int32_t velocidad)
+{
+    uint32_t objetivo = (uint32_t)base + pico_perfil;
+    if (objetivo > PERFIL_VELOCIDAD_MAXIMA)
+    {
+        objetivo = (base > PERFIL_VELOCIDAD_MAXIMA) ? base : PERFIL_VELOCIDAD_MAXIMA;
+    }
+
+    uint32_t distancia = distancia_perfil;
+    uint32_t adelanto = (uint32_t)(velocidad >> 8) * PERFIL_TIEMPO_JERK * 2;
+    distancia = (distancia > adelanto) ? distancia - adelanto : 0;
+    uint32_t frenada = raiz_cuadrada((uint32_t)base * base + 2u * PERFIL_ACELERACION_MAXIMA * distancia);
+    if (objetivo > frenada)
+    {
+        objetivo = frenada;
+    }
+    return (int32_t)objetivo << 8;
+}
+
+/**
+ * @brief Vuelve a arrancar las rampas desde PERFIL_VELOCIDAD_INICIAL
+ * @details Después de un giro o una frenada el robot parte casi quieto
+ */
+static void reiniciar_perfil(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    rampa_izq.velocidad = (int32_t)PERFIL_VELOCIDAD_INICIAL << 8;
+    rampa_der.velocidad = (int32_t)PERFIL_VELOCIDAD_INICIAL << 8;
+    rampa_izq.aceleracion = 0;
+    rampa_der.aceleracion = 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Avanza una rampa dt milisegundos hacia su objetivo
+ * @details La aceleración deseada es proporcional a lo que falta (llega sin
+ *          pasarse) y limitada a PERFIL_ACELERACION_MAXIMA; la aceleración
+ *          real se acerca a la deseada a lo sumo de a un jerk por ms
+ */
+static void avanzar_rampa(volatile rampa_t *rampa, int32_t objetivo, uint32_t dt)
+{
+    const int32_t aceleracion_maxima = (int32_t)PERFIL_ACELERACION_MAXIMA << 8;
+    const int32_t jerk = (aceleracion_maxima / PERFIL_TIEMPO_JERK > 0) ? aceleracion_maxima / PERFIL_TIEMPO_JERK : 1;
+
+    for (; dt > 0; dt--)
+    {
+        int32_t falta = objetivo - rampa->velocidad;
+        int32_t deseada = falta / PERFIL_TIEMPO_JERK;
+
+        if (deseada == 0 && falta != 0)
+            deseada = (falta > 0) ? 1 : -1; // Que el último tramo no se quede en cero
+        if (deseada > aceleracion_maxima)
+            deseada = aceleracion_maxima;
+        else if (deseada < -aceleracion_maxima)
+            deseada = -aceleracion_maxima;
+
+        if (deseada > rampa->aceleracion + jerk)
+            rampa->aceleracion += jerk;
+        else if (deseada < rampa->aceleracion - jerk)
+            rampa->aceleracion -= jerk;
+        else
+            rampa->aceleracion = deseada;
+
+        int32_t velocidad = rampa->velocidad + rampa->aceleracion;
+        if ((falta > 0 && velocidad >= objetivo) || (falta < 0 && velocidad <= objetivo) || falta == 0)
+        {
+            velocidad = objetivo; // Llegó: sin pasarse
+            rampa->aceleracion = 0;
+        }
+        rampa->velocidad = velocidad;
+    }
+}
+
+/**
+ * @brief Avanza las rampas según el tiempo actual
+ * @param ahora_ms Tiempo actual en milisegundos
+ * @return true si el robot avanza en recta y la velocidad cambió
+ */
+bool perfil_actualizar(uint32_t ahora_ms)
+{
+    uint32_t dt = ahora_ms - ultima_actualizacion_perfil;
+    ultima_actualizacion_perfil = ahora_ms;
+    if (!perfil_velocidad || dt == 0)
+    {
+        return false;
+    }
+    if (dt > 50)
+    {
+        dt = 50; // Después de una pausa larga (flash, volcado) no recuperar todo de golpe
+    }
+    if (!en_avance)
+    {
+        return false; // Girando o detenido: la rampa espera en la inicial hasta el próximo avance
+    }
+
+    uint16_t izq_anterior = perfil_get_velocidad_izq();
+    uint16_t der_anterior = perfil_get_velocidad_der();
+
+    // Lo recorrido desde la última vez, con la velocidad que tenían las ruedas
+    uint32_t recorrido = (uint32_t)(izq_anterior + der_anterior) / 2 * dt;
+    uint32_t distancia = distancia_perfil;
+    distancia_perfil = (distancia > recorrido) ? distancia - recorrido : 0;
+
+    avanzar_rampa(&rampa_izq, objetivo_perfil(velocidad_actual_izq, rampa_izq.velocidad), dt);
+    avanzar_rampa(&rampa_der, objetivo_perfil(velocidad_actual_der, rampa_der.velocidad), dt);
+
+    // Solo cuenta mientras avanza en recta; quien llama escribe los motores una vez
+    estado_movimiento_t estado = estado_movimiento;
+    return en_avance && (estado == MOVIMIENTO_LIBRE || estado == MOVIMIENTO_AVANCE) &&
+           (perfil_get_velocidad_izq() != izq_anterior || perfil_get_velocidad_der() != der_anterior);
+}
+
+/**
+ * @brief Planifica un tramo recto que empieza en el centro de una casilla
+ * @param casillas Casillas del tramo
+ * @details Hasta la última línea hay casillas - 1/2 casillas. El pico es el
+ *          de acelerar desde la velocidad actual y frenar hasta la base en esa
+ *          distancia: v^2 = (2 a d + v0^2 + base^2) / 2
+ */
+void perfil_planificar_recta(uint8_t casillas)
+{
+    uint32_t distancia = (casillas > 0) ? distancia_perfil_mm((2u * casillas - 1u) * PERFIL_LARGO_CASILLA_MM / 2u) : 0;
+    uint32_t inicial = (uint32_t)(rampa_izq.velocidad >> 8);
+    uint32_t base = velocidad_actual_izq;
+    uint32_t pico = raiz_cuadrada((2u * PERFIL_ACELERACION_MAXIMA * distancia + inicial * inicial + base * base) / 2u);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    distancia_perfil = distancia;
+    pico_perfil = (casillas > 0 && pico > base) ? (uint16_t)(pico - base) : 0;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Corrige la distancia que queda al cruzar una línea del tramo
+ * @param casillas Casillas hasta la última línea
+ */
+void perfil_set_casillas_restantes(uint8_t casillas)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    distancia_perfil = distancia_perfil_mm((uint32_t)casillas * PERFIL_LARGO_CASILLA_MM);
+    if (casillas == 0)
+    {
+        pico_perfil = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief Velocidad de avance del motor izquierdo según el perfil
+ */
+uint16_t perfil_get_velocidad_izq(void)
+{
+    return perfil_velocidad ? (uint16_t)(rampa_izq.velocidad >> 8) : velocidad_actual_izq;
+}
+
+/**
+ * @brief Velocidad de avance del motor derecho según el perfil
+ */
+uint16_t perfil_get_velocidad_der(void)
+{
+    return perfil_velocidad ? (uint16_t)(rampa_der.velocidad >> 8) : velocidad_actual_der;
+}
+
 /**
  * @brief Activa el modo sprint de alta velocidad
  * @details Cambia las velocidades de avance a valores de sprint (90% vs 70%)
@@ -23,8 +322,8 @@ uint16_t velocidad_giro_actual_der = VELOCIDAD_GIRO_DER;
  */
 void activar_modo_sprint(void)
 {
-    velocidad_actual_izq = VELOCIDAD_SPRINT_IZQ;
-    velocidad_actual_der = VELOCIDAD_SPRINT_DER;
+    velocidad_actual_izq = velocidad_sprint_izq;
+    velocidad_actual_der = velocidad_sprint_der;
 }
 
 /**
@@ -36,70 +335,79 @@ void control_motor_init(void)
     HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_3); // Motor izquierdo (PC8)
     HAL_TIM_PWM_Start(&htim3, TIM_CHANNEL_4); // Motor derecho (PC9)
 
-    // comienza yendo para adelante
+    // comienza yendo para adelante, desde la velocidad inicial del perfil
+    reiniciar_perfil();
+    ultima_actualizacion_perfil = HAL_GetTick();
     avanza();
 }
 
 /**
- * @brief Configura motor izquierdo
- * @param estado: MOTOR_AVANCE, MOTOR_RETROCESO o MOTOR_FRENADO
- * @param pwm: Valor PWM (0-1000)
+ * @brief Bits de BSRR para los dos pines de dirección de un motor
+ * @param pin0 Pin M0 del motor
+ * @param pin1 Pin M1 del motor
+ * @param estado MOTOR_AVANCE, MOTOR_RETROCESO o MOTOR_FRENADO
+ * @return Mitad baja = pines a 1, mitad alta = pines a 0 (formato de BSRR)
  */
-void set_motor_izq(motor_estado_t estado, uint16_t pwm)
+static uint32_t bits_direccion(uint16_t pin0, uint16_t pin1, motor_estado_t estado)
 {
     switch (estado)
     {
     case MOTOR_AVANCE:
-        HAL_GPIO_WritePin(MI0_GPIO_Port, MI0_Pin, GPIO_PIN_SET);   // MI0 = 1
-        HAL_GPIO_WritePin(MI1_GPIO_Port, MI1_Pin, GPIO_PIN_RESET); // MI1 = 0
-        break;
+        return pin0 | ((uint32_t)pin1 << 16); // M0 = 1, M1 = 0
 
     case MOTOR_RETROCESO:
-        HAL_GPIO_WritePin(MI0_GPIO_Port, MI0_Pin, GPIO_PIN_RESET); // MI0 = 0
-        HAL_GPIO_WritePin(MI1_GPIO_Port, MI1_Pin, GPIO_PIN_SET);   // MI1 = 1
-        break;
+        return pin1 | ((uint32_t)pin0 << 16); // M0 = 0, M1 = 1
 
     case MOTOR_FRENADO:
     default:
-        HAL_GPIO_WritePin(MI0_GPIO_Port, MI0_Pin, GPIO_PIN_RESET); // MI0 = 0
-        HAL_GPIO_WritePin(MI1_GPIO_Port, MI1_Pin, GPIO_PIN_RESET); // MI1 = 0
-        pwm = 0;                                                   // Forzar PWM a 0 en frenado
-        break;
+        return ((uint32_t)(pin0 | pin1)) << 16; // M0 = 0, M1 = 0
     }
-
-    // Establecer PWM, aca le definimos la velocidad
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, pwm);
 }
 
 /**
- * @brief Configura motor derecho
- * @param estado: MOTOR_AVANCE, MOTOR_RETROCESO o MOTOR_FRENADO
- * @param pwm: Valor PWM (0-1000)
+ * @brief Configura los dos motores a la vez
+ * @param estado_izq Estado del motor izquierdo
+ * @param pwm_izq PWM del motor izquierdo (0-1000)
+ * @param estado_der Estado del motor derecho
+ * @param pwm_der PWM del motor derecho (0-1000)
+ *
+ * @details
+ * - Los cuatro pines de dirección están en GPIOB (ver main.h): se escriben
+ *   con un solo acceso a BSRR, así las dos ruedas cambian juntas
+ * - Los compare de TIM3 tienen precarga: los valores nuevos pasan al
+ *   contador en el próximo evento de actualización. Con UDIS se evita que
+ *   ese evento caiga entre las dos escrituras, así ambos canales cambian en
+ *   el mismo período
+ * - Con las interrupciones deshabilitadas: el control lateral por timer no
+ *   puede mezclar su comando con uno del bucle principal
  */
-void set_motor_der(motor_estado_t estado, uint16_t pwm)
+void set_motores(motor_estado_t estado_izq, uint16_t pwm_izq, motor_estado_t estado_der, uint16_t pwm_der)
 {
-    switch (estado)
+    if (estado_izq != MOTOR_AVANCE && estado_izq != MOTOR_RETROCESO)
     {
-    case MOTOR_AVANCE:
-        HAL_GPIO_WritePin(MD0_GPIO_Port, MD0_Pin, GPIO_PIN_SET);   // MD0 = 1
-        HAL_GPIO_WritePin(MD1_GPIO_Port, MD1_Pin, GPIO_PIN_RESET); // MD1 = 0
-        break;
+        pwm_izq = 0; // Forzar PWM a 0 en frenado
+    }
+    if (estado_der != MOTOR_AVANCE && estado_der != MOTOR_RETROCESO)
+    {
+        pwm_der = 0;
+    }
 
-    case MOTOR_RETROCESO:
-        HAL_GPIO_WritePin(MD0_GPIO_Port, MD0_Pin, GPIO_PIN_RESET); // MD0 = 0
-        HAL_GPIO_WritePin(MD1_GPIO_Port, MD1_Pin, GPIO_PIN_SET);   // MD1 = 1
-        break;
+    uint32_t bsrr = bits_direccion(MI0_Pin, MI1_Pin, estado_izq) | bits_direccion(MD0_Pin, MD1_Pin, estado_der);
 
-    case MOTOR_FRENADO:
-    default:
-        HAL_GPIO_WritePin(MD0_GPIO_Port, MD0_Pin, GPIO_PIN_RESET); // MD0 = 0
-        HAL_GPIO_WritePin(MD1_GPIO_Port, MD1_Pin, GPIO_PIN_RESET); // MD1 = 0
-        pwm = 0;                                                   // Forzar PWM a 0 en frenado
-        break;
-    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    htim3.Instance->CR1 |= TIM_CR1_UDIS; // Sin evento de actualización entre los dos compare
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, pwm_izq);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, pwm_der);
+    htim3.Instance->CR1 &= ~TIM_CR1_UDIS;
+
+    MI0_GPIO_Port->BSRR = bsrr; // MI0, MI1, MD0 y MD1 de una vez
 
-    // Establecer VELOCIDAD
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, pwm);
+    __set_PRIMASK(primask);
+
+    registro_motor(0, estado_izq, pwm_izq);
+    registro_motor(1, estado_der, pwm_der);
 }
 
 /**
@@ -107,20 +415,20 @@ void set_motor_der(motor_estado_t estado, uint16_t pwm)
  */
 void avanza(void)
 {
-    set_motor_izq(MOTOR_AVANCE, velocidad_actual_izq);
-    set_motor_der(MOTOR_AVANCE, velocidad_actual_der);
+    en_avance = true;
+    set_motores(MOTOR_AVANCE, perfil_get_velocidad_izq(), MOTOR_AVANCE, perfil_get_velocidad_der());
 }
 
 /**
- * @brief Gira 90 grados a la izquierda y luego continúa avanzando
- * Motor izq retrocede, motor der avanza
+ * @brief Arranca un giro de 90 grados a la izquierda
+ * Motor izq retrocede, motor der avanza; movimiento_actualizar() lo termina
  */
 brujula gira90izq(brujula sentido)
 {
-    set_motor_izq(MOTOR_RETROCESO, velocidad_giro_actual_izq);
-    set_motor_der(MOTOR_AVANCE, velocidad_giro_actual_der);
-
-    HAL_Delay(TIEMPO_GIRO_90_IZQ);
+    iniciar_movimiento(MOVIMIENTO_GIRO, tiempo_giro_90_izq, angulo_giro_90 * 100); // Antes que los motores: ver iniciar_movimiento()
+    en_avance = false;
+    reiniciar_perfil(); // Después del giro arranca de nuevo la rampa
+    set_motores(MOTOR_RETROCESO, velocidad_giro_actual_izq, MOTOR_AVANCE, velocidad_giro_actual_der);
     switch (sentido)
     {
     case norte:
@@ -140,24 +448,21 @@ brujula gira90izq(brujula sentido)
         break;
     }
 
-    // Después del giro, continuar avanzando
-    //avanza();
-
-    // termina de girar y verifica que no halla un muro adelante
+    // Después del giro, continuar avanzando: lo hace movimiento_actualizar()
 
     return sentido;
 }
 
 /**
- * @brief Gira 90 grados a la derecha y luego continúa avanzando
- * Motor der retrocede, motor izq avanza
+ * @brief Arranca un giro de 90 grados a la derecha
+ * Motor der retrocede, motor izq avanza; movimiento_actualizar() lo termina
  */
 brujula gira90der(brujula sentido)
 {
-    set_motor_izq(MOTOR_AVANCE, velocidad_giro_actual_izq);
-    set_motor_der(MOTOR_RETROCESO, velocidad_giro_actual_der);
-
-    HAL_Delay(TIEMPO_GIRO_90_DER);
+    iniciar_movimiento(MOVIMIENTO_GIRO, tiempo_giro_90_der, angulo_giro_90 * 100);
+    en_avance = false;
+    reiniciar_perfil();
+    set_motores(MOTOR_AVANCE, velocidad_giro_actual_izq, MOTOR_RETROCESO, velocidad_giro_actual_der);
     switch (sentido)
     {
     case norte:
@@ -177,22 +482,21 @@ brujula gira90der(brujula sentido)
         break;
     }
 
-    // Después del giro, continuar avanzando
-    //avanza();
-    
+    // Después del giro, continuar avanzando: lo hace movimiento_actualizar()
+
     return sentido;
 }
 
 /**
- * @brief Gira 180 grados y luego continúa avanzando
- * Motor der retrocede, motor izq avanza
+ * @brief Arranca un giro de 180 grados
+ * Motor der retrocede, motor izq avanza; movimiento_actualizar() lo termina
  */
 brujula gira180(brujula sentido)
 {
-    set_motor_izq(MOTOR_AVANCE, velocidad_giro_actual_izq);
-    set_motor_der(MOTOR_RETROCESO, velocidad_giro_actual_der);
-
-    HAL_Delay(TIEMPO_GIRO_180);
+    iniciar_movimiento(MOVIMIENTO_GIRO, tiempo_giro_180, angulo_giro_180 * 100);
+    en_avance = false;
+    reiniciar_perfil();
+    set_motores(MOTOR_AVANCE, velocidad_giro_actual_izq, MOTOR_RETROCESO, velocidad_giro_actual_der);
     switch (sentido)
     {
     case norte:
@@ -212,8 +516,8 @@ brujula gira180(brujula sentido)
         break;
     }
 
-    // Después del giro, continuar avanzando
-    //avanza();
+    // Después del giro, continuar avanzando: lo hace movimiento_actualizar()
+
     return sentido;
 }
 
@@ -222,44 +526,106 @@ brujula gira180(brujula sentido)
  */
 void termino(void)
 {
-    set_motor_izq(MOTOR_FRENADO, 0);
-    set_motor_der(MOTOR_FRENADO, 0);
+    movimiento_cancelar();
+    en_avance = false;
+    reiniciar_perfil();
+    set_motores(MOTOR_FRENADO, 0, MOTOR_FRENADO, 0);
 }
 
 /**
- * @brief Aplica corrección hacia la izquierda para seguimiento de línea
- * @details Reduce velocidad del motor izquierdo temporalmente para corregir
- *          la trayectoria cuando el robot se desvía hacia la derecha
- * @note Se interrumpe automáticamente si se detecta línea
+ * @brief Avanza en recta durante un tiempo sin bloquear
+ * @param duracion_ms Duración del avance en milisegundos
+ * @details Reemplaza al HAL_Delay(TIEMPO_AVANCE_LINEA) de chequeolinea(): el
+ *          bucle principal sigue corriendo mientras el robot se centra
  */
-void correccion_izquierda(void)
+void movimiento_iniciar_avance(uint32_t duracion_ms)
+{
+    iniciar_movimiento(MOVIMIENTO_AVANCE, duracion_ms, (int32_t)distancia_avance_linea * 1000);
+    avanza();
+}
+
+/**
+ * @brief Avanza el ejecutor de movimientos
+ * @param ahora_ms Tiempo actual en milisegundos
+ * @return Movimiento que terminó en esta llamada, MOVIMIENTO_LIBRE si ninguno
+ *
+ * @details Cuando vence el plazo del movimiento en curso, o antes si con
+ *          ODOMETRIA_ENCODERS los encoders ya midieron su ángulo o distancia:
+ * - Giro: pone los motores a avanzar (como hacía antes quien llamaba al giro)
+ * - Avance y corrección: deja los motores como están
+ *
+ * @note La resta sin signo hace que funcione aunque HAL_GetTick() dé la vuelta
+ */
+estado_movimiento_t movimiento_actualizar(uint32_t ahora_ms)
 {
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, 100); // Motor izq más lento
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, 700); // Motor der normal
-     for (int i = 0; i < 7; i++)                       // 10 ciclos de 10 ms = 100 ms de corrección
+    estado_movimiento_t estado = estado_movimiento;
+
+    if (estado == MOVIMIENTO_LIBRE)
+    {
+        return MOVIMIENTO_LIBRE;
+    }
+    if ((uint32_t)(ahora_ms - inicio_movimiento) < duracion_movimiento && !objetivo_alcanzado(estado))
+    {
+        return MOVIMIENTO_LIBRE;
+    }
+
+    estado_movimiento = MOVIMIENTO_LIBRE;
+
+    if (estado == MOVIMIENTO_GIRO)
     {
-        if (flag_linea_detectada || flag_muro_detectado)
-            return; // Salir si hay algo urgente
+        avanza();
+    }
+
+    return estado;
+}
+
+/**
+ * @brief Estado actual del ejecutor de movimientos
+ */
+estado_movimiento_t movimiento_get_estado(void)
+{
+    return estado_movimiento;
+}
+
+/**
+ * @brief Indica si hay un giro o avance con plazo en curso
+ */
+bool movimiento_en_curso(void)
+{
+    estado_movimiento_t estado = estado_movimiento;
+    return estado == MOVIMIENTO_AVANCE || estado == MOVIMIENTO_GIRO;
+}
+
+/**
+ * @brief Descarta el movimiento en curso sin tocar los motores
+ */
+void movimiento_cancelar(void)
+{
+    estado_movimiento = MOVIMIENTO_LIBRE;
+}
 
-        HAL_Delay(10);
-    } 
+/**
+ * @brief Aplica corrección hacia la izquierda para seguimiento de línea
+ * @details Reduce velocidad del motor izquierdo durante tiempo_correccion para
+ *          corregir la trayectoria cuando el robot se desvía hacia la derecha
+ * @note No bloquea: si se detecta línea o muro, el movimiento siguiente la reemplaza
+ */
+void correccion_izquierda(void)
+{
+    set_motores(MOTOR_AVANCE, VELOCIDAD_CORRECCION_LENTA,   // Motor izq más lento
+                MOTOR_AVANCE, VELOCIDAD_CORRECCION_NORMAL); // Motor der normal
+    iniciar_movimiento(MOVIMIENTO_CORRECCION, tiempo_correccion, 0);
 }
 
 /**
  * @brief Aplica corrección hacia la derecha para seguimiento de línea
- * @details Reduce velocidad del motor derecho temporalmente para corregir
- *          la trayectoria cuando el robot se desvía hacia la izquierda
- * @note Se interrumpe automáticamente si se detecta línea o muro
+ * @details Reduce velocidad del motor derecho durante tiempo_correccion para
+ *          corregir la trayectoria cuando el robot se desvía hacia la izquierda
+ * @note No bloquea: si se detecta línea o muro, el movimiento siguiente la reemplaza
  */
 void correccion_derecha(void)
 {
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, 700); // Motor izq normal
-    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, 100); // Motor der más lento
-     for (int i = 0; i < 7; i++)                       // 10 ciclos de 10 ms = 100 ms de corrección
-    {
-        if (flag_linea_detectada || flag_muro_detectado)
-            return; // Salir si hay algo urgente
-
-        HAL_Delay(10);
-    } 
+    set_motores(MOTOR_AVANCE, VELOCIDAD_CORRECCION_NORMAL,  // Motor izq normal
+                MOTOR_AVANCE, VELOCIDAD_CORRECCION_LENTA);  // Motor der más lento
+    iniciar_movimiento(MOVIMIENTO_CORRECCION, tiempo_correccion, 0);
 }
@@ -6,70 +6,311 @@
 
 #include "laberinto.h"
 
+#ifdef USE_HAL_DRIVER
+#include "main.h" // DWT->CYCCNT para medir ciclos
+#define LEER_CICLOS() (DWT->CYCCNT)
+#else
+#define LEER_CICLOS() 0u // Fuera del micro (p. ej. en la PC) no se miden ciclos
+#endif
+
 /** @defgroup Laberinto_Variables Variables del laberinto
  * @brief Variables estáticas para representación interna del laberinto
  * @{
  */
 
-/** @brief Array bidimensional que representa el laberinto completo */
-static casilla_t laberinto[TAMAÑO_LABERINTO][TAMAÑO_LABERINTO];
+/** @brief Peso de cada casilla (distancia a la meta), indexado con LABERINTO_INDICE() */
+static peso_t pesos[CANTIDAD_CASILLAS];
+
+/**
+ * @brief Muros horizontales empaquetados, un bit por tramo
+ * @details La palabra h es la línea entre la fila h y la fila h + 1 (0 = borde norte,
+ *          FILAS_LABERINTO = borde sur); el bit columna - 1 es el tramo de esa columna.
+ *          Cada muro interior se guarda una sola vez y lo comparten las dos casillas.
+ */
+static mascara_fila_t muros_horizontales[FILAS_LABERINTO + 1];
+
+/**
+ * @brief Muros verticales empaquetados, un bit por tramo
+ * @details La palabra v es la línea entre la columna v y la columna v + 1 (0 = borde
+ *          oeste, COLUMNAS_LABERINTO = borde este); el bit fila - 1 es el tramo de esa fila.
+ */
+static mascara_columna_t muros_verticales[COLUMNAS_LABERINTO + 1];
+
+#if FLOOD_BITBOARD
+/**
+ * @brief Muros verticales vistos por fila (caché para el Flood Fill por bitboard)
+ * @details Bit columna - 1 de la palabra fila - 1 en 1 si hay muro al este de esa
+ *          casilla. Es la transpuesta de muros_verticales[] sin los bordes, para
+ *          poder desplazar filas enteras hacia el este o el oeste.
+ */
+static mascara_fila_t muros_este[FILAS_LABERINTO];
+#endif
+
+/**
+ * @brief Direcciones transitables de cada casilla (bit 1 << brujula)
+ * @details Caché derivada de los bordes y de los muros empaquetados: un bit en 1
+ *          significa que la vecina existe y no hay muro de por medio. Es lo único
+ *          que lee el lazo interno del Flood Fill.
+ */
+static uint8_t direcciones_libres[CANTIDAD_CASILLAS];
+
+/**
+ * @brief Salto de índice plano hacia la vecina en cada dirección
+ * @details Indexado por brujula: norte, este, sur, oeste
+ */
+static const int16_t desplazamiento_vecina[4] = {-COLUMNAS_LABERINTO, 1, COLUMNAS_LABERINTO, -1};
+
+/** @brief Casillas meta: el Flood Fill arranca desde todas a la vez */
+static indice_t metas[MAX_METAS];
+
+/** @brief Cantidad de casillas cargadas en metas[] */
+static uint8_t cantidad_metas = 0;
+
+/** @brief Cola circular del Flood Fill (cada casilla se encola una sola vez) */
+static indice_t cola_flood[TAMAÑO_COLA_FLOOD];
+
+/** @brief Ciclos de CPU consumidos por el último laberinto_recalcular_pesos() */
+static uint32_t ciclos_ultimo_flood = 0;
+
+/** @brief Casillas que perdieron su camino más corto al agregar un muro */
+static indice_t zona_afectada[TAMAÑO_COLA_FLOOD];
+
+/** @brief Marca de pertenencia a la zona afectada */
+static bool afectada[CANTIDAD_CASILLAS];
+
+/** @brief Marca de casilla presente en la cola de relajación */
+static bool en_cola[CANTIDAD_CASILLAS];
+
+/** @brief Ciclos de CPU consumidos por la última actualización incremental */
+static uint32_t ciclos_ultimo_muro = 0;
+
+/** @brief Discrepancias detectadas entre la actualización incremental y la completa */
+static uint32_t fallos_incremental = 0;
+
+#if VERIFICAR_FLOOD_INCREMENTAL
+/** @brief Copia de los pesos incrementales para contrastar con el recálculo completo */
+static peso_t pesos_verificacion[CANTIDAD_CASILLAS];
+#endif
 
 /**
  * @}
  */
 
+static inline bool muro_en(uint8_t fila, uint8_t columna, brujula direccion);
+#if FLOOD_BITBOARD
+static void flood_bitboard(void);
+#else
+static void flood_escalar(void);
+#endif
+static bool laberinto_tiene_padre(indice_t casilla);
+static void laberinto_repropagar_muro(indice_t a, indice_t b);
+
+/**
+ * @brief Carga una meta por defecto sin recalcular los pesos
+ * @details Como laberinto_agregar_meta(): una casilla que ya es meta no se repite
+ */
+static void cargar_meta_inicial(uint8_t fila, uint8_t columna)
+{
+    if (!laberinto_es_meta(fila, columna) && cantidad_metas < MAX_METAS)
+    {
+        metas[cantidad_metas++] = LABERINTO_INDICE(fila, columna);
+    }
+}
+
 /**
  * @brief Inicializa el laberinto con pesos por distancia Manhattan y sin muros
  * @details Configura cada casilla con:
- * - Identificación de posición (fila, columna)
- * - Peso inicial calculado como distancia Manhattan a la meta
  * - Sin muros inicialmente (laberinto abierto)
- * - Meta en (1,1) con peso 0
+ * - Direcciones libres: todas menos las que salen por el borde
+ * - Metas por defecto: (POSICION_META_FILA, POSICION_META_COLUMNA), o las
+ *   cuatro casillas centrales si se compila con META_CENTRAL
+ * - Peso inicial = distancia Manhattan a la meta más cercana (sin muros el
+ *   Flood Fill da exactamente eso)
+ * - Contador de ciclos DWT habilitado para medir el Flood Fill
  */
 void laberinto_init(void)
 {
-    // Inicializar cada casilla
-    for (uint8_t fila = 1; fila <= TAMAÑO_LABERINTO; fila++)
+#ifdef USE_HAL_DRIVER
+    // Habilitar el contador de ciclos para medir el Flood Fill
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+    // Inicializar sin muros (incluye los bordes)
+    for (uint8_t linea = 0; linea <= FILAS_LABERINTO; linea++)
+    {
+        muros_horizontales[linea] = 0;
+    }
+    for (uint8_t linea = 0; linea <= COLUMNAS_LABERINTO; linea++)
+    {
+        muros_verticales[linea] = 0;
+    }
+#if FLOOD_BITBOARD
+    for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+    {
+        muros_este[fila] = 0;
+    }
+#endif
+
+    // Máscara de bordes: sin muros solo se bloquea lo que sale del laberinto
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
     {
-        for (uint8_t columna = 1; columna <= TAMAÑO_LABERINTO; columna++)
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
         {
+            uint8_t libres = DIRECCION_BIT(norte) | DIRECCION_BIT(este) |
+                             DIRECCION_BIT(sur) | DIRECCION_BIT(oeste);
+
+            if (fila == 1)
+                libres &= ~DIRECCION_BIT(norte);
+            if (fila == FILAS_LABERINTO)
+                libres &= ~DIRECCION_BIT(sur);
+            if (columna == 1)
+                libres &= ~DIRECCION_BIT(oeste);
+            if (columna == COLUMNAS_LABERINTO)
+                libres &= ~DIRECCION_BIT(este);
+
+            direcciones_libres[LABERINTO_INDICE(fila, columna)] = libres;
+        }
+    }
 
-            // Configurar identificación
-            laberinto[fila - 1][columna - 1].posicion.fila = fila;
-            laberinto[fila - 1][columna - 1].posicion.columna = columna;
+    // Cargar las metas por defecto
+    cantidad_metas = 0;
+#ifdef META_CENTRAL
+    // Con una dimensión impar el centro es una sola fila o columna: no repetir casillas
+    cargar_meta_inicial((FILAS_LABERINTO + 1) / 2, (COLUMNAS_LABERINTO + 1) / 2);
+    cargar_meta_inicial((FILAS_LABERINTO + 1) / 2, (COLUMNAS_LABERINTO + 2) / 2);
+    cargar_meta_inicial((FILAS_LABERINTO + 2) / 2, (COLUMNAS_LABERINTO + 1) / 2);
+    cargar_meta_inicial((FILAS_LABERINTO + 2) / 2, (COLUMNAS_LABERINTO + 2) / 2);
+#else
+    cargar_meta_inicial(POSICION_META_FILA, POSICION_META_COLUMNA);
+#endif
+
+    // Pesos iniciales (distancia jaja sape a la meta más cercana)
+    laberinto_recalcular_pesos();
+}
 
-            // Calcular peso inicial (distancia jaja sape a la meta)
-            uint8_t distancia_fila = (fila > POSICION_META_FILA) ? (fila - POSICION_META_FILA) : (POSICION_META_FILA - fila);
-            uint8_t distancia_columna = (columna > POSICION_META_COLUMNA) ? (columna - POSICION_META_COLUMNA) : (POSICION_META_COLUMNA - columna);
+/**
+ * @brief Borra todas las metas
+ * @details Sin metas ninguna casilla es alcanzable: todos los pesos quedan en
+ *          PESO_MAXIMO hasta que se agregue alguna con laberinto_agregar_meta()
+ */
+void laberinto_limpiar_metas(void)
+{
+    cantidad_metas = 0;
+    laberinto_recalcular_pesos();
+}
 
-            laberinto[fila - 1][columna - 1].peso = distancia_fila + distancia_columna;
+/**
+ * @brief Agrega una casilla al conjunto de metas y recalcula los pesos
+ * @param fila Fila de la meta
+ * @param columna Columna de la meta
+ * @return true si se agregó (o ya era meta), false si la posición es inválida
+ *         o ya hay MAX_METAS cargadas
+ */
+bool laberinto_agregar_meta(uint8_t fila, uint8_t columna)
+{
+    if (!laberinto_posicion_valida(fila, columna))
+    {
+        return false;
+    }
 
-            // Inicializar sin muros
-            for (uint8_t dir = 0; dir < 4; dir++)
-            {
-                laberinto[fila - 1][columna - 1].muros[dir] = false;
-            }
+    if (laberinto_es_meta(fila, columna))
+    {
+        return true;
+    }
+
+    if (cantidad_metas >= MAX_METAS)
+    {
+        return false;
+    }
+
+    metas[cantidad_metas++] = LABERINTO_INDICE(fila, columna);
+    laberinto_recalcular_pesos();
+    return true;
+}
+
+/**
+ * @brief Indica si una casilla pertenece al conjunto de metas
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
+ * @return true si la casilla es una de las metas cargadas
+ */
+bool laberinto_es_meta(uint8_t fila, uint8_t columna)
+{
+    if (!laberinto_posicion_valida(fila, columna))
+    {
+        return false;
+    }
+
+    indice_t casilla = LABERINTO_INDICE(fila, columna);
+
+    for (uint8_t i = 0; i < cantidad_metas; i++)
+    {
+        if (metas[i] == casilla)
+        {
+            return true;
         }
     }
 
-    // La meta tiene peso 0
-    laberinto[POSICION_META_FILA - 1][POSICION_META_COLUMNA - 1].peso = 0;
+    return false;
 }
 
 /**
  * @brief Obtiene el peso de una casilla específica
- * @param fila Fila de la casilla 
- * @param columna Columna de la casilla 
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
  * @return Peso de la casilla, PESO_MAXIMO si posición inválida
  */
-uint8_t laberinto_get_peso(uint8_t fila, uint8_t columna)
+peso_t laberinto_get_peso(uint8_t fila, uint8_t columna)
 {
     if (!laberinto_posicion_valida(fila, columna))
     {
         return PESO_MAXIMO;
     }
 
-    return laberinto[fila - 1][columna - 1].peso;
+    return pesos[LABERINTO_INDICE(fila, columna)];
+}
+
+/**
+ * @brief Obtiene el peso de la casilla vecina en una dirección
+ * @param fila Fila de la casilla de referencia
+ * @param columna Columna de la casilla de referencia
+ * @param direccion Dirección de la vecina
+ * @return Peso de la vecina, PESO_MAXIMO si hay muro, borde o posición inválida
+ */
+peso_t laberinto_get_peso_adyacente(uint8_t fila, uint8_t columna, brujula direccion)
+{
+    if (!laberinto_posicion_valida(fila, columna))
+    {
+        return PESO_MAXIMO;
+    }
+
+    indice_t casilla = LABERINTO_INDICE(fila, columna);
+
+    if (!(direcciones_libres[casilla] & DIRECCION_BIT(direccion)))
+    {
+        return PESO_MAXIMO;
+    }
+
+    return pesos[casilla + desplazamiento_vecina[direccion]];
+}
+
+/**
+ * @brief Devuelve las direcciones transitables desde una casilla
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
+ * @return Máscara con DIRECCION_BIT(dir) en 1 si se puede avanzar hacia dir
+ *         (vecina dentro del laberinto y sin muro conocido), 0 si la posición es inválida
+ */
+uint8_t laberinto_get_direcciones_libres(uint8_t fila, uint8_t columna)
+{
+    if (!laberinto_posicion_valida(fila, columna))
+    {
+        return 0;
+    }
+
+    return direcciones_libres[LABERINTO_INDICE(fila, columna)];
 }
 
 /**
@@ -78,9 +319,12 @@ uint8_t laberinto_get_peso(uint8_t fila, uint8_t columna)
  * @param columna Columna donde se detectó el muro
  * @param direccion Dirección del muro detectado
  * @details Proceso completo:
- * 1. Marca el muro en la casilla actual
- * 2. Marca el muro opuesto en la casilla adyacente
- * 3. Recalcula todos los pesos con Flood Fill
+ * 1. Marca el tramo de muro compartido (vale para ambas casillas)
+ * 2. Cierra la dirección en la máscara de direcciones libres de ambas casillas
+ * 3. Repropaga los pesos solo en la zona afectada por el muro nuevo
+ *
+ * @note Si el muro ya era conocido o es un borde del laberinto no se recalcula nada
+ * @note Con VERIFICAR_FLOOD_INCREMENTAL se contrasta contra el Flood Fill completo
  */
 void laberinto_set_muro(uint8_t fila, uint8_t columna, brujula direccion)
 {
@@ -89,97 +333,495 @@ void laberinto_set_muro(uint8_t fila, uint8_t columna, brujula direccion)
         return;
     }
 
-    // Marcar muro en casilla actual
-    laberinto[fila - 1][columna - 1].muros[direccion] = true;
+    // Muro ya registrado: los pesos no cambian
+    if (muro_en(fila, columna, direccion))
+    {
+        return;
+    }
+
+    // Un solo bit representa el muro para las dos casillas
+    switch (direccion)
+    {
+    case norte:
+        muros_horizontales[fila - 1] |= (mascara_fila_t)1 << (columna - 1);
+        break;
+    case sur:
+        muros_horizontales[fila] |= (mascara_fila_t)1 << (columna - 1);
+        break;
+    case oeste:
+        muros_verticales[columna - 1] |= (mascara_columna_t)1 << (fila - 1);
+#if FLOOD_BITBOARD
+        if (columna > 1)
+        {
+            muros_este[fila - 1] |= (mascara_fila_t)1 << (columna - 2);
+        }
+#endif
+        break;
+    case este:
+        muros_verticales[columna] |= (mascara_columna_t)1 << (fila - 1);
+#if FLOOD_BITBOARD
+        muros_este[fila - 1] |= (mascara_fila_t)1 << (columna - 1);
+#endif
+        break;
+    }
 
-    // Marcar muro en casilla adyacente (si existe)
-    posicion_t pos_adyacente = laberinto_get_posicion_adyacente(
-        (posicion_t){fila, columna}, direccion);
+    indice_t casilla = LABERINTO_INDICE(fila, columna);
 
-    if (laberinto_posicion_valida(pos_adyacente.fila, pos_adyacente.columna))
+    if (!(direcciones_libres[casilla] & DIRECCION_BIT(direccion)))
     {
-        // Dirección opuesta
-        brujula direccion_opuesta = (direccion + 2) % 4;
-        laberinto[pos_adyacente.fila - 1][pos_adyacente.columna - 1].muros[direccion_opuesta] = true;
+        return; // Muro de borde: no separa casillas, los pesos no cambian
     }
 
-    // Recalcular pesos después de agregar muro
-    laberinto_recalcular_pesos();
+    // Dirección opuesta
+    brujula direccion_opuesta = (direccion + 2) % 4;
+    indice_t vecina = casilla + desplazamiento_vecina[direccion];
+
+    direcciones_libres[casilla] &= ~DIRECCION_BIT(direccion);
+    direcciones_libres[vecina] &= ~DIRECCION_BIT(direccion_opuesta);
+
+    // Actualizar pesos solo donde el muro puede cambiarlos
+    uint32_t ciclos_inicio = LEER_CICLOS();
+    laberinto_repropagar_muro(casilla, vecina);
+    ciclos_ultimo_muro = LEER_CICLOS() - ciclos_inicio;
+
+#if VERIFICAR_FLOOD_INCREMENTAL
+    // Guardar el resultado incremental y compararlo con el recálculo completo
+    for (indice_t i = 0; i < CANTIDAD_CASILLAS; i++)
+    {
+        pesos_verificacion[i] = pesos[i];
+    }
+
+    laberinto_recalcular_pesos(); // El completo queda como resultado válido
+
+    for (indice_t i = 0; i < CANTIDAD_CASILLAS; i++)
+    {
+        if (pesos_verificacion[i] != pesos[i])
+        {
+            fallos_incremental++;
+            return;
+        }
+    }
+#endif
 }
 
 /**
- * @brief Implementa el algoritmo Flood Fill para recalcular pesos
- * @details Algoritmo iterativo que propaga pesos desde la meta:
- * 1. Mantiene la meta con peso 0
- * 2. Para cada casilla, calcula peso = menor_peso_adyacente + 1
- * 3. Respeta muros existentes (no considera casillas bloqueadas)
- * 4. Itera hasta convergencia o máximo de iteraciones
+ * @brief Indica si una casilla conserva algún camino más corto hacia la meta
+ * @param casilla Índice plano de la casilla a revisar
+ * @return true si tiene una vecina accesible, no afectada, con peso - 1
+ */
+static bool laberinto_tiene_padre(indice_t casilla)
+{
+    peso_t peso_casilla = pesos[casilla];
+
+    if (peso_casilla == 0)
+    {
+        return true; // La meta no depende de nadie
+    }
+
+    uint8_t libres = direcciones_libres[casilla];
+
+    for (brujula dir = norte; dir <= oeste; dir++)
+    {
+        if (!(libres & DIRECCION_BIT(dir)))
+        {
+            continue;
+        }
+
+        indice_t vecina = casilla + desplazamiento_vecina[dir];
+
+        if (!afectada[vecina] && pesos[vecina] == peso_casilla - 1)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Repropaga los pesos después de cerrar el paso entre dos casillas
+ * @param a Casilla de un lado del muro nuevo
+ * @param b Casilla del otro lado del muro nuevo
+ * @details Agregar un muro solo puede aumentar distancias, y solo en casillas
+ *          cuyo camino más corto pasaba por ese muro. Se resuelve en dos fases:
+ * 1. Desde la casilla más lejana a la meta, marca como afectadas las casillas
+ *    que se quedaron sin vecina sana con peso - 1. Se recorre por capas de
+ *    distancia, así cada casilla se decide con sus "padres" ya clasificados.
+ * 2. Borra los pesos afectados, siembra cada casilla afectada desde sus
+ *    vecinas sanas y relaja con la cola circular hasta que no haya cambios.
  *
- * @note Protección contra bucles infinitos con MAX_ITERACIONES = 20
+ * @note Si los pesos de a y b no difieren en 1 el muro no cortaba ningún
+ *       camino más corto y no se toca nada
+ * @note Si la zona afectada pasa de ZONA_MAXIMA_INCREMENTAL casillas (un muro
+ *       que aísla buena parte del laberinto) se corta la fase 1 y se hace el
+ *       Flood Fill completo: las tres pasadas sobre cada casilla afectada
+ *       costaban hasta 4 veces más que él (Host/herramientas/velocidad_flood)
  */
-void laberinto_recalcular_pesos(void)
+static void laberinto_repropagar_muro(indice_t a, indice_t b)
 {
-    bool cambio_detectado = true;
-    uint8_t iteraciones = 0;
-    const uint8_t MAX_ITERACIONES = 20; // Evitar bucles infinitos Protección contra boludos
+    peso_t peso_a = pesos[a];
+    peso_t peso_b = pesos[b];
 
-    // Algoritmo Flood Fill iterativo
-    while (cambio_detectado && iteraciones < MAX_ITERACIONES)
+    indice_t origen;
+    if (peso_b != PESO_MAXIMO && peso_b == peso_a + 1)
+    {
+        origen = b;
+    }
+    else if (peso_a != PESO_MAXIMO && peso_a == peso_b + 1)
+    {
+        origen = a;
+    }
+    else
     {
-        cambio_detectado = false;
-        iteraciones++;
+        return; // Ningún camino más corto cruzaba este muro
+    }
+
+    if (laberinto_tiene_padre(origen))
+    {
+        return; // La casilla lejana tenía otro camino igual de corto
+    }
 
-        for (uint8_t fila = 1; fila <= TAMAÑO_LABERINTO; fila++) // se propaga desde (1,1) hacia afuera
+    // Fase 1: la lista de afectadas funciona como cola lineal (cada casilla entra una vez)
+    uint16_t cantidad_afectadas = 0;
+    afectada[origen] = true;
+    zona_afectada[cantidad_afectadas++] = origen;
+
+    for (uint16_t i = 0; i < cantidad_afectadas; i++)
+    {
+        indice_t actual = zona_afectada[i];
+        uint8_t libres = direcciones_libres[actual];
+
+        for (brujula dir = norte; dir <= oeste; dir++)
         {
-            for (uint8_t columna = 1; columna <= TAMAÑO_LABERINTO; columna++)
+            if (!(libres & DIRECCION_BIT(dir)))
             {
+                continue;
+            }
 
-                // No recalcular la meta
-                if (fila == POSICION_META_FILA && columna == POSICION_META_COLUMNA)
-                {
-                    continue;
-                }
+            indice_t vecina = actual + desplazamiento_vecina[dir];
 
-                uint8_t peso_minimo = PESO_MAXIMO;
+            // Solo los "hijos" de una casilla afectada pueden quedar afectados
+            if (afectada[vecina] || pesos[vecina] != pesos[actual] + 1)
+            {
+                continue;
+            }
 
-                // Verificar todas las direcciones adyacentes
-                for (brujula dir = norte; dir <= oeste; dir++)
+            if (!laberinto_tiene_padre(vecina))
+            {
+                if (cantidad_afectadas >= ZONA_MAXIMA_INCREMENTAL)
                 {
-
-                    // Saltar si hay muro en esta dirección
-                    if (laberinto[fila - 1][columna - 1].muros[dir])
+                    // Zona grande: recorrerla varias veces cuesta más que un Flood Fill completo
+                    for (uint16_t j = 0; j < cantidad_afectadas; j++)
                     {
-                        continue;
+                        afectada[zona_afectada[j]] = false;
                     }
+                    laberinto_recalcular_pesos();
+                    return;
+                }
 
-                    posicion_t pos_adyacente = laberinto_get_posicion_adyacente(
-                        (posicion_t){fila, columna}, dir);
+                afectada[vecina] = true;
+                zona_afectada[cantidad_afectadas++] = vecina;
+            }
+        }
+    }
 
-                    if (laberinto_posicion_valida(pos_adyacente.fila, pos_adyacente.columna))
-                    {
-                        uint8_t peso_adyacente = laberinto_get_peso(
-                            pos_adyacente.fila, pos_adyacente.columna);
+    // Fase 2: borrar los pesos de la zona afectada
+    for (uint16_t i = 0; i < cantidad_afectadas; i++)
+    {
+        pesos[zona_afectada[i]] = PESO_MAXIMO;
+    }
 
-                        if (peso_adyacente < peso_minimo)
-                        {
-                            peso_minimo = peso_adyacente;
-                        }
-                    }
-                }
+    uint16_t cabeza = 0;
+    uint16_t cola_fin = 0;
+
+    // Sembrar cada casilla afectada desde sus vecinas sanas
+    for (uint16_t i = 0; i < cantidad_afectadas; i++)
+    {
+        indice_t actual = zona_afectada[i];
+        uint8_t libres = direcciones_libres[actual];
+        peso_t peso_minimo = PESO_MAXIMO;
 
-                // Nuevo peso = menor peso adyacente + 1
-                uint8_t nuevo_peso = (peso_minimo == PESO_MAXIMO) ? PESO_MAXIMO : peso_minimo + 1;
+        for (brujula dir = norte; dir <= oeste; dir++)
+        {
+            if (!(libres & DIRECCION_BIT(dir)))
+            {
+                continue;
+            }
 
-                // Actualizar si hay cambio
-                if (nuevo_peso != laberinto[fila - 1][columna - 1].peso)
-                {
-                    laberinto[fila - 1][columna - 1].peso = nuevo_peso;
-                    cambio_detectado = true;
-                }
+            peso_t peso_adyacente = pesos[actual + desplazamiento_vecina[dir]];
+
+            if (peso_adyacente < peso_minimo)
+            {
+                peso_minimo = peso_adyacente;
+            }
+        }
+
+        if (peso_minimo != PESO_MAXIMO)
+        {
+            pesos[actual] = peso_minimo + 1;
+            en_cola[actual] = true;
+            cola_flood[cola_fin] = actual;
+            cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
+        }
+    }
+
+    // Relajar dentro de la zona afectada hasta que no haya mejoras
+    while (cabeza != cola_fin)
+    {
+        indice_t actual = cola_flood[cabeza];
+        cabeza = (cabeza + 1) % TAMAÑO_COLA_FLOOD;
+        en_cola[actual] = false;
+
+        uint8_t libres = direcciones_libres[actual];
+        peso_t peso_nuevo = pesos[actual] + 1;
+
+        for (brujula dir = norte; dir <= oeste; dir++)
+        {
+            if (!(libres & DIRECCION_BIT(dir)))
+            {
+                continue;
+            }
+
+            indice_t vecina = actual + desplazamiento_vecina[dir];
+
+            if (!afectada[vecina] || pesos[vecina] <= peso_nuevo)
+            {
+                continue;
+            }
+
+            pesos[vecina] = peso_nuevo;
+
+            if (!en_cola[vecina])
+            {
+                en_cola[vecina] = true;
+                cola_flood[cola_fin] = vecina;
+                cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
+            }
+        }
+    }
+
+    // Dejar las marcas limpias para el próximo muro
+    for (uint16_t i = 0; i < cantidad_afectadas; i++)
+    {
+        afectada[zona_afectada[i]] = false;
+    }
+}
+
+/**
+ * @brief Devuelve los ciclos de CPU que tardó la última actualización por muro
+ * @return Ciclos medidos con DWT->CYCCNT en el último laberinto_set_muro() que cambió el mapa
+ */
+uint32_t laberinto_get_ciclos_muro(void)
+{
+    return ciclos_ultimo_muro;
+}
+
+/**
+ * @brief Devuelve cuántas veces la actualización incremental no coincidió con el Flood Fill completo
+ * @return Cantidad de discrepancias (siempre 0 si VERIFICAR_FLOOD_INCREMENTAL está desactivado)
+ */
+uint32_t laberinto_get_fallos_incremental(void)
+{
+    return fallos_incremental;
+}
+
+/**
+ * @brief Recalcula todos los pesos del laberinto con el motor elegido al compilar
+ * @details Con FLOOD_BITBOARD en 1 usa el frente de onda por palabras de fila
+ *          (flood_bitboard()); si no, el BFS casilla por casilla (flood_escalar()).
+ *          Los dos dan exactamente los mismos pesos.
+ *
+ * @note Los ciclos de CPU de la última llamada se leen con laberinto_get_ciclos_flood()
+ */
+void laberinto_recalcular_pesos(void)
+{
+    uint32_t ciclos_inicio = LEER_CICLOS();
+
+#if FLOOD_BITBOARD
+    flood_bitboard();
+#else
+    flood_escalar();
+#endif
+
+    ciclos_ultimo_flood = LEER_CICLOS() - ciclos_inicio;
+}
+
+#if !FLOOD_BITBOARD
+/**
+ * @brief Flood Fill escalar: BFS casilla por casilla
+ * @details Recorrido en anchura (BFS) desde todas las metas a la vez:
+ * 1. Marca todas las casillas como no alcanzadas (PESO_MAXIMO)
+ * 2. Encola cada meta con peso 0, así el peso es la distancia a la más cercana
+ * 3. Saca una casilla de la cola y asigna peso + 1 a cada vecina
+ *    alcanzable (sin muro de por medio) que todavía no tenga peso
+ * 4. Encola cada vecina recién pesada y repite hasta vaciar la cola
+ *
+ * Cada casilla entra a la cola una sola vez, así que el costo es O(N²)
+ * para cualquier laberinto, sin importar cuántas vueltas tenga el camino.
+ * Las casillas encerradas por muros quedan con PESO_MAXIMO.
+ *
+ * El lazo interno trabaja con índices planos: la máscara direcciones_libres
+ * ya descarta bordes y muros, y la vecina sale de sumar desplazamiento_vecina,
+ * sin validar posiciones ni leer los muros empaquetados.
+ *
+ */
+static void flood_escalar(void)
+{
+    // Ninguna casilla alcanzada todavía
+    for (indice_t i = 0; i < CANTIDAD_CASILLAS; i++)
+    {
+        pesos[i] = PESO_MAXIMO;
+    }
+
+    uint16_t cabeza = 0;
+    uint16_t cola_fin = 0;
+
+    // Todas las metas son origen de la onda
+    for (uint8_t i = 0; i < cantidad_metas; i++)
+    {
+        pesos[metas[i]] = 0;
+        cola_flood[cola_fin] = metas[i];
+        cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
+    }
+
+    while (cabeza != cola_fin)
+    {
+        indice_t actual = cola_flood[cabeza];
+        cabeza = (cabeza + 1) % TAMAÑO_COLA_FLOOD;
+
+        uint8_t libres = direcciones_libres[actual];
+        peso_t peso_nuevo = pesos[actual] + 1;
+
+        for (brujula dir = norte; dir <= oeste; dir++)
+        {
+            if (!(libres & DIRECCION_BIT(dir)))
+            {
+                continue;
+            }
+
+            indice_t vecina = actual + desplazamiento_vecina[dir];
+
+            // Ya alcanzada por un camino igual o más corto
+            if (pesos[vecina] != PESO_MAXIMO)
+            {
+                continue;
             }
+
+            pesos[vecina] = peso_nuevo;
+            cola_flood[cola_fin] = vecina;
+            cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
         }
     }
 }
+#endif
+
+#if FLOOD_BITBOARD
+/** @brief Palabra de fila con un bit en 1 por cada columna del laberinto */
+#define FILA_COMPLETA ((mascara_fila_t)(0xFFFFFFFFu >> (32 - COLUMNAS_LABERINTO)))
+
+/**
+ * @brief Flood Fill por bitboard: crece el frente de onda de a una capa por vez
+ * @details Cada fila del laberinto es una palabra con un bit por columna. En cada
+ *          capa de distancia d, el frente (casillas con peso d) se expande con
+ *          desplazamientos y máscaras de muros, una fila entera por operación:
+ * - Este:  (frente & ~muros_este) << 1
+ * - Oeste: (frente >> 1) & ~muros_este
+ * - Sur:   frente de la fila de arriba & ~muro horizontal entre ambas
+ * - Norte: frente de la fila de abajo & ~muro horizontal entre ambas
+ *
+ *          Lo nuevo (sin visitar) recibe peso d + 1 y pasa a ser el frente.
+ *          Termina cuando una capa no agrega casillas. Las casillas que nunca
+ *          se alcanzan quedan con PESO_MAXIMO, igual que en flood_escalar().
+ */
+static void flood_bitboard(void)
+{
+    mascara_fila_t frente[FILAS_LABERINTO];
+    mascara_fila_t visitadas[FILAS_LABERINTO];
+    mascara_fila_t nuevas[FILAS_LABERINTO];
+
+    for (indice_t i = 0; i < CANTIDAD_CASILLAS; i++)
+    {
+        pesos[i] = PESO_MAXIMO;
+    }
+
+    for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+    {
+        frente[fila] = 0;
+    }
+
+    // Las metas forman la capa 0
+    for (uint8_t i = 0; i < cantidad_metas; i++)
+    {
+        pesos[metas[i]] = 0;
+        frente[metas[i] / COLUMNAS_LABERINTO] |= (mascara_fila_t)1 << (metas[i] % COLUMNAS_LABERINTO);
+    }
+
+    for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+    {
+        visitadas[fila] = frente[fila];
+    }
+
+    peso_t distancia = 0;
+    bool hay_nuevas = (cantidad_metas > 0);
+
+    while (hay_nuevas)
+    {
+        distancia++;
+        hay_nuevas = false;
+
+        for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+        {
+            mascara_fila_t f = frente[fila];
+            mascara_fila_t expansion = ((f & ~muros_este[fila]) << 1) | ((f >> 1) & ~muros_este[fila]);
+
+            // Desde la fila de arriba hacia el sur (muro horizontal de índice fila)
+            if (fila > 0)
+            {
+                expansion |= frente[fila - 1] & ~muros_horizontales[fila];
+            }
+
+            // Desde la fila de abajo hacia el norte (muro horizontal de índice fila + 1)
+            if (fila < FILAS_LABERINTO - 1)
+            {
+                expansion |= frente[fila + 1] & ~muros_horizontales[fila + 1];
+            }
+
+            nuevas[fila] = expansion & ~visitadas[fila] & FILA_COMPLETA;
+        }
+
+        for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+        {
+            mascara_fila_t bits = nuevas[fila];
+            frente[fila] = bits;
+            visitadas[fila] |= bits;
+
+            if (bits == 0)
+            {
+                continue;
+            }
+
+            hay_nuevas = true;
+
+            // Escribir el peso de cada casilla nueva de la fila
+            indice_t base = (indice_t)fila * COLUMNAS_LABERINTO;
+            while (bits)
+            {
+                pesos[base + __builtin_ctz(bits)] = distancia;
+                bits &= bits - 1;
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Devuelve los ciclos de CPU que tardó el último Flood Fill
+ * @return Ciclos medidos con el contador DWT->CYCCNT (0 si se compila sin el HAL)
+ */
+uint32_t laberinto_get_ciclos_flood(void)
+{
+    return ciclos_ultimo_flood;
+}
 
 /**
  * @brief Verifica si existe un muro en una dirección específica
@@ -195,7 +837,30 @@ bool laberinto_hay_muro(uint8_t fila, uint8_t columna, brujula direccion)
         return true; // Considerar bordes como muros
     }
 
-    return laberinto[fila - 1][columna - 1].muros[direccion];
+    return muro_en(fila, columna, direccion);
+}
+
+/**
+ * @brief Lee el bit de muro de una casilla ya validada
+ * @param fila Fila de la casilla (1 a FILAS_LABERINTO)
+ * @param columna Columna de la casilla (1 a COLUMNAS_LABERINTO)
+ * @param direccion Lado de la casilla a consultar
+ * @return true si el tramo de muro está marcado
+ */
+static inline bool muro_en(uint8_t fila, uint8_t columna, brujula direccion)
+{
+    switch (direccion)
+    {
+    case norte:
+        return (muros_horizontales[fila - 1] >> (columna - 1)) & 1u;
+    case sur:
+        return (muros_horizontales[fila] >> (columna - 1)) & 1u;
+    case oeste:
+        return (muros_verticales[columna - 1] >> (fila - 1)) & 1u;
+    case este:
+    default:
+        return (muros_verticales[columna] >> (fila - 1)) & 1u;
+    }
 }
 
 /**
@@ -231,10 +896,10 @@ posicion_t laberinto_get_posicion_adyacente(posicion_t pos_actual, brujula direc
  * @brief Valida si una posición está dentro de los límites del laberinto
  * @param fila Fila a validar
  * @param columna Columna a validar
- * @return true si la posición es válida (1 ≤ fila,columna ≤ 4), false en caso contrario
+ * @return true si la posición es válida (1 ≤ fila ≤ FILAS_LABERINTO, 1 ≤ columna ≤ COLUMNAS_LABERINTO)
  */
 bool laberinto_posicion_valida(uint8_t fila, uint8_t columna)
 {
-    return (fila >= 1 && fila <= TAMAÑO_LABERINTO &&
-            columna >= 1 && columna <= TAMAÑO_LABERINTO);
+    return (fila >= 1 && fila <= FILAS_LABERINTO &&
+            columna >= 1 && columna <= COLUMNAS_LABERINTO);
 }
\ No newline at end of file
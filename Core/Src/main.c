@@ -5,7 +5,8 @@
  * @brief          : Main program body
  * @author demianmozo
  * @date 2025-06-07
- * Este archivo contiene la función main y la lógica principal del robot.
+ * Este archivo contiene la función main y la inicialización de los periféricos;
+ * la lógica de la corrida está en recorrido.c.
  *
  * @section hardware Hardware utilizado
  * - STM32F407VG Discovery Board
@@ -31,16 +32,8 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-#include "antirebote.h"         ///< Funciones de antirebote para sensores
-#include "control_motor.h"      ///< Control de motores y PWM
-#include "laberinto.h"          ///< Representación y manejo del laberinto
-#include "navegacion.h"         ///< Algoritmos de navegación Flood Fill
-#include "control_linearecta.h" ///< Control PID para línea recta
-#include <stdint.h>             ///< Tipos de datos enteros estándar
-#include <stdbool.h>            ///< Tipo de dato booleano
-#include "uart.h"               ///< Comunicación UART para debugging
-#include <string.h>             ///< Funciones de manipulación de strings
-#include <stdio.h>              ///< Funciones de entrada/salida estándar
+#include "control_linearecta.h" ///< dma_buffer y BUFFER_TOTAL de los sensores IR
+#include "recorrido.h"          ///< Lógica de la corrida (exploración y sprint)
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -65,41 +58,17 @@ I2C_HandleTypeDef hi2c1;
 
 SPI_HandleTypeDef hspi1;
 
+TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim2;
 TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim6;
 
 UART_HandleTypeDef huart5;
+DMA_HandleTypeDef hdma_uart5_tx;
 
 /* USER CODE BEGIN PV */
-/** @defgroup Main_Variables Variables globales principales
- * @brief Variables globales utilizadas en el programa principal
- * @{
- */
-
-/** @brief Posición actual del robot */
-uint8_t fila_actual = 4, columna_actual = 4; ///< Fila y columna inicial  del robot (4;4)
-
-/** @brief Estado y orientación del robot */
-brujula sentido_actual = norte; ///< Orientación inicial del robot
-bool terminado = false;         ///< Flag que indica si el robot llegó a la meta
-
-/** @brief Control de timing y velocidad */
-uint16_t TIEMPO_AVANCE_LINEA = 250; ///< Tiempo de avance entre líneas (ms) - Exploración
-bool modo_sprint = false;           ///< Flag para modo de alta velocidad
-
 /** @brief Buffer para ADC con DMA */
 uint16_t dma_buffer[BUFFER_TOTAL]; ///< Buffer para lecturas ADC de sensores IR
-
-/** @brief Variables para control de interrupciones */
-volatile bool ultimo_estado_linea = true; ///< Último estado del sensor de línea (HIGH = no detectando)
-volatile bool ultimo_estado_muro = true;  ///< Último estado del sensor de muro (HIGH = no detectando)
-
-/** @brief Flags de interrupciones */
-volatile bool flag_linea_detectada = false; ///< Flag activado por ISR al detectar línea
-volatile bool flag_muro_detectado = false;  ///< Flag activado por ISR al detectar muro
-
-/**
- * @}
- */
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -111,64 +80,13 @@ static void MX_SPI1_Init(void);
 static void MX_ADC1_Init(void);
 static void MX_TIM3_Init(void);
 static void MX_UART5_Init(void);
+static void MX_TIM6_Init(void);
+static void MX_TIM1_Init(void);
+static void MX_TIM2_Init(void);
 void MX_USB_HOST_Process(void);
 
 /* USER CODE BEGIN PFP */
 
-/** @defgroup Main_Functions Prototipos de funciones principales
- * @brief Declaraciones de funciones implementadas en este archivo
- * @{
- */
-
-/**
- * @brief Procesa la detección de una línea
- * @details Actualiza posición, verifica meta, calcula nueva dirección y ejecuta movimiento
- */
-void chequeolinea(void);
-
-/**
- * @brief Procesa la detección de un muro
- * @details Registra el muro, recalcula pesos y ejecuta nuevo movimiento
- */
-void chequeomuro(void);
-
-/**
- * @brief Maneja el botón para modo sprint
- * @details Reinicia posición y activa modo de alta velocidad
- */
-void reset_posicion_pushbutton(void);
-
-/**
- * @brief Realiza auto-calibración inicial de sensores
- * @details Calibra los valores mínimos y máximos de los sensores IR
- */
-void auto_calibracion(void);
-
-/**
- * @brief Promedia las lecturas de los sensores IR
- * @param buffer Buffer con las lecturas DMA del ADC
- */
-void promediar_sensores(uint16_t *buffer);
-
-/**
- * @brief Controla el seguimiento de línea recta
- * @details Mantiene el robot centrado
- */
-void controlar_linea_recta(void);
-
-/**
- * @brief Aplica corrección hacia la izquierda
- */
-void correccion_izquierda(void);
-
-/**
- * @brief Aplica corrección hacia la derecha
- */
-void correccion_derecha(void);
-
-/**
- * @}
- */
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -214,28 +132,23 @@ int main(void)
   MX_ADC1_Init();
   MX_TIM3_Init();
   MX_UART5_Init();
+  MX_TIM6_Init();
+  MX_TIM1_Init();
+  MX_TIM2_Init();
   /* USER CODE BEGIN 2 */
   // Inicializar ADC con DMA primero
   HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
 
-  // Auto-calibración (sin motores activos)
-  auto_calibracion();
-
-  // Inicializar módulos
-  control_motor_init();
-  laberinto_init();
-  Inicializar_UART();
+  // Mapa y calibración, módulos y control lateral (ver recorrido.c)
+  recorrido_iniciar();
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   /**
    * @brief Bucle principal del programa
-   * @details Implementa la máquina de estados principal:
-   * - Control de línea recta
-   * - Procesamiento de interrupciones (línea > muro)
-   * - Verificación de botón de sprint
-   * - Verificación de estado terminado
+   * @details Cada vuelta atiende el USB y la máquina de estados de la corrida
+   *          (ver recorrido_paso())
    */
   while (1)
   {
@@ -243,29 +156,7 @@ int main(void)
     MX_USB_HOST_Process();
 
     /* USER CODE BEGIN 3 */
-    if (!terminado)
-    {
-      controlar_linea_recta();
-      // PROCESAR FLAGS CON PRIORIDAD: LÍNEA > MURO
-      if (flag_linea_detectada)
-      {
-        flag_linea_detectada = false;                            // Clear flag PRIMERO
-        chequeolinea();
-      }
-      if (GPIO_PIN_RESET == HAL_GPIO_ReadPin(WallSensor_GPIO_Port, WallSensor_Pin))
-      {
-        HAL_Delay(20);
-        if (HAL_GPIO_ReadPin(WallSensor_GPIO_Port, WallSensor_Pin) == GPIO_PIN_RESET)
-        {
-          chequeomuro();
-        }
-      }
-    }
-    else
-    {
-      termino(); // Robot detenido en meta
-    }
-    reset_posicion_pushbutton(); // ⚡ I AM SPEED button */
+    recorrido_paso(); // Movimientos, sensores, botón de sprint y comandos
     /* USER CODE END 3 */
   }
 }
@@ -444,6 +335,105 @@ static void MX_SPI1_Init(void)
   /* USER CODE END SPI1_Init 2 */
 }
 
+/**
+ * @brief TIM1 Initialization Function
+ * @param None
+ * @retval None
+ */
+static void MX_TIM1_Init(void)
+{
+
+  /* USER CODE BEGIN TIM1_Init 0 */
+
+  /* USER CODE END TIM1_Init 0 */
+
+  TIM_Encoder_InitTypeDef sConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM1_Init 1 */
+
+  /* USER CODE END TIM1_Init 1 */
+  htim1.Instance = TIM1;
+  htim1.Init.Prescaler = 0;
+  htim1.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim1.Init.Period = 65535;
+  htim1.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim1.Init.RepetitionCounter = 0;
+  htim1.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  sConfig.EncoderMode = TIM_ENCODERMODE_TI12;
+  sConfig.IC1Polarity = TIM_ICPOLARITY_RISING;
+  sConfig.IC1Selection = TIM_ICSELECTION_DIRECTTI;
+  sConfig.IC1Prescaler = TIM_ICPSC_DIV1;
+  sConfig.IC1Filter = 6;
+  sConfig.IC2Polarity = TIM_ICPOLARITY_RISING;
+  sConfig.IC2Selection = TIM_ICSELECTION_DIRECTTI;
+  sConfig.IC2Prescaler = TIM_ICPSC_DIV1;
+  sConfig.IC2Filter = 6;
+  if (HAL_TIM_Encoder_Init(&htim1, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim1, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM1_Init 2 */
+  // Encoder de la rueda derecha; lo arranca odometria_iniciar()
+  /* USER CODE END TIM1_Init 2 */
+
+}
+
+/**
+ * @brief TIM2 Initialization Function
+ * @param None
+ * @retval None
+ */
+static void MX_TIM2_Init(void)
+{
+
+  /* USER CODE BEGIN TIM2_Init 0 */
+
+  /* USER CODE END TIM2_Init 0 */
+
+  TIM_Encoder_InitTypeDef sConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM2_Init 1 */
+
+  /* USER CODE END TIM2_Init 1 */
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 0;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 65535;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim2.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  sConfig.EncoderMode = TIM_ENCODERMODE_TI12;
+  sConfig.IC1Polarity = TIM_ICPOLARITY_RISING;
+  sConfig.IC1Selection = TIM_ICSELECTION_DIRECTTI;
+  sConfig.IC1Prescaler = TIM_ICPSC_DIV1;
+  sConfig.IC1Filter = 6;
+  sConfig.IC2Polarity = TIM_ICPOLARITY_RISING;
+  sConfig.IC2Selection = TIM_ICSELECTION_DIRECTTI;
+  sConfig.IC2Prescaler = TIM_ICPSC_DIV1;
+  sConfig.IC2Filter = 6;
+  if (HAL_TIM_Encoder_Init(&htim2, &sConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM2_Init 2 */
+  // Encoder de la rueda izquierda; contador de 16 bits como el de TIM1
+  /* USER CODE END TIM2_Init 2 */
+
+}
+
 /**
  * @brief TIM3 Initialization Function
  * @param None
@@ -468,7 +458,7 @@ static void MX_TIM3_Init(void)
   htim3.Init.CounterMode = TIM_COUNTERMODE_UP;
   htim3.Init.Period = 999;
   htim3.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-  htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  htim3.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
   if (HAL_TIM_Base_Init(&htim3) != HAL_OK)
   {
     Error_Handler();
@@ -506,6 +496,44 @@ static void MX_TIM3_Init(void)
   HAL_TIM_MspPostInit(&htim3);
 }
 
+/**
+ * @brief TIM6 Initialization Function
+ * @param None
+ * @retval None
+ */
+static void MX_TIM6_Init(void)
+{
+
+  /* USER CODE BEGIN TIM6_Init 0 */
+
+  /* USER CODE END TIM6_Init 0 */
+
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  /* USER CODE BEGIN TIM6_Init 1 */
+
+  /* USER CODE END TIM6_Init 1 */
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = 83;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = 999;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  /* USER CODE BEGIN TIM6_Init 2 */
+  // El período real lo fija control_lazo_iniciar() según FRECUENCIA_CONTROL_HZ
+  /* USER CODE END TIM6_Init 2 */
+
+}
+
 /**
  * @brief UART5 Initialization Function
  * @param None
@@ -545,9 +573,13 @@ static void MX_DMA_Init(void)
 {
 
   /* DMA controller clock enable */
+  __HAL_RCC_DMA1_CLK_ENABLE();
   __HAL_RCC_DMA2_CLK_ENABLE();
 
   /* DMA interrupt init */
+  /* DMA1_Stream7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Stream7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Stream7_IRQn);
   /* DMA2_Stream0_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
@@ -695,184 +727,6 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
-/**
- * @brief Actualiza la posición del robot en el laberinto
- * @details Modifica las coordenadas del robot según la dirección de movimiento
- * @param fila Puntero a la fila actual (se modifica)
- * @param columna Puntero a la columna actual (se modifica)
- * @param sentido Orientación actual del robot
- *
- * @note Las coordenadas van de 1 a 4 para un laberinto 4x4
- */
-void actualizar_posicion(uint8_t *fila, uint8_t *columna, brujula sentido)
-{
-  switch (sentido)
-  {
-  case norte:
-    (*fila)--;
-    break;
-  case este:
-    (*columna)++;
-    break;
-  case sur:
-    (*fila)++;
-    break;
-  case oeste:
-    (*columna)--;
-    break;
-  }
-}
-
-/**
- * @brief Procesa la detección de una línea del laberinto
- * @details Secuencia completa de procesamiento al cruzar una línea:
- * 1. Desactiva interrupciones temporalmente
- * 2. Avanza el tiempo necesario para posicionarse
- * 3. Actualiza la posición del robot
- * 4. Verifica si llegó a la meta (1,1)
- * 5. Calcula la mejor dirección usando Flood Fill
- * 6. Ejecuta el movimiento necesario
- * 7. Reactiva interrupciones
- *
- * @note Usa TIEMPO_AVANCE_LINEA que varía según el modo (exploración/sprint)
- */
-void chequeolinea(void)
-{
-  HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
-  HAL_Delay(TIEMPO_AVANCE_LINEA); // por si es sprint o no
-
-  // Actualizar posición
-  actualizar_posicion(&fila_actual, &columna_actual, sentido_actual);
-
-  sprintf(mensaje, "%d,%d", fila_actual, columna_actual);
-  Transmision();
-
-  // terminó?
-  if (fila_actual == 1 && columna_actual == 1)
-  {
-    termino();
-    terminado = true;
-    strcpy(mensaje, "Finalizado");
-    Transmision();
-    return;
-  }
-
-  // Calcular y ejecutar
-  brujula sentido_deseado = calcular_mejor_direccion(fila_actual, columna_actual); // funcion definida en navegacion.h
-  sentido_actual = ejecutar_movimiento(sentido_actual, sentido_deseado);           // funcion definida en navegacion.h
-  avanza();
-
-  HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
-  HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_RESET);
-}
-
-/**
- * @brief Procesa la detección de un muro
- * @details Secuencia de procesamiento al detectar un obstáculo:
- * 1. Desactiva interrupciones
- * 2. Registra el muro en el mapa del laberinto
- * 3. Recalcula todos los pesos usando Flood Fill
- * 4. Calcula nueva mejor dirección
- * 5. Ejecuta el movimiento alternativo
- * 6. Reactiva interrupciones
- *
- * @note El algoritmo Flood Fill se ejecuta completamente tras cada muro detectado
- */
-void chequeomuro(void)
-{
-  HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
-
-  // 1. Registrar el muro detectado
-  laberinto_set_muro(fila_actual, columna_actual, sentido_actual);
-
-  // 2. Recalcular todos los pesos con el nuevo muro
-  laberinto_recalcular_pesos();
-
-  // 3. Calcular nueva mejor dirección
-  brujula sentido_deseado = calcular_mejor_direccion(fila_actual, columna_actual);
-
-  // 4. Ejecutar movimiento LO QUE HIZO EL COLO YA ACTUALIZA EL SENTIDO ACTUAL SOLO
-  sentido_actual = ejecutar_movimiento(sentido_actual, sentido_deseado);
-  avanza();
-
-  HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
-  HAL_GPIO_WritePin(LD6_GPIO_Port, LD6_Pin, GPIO_PIN_RESET);
-}
-
-/**
- * @brief Maneja el botón para activar modo sprint
- * @details Al presionar el botón "I AM SPEED":
- * 1. Reinicia la posición a (4,4) orientación norte
- * 2. Activa el modo sprint (mayor velocidad)
- * 3. Reduce el tiempo de avance entre líneas
- * 4. Resetea flags y estados de sensores
- * 5. Inicia el movimiento inmediatamente
- *
- * @note El robot mantiene el conocimiento del laberinto de la primera ejecución
- */
-void reset_posicion_pushbutton(void)
-{
-  if (antirebote(i_am_speed_GPIO_Port, i_am_speed_Pin))
-  {
-    HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
-
-    // Resetear posición
-    fila_actual = 4;
-    columna_actual = 4;
-    sentido_actual = norte;
-    terminado = false;
-
-    // ⚡ I AM SPEED!
-    activar_modo_sprint();     // Esta función está en control_motor.c
-    TIEMPO_AVANCE_LINEA = 400; // Reducir tiempo de avance a 400 ms
-
-    flag_linea_detectada = false;
-    flag_muro_detectado = false;
-
-    // Resetear estados de sensores
-    ultimo_estado_linea = true;
-    ultimo_estado_muro = true;
-
-    avanza();
-    // Reactivar interrupciones
-    HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
-  }
-}
-
-/**
- * @brief Rutina de atencion a la interrupción para sensores
- * @details ISR para interrupciones externas EXTI9_5. Implementa antirebote
- *          por hardware y activa flags para procesamiento en main loop
- * @param GPIO_Pin Pin que generó la interrupción
- *
- * @note Esta función implementa antirebote con delay no bloqueante
- */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
-{
-  if (GPIO_Pin == LineSensor_Pin)
-  {
-    static GPIO_PinState ultima_lectura_valida_linea = GPIO_PIN_SET;
-    GPIO_PinState lectura1, lectura2;
-
-    lectura1 = HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin);
-    if (lectura1 != ultima_lectura_valida_linea)
-    {
-      // Micro-delay en lugar de HAL_Delay (no bloquea tanto)
-      for (volatile int i = 0; i < 1000000; i++)
-        ; // ~20ms aprox
-
-      lectura2 = HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin);
-      if (lectura2 == lectura1)
-      {
-        ultima_lectura_valida_linea = lectura2;
-        if (ultima_lectura_valida_linea == GPIO_PIN_RESET)
-        {
-          flag_linea_detectada = true;
-        }
-      }
-    }
-  }
-}
 
 /* USER CODE END 4 */
 
@@ -5,6 +5,10 @@
  */
 
 #include "navegacion.h"
+#include "control_motor.h" // Giros y sus tiempos
+
+/** @brief Orden en que se evalúan las direcciones; en empate gana la primera */
+static const brujula orden_eval[4] = {ORDEN_EVALUACION};
 
 /**
  * @brief Calcula la mejor dirección para moverse basándose en los pesos del laberinto
@@ -13,49 +17,39 @@
  * @return Dirección óptima para moverse (norte, este, sur, oeste)
  *
  * @details Algoritmo de selección de dirección:
- * 1. Evalúa las 4 direcciones posibles en orden de preferencia: oeste, norte, sur, este
- * 2. Descarta direcciones bloqueadas por muros
- * 3. Descarta direcciones que salen del laberinto
- * 4. Selecciona la dirección con menor peso (más cerca de la meta)
- * 5. En caso de empate, da preferencia al orden de evaluación
- * 6. Incluye verificación de seguridad final
+ * 1. Evalúa las 4 direcciones posibles en orden de preferencia (ORDEN_EVALUACION,
+ *    por defecto oeste, norte, sur, este)
+ * 2. Descarta direcciones bloqueadas por muros o que salen del laberinto
+ *    (ambas cosas vienen en la máscara de direcciones libres)
+ * 3. Selecciona la dirección con menor peso (más cerca de la meta)
+ * 4. En caso de empate, da preferencia al orden de evaluación
+ * 5. Incluye verificación de seguridad final
  *
- * @note El orden de evaluación favorece movimientos hacia la meta (1,1)
+ * @note El orden de evaluación favorece movimientos hacia la meta (1,1) por defecto
  */
 brujula calcular_mejor_direccion(uint8_t fila_actual, uint8_t columna_actual) // nos devuelve direccion en TIPO BRUJULA gracias colo
 {
-    uint8_t peso_minimo = PESO_MAXIMO;
+    peso_t peso_minimo = PESO_MAXIMO;
     brujula mejor_direccion = norte; // Dirección por defecto
     bool direccion_valida_encontrada = false;
 
-    // Para dar preferencia a oeste y norte que llevan hacia la meta (1,1)
-    // Primero oeste, luego norte, luego sur, luego este
-    static const brujula orden_eval[] = {oeste, norte, sur, este};
+    // Bordes y muros conocidos de la casilla actual
+    uint8_t libres = laberinto_get_direcciones_libres(fila_actual, columna_actual);
 
     for (int i = 0; i < 4; i++)
     {
         brujula direccion = orden_eval[i];
 
-        // 1. ¿Hay muro en esta dirección?
-        if (laberinto_hay_muro(fila_actual, columna_actual, direccion))
+        // 1. ¿Hay muro o borde en esta dirección? (una sola máscara por casilla)
+        if (!(libres & DIRECCION_BIT(direccion)))
         {
-            continue; // Saltar si hay muro
+            continue; // Saltar si hay muro o se sale del laberinto
         }
 
-        // 2. Obtener posición adyacente
-        posicion_t pos_adyacente = laberinto_get_posicion_adyacente(
-            (posicion_t){fila_actual, columna_actual}, direccion);
-
-        // 3. ¿Es válida? (no salirse del laberinto)
-        if (!laberinto_posicion_valida(pos_adyacente.fila, pos_adyacente.columna))
-        {
-            continue; // Saltar si está fuera del laberinto
-        }
+        // 2. Obtener peso de la casilla adyacente
+        peso_t peso_adyacente = laberinto_get_peso_adyacente(fila_actual, columna_actual, direccion);
 
-        // 4. Obtener peso de la casilla adyacente
-        uint8_t peso_adyacente = laberinto_get_peso(pos_adyacente.fila, pos_adyacente.columna);
-
-        // 5. ¿Es el mejor peso hasta ahora? O primera dirección válida encontrada
+        // 3. ¿Es el mejor peso hasta ahora? O primera dirección válida encontrada
         if (!direccion_valida_encontrada || peso_adyacente < peso_minimo)
         {
             peso_minimo = peso_adyacente;
@@ -107,6 +101,7 @@ brujula calcular_mejor_direccion(uint8_t fila_actual, uint8_t columna_actual) //
  *
  * @note Utiliza aritmética modular para calcular la diferencia angular
  * @note Los valores de brújula son: norte=0, este=1, sur=2, oeste=3
+ * @note El giro solo se arranca; termina en movimiento_actualizar() (control_motor.h)
  */
 brujula ejecutar_movimiento(brujula sentido_actual, brujula sentido_deseado)
 {
@@ -136,4 +131,456 @@ brujula ejecutar_movimiento(brujula sentido_actual, brujula sentido_deseado)
         // avanza();
         return sentido_actual;
     }
-}
\ No newline at end of file
+}
+#if PLANIFICAR_CON_GIROS
+/** @brief Cantidad de estados (casilla, orientación) del planificador */
+#define CANTIDAD_ESTADOS (CANTIDAD_CASILLAS * 4)
+
+/** @brief Tiempo estimado a la meta de cada estado, índice casilla * 4 + orientación */
+static costo_t costo_a_meta[CANTIDAD_ESTADOS];
+
+/** @brief Montículo binario de estados pendientes, ordenado por costo_a_meta */
+static uint16_t monticulo[CANTIDAD_ESTADOS];
+
+/** @brief Posición de cada estado dentro del montículo (0xFFFF = fuera) */
+static uint16_t posicion_monticulo[CANTIDAD_ESTADOS];
+
+/** @brief Cantidad de estados en el montículo */
+static uint16_t tamaño_monticulo = 0;
+
+/** @brief Tiempo estimado para cruzar una casilla en recta (ms), de calcular_costos_movimiento() */
+static costo_t costo_avance_celda = 1;
+
+/** @brief Lo que se pierde al arrancar de nuevo después de un giro (ms) */
+static costo_t costo_arranque = 0;
+
+/**
+ * @brief Calcula los tiempos de avance y arranque con la velocidad actual
+ * @details La casilla son PERFIL_LARGO_CASILLA_MM a velocidad_actual_izq
+ *          (la de sprint después de activar_modo_sprint()), con la misma
+ *          conversión de PWM a mm/s que el perfil. Con perfil_velocidad el
+ *          robot sale de cada giro a PERFIL_VELOCIDAD_INICIAL y llega a la base
+ *          con PERFIL_ACELERACION_MAXIMA: pierde (base - inicial)² / (2 a base)
+ *          contra haber ido a la base todo el tramo. Sin perfil los motores
+ *          van directo a la base y el giro cuesta solo su tiempo.
+ */
+static void calcular_costos_movimiento(void)
+{
+    uint32_t base = velocidad_actual_izq ? velocidad_actual_izq : 1;
+
+    costo_avance_celda = PERFIL_LARGO_CASILLA_MM * 1000000u / (PERFIL_VELOCIDAD_1000_MM_S * base);
+    if (costo_avance_celda == 0)
+    {
+        costo_avance_celda = 1;
+    }
+
+    costo_arranque = 0;
+    if (perfil_velocidad && base > PERFIL_VELOCIDAD_INICIAL)
+    {
+        uint32_t diferencia = base - PERFIL_VELOCIDAD_INICIAL;
+        costo_arranque = diferencia * diferencia / (2u * PERFIL_ACELERACION_MAXIMA * base);
+    }
+}
+
+/**
+ * @brief Tiempo de pasar de una orientación a otra con los giros de control_motor.c
+ * @param desde Orientación actual
+ * @param hacia Orientación deseada
+ * @return Milisegundos del giro y del arranque posterior (0 si no hay que girar)
+ */
+static costo_t costo_giro(brujula desde, brujula hacia)
+{
+    switch ((hacia - desde + 4) % 4)
+    {
+    case 1:
+        return tiempo_giro_90_der + costo_arranque;
+    case 2:
+        return tiempo_giro_180 + costo_arranque;
+    case 3:
+        return tiempo_giro_90_izq + costo_arranque;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Intercambia dos entradas del montículo manteniendo las posiciones
+ */
+static void monticulo_intercambiar(uint16_t i, uint16_t j)
+{
+    uint16_t estado_i = monticulo[i];
+    monticulo[i] = monticulo[j];
+    monticulo[j] = estado_i;
+    posicion_monticulo[monticulo[i]] = i;
+    posicion_monticulo[monticulo[j]] = j;
+}
+
+/**
+ * @brief Sube un estado en el montículo hasta respetar el orden por costo
+ */
+static void monticulo_subir(uint16_t i)
+{
+    while (i > 0)
+    {
+        uint16_t padre = (i - 1) / 2;
+        if (costo_a_meta[monticulo[padre]] <= costo_a_meta[monticulo[i]])
+        {
+            break;
+        }
+        monticulo_intercambiar(i, padre);
+        i = padre;
+    }
+}
+
+/**
+ * @brief Saca el estado de menor costo del montículo
+ * @return Estado extraído
+ */
+static uint16_t monticulo_extraer(void)
+{
+    uint16_t minimo = monticulo[0];
+    posicion_monticulo[minimo] = 0xFFFF;
+    tamaño_monticulo--;
+
+    if (tamaño_monticulo > 0)
+    {
+        monticulo[0] = monticulo[tamaño_monticulo];
+        posicion_monticulo[monticulo[0]] = 0;
+
+        // Bajar la raíz hasta su lugar
+        uint16_t i = 0;
+        while (true)
+        {
+            uint16_t menor = i;
+            uint16_t izq = 2 * i + 1;
+            uint16_t der = 2 * i + 2;
+
+            if (izq < tamaño_monticulo && costo_a_meta[monticulo[izq]] < costo_a_meta[monticulo[menor]])
+                menor = izq;
+            if (der < tamaño_monticulo && costo_a_meta[monticulo[der]] < costo_a_meta[monticulo[menor]])
+                menor = der;
+            if (menor == i)
+                break;
+
+            monticulo_intercambiar(i, menor);
+            i = menor;
+        }
+    }
+
+    return minimo;
+}
+
+/**
+ * @brief Baja el costo de un estado y lo encola (o lo reubica si ya estaba)
+ */
+static void relajar_estado(uint16_t estado, costo_t costo)
+{
+    if (costo >= costo_a_meta[estado])
+    {
+        return;
+    }
+
+    costo_a_meta[estado] = costo;
+
+    if (posicion_monticulo[estado] == 0xFFFF)
+    {
+        monticulo[tamaño_monticulo] = estado;
+        posicion_monticulo[estado] = tamaño_monticulo;
+        tamaño_monticulo++;
+    }
+
+    monticulo_subir(posicion_monticulo[estado]);
+}
+
+/**
+ * @brief Calcula el tiempo estimado a la meta de todos los estados (casilla, orientación)
+ * @details Dijkstra hacia atrás desde las metas sobre el grafo de estados:
+ * - Llegar a una meta con cualquier orientación cuesta 0
+ * - Desde (c, h) el robot puede girar a h' y avanzar a la vecina n en h',
+ *   llegando a (n, h') con costo costo_giro(h, h') + costo_avance_celda
+ * - Los muros desconocidos se suponen abiertos, igual que en el Flood Fill
+ *
+ * Al sacar (n, h') del montículo se relajan los cuatro estados (c, h) de la
+ * casilla c de la que se llega a n avanzando hacia h'.
+ */
+static void planificar_costos(void)
+{
+    calcular_costos_movimiento();
+    tamaño_monticulo = 0;
+
+    for (uint16_t estado = 0; estado < CANTIDAD_ESTADOS; estado++)
+    {
+        costo_a_meta[estado] = COSTO_INFINITO;
+        posicion_monticulo[estado] = 0xFFFF;
+    }
+
+    // Sembrar todas las metas en todas las orientaciones
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (laberinto_es_meta(fila, columna))
+            {
+                for (brujula h = norte; h <= oeste; h++)
+                {
+                    relajar_estado(LABERINTO_INDICE(fila, columna) * 4 + h, 0);
+                }
+            }
+        }
+    }
+
+    while (tamaño_monticulo > 0)
+    {
+        uint16_t estado = monticulo_extraer();
+        indice_t casilla = estado / 4;
+        brujula llegada = estado % 4;
+        costo_t costo = costo_a_meta[estado];
+
+        uint8_t fila = casilla / COLUMNAS_LABERINTO + 1;
+        uint8_t columna = casilla % COLUMNAS_LABERINTO + 1;
+
+        // La casilla previa está del lado opuesto a la orientación de llegada
+        brujula hacia_previa = (llegada + 2) % 4;
+        if (!(laberinto_get_direcciones_libres(fila, columna) & DIRECCION_BIT(hacia_previa)))
+        {
+            continue;
+        }
+
+        posicion_t previa = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, hacia_previa);
+        indice_t casilla_previa = LABERINTO_INDICE(previa.fila, previa.columna);
+
+        for (brujula h = norte; h <= oeste; h++)
+        {
+            relajar_estado(casilla_previa * 4 + h, costo + costo_avance_celda + costo_giro(h, llegada));
+        }
+    }
+}
+
+/**
+ * @brief Tiempo estimado hasta la meta desde una casilla y orientación
+ * @param fila Fila de la casilla
+ * @param columna Columna de la casilla
+ * @param sentido Orientación del robot
+ * @return Milisegundos según el último plan, COSTO_INFINITO si no hay camino o posición inválida
+ */
+costo_t navegacion_get_costo_estimado(uint8_t fila, uint8_t columna, brujula sentido)
+{
+    if (!laberinto_posicion_valida(fila, columna))
+    {
+        return COSTO_INFINITO;
+    }
+
+    return costo_a_meta[LABERINTO_INDICE(fila, columna) * 4 + sentido];
+}
+#endif
+
+/**
+ * @brief Elige la dirección según el último plan calculado
+ * @details Mismo criterio que calcular_mejor_direccion_orientada() pero sin
+ *          recalcular el plan, para recorrer una ruta entera con un solo
+ *          planificar_costos()
+ */
+static brujula elegir_direccion(uint8_t fila_actual, uint8_t columna_actual, brujula sentido_actual)
+{
+#if PLANIFICAR_CON_GIROS
+    uint8_t libres = laberinto_get_direcciones_libres(fila_actual, columna_actual);
+    costo_t costo_minimo = COSTO_INFINITO;
+    brujula mejor_direccion = sentido_actual;
+
+    for (int i = 0; i < 4; i++)
+    {
+        brujula direccion = orden_eval[i];
+
+        if (!(libres & DIRECCION_BIT(direccion)))
+        {
+            continue;
+        }
+
+        posicion_t vecina = laberinto_get_posicion_adyacente((posicion_t){fila_actual, columna_actual}, direccion);
+        costo_t costo_vecina = navegacion_get_costo_estimado(vecina.fila, vecina.columna, direccion);
+
+        if (costo_vecina == COSTO_INFINITO)
+        {
+            continue;
+        }
+
+        costo_t costo = costo_giro(sentido_actual, direccion) + costo_avance_celda + costo_vecina;
+
+        if (costo < costo_minimo)
+        {
+            costo_minimo = costo;
+            mejor_direccion = direccion;
+        }
+    }
+
+    if (costo_minimo != COSTO_INFINITO)
+    {
+        return mejor_direccion;
+    }
+#else
+    (void)sentido_actual;
+#endif
+
+    return calcular_mejor_direccion(fila_actual, columna_actual);
+}
+
+/**
+ * @brief Calcula la mejor dirección teniendo en cuenta la orientación del robot
+ * @param fila_actual Fila actual del robot
+ * @param columna_actual Columna actual del robot
+ * @param sentido_actual Orientación actual del robot
+ * @return Dirección hacia la que conviene girar y avanzar
+ *
+ * @details Con PLANIFICAR_CON_GIROS:
+ * 1. Recalcula el tiempo estimado a la meta de cada estado (casilla, orientación)
+ * 2. Para cada dirección libre suma giro + avance + tiempo desde la vecina
+ * 3. Elige la de menor tiempo; en empate respeta el mismo orden de evaluación
+ *    que calcular_mejor_direccion()
+ *
+ * Así prefiere un camino con una casilla más pero sin media vuelta (1100 ms)
+ * frente a uno más corto en casillas pero con más giros.
+ *
+ * @note Sin PLANIFICAR_CON_GIROS, o si no hay camino conocido, usa calcular_mejor_direccion()
+ */
+brujula calcular_mejor_direccion_orientada(uint8_t fila_actual, uint8_t columna_actual, brujula sentido_actual)
+{
+#if PLANIFICAR_CON_GIROS
+    planificar_costos();
+#endif
+
+    return elegir_direccion(fila_actual, columna_actual, sentido_actual);
+}
+
+/** @brief Ruta de sprint compilada */
+static comando_t ruta[MAX_COMANDOS_RUTA];
+
+/** @brief Cantidad de comandos de la ruta */
+static uint16_t cantidad_comandos = 0;
+
+/**
+ * @brief Agrega un comando al final de la ruta
+ * @return false si la ruta ya está llena
+ */
+static bool agregar_comando(tipo_comando_t tipo, uint8_t casillas)
+{
+    if (cantidad_comandos >= MAX_COMANDOS_RUTA)
+    {
+        return false;
+    }
+
+    ruta[cantidad_comandos].tipo = (uint8_t)tipo;
+    ruta[cantidad_comandos].casillas = casillas;
+    cantidad_comandos++;
+    return true;
+}
+
+/**
+ * @brief Compila el camino desde una casilla hasta la meta en comandos de movimiento
+ * @param fila Fila de partida
+ * @param columna Columna de partida
+ * @param sentido Orientación de partida
+ * @return Cantidad de comandos de la ruta, 0 si no se pudo compilar
+ *
+ * @details Simula el recorrido que haría la exploración sobre el mapa actual:
+ * 1. Elige la dirección de cada casilla igual que calcular_mejor_direccion_orientada()
+ *    (con PLANIFICAR_CON_GIROS el plan se calcula una sola vez)
+ * 2. Si hay que cambiar de orientación agrega el giro correspondiente
+ * 3. Cada avance se suma al último COMANDO_AVANZAR si lo hay, así una recta
+ *    de N casillas queda en un solo comando
+ *
+ * Ejemplo: "avanzar 3, derecha, avanzar 2, izquierda, avanzar 1".
+ *
+ * @note Los pesos bajan en cada paso, así que el recorrido no puede ciclar;
+ *       igual se corta a CANTIDAD_CASILLAS pasos por seguridad
+ */
+uint16_t navegacion_compilar_ruta(uint8_t fila, uint8_t columna, brujula sentido)
+{
+    static const tipo_comando_t giro_por_diferencia[] = {COMANDO_AVANZAR, COMANDO_GIRO_DER, COMANDO_GIRO_180, COMANDO_GIRO_IZQ};
+
+    cantidad_comandos = 0;
+
+    if (laberinto_get_peso(fila, columna) == PESO_MAXIMO)
+    {
+        return 0; // Sin camino conocido a la meta
+    }
+
+#if PLANIFICAR_CON_GIROS
+    planificar_costos();
+#endif
+
+    for (uint16_t pasos = 0; !laberinto_es_meta(fila, columna); pasos++)
+    {
+        brujula direccion = elegir_direccion(fila, columna, sentido);
+
+        if (pasos >= CANTIDAD_CASILLAS || !(laberinto_get_direcciones_libres(fila, columna) & DIRECCION_BIT(direccion)))
+        {
+            cantidad_comandos = 0;
+            return 0;
+        }
+
+        // 1. Giro si cambia la orientación
+        if (direccion != sentido)
+        {
+            if (!agregar_comando(giro_por_diferencia[(direccion - sentido + 4) % 4], 0))
+            {
+                cantidad_comandos = 0;
+                return 0;
+            }
+            sentido = direccion;
+        }
+
+        // 2. Avance, juntando las rectas
+        comando_t *ultimo = (cantidad_comandos > 0) ? &ruta[cantidad_comandos - 1] : NULL;
+        if (ultimo != NULL && ultimo->tipo == COMANDO_AVANZAR && ultimo->casillas < UINT8_MAX)
+        {
+            ultimo->casillas++;
+        }
+        else if (!agregar_comando(COMANDO_AVANZAR, 1))
+        {
+            cantidad_comandos = 0;
+            return 0;
+        }
+
+        posicion_t siguiente = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, direccion);
+        fila = siguiente.fila;
+        columna = siguiente.columna;
+    }
+
+    return cantidad_comandos;
+}
+
+/**
+ * @brief Devuelve la lista de comandos de la última ruta compilada
+ * @return Puntero a los comandos; la cantidad la devuelve navegacion_compilar_ruta()
+ */
+const comando_t *navegacion_get_ruta(void)
+{
+    return ruta;
+}
+
+/**
+ * @brief Ejecuta un comando de giro de la ruta con los giros de control_motor.c
+ * @param sentido_actual Orientación actual del robot
+ * @param comando Comando a ejecutar
+ * @return Nueva orientación del robot
+ *
+ * @note COMANDO_AVANZAR no hace nada acá: el avance lo maneja quien recorre la ruta
+ * @note Como ejecutar_movimiento(), solo arranca el giro
+ */
+brujula ejecutar_comando_giro(brujula sentido_actual, comando_t comando)
+{
+    switch (comando.tipo)
+    {
+    case COMANDO_GIRO_DER:
+        return gira90der(sentido_actual);
+
+    case COMANDO_GIRO_IZQ:
+        return gira90izq(sentido_actual);
+
+    case COMANDO_GIRO_180:
+        return gira180(sentido_actual);
+
+    default:
+        return sentido_actual;
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * @file odometria.c
+ * @brief Implementación de la odometría con encoders de cuadratura
+ * @author demianmozo
+ */
+
+#include "odometria.h"
+#include <stdbool.h>
+
+#ifdef USE_HAL_DRIVER
+#include "main.h"
+extern TIM_HandleTypeDef htim1; // Encoder derecho
+extern TIM_HandleTypeDef htim2; // Encoder izquierdo
+#define CONTADOR_IZQ() ((uint16_t)htim2.Instance->CNT)
+#define CONTADOR_DER() ((uint16_t)htim1.Instance->CNT)
+#else
+static uint16_t contador_simulado_izq = 0;
+static uint16_t contador_simulado_der = 0;
+#define CONTADOR_IZQ() (contador_simulado_izq)
+#define CONTADOR_DER() (contador_simulado_der)
+#endif
+
+/* Última lectura de cada contador, para sacar la diferencia con la siguiente */
+static uint16_t anterior_izq = 0;
+static uint16_t anterior_der = 0;
+
+/* Acumulados: los escribe solo odometria_actualizar(), se leen de a 32 bits */
+static volatile int32_t pulsos_izq = 0;
+static volatile int32_t pulsos_der = 0;
+static volatile int32_t distancia_um = 0;
+static volatile int32_t angulo_mgrados = 0;
+
+/**
+ * @brief Arranca los dos timers en modo encoder y pone la odometría a cero
+ */
+void odometria_iniciar(void)
+{
+#ifdef USE_HAL_DRIVER
+    HAL_TIM_Encoder_Start(&htim2, TIM_CHANNEL_ALL);
+    HAL_TIM_Encoder_Start(&htim1, TIM_CHANNEL_ALL);
+#endif
+
+    anterior_izq = CONTADOR_IZQ();
+    anterior_der = CONTADOR_DER();
+    pulsos_izq = 0;
+    pulsos_der = 0;
+    distancia_um = 0;
+    angulo_mgrados = 0;
+}
+
+/**
+ * @brief Lee los contadores y acumula los pulsos de cada rueda
+ *
+ * @details
+ * - La resta en 16 bits pasada a int16_t da el avance con signo aunque el
+ *   contador haya dado la vuelta
+ * - Distancia = (izq + der) / 2 * pi * diámetro / pulsos por vuelta
+ *   (pi como 355/113)
+ * - Ángulo en radianes = (der - izq) * pi * diámetro / (pulsos por vuelta * trocha);
+ *   en grados pi se cancela con los 180 / pi
+ * - Se recalcula desde los pulsos totales: el redondeo no se acumula
+ */
+void odometria_actualizar(void)
+{
+    uint16_t contador_izq = CONTADOR_IZQ();
+    uint16_t contador_der = CONTADOR_DER();
+
+    int32_t total_izq = pulsos_izq + ODOMETRIA_SIGNO_IZQ * (int16_t)(uint16_t)(contador_izq - anterior_izq);
+    int32_t total_der = pulsos_der + ODOMETRIA_SIGNO_DER * (int16_t)(uint16_t)(contador_der - anterior_der);
+    anterior_izq = contador_izq;
+    anterior_der = contador_der;
+
+    pulsos_izq = total_izq;
+    pulsos_der = total_der;
+    distancia_um = (int32_t)(((int64_t)(total_izq + total_der) * ODOMETRIA_DIAMETRO_RUEDA_UM * 355) /
+                             (2LL * ODOMETRIA_PULSOS_POR_VUELTA * 113));
+    angulo_mgrados = (int32_t)(((int64_t)(total_der - total_izq) * ODOMETRIA_DIAMETRO_RUEDA_UM * 180000) /
+                               ((int64_t)ODOMETRIA_PULSOS_POR_VUELTA * ODOMETRIA_TROCHA_UM));
+}
+
+/**
+ * @brief Distancia recorrida por el centro del robot
+ */
+int32_t odometria_get_distancia_um(void)
+{
+    return distancia_um;
+}
+
+/**
+ * @brief Rumbo acumulado, positivo hacia la izquierda
+ */
+int32_t odometria_get_angulo_mgrados(void)
+{
+    return angulo_mgrados;
+}
+
+/**
+ * @brief Pulsos acumulados de cada rueda
+ * @note Con interrupciones deshabilitadas para que los dos sean de la misma lectura
+ */
+void odometria_get_pulsos(int32_t *izq, int32_t *der)
+{
+#ifdef USE_HAL_DRIVER
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+#endif
+    *izq = pulsos_izq;
+    *der = pulsos_der;
+#ifdef USE_HAL_DRIVER
+    __set_PRIMASK(primask);
+#endif
+}
+
+#ifndef USE_HAL_DRIVER
+/**
+ * @brief Mueve los contadores simulados
+ */
+void odometria_simular_pulsos(int16_t izq, int16_t der)
+{
+    contador_simulado_izq = (uint16_t)(contador_simulado_izq + izq);
+    contador_simulado_der = (uint16_t)(contador_simulado_der + der);
+}
+#endif
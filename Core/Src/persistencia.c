@@ -0,0 +1,353 @@
+/**
+ * @file persistencia.c
+ * @brief Implementación del guardado en flash con registros rotativos y CRC32
+ * @author demianmozo
+ */
+
+#include "persistencia.h"
+#include "laberinto.h"
+#include "control_motor.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef USE_HAL_DRIVER
+#include "main.h"
+#define DIRECCION_SECTOR 0x080E0000u ///< Comienzo del sector 11
+#define SECTOR_PERSISTENCIA FLASH_SECTOR_11
+#define IMAGEN ((const uint8_t *)DIRECCION_SECTOR)
+#else
+static uint8_t imagen_simulada[TAMAÑO_SECTOR_PERSISTENCIA];
+static bool imagen_lista = false; // El arreglo arranca en 0: hay que "borrarlo" la primera vez
+#define IMAGEN ((const uint8_t *)persistencia_get_imagen())
+#endif
+
+#define MAGIA_REGISTRO 0x3142414Cu ///< "LAB1" en little endian
+#define VERSION_REGISTRO 2            ///< Subir al cambiar registro_flash_t o parametros_guardados
+#define CANTIDAD_PARAMETROS_GUARDADOS 16
+
+/* Umbrales de los sensores IR (control_linearecta.c) */
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+extern bool calibrado;
+
+/* Ganancias y límite del PID lateral (control_linearecta.c) */
+extern uint16_t pid_kp, pid_ki, pid_kd, pid_salida_maxima;
+
+/* Avance que toma el sprint (recorrido.c) */
+extern uint16_t tiempo_avance_sprint;
+
+/**
+ * @brief Un guardado completo
+ * @details Termina en el CRC32 de uint32_t, así el tamaño es múltiplo de 4 y
+ *          se escribe de a palabras
+ */
+typedef struct
+{
+    uint32_t magia;       ///< MAGIA_REGISTRO
+    uint32_t secuencia;   ///< Aumenta en 1 por guardado
+    uint8_t filas;        ///< FILAS_LABERINTO con que se guardó
+    uint8_t columnas;     ///< COLUMNAS_LABERINTO con que se guardó
+    uint8_t explorado;    ///< 1 = el mapa sirve para el sprint
+    uint8_t version;      ///< VERSION_REGISTRO con que se guardó
+    uint16_t calibracion[6];                            ///< izq cerca/lejos/centrado, der cerca/lejos/centrado
+    uint16_t parametros[CANTIDAD_PARAMETROS_GUARDADOS]; ///< Ver parametros_guardados
+    uint8_t muros[(CANTIDAD_CASILLAS + 1) / 2];         ///< Un nibble por casilla, DIRECCION_BIT()
+    uint32_t crc;                                       ///< CRC32 de todo lo anterior
+} registro_flash_t;
+
+#define CANTIDAD_RANURAS (TAMAÑO_SECTOR_PERSISTENCIA / sizeof(registro_flash_t))
+
+/** @brief Variables que se guardan, en el orden de registro_flash_t.parametros */
+static uint16_t *const parametros_guardados[CANTIDAD_PARAMETROS_GUARDADOS] = {
+    &velocidad_sprint_izq,
+    &velocidad_sprint_der,
+    &velocidad_giro_actual_izq,
+    &velocidad_giro_actual_der,
+    &tiempo_giro_90_izq,
+    &tiempo_giro_90_der,
+    &tiempo_giro_180,
+    &tiempo_correccion,
+    &tiempo_avance_sprint,
+    &pid_kp,
+    &pid_ki,
+    &pid_kd,
+    &pid_salida_maxima,
+    &angulo_giro_90,
+    &angulo_giro_180,
+    &distancia_avance_linea,
+};
+
+/** @brief Secuencia del último registro válido (0 = ninguno) */
+static uint32_t ultima_secuencia = 0;
+
+/**
+ * @brief CRC32 (polinomio reflejado 0xEDB88320), bit a bit
+ * @note Se calcula una vez por guardado o arranque: no hace falta tabla
+ */
+static uint32_t crc32(const uint8_t *datos, size_t largo)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < largo; i++)
+    {
+        crc ^= datos[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief Borra el sector entero (todo a 0xFF)
+ */
+static bool flash_borrar(void)
+{
+#ifdef USE_HAL_DRIVER
+    FLASH_EraseInitTypeDef borrado = {0};
+    uint32_t sector_con_error;
+
+    borrado.TypeErase = FLASH_TYPEERASE_SECTORS;
+    borrado.Sector = SECTOR_PERSISTENCIA;
+    borrado.NbSectors = 1;
+    borrado.VoltageRange = FLASH_VOLTAGE_RANGE_3; // 2.7 a 3.6 V: de a 32 bits
+
+    HAL_FLASH_Unlock();
+    __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR |
+                           FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+    HAL_StatusTypeDef estado = HAL_FLASHEx_Erase(&borrado, &sector_con_error);
+    HAL_FLASH_Lock();
+
+    return estado == HAL_OK;
+#else
+    memset(imagen_simulada, 0xFF, sizeof(imagen_simulada));
+    imagen_lista = true;
+    return true;
+#endif
+}
+
+/**
+ * @brief Escribe palabras a partir de un desplazamiento del sector
+ * @note Las palabras tienen que estar borradas: la flash solo baja bits
+ */
+static bool flash_escribir(uint32_t desplazamiento, const uint32_t *palabras, uint32_t cantidad)
+{
+#ifdef USE_HAL_DRIVER
+    HAL_StatusTypeDef estado = HAL_OK;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < cantidad && estado == HAL_OK; i++)
+    {
+        estado = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, DIRECCION_SECTOR + desplazamiento + 4 * i, palabras[i]);
+    }
+    HAL_FLASH_Lock();
+
+    return estado == HAL_OK;
+#else
+    persistencia_get_imagen();
+    for (uint32_t i = 0; i < cantidad; i++)
+    {
+        uint32_t palabra;
+        memcpy(&palabra, &imagen_simulada[desplazamiento + 4 * i], 4);
+        palabra &= palabras[i];
+        memcpy(&imagen_simulada[desplazamiento + 4 * i], &palabra, 4);
+    }
+    return true;
+#endif
+}
+
+#ifndef USE_HAL_DRIVER
+/**
+ * @brief Imagen de la flash simulada (se crea borrada)
+ */
+uint8_t *persistencia_get_imagen(void)
+{
+    if (!imagen_lista)
+    {
+        flash_borrar();
+    }
+    return imagen_simulada;
+}
+#endif
+
+/**
+ * @brief Registro de una ranura del sector
+ */
+static const registro_flash_t *ranura(uint32_t indice)
+{
+    return (const registro_flash_t *)(IMAGEN + indice * sizeof(registro_flash_t));
+}
+
+/**
+ * @brief Indica si un registro es íntegro, de este laberinto y de este formato
+ * @note Un registro de otra versión del firmware se ignora entero: con otro
+ *       orden de parametros_guardados cargaría valores en variables ajenas
+ */
+static bool registro_valido(const registro_flash_t *registro)
+{
+    return registro->magia == MAGIA_REGISTRO && registro->version == VERSION_REGISTRO &&
+           registro->filas == FILAS_LABERINTO && registro->columnas == COLUMNAS_LABERINTO &&
+           registro->crc == crc32((const uint8_t *)registro, offsetof(registro_flash_t, crc));
+}
+
+/**
+ * @brief Indica si una ranura está sin escribir desde el último borrado
+ */
+static bool ranura_libre(uint32_t indice)
+{
+    const uint32_t *palabras = (const uint32_t *)ranura(indice);
+
+    for (uint32_t i = 0; i < sizeof(registro_flash_t) / 4; i++)
+    {
+        if (palabras[i] != 0xFFFFFFFFu)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Busca el registro válido más nuevo
+ * @return El registro, NULL si no hay ninguno
+ */
+static const registro_flash_t *buscar_ultimo(void)
+{
+    const registro_flash_t *ultimo = NULL;
+
+    for (uint32_t i = 0; i < CANTIDAD_RANURAS; i++)
+    {
+        const registro_flash_t *registro = ranura(i);
+
+        if (registro_valido(registro) && (ultimo == NULL || registro->secuencia > ultimo->secuencia))
+        {
+            ultimo = registro;
+        }
+    }
+
+    return ultimo;
+}
+
+/**
+ * @brief Busca el último registro válido y lo aplica
+ */
+datos_guardados_t persistencia_cargar(void)
+{
+    const registro_flash_t *registro = buscar_ultimo();
+
+    if (registro == NULL)
+    {
+        ultima_secuencia = 0;
+        return DATOS_NINGUNO;
+    }
+    ultima_secuencia = registro->secuencia;
+
+    izq_cerca = registro->calibracion[0];
+    izq_lejos = registro->calibracion[1];
+    izq_centrado = registro->calibracion[2];
+    der_cerca = registro->calibracion[3];
+    der_lejos = registro->calibracion[4];
+    der_centrado = registro->calibracion[5];
+    calibrado = true;
+
+    for (uint8_t i = 0; i < CANTIDAD_PARAMETROS_GUARDADOS; i++)
+    {
+        *parametros_guardados[i] = registro->parametros[i];
+    }
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            indice_t indice = LABERINTO_INDICE(fila, columna);
+            uint8_t muros = (registro->muros[indice / 2] >> (4 * (indice % 2))) & 0x0F;
+
+            for (brujula direccion = norte; direccion <= oeste; direccion++)
+            {
+                if (muros & DIRECCION_BIT(direccion))
+                {
+                    laberinto_set_muro(fila, columna, direccion);
+                }
+            }
+        }
+    }
+
+    return registro->explorado ? DATOS_MAPA : DATOS_CALIBRACION;
+}
+
+/**
+ * @brief Guarda el estado actual en la próxima ranura libre
+ * @details Si no queda ninguna ranura libre borra el sector y empieza de nuevo.
+ *          Si se corta la alimentación mientras borra se pierde lo guardado;
+ *          mientras escribe, queda el registro anterior
+ */
+bool persistencia_guardar(bool mapa_explorado)
+{
+    registro_flash_t registro;
+
+    memset(&registro, 0, sizeof(registro));
+    registro.magia = MAGIA_REGISTRO;
+    registro.secuencia = ultima_secuencia + 1;
+    registro.filas = FILAS_LABERINTO;
+    registro.columnas = COLUMNAS_LABERINTO;
+    registro.explorado = mapa_explorado ? 1 : 0;
+    registro.version = VERSION_REGISTRO;
+
+    registro.calibracion[0] = izq_cerca;
+    registro.calibracion[1] = izq_lejos;
+    registro.calibracion[2] = izq_centrado;
+    registro.calibracion[3] = der_cerca;
+    registro.calibracion[4] = der_lejos;
+    registro.calibracion[5] = der_centrado;
+
+    for (uint8_t i = 0; i < CANTIDAD_PARAMETROS_GUARDADOS; i++)
+    {
+        registro.parametros[i] = *parametros_guardados[i];
+    }
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            indice_t indice = LABERINTO_INDICE(fila, columna);
+            uint8_t muros = (uint8_t)~laberinto_get_direcciones_libres(fila, columna) & 0x0F;
+            registro.muros[indice / 2] |= (uint8_t)(muros << (4 * (indice % 2)));
+        }
+    }
+
+    registro.crc = crc32((const uint8_t *)&registro, offsetof(registro_flash_t, crc));
+
+    uint32_t indice = 0;
+    while (indice < CANTIDAD_RANURAS && !ranura_libre(indice))
+    {
+        indice++;
+    }
+    if (indice == CANTIDAD_RANURAS)
+    {
+        if (!flash_borrar())
+        {
+            return false;
+        }
+        indice = 0;
+    }
+
+    if (!flash_escribir(indice * sizeof(registro_flash_t), (const uint32_t *)&registro, sizeof(registro) / 4))
+    {
+        return false;
+    }
+
+    ultima_secuencia = registro.secuencia;
+    return registro_valido(ranura(indice)); // Leer lo escrito para confirmar
+}
+
+/**
+ * @brief Borra el sector: el próximo arranque vuelve a calibrar
+ */
+bool persistencia_borrar(void)
+{
+    ultima_secuencia = 0;
+    return flash_borrar();
+}
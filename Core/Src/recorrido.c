@@ -0,0 +1,558 @@
+/**
+ * @file recorrido.c
+ * @brief Lógica de la corrida: exploración, sprint y respuesta a los sensores
+ * @author demianmozo
+ */
+
+#include "recorrido.h"
+#include "main.h"
+#include "antirebote.h"         ///< Funciones de antirebote para sensores
+#include "control_motor.h"      ///< Control de motores y PWM
+#include "laberinto.h"          ///< Representación y manejo del laberinto
+#include "navegacion.h"         ///< Algoritmos de navegación Flood Fill
+#include "control_linearecta.h" ///< Control PID para línea recta
+#include "uart.h"               ///< Comunicación UART para debugging
+#include "registro.h"           ///< Registro de la corrida en CCMRAM
+#include "telemetria.h"         ///< Telemetría por UART (texto o binaria)
+#include "comandos.h"           ///< Comandos por UART para ajustar entre corridas
+#include "persistencia.h"       ///< Mapa y calibración guardados en flash
+#include "odometria.h"          ///< Distancia y rumbo medidos con los encoders
+#include <stddef.h>
+
+/** @defgroup Recorrido_Variables Variables de la corrida
+ * @brief Posición, modo, ruta de sprint y flags de los sensores
+ * @{
+ */
+
+/** @brief Posición actual del robot */
+uint8_t fila_actual = POSICION_INICIO_FILA, columna_actual = POSICION_INICIO_COLUMNA; ///< Fila y columna inicial del robot
+
+/** @brief Estado y orientación del robot */
+brujula sentido_actual = norte; ///< Orientación inicial del robot
+bool terminado = false;         ///< Flag que indica si el robot llegó a la meta
+
+/** @brief Control de timing y velocidad */
+uint16_t TIEMPO_AVANCE_LINEA = TIEMPO_AVANCE_LINEA_EXPLORACION; ///< Tiempo de avance entre líneas (ms) - Exploración
+uint16_t tiempo_avance_sprint = TIEMPO_AVANCE_LINEA_SPRINT;      ///< Tiempo de avance que toma el sprint (ajustable por UART)
+bool modo_sprint = false;           ///< Flag para modo de alta velocidad
+
+/** @brief Ruta compilada al activar el sprint */
+const comando_t *ruta_sprint = NULL;  ///< Comandos de la ruta (ver navegacion.h)
+uint16_t cantidad_comandos_ruta = 0;  ///< Cantidad de comandos de la ruta
+uint16_t indice_ruta = 0;             ///< Próximo comando a ejecutar
+uint8_t casillas_restantes = 0;       ///< Líneas que faltan cruzar en el tramo recto actual
+bool ruta_sprint_activa = false;      ///< true mientras el sprint sigue la ruta compilada
+
+/** @brief Variables para control de interrupciones */
+volatile bool ultimo_estado_linea = true; ///< Último estado del sensor de línea (HIGH = no detectando)
+volatile bool ultimo_estado_muro = true;  ///< Último estado del sensor de muro (HIGH = no detectando)
+
+/** @brief Flags de interrupciones */
+volatile bool flag_linea_detectada = false; ///< Flag activado por ISR al detectar línea
+volatile bool flag_muro_detectado = false;  ///< Flag activado por ISR al detectar muro
+volatile bool flanco_linea = false;         ///< Flanco del sensor de línea sin confirmar (lo marca la ISR)
+
+/** @brief Antirebote de los sensores, confirmado con HAL_GetTick() desde el bucle principal */
+antirebote_sensor_t sensor_linea = ANTIREBOTE_SENSOR_INIT; ///< Sensor de línea (EXTI)
+antirebote_sensor_t sensor_muro = ANTIREBOTE_SENSOR_INIT;  ///< Sensor de muro (por consulta)
+
+/* Umbrales de los sensores IR (control_linearecta.c), para el registro */
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+
+/**
+ * @}
+ */
+
+/** @defgroup Recorrido_Privadas Funciones internas de la corrida
+ * @{
+ */
+
+/**
+ * @brief Ejecuta los giros de la ruta de sprint hasta el próximo tramo recto
+ */
+static void preparar_tramo_ruta(void);
+
+/**
+ * @brief Vuelve al inicio y descarta maniobras, ruta y estados de sensores
+ */
+static void reiniciar_posicion(void);
+
+/**
+ * @brief Espera con el LED verde titilando antes de la primera exploración
+ */
+static void esperar_largada(void);
+
+/**
+ * @brief Vacía el registro y guarda la calibración con que arranca la etapa
+ */
+static void empezar_registro(void);
+
+/**
+ * @brief Arranca el sprint desde el inicio con la ruta compilada
+ */
+static void iniciar_sprint(void);
+
+/**
+ * @brief Termina una maniobra: sigue en recta y reactiva los sensores
+ */
+static void continuar_avance(void);
+
+/**
+ * @}
+ */
+
+/**
+ * @brief Carga lo guardado, calibra si hace falta y arranca los módulos
+ * @details Sin nada en la flash corre auto_calibracion() y guarda el
+ *          resultado; con la calibración pero sin mapa espera
+ *          ESPERA_LARGADA_MS; con un mapa explorado queda detenido esperando
+ *          el sprint. Termina arrancando el control lateral por timer
+ */
+void recorrido_iniciar(void)
+{
+    // Mapa, calibración y parámetros guardados en la flash (si hay)
+    laberinto_init();
+    datos_guardados_t datos_guardados = persistencia_cargar();
+    if (datos_guardados == DATOS_NINGUNO)
+    {
+        // Auto-calibración (sin motores activos)
+        auto_calibracion();
+        persistencia_guardar(false); // El próximo arranque no recalibra
+    }
+    else if (datos_guardados == DATOS_CALIBRACION)
+    {
+        // Sin las esperas de auto_calibracion(): dar tiempo a soltar el robot en la largada
+        esperar_largada();
+    }
+
+    // Inicializar módulos
+    empezar_registro(); // Empieza a grabar la corrida
+    odometria_iniciar(); // Encoders de las ruedas (TIM1 y TIM2)
+    control_motor_init();
+    Inicializar_UART();
+    telemetria_evento(EVENTO_INICIO);
+
+    // Con un mapa ya explorado se espera detenido el botón de sprint
+    if (datos_guardados == DATOS_MAPA)
+    {
+        terminado = true;
+        termino();
+    }
+
+    // Control lateral a frecuencia fija en la interrupción de TIM6
+    control_lazo_iniciar();
+}
+
+/**
+ * @brief Una vuelta del bucle principal
+ * @details Implementa la máquina de estados principal:
+ * - Avance de giros y avances con plazo (sin bloquear)
+ * - Control de línea recta (si no corre en la interrupción de TIM6)
+ * - Procesamiento de interrupciones (línea > muro)
+ * - Verificación de botón de sprint
+ * - Comandos recibidos por UART (ver comandos.h)
+ * - Verificación de estado terminado
+ */
+void recorrido_paso(void)
+{
+    // Avanzar el movimiento en curso; al vencer su plazo sigue la secuencia
+    switch (movimiento_actualizar(HAL_GetTick()))
+    {
+    case MOVIMIENTO_AVANCE: // Llegó al centro de la casilla
+        llegada_centro_casilla();
+        break;
+
+    case MOVIMIENTO_GIRO: // Terminó el giro
+        continuar_avance();
+        break;
+
+    default:
+        break;
+    }
+
+    if (!terminado)
+    {
+#if !CONTROL_POR_TIMER
+        control_lazo_paso(HAL_GetTick());
+#endif
+        telemetria_actualizar(HAL_GetTick());
+
+        // Confirmar la línea sin bloquear; se sigue leyendo hasta que el robot sale de ella
+        if (!movimiento_en_curso() && (flanco_linea || sensor_linea.esperando || sensor_linea.estable == GPIO_PIN_RESET))
+        {
+            flanco_linea = false;
+            if (antirebote_sensor(&sensor_linea, HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin), HAL_GetTick()))
+            {
+                flag_linea_detectada = true;
+            }
+        }
+
+        // PROCESAR FLAGS CON PRIORIDAD: LÍNEA > MURO
+        if (flag_linea_detectada)
+        {
+            flag_linea_detectada = false;                            // Clear flag PRIMERO
+            chequeolinea();
+        }
+        if (!movimiento_en_curso() && antirebote_sensor(&sensor_muro, HAL_GPIO_ReadPin(WallSensor_GPIO_Port, WallSensor_Pin), HAL_GetTick()))
+        {
+            chequeomuro();
+            antirebote_sensor_reiniciar(&sensor_muro); // Si después del giro hay otro muro, volver a detectarlo
+        }
+    }
+    else
+    {
+        termino(); // Robot detenido en meta
+    }
+    reset_posicion_pushbutton(); // ⚡ I AM SPEED button */
+    registro_volcar_paso(); // Lo que falte del volcado del registro, sin bloquear
+
+    // Comandos por UART (ajustes, mapa, volcado)
+    switch (comandos_procesar())
+    {
+    case ACCION_POSICION: // Volver al inicio y esperar detenido
+        reiniciar_posicion();
+        terminado = true; // Antes de frenar: el control por timer deja de mover los motores
+        termino();
+        break;
+
+    case ACCION_SPRINT:
+        iniciar_sprint();
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Actualiza la posición del robot en el laberinto
+ * @details Modifica las coordenadas del robot según la dirección de movimiento
+ * @param fila Puntero a la fila actual (se modifica)
+ * @param columna Puntero a la columna actual (se modifica)
+ * @param sentido Orientación actual del robot
+ *
+ * @note Las coordenadas van de 1 a FILAS_LABERINTO y de 1 a COLUMNAS_LABERINTO
+ */
+void actualizar_posicion(uint8_t *fila, uint8_t *columna, brujula sentido)
+{
+    switch (sentido)
+    {
+    case norte:
+        (*fila)--;
+        break;
+    case este:
+        (*columna)++;
+        break;
+    case sur:
+        (*fila)++;
+        break;
+    case oeste:
+        (*columna)--;
+        break;
+    }
+}
+
+/**
+ * @brief Procesa la detección de una línea del laberinto
+ * @details Secuencia completa de procesamiento al cruzar una línea:
+ * 1. Desactiva interrupciones temporalmente
+ * 2. Arranca el avance necesario para posicionarse (no bloquea)
+ * 3. Al vencer ese avance, llegada_centro_casilla() hace el resto
+ *
+ * En sprint con ruta compilada el avance y la decisión solo se hacen al final
+ * de cada tramo recto; en las líneas intermedias solo se actualiza la posición
+ * y el robot sigue sin frenar.
+ *
+ * @note Usa TIEMPO_AVANCE_LINEA que varía según el modo (exploración/sprint)
+ */
+void chequeolinea(void)
+{
+    HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
+
+    // Sprint con ruta compilada: en medio de una recta no se frena ni se recalcula
+    if (ruta_sprint_activa && casillas_restantes > 1)
+    {
+        casillas_restantes--;
+        perfil_set_casillas_restantes(casillas_restantes); // Corrige lo que falta para frenar hasta la base
+        registro_agregar(REGISTRO_LINEA, 0, fila_actual, columna_actual);
+        actualizar_posicion(&fila_actual, &columna_actual, sentido_actual);
+        registro_agregar(REGISTRO_POSICION, sentido_actual, fila_actual, columna_actual);
+        telemetria_casilla(fila_actual, columna_actual, sentido_actual, laberinto_get_peso(fila_actual, columna_actual));
+
+        HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+        HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_RESET);
+        return;
+    }
+
+    registro_agregar(REGISTRO_LINEA, 0, fila_actual, columna_actual);
+    perfil_set_casillas_restantes(0);               // El avance hasta el centro va a la base, como se calibró
+    movimiento_iniciar_avance(TIEMPO_AVANCE_LINEA); // por si es sprint o no
+}
+
+/**
+ * @brief Sigue el procesamiento de una línea cuando el robot llegó al centro de la casilla
+ * @details Lo llama el bucle principal al terminar el avance de chequeolinea():
+ * 1. Actualiza la posición del robot
+ * 2. Verifica si llegó a alguna de las metas del laberinto
+ * 3. Calcula la mejor dirección usando Flood Fill (o sigue la ruta compilada)
+ * 4. Arranca el giro necesario
+ * 5. Sin giro, sigue avanzando y reactiva interrupciones enseguida; con giro,
+ *    al terminarlo
+ */
+void llegada_centro_casilla(void)
+{
+    uint32_t ciclos_inicio = DWT->CYCCNT;
+    brujula sentido_anterior = sentido_actual;
+
+    // Actualizar posición
+    actualizar_posicion(&fila_actual, &columna_actual, sentido_actual);
+    registro_agregar(REGISTRO_POSICION, sentido_actual, fila_actual, columna_actual);
+    telemetria_casilla(fila_actual, columna_actual, sentido_actual, laberinto_get_peso(fila_actual, columna_actual));
+
+    // terminó?
+    if (laberinto_es_meta(fila_actual, columna_actual))
+    {
+        terminado = true; // Antes de frenar: el control por timer deja de mover los motores
+        termino();
+        telemetria_evento(EVENTO_META);
+        registro_volcar(); // Robot detenido: mandar lo grabado (sigue en recorrido_paso())
+        persistencia_guardar(true); // Un reset ya no pierde el mapa
+        return;
+    }
+
+    // Fin de un tramo de la ruta: girar hacia el siguiente
+    if (ruta_sprint_activa)
+    {
+        preparar_tramo_ruta();
+    }
+
+    // Calcular y ejecutar
+    if (!ruta_sprint_activa)
+    {
+        brujula sentido_deseado = calcular_mejor_direccion_orientada(fila_actual, columna_actual, sentido_actual); // funcion definida en navegacion.h
+        sentido_actual = ejecutar_movimiento(sentido_actual, sentido_deseado);           // funcion definida en navegacion.h
+    }
+
+    telemetria_tiempo(ETAPA_DECISION, DWT->CYCCNT - ciclos_inicio);
+    if (sentido_actual != sentido_anterior)
+    {
+        telemetria_giro(sentido_anterior, sentido_actual);
+    }
+
+    HAL_GPIO_WritePin(LD4_GPIO_Port, LD4_Pin, GPIO_PIN_RESET);
+    if (!movimiento_en_curso())
+    {
+        continuar_avance();
+    }
+}
+
+/**
+ * @brief Procesa la detección de un muro
+ * @details Secuencia de procesamiento al detectar un obstáculo:
+ * 1. Desactiva interrupciones
+ * 2. Registra el muro en el mapa del laberinto y repropaga los pesos afectados
+ * 3. Calcula nueva mejor dirección
+ * 4. Arranca el giro hacia la dirección alternativa
+ * 5. Reactiva interrupciones (al terminar el giro si lo hubo)
+ *
+ * @note Solo se recalculan las casillas cuyo camino más corto pasaba por el muro
+ */
+void chequeomuro(void)
+{
+    HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
+
+    // El mapa no era el de la exploración: seguir casilla por casilla
+    ruta_sprint_activa = false;
+    perfil_set_casillas_restantes(0);
+
+    registro_agregar(REGISTRO_MURO, sentido_actual, fila_actual, columna_actual);
+
+    // 1. Registrar el muro detectado (ya repropaga los pesos afectados)
+    laberinto_set_muro(fila_actual, columna_actual, sentido_actual);
+    telemetria_muro(fila_actual, columna_actual, sentido_actual, laberinto_get_ciclos_muro());
+
+    // 2. Calcular nueva mejor dirección
+    brujula sentido_deseado = calcular_mejor_direccion_orientada(fila_actual, columna_actual, sentido_actual);
+
+    // 3. Ejecutar movimiento LO QUE HIZO EL COLO YA ACTUALIZA EL SENTIDO ACTUAL SOLO
+    brujula sentido_anterior = sentido_actual;
+    sentido_actual = ejecutar_movimiento(sentido_actual, sentido_deseado);
+    telemetria_giro(sentido_anterior, sentido_actual);
+
+    HAL_GPIO_WritePin(LD6_GPIO_Port, LD6_Pin, GPIO_PIN_RESET);
+    if (!movimiento_en_curso())
+    {
+        continuar_avance();
+    }
+}
+
+/**
+ * @brief Maneja el botón para activar modo sprint
+ * @details Al presionar el botón "I AM SPEED":
+ * 1. Reinicia la posición al inicio configurado, orientación norte
+ * 2. Activa el modo sprint (mayor velocidad)
+ * 3. Reduce el tiempo de avance entre líneas
+ * 4. Resetea flags y estados de sensores
+ * 5. Compila la ruta óptima del mapa explorado en una lista de comandos
+ * 6. Ejecuta los giros iniciales de la ruta e inicia el movimiento
+ *
+ * @note El robot mantiene el conocimiento del laberinto de la primera ejecución
+ */
+void reset_posicion_pushbutton(void)
+{
+    if (antirebote(i_am_speed_GPIO_Port, i_am_speed_Pin, HAL_GetTick()))
+    {
+        iniciar_sprint();
+    }
+}
+
+/**
+ * @brief Espera ESPERA_LARGADA_MS con el LED verde titilando
+ * @details Con la calibración cargada de la flash no se pasa por
+ *          auto_calibracion() y el robot arrancaría apenas se suelta el reset.
+ *          Se llama antes de arrancar el control lateral, con los motores quietos
+ */
+static void esperar_largada(void)
+{
+    for (uint32_t espera = 0; espera < ESPERA_LARGADA_MS; espera += 250)
+    {
+        HAL_GPIO_TogglePin(LD3_GPIO_Port, LD3_Pin);
+        HAL_Delay(250);
+    }
+    HAL_GPIO_WritePin(LD3_GPIO_Port, LD3_Pin, GPIO_PIN_RESET);
+}
+
+/**
+ * @brief Vacía el registro y guarda la calibración con que arranca la etapa
+ * @details Los umbrales van primero: sin ellos no se puede reproducir lo que
+ *          hizo el control lateral con los promedios registrados
+ */
+static void empezar_registro(void)
+{
+    registro_init();
+    registro_agregar(REGISTRO_CALIBRACION, 0, izq_cerca, der_cerca);
+    registro_agregar(REGISTRO_CALIBRACION, 1, izq_lejos, der_lejos);
+    registro_agregar(REGISTRO_CALIBRACION, 2, izq_centrado, der_centrado);
+}
+
+/**
+ * @brief Vuelve a la casilla de inicio mirando al norte, sin movimiento en curso
+ * @details Descarta giros y avances a medias, la ruta de sprint, los flags de
+ *          interrupción y los antirebotes de los sensores. Deja la línea
+ *          deshabilitada: la reactiva continuar_avance()
+ */
+static void reiniciar_posicion(void)
+{
+    HAL_NVIC_DisableIRQ(EXTI9_5_IRQn);
+    movimiento_cancelar(); // Descartar cualquier giro o avance a medias
+
+    // Resetear posición
+    fila_actual = POSICION_INICIO_FILA;
+    columna_actual = POSICION_INICIO_COLUMNA;
+    sentido_actual = norte;
+    ruta_sprint_activa = false;
+    perfil_set_casillas_restantes(0);
+
+    flag_linea_detectada = false;
+    flag_muro_detectado = false;
+
+    // Resetear estados de sensores
+    ultimo_estado_linea = true;
+    ultimo_estado_muro = true;
+    flanco_linea = false;
+    antirebote_sensor_reiniciar(&sensor_linea);
+    antirebote_sensor_reiniciar(&sensor_muro);
+}
+
+/**
+ * @brief Arranca el sprint desde el inicio (botón o comando "sprint")
+ */
+static void iniciar_sprint(void)
+{
+    reiniciar_posicion();
+    terminado = false;
+
+    empezar_registro(); // Lo de la exploración ya se volcó al llegar a la meta
+    telemetria_evento(EVENTO_SPRINT);
+
+    // ⚡ I AM SPEED!
+    activar_modo_sprint();     // Esta función está en control_motor.c
+    TIEMPO_AVANCE_LINEA = tiempo_avance_sprint; // Tiempo de avance del sprint
+
+    // Compilar la ruta con lo que se conoce del laberinto
+    uint32_t ciclos_inicio = DWT->CYCCNT;
+    cantidad_comandos_ruta = navegacion_compilar_ruta(fila_actual, columna_actual, sentido_actual);
+    telemetria_tiempo(ETAPA_RUTA, DWT->CYCCNT - ciclos_inicio);
+    ruta_sprint = navegacion_get_ruta();
+    indice_ruta = 0;
+    ruta_sprint_activa = (cantidad_comandos_ruta > 0);
+    if (ruta_sprint_activa)
+    {
+        preparar_tramo_ruta();
+    }
+
+    // Si arrancó un giro, se avanza y se reactivan las interrupciones al terminarlo
+    if (!movimiento_en_curso())
+    {
+        continuar_avance();
+    }
+}
+
+/**
+ * @brief Arranca el giro de la ruta de sprint previo al próximo tramo recto
+ * @details Deja en casillas_restantes el largo del tramo. Si la ruta se terminó
+ *          la desactiva y el robot vuelve a decidir casilla por casilla
+ * @note La ruta compilada tiene a lo sumo un giro entre dos tramos
+ */
+static void preparar_tramo_ruta(void)
+{
+    if (indice_ruta < cantidad_comandos_ruta && ruta_sprint[indice_ruta].tipo != COMANDO_AVANZAR)
+    {
+        brujula sentido_anterior = sentido_actual;
+        sentido_actual = ejecutar_comando_giro(sentido_actual, ruta_sprint[indice_ruta]);
+        telemetria_giro(sentido_anterior, sentido_actual);
+        indice_ruta++;
+    }
+
+    if (indice_ruta < cantidad_comandos_ruta)
+    {
+        casillas_restantes = ruta_sprint[indice_ruta].casillas;
+        indice_ruta++;
+    }
+    else
+    {
+        ruta_sprint_activa = false;
+        casillas_restantes = 0;
+    }
+    perfil_planificar_recta(casillas_restantes); // Las rectas largas llegan a más velocidad
+}
+
+/**
+ * @brief Termina una maniobra: sigue en recta y reactiva los sensores
+ * @details Se llama al terminar el giro de chequeolinea()/chequeomuro(), o
+ *          enseguida si no hizo falta girar
+ */
+static void continuar_avance(void)
+{
+    avanza();
+    HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+}
+
+/**
+ * @brief Rutina de atencion a la interrupción para sensores
+ * @details ISR para interrupciones externas EXTI9_5. Solo marca el flanco;
+ *          el bucle principal lo confirma con antirebote_sensor() cuando la
+ *          lectura se sostuvo TREBOTES_SENSOR ms y recién ahí activa
+ *          flag_linea_detectada
+ * @param GPIO_Pin Pin que generó la interrupción
+ *
+ * @note No espera dentro de la interrupción: todo el tiempo se mide con HAL_GetTick()
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin == LineSensor_Pin)
+    {
+        flanco_linea = true;
+    }
+}
@@ -0,0 +1,290 @@
+/**
+ * @file registro.c
+ * @brief Implementación del registro de la corrida en la CCMRAM
+ * @author demianmozo
+ */
+
+#include "registro.h"
+#include "main.h"
+#include "telemetria.h"
+#include "control_motor.h"
+
+#if REGISTRO_SENSORES
+/** @defgroup Registro_Variables Variables del registro
+ * @brief Buffer circular en la CCMRAM y sus índices
+ * @{
+ */
+
+/**
+ * @brief Buffer circular de entradas
+ * @note Va en .ccmram_noinit (NOLOAD, ver el linker script): no ocupa flash y
+ *       no se inicializa al arrancar, por eso solo valen las entradas que
+ *       indica cantidad_registros
+ */
+static registro_t registros[CANTIDAD_REGISTROS] __attribute__((section(".ccmram_noinit")));
+
+/** @brief Próxima posición a escribir */
+static volatile uint16_t indice_escritura = 0;
+
+/** @brief Entradas válidas en el buffer */
+static volatile uint16_t cantidad_registros = 0;
+
+/** @brief false mientras se vuelca, para no pisar lo que se está enviando */
+static volatile bool grabando = false;
+
+/** @brief Etapas del volcado por UART */
+typedef enum
+{
+    VOLCADO_NINGUNO = 0, ///< No se está volcando
+    VOLCADO_INICIO,      ///< Falta la trama de inicio
+    VOLCADO_ENTRADAS,    ///< Mandando entradas
+    VOLCADO_FIN          ///< Falta la trama de fin
+} etapa_volcado_t;
+
+/** @brief Etapa del volcado en curso */
+static etapa_volcado_t etapa_volcado = VOLCADO_NINGUNO;
+
+/** @brief Entradas del volcado, próxima a mandar y cuántas faltan */
+static uint16_t cantidad_volcado = 0;
+static uint16_t indice_volcado = 0;
+static uint16_t pendientes_volcado = 0;
+
+/** @brief Medios buffers del ADC desde la última entrada REGISTRO_ADC */
+static uint8_t contador_adc = 0;
+
+/** @brief Último estado y PWM registrado de cada motor (0 izq, 1 der) */
+static uint8_t ultimo_estado_motor[2] = {0xFF, 0xFF};
+static uint16_t ultimo_pwm_motor[2] = {0xFFFF, 0xFFFF};
+
+/**
+ * @}
+ */
+#endif
+
+/**
+ * @brief Vacía el registro y empieza a grabar
+ */
+void registro_init(void)
+{
+#if REGISTRO_SENSORES
+    indice_escritura = 0;
+    cantidad_registros = 0;
+    contador_adc = 0;
+    ultimo_estado_motor[0] = ultimo_estado_motor[1] = 0xFF;
+    ultimo_pwm_motor[0] = ultimo_pwm_motor[1] = 0xFFFF;
+    etapa_volcado = VOLCADO_NINGUNO;
+    grabando = true;
+#endif
+}
+
+/**
+ * @brief Agrega una entrada al registro
+ * @param tipo Tipo de entrada
+ * @param extra Dato chico (ver tipo_registro_t)
+ * @param a Primer dato
+ * @param b Segundo dato
+ *
+ * @details Reserva la posición con las interrupciones deshabilitadas (las
+ *          llamadas del ADC llegan desde su callback) y después la completa.
+ *          Con el buffer lleno pisa la entrada más vieja.
+ */
+void registro_agregar(tipo_registro_t tipo, uint8_t extra, uint16_t a, uint16_t b)
+{
+#if REGISTRO_SENSORES
+    if (!grabando)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t indice = indice_escritura;
+    indice_escritura = (indice + 1 == CANTIDAD_REGISTROS) ? 0 : indice + 1;
+    if (cantidad_registros < CANTIDAD_REGISTROS)
+    {
+        cantidad_registros++;
+    }
+    __set_PRIMASK(primask);
+
+    registro_t *registro = &registros[indice];
+    registro->tiempo_ms = HAL_GetTick();
+    registro->tipo = (uint8_t)tipo;
+    registro->extra = extra;
+    registro->a = a;
+    registro->b = b;
+    registro->reservado = 0;
+#else
+    (void)tipo;
+    (void)extra;
+    (void)a;
+    (void)b;
+#endif
+}
+
+/**
+ * @brief Registra los promedios de un medio buffer del ADC
+ * @param izq Promedio del sensor izquierdo
+ * @param der Promedio del sensor derecho
+ *
+ * @note Llega un medio buffer cada pocos milisegundos; guardarlos todos llenaría
+ *       el registro en segundos, por eso se guarda 1 de cada REGISTRO_DIVISOR_ADC
+ *       y nada con los dos motores frenados (según los últimos registro_motor())
+ */
+void registro_sensores(uint16_t izq, uint16_t der)
+{
+#if REGISTRO_SENSORES
+    bool andando = (ultimo_estado_motor[0] != MOTOR_FRENADO && ultimo_pwm_motor[0] != 0) ||
+                   (ultimo_estado_motor[1] != MOTOR_FRENADO && ultimo_pwm_motor[1] != 0);
+    if (!andando || ++contador_adc < REGISTRO_DIVISOR_ADC)
+    {
+        return;
+    }
+    contador_adc = 0;
+
+    registro_agregar(REGISTRO_ADC, 0, izq, der);
+#else
+    (void)izq;
+    (void)der;
+#endif
+}
+
+/**
+ * @brief Registra un comando de motor si cambió
+ * @param motor 0 = izquierdo, 1 = derecho
+ * @param estado Valor de motor_estado_t
+ * @param pwm PWM aplicado
+ *
+ * @note El control lateral corrige el PWM en cada ejecución; solo se guardan los
+ *       cambios de sentido y los de al menos REGISTRO_DELTA_PWM, y siempre la
+ *       llegada a 0 (frenado)
+ */
+void registro_motor(uint8_t motor, uint8_t estado, uint16_t pwm)
+{
+#if REGISTRO_SENSORES
+    if (motor > 1)
+    {
+        return;
+    }
+
+    uint16_t anterior = ultimo_pwm_motor[motor];
+    uint16_t diferencia = (pwm > anterior) ? pwm - anterior : anterior - pwm;
+    if (ultimo_estado_motor[motor] == estado && diferencia < REGISTRO_DELTA_PWM && (pwm != 0 || anterior == 0))
+    {
+        return;
+    }
+    ultimo_estado_motor[motor] = estado;
+    ultimo_pwm_motor[motor] = pwm;
+
+    registro_agregar(REGISTRO_MOTOR, motor, estado, pwm);
+#else
+    (void)motor;
+    (void)estado;
+    (void)pwm;
+#endif
+}
+
+/**
+ * @brief Cantidad de entradas guardadas
+ */
+uint16_t registro_get_cantidad(void)
+{
+#if REGISTRO_SENSORES
+    return cantidad_registros;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Entrada guardada número indice, contando desde la más vieja
+ * @param indice 0 = la más vieja
+ * @return NULL si no hay tantas
+ * @note Para leer el registro sin volcarlo (p. ej. desde las herramientas de la PC)
+ */
+const registro_t *registro_get_entrada(uint16_t indice)
+{
+#if REGISTRO_SENSORES
+    if (indice >= cantidad_registros)
+    {
+        return NULL;
+    }
+    uint16_t primera = (cantidad_registros < CANTIDAD_REGISTROS) ? 0 : indice_escritura;
+    return &registros[((uint32_t)primera + indice) % CANTIDAD_REGISTROS];
+#else
+    (void)indice;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief Empieza el volcado del registro por UART
+ * @details Tramas de telemetria.h:
+ * - TELEMETRIA_VOLCADO de inicio con la cantidad de entradas
+ * - Un TELEMETRIA_REGISTRO por entrada
+ * - TELEMETRIA_VOLCADO de fin
+ *
+ * @note Antes era un CSV que bloqueaba unos 10 s con 4096 entradas a 115200
+ *       baudios; ahora el bucle principal sigue mientras sale
+ */
+void registro_volcar(void)
+{
+#if REGISTRO_SENSORES
+    grabando = false;
+
+    cantidad_volcado = cantidad_registros;
+    indice_volcado = (cantidad_volcado < CANTIDAD_REGISTROS) ? 0 : indice_escritura; // La más vieja
+    pendientes_volcado = cantidad_volcado;
+    etapa_volcado = VOLCADO_INICIO;
+
+    registro_volcar_paso();
+#endif
+}
+
+/**
+ * @brief Encola lo que entre del volcado en curso
+ * @details Cada trama se encola solo si entra entera; la que no entra se
+ *          reintenta en la próxima llamada
+ */
+bool registro_volcar_paso(void)
+{
+#if REGISTRO_SENSORES
+    switch (etapa_volcado)
+    {
+    case VOLCADO_INICIO:
+        if (!telemetria_volcado(false, cantidad_volcado))
+        {
+            return true;
+        }
+        etapa_volcado = VOLCADO_ENTRADAS;
+        /* fall through */
+
+    case VOLCADO_ENTRADAS:
+        while (pendientes_volcado > 0)
+        {
+            if (!telemetria_registro(&registros[indice_volcado]))
+            {
+                return true;
+            }
+            indice_volcado = (indice_volcado + 1 == CANTIDAD_REGISTROS) ? 0 : indice_volcado + 1;
+            pendientes_volcado--;
+        }
+        etapa_volcado = VOLCADO_FIN;
+        /* fall through */
+
+    case VOLCADO_FIN:
+        if (!telemetria_volcado(true, cantidad_volcado))
+        {
+            return true;
+        }
+        etapa_volcado = VOLCADO_NINGUNO;
+        grabando = true;
+        return false;
+
+    case VOLCADO_NINGUNO:
+    default:
+        return false;
+    }
+#else
+    return false;
+#endif
+}
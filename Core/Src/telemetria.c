@@ -0,0 +1,293 @@
+/**
+ * @file telemetria.c
+ * @brief Implementación de la telemetría en texto o en tramas COBS + CRC16
+ * @author demianmozo
+ */
+
+#include "telemetria.h"
+#include "main.h"
+#include "uart.h"
+#include "control_linearecta.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LARGO_CABECERA 6    ///< tipo + secuencia + tiempo_ms
+#define MAX_DATOS_TRAMA 16  ///< Datos de un registro como máximo
+#define MAX_TRAMA (LARGO_CABECERA + MAX_DATOS_TRAMA + 2) ///< Trama sin codificar (con CRC)
+
+/** @brief Número de secuencia de la próxima trama */
+static uint8_t secuencia = 0;
+
+#if TELEMETRIA_BINARIA
+/** @brief Última foto de sensores enviada */
+static uint32_t ultima_foto_sensores = 0;
+#endif
+
+/**
+ * @brief CRC16-CCITT (0x1021, inicial 0xFFFF), bit a bit
+ * @note Las tramas son cortas: no vale la pena una tabla de 512 bytes
+ */
+static uint16_t crc16(const uint8_t *datos, uint8_t largo)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint8_t i = 0; i < largo; i++)
+    {
+        crc ^= (uint16_t)datos[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Codifica con COBS y agrega el 0x00 separador
+ * @param entrada Trama sin codificar
+ * @param largo Largo de la trama (menos de 254 bytes)
+ * @param salida Destino, con lugar para largo + 2 bytes
+ * @return Bytes escritos en salida (incluido el separador)
+ */
+static uint8_t cobs_codificar(const uint8_t *entrada, uint8_t largo, uint8_t *salida)
+{
+    uint8_t posicion_codigo = 0; // Dónde va el byte que indica la distancia al próximo cero
+    uint8_t codigo = 1;
+    uint8_t escritos = 1;
+
+    for (uint8_t i = 0; i < largo; i++)
+    {
+        if (entrada[i] == 0)
+        {
+            salida[posicion_codigo] = codigo;
+            posicion_codigo = escritos++;
+            codigo = 1;
+        }
+        else
+        {
+            salida[escritos++] = entrada[i];
+            codigo++;
+        }
+    }
+
+    salida[posicion_codigo] = codigo;
+    salida[escritos++] = 0x00;
+
+    return escritos;
+}
+
+/**
+ * @brief Arma la trama y la codifica; gasta un número de secuencia
+ * @param tiempo Tiempo de la cabecera
+ * @param codificada Destino, con lugar para MAX_TRAMA + 2 bytes
+ * @return Bytes a encolar (con el separador)
+ */
+static uint8_t armar_trama(tipo_telemetria_t tipo, uint32_t tiempo, const uint8_t *datos, uint8_t largo,
+                           uint8_t *codificada)
+{
+    uint8_t trama[MAX_TRAMA];
+
+    trama[0] = (uint8_t)tipo;
+    trama[1] = secuencia++;
+    trama[2] = (uint8_t)tiempo;
+    trama[3] = (uint8_t)(tiempo >> 8);
+    trama[4] = (uint8_t)(tiempo >> 16);
+    trama[5] = (uint8_t)(tiempo >> 24);
+    memcpy(&trama[LARGO_CABECERA], datos, largo);
+
+    uint8_t largo_trama = LARGO_CABECERA + largo;
+    uint16_t crc = crc16(trama, largo_trama);
+    trama[largo_trama++] = (uint8_t)crc;
+    trama[largo_trama++] = (uint8_t)(crc >> 8);
+
+    return cobs_codificar(trama, largo_trama, codificada);
+}
+
+/**
+ * @brief Encola una trama solo si entra entera
+ * @return false si no entraba: no se gasta la secuencia y se puede reintentar
+ */
+static bool enviar_trama_si_entra(tipo_telemetria_t tipo, uint32_t tiempo, const uint8_t *datos, uint8_t largo)
+{
+    uint8_t codificada[MAX_TRAMA + 2];
+
+    if (uart_get_espacio_libre() < LARGO_CABECERA + largo + 4) // + CRC, código COBS y separador
+    {
+        return false;
+    }
+
+    uart_encolar(codificada, armar_trama(tipo, tiempo, datos, largo, codificada));
+    return true;
+}
+
+/** @brief Escribe un uint16_t en little endian */
+static void escribir_u16(uint8_t *destino, uint16_t valor)
+{
+    destino[0] = (uint8_t)valor;
+    destino[1] = (uint8_t)(valor >> 8);
+}
+
+#if TELEMETRIA_BINARIA
+/**
+ * @brief Arma la trama, la codifica y la encola para el DMA de la UART
+ * @note Con la cola llena se descarta (uart_get_bytes_descartados()); el
+ *       salto de secuencia lo delata del otro lado
+ */
+static void enviar_trama(tipo_telemetria_t tipo, const uint8_t *datos, uint8_t largo)
+{
+    uint8_t codificada[MAX_TRAMA + 2];
+
+    uart_encolar(codificada, armar_trama(tipo, HAL_GetTick(), datos, largo, codificada));
+}
+
+/** @brief Escribe un uint32_t en little endian */
+static void escribir_u32(uint8_t *destino, uint32_t valor)
+{
+    destino[0] = (uint8_t)valor;
+    destino[1] = (uint8_t)(valor >> 8);
+    destino[2] = (uint8_t)(valor >> 16);
+    destino[3] = (uint8_t)(valor >> 24);
+}
+#endif
+
+/**
+ * @brief Llegada a una casilla
+ * @note En modo texto manda "fila,columna" como siempre
+ */
+void telemetria_casilla(uint8_t fila, uint8_t columna, brujula sentido, peso_t peso)
+{
+#if TELEMETRIA_BINARIA
+    uint8_t datos[5] = {fila, columna, (uint8_t)sentido};
+    escribir_u16(&datos[3], peso);
+    enviar_trama(TELEMETRIA_CASILLA, datos, sizeof(datos));
+#else
+    (void)sentido;
+    (void)peso;
+    sprintf(mensaje, "%d,%d", fila, columna);
+    Transmision();
+#endif
+}
+
+/**
+ * @brief Muro nuevo en el mapa
+ * @note Solo en modo binario
+ */
+void telemetria_muro(uint8_t fila, uint8_t columna, brujula direccion, uint32_t ciclos)
+{
+#if TELEMETRIA_BINARIA
+    uint8_t datos[7] = {fila, columna, (uint8_t)direccion};
+    escribir_u32(&datos[3], ciclos);
+    enviar_trama(TELEMETRIA_MURO, datos, sizeof(datos));
+#else
+    (void)fila;
+    (void)columna;
+    (void)direccion;
+    (void)ciclos;
+#endif
+}
+
+/**
+ * @brief Cambio de orientación
+ * @note Solo en modo binario
+ */
+void telemetria_giro(brujula desde, brujula hacia)
+{
+#if TELEMETRIA_BINARIA
+    uint8_t datos[2] = {(uint8_t)desde, (uint8_t)hacia};
+    enviar_trama(TELEMETRIA_GIRO, datos, sizeof(datos));
+#else
+    (void)desde;
+    (void)hacia;
+#endif
+}
+
+/**
+ * @brief Duración de una etapa del procesamiento
+ * @note Solo en modo binario
+ */
+void telemetria_tiempo(etapa_telemetria_t etapa, uint32_t ciclos)
+{
+#if TELEMETRIA_BINARIA
+    uint8_t datos[5] = {(uint8_t)etapa};
+    escribir_u32(&datos[1], ciclos);
+    enviar_trama(TELEMETRIA_TIEMPO, datos, sizeof(datos));
+#else
+    (void)etapa;
+    (void)ciclos;
+#endif
+}
+
+/**
+ * @brief Evento de la corrida
+ * @note En modo texto solo se manda la meta, como "Finalizado"
+ */
+void telemetria_evento(evento_telemetria_t evento)
+{
+#if TELEMETRIA_BINARIA
+    uint8_t datos[1] = {(uint8_t)evento};
+    enviar_trama(TELEMETRIA_EVENTO, datos, sizeof(datos));
+#else
+    if (evento == EVENTO_META)
+    {
+        strcpy(mensaje, "Finalizado");
+        Transmision();
+    }
+#endif
+}
+
+/**
+ * @brief Inicio o fin del volcado del registro
+ * @details El inicio va después de un 0x00 suelto: si antes hubo texto, el
+ *          decodificador lo descarta como una trama rota y no se come el inicio
+ */
+bool telemetria_volcado(bool fin, uint16_t cantidad)
+{
+    uint8_t datos[3] = {fin ? 1 : 0};
+    escribir_u16(&datos[1], cantidad);
+
+    if (!fin)
+    {
+        if (uart_get_espacio_libre() < 1 + LARGO_CABECERA + sizeof(datos) + 4)
+        {
+            return false;
+        }
+        uart_encolar((const uint8_t *)"", 1);
+    }
+
+    return enviar_trama_si_entra(TELEMETRIA_VOLCADO, HAL_GetTick(), datos, sizeof(datos));
+}
+
+/**
+ * @brief Una entrada del registro, con su propio tiempo en la cabecera
+ */
+bool telemetria_registro(const registro_t *registro)
+{
+    uint8_t datos[6] = {registro->tipo, registro->extra};
+    escribir_u16(&datos[2], registro->a);
+    escribir_u16(&datos[4], registro->b);
+
+    return enviar_trama_si_entra(TELEMETRIA_REGISTRO, registro->tiempo_ms, datos, sizeof(datos));
+}
+
+/**
+ * @brief Foto periódica de los sensores
+ * @note Solo en modo binario; en texto no hay lugar a 115200 baudios
+ */
+void telemetria_actualizar(uint32_t ahora_ms)
+{
+#if TELEMETRIA_BINARIA
+    if ((uint32_t)(ahora_ms - ultima_foto_sensores) < TELEMETRIA_PERIODO_SENSORES)
+    {
+        return;
+    }
+    ultima_foto_sensores = ahora_ms;
+
+    uint8_t datos[4];
+    escribir_u16(&datos[0], sensor_izq_avg);
+    escribir_u16(&datos[2], sensor_der_avg);
+    enviar_trama(TELEMETRIA_SENSORES, datos, sizeof(datos));
+#else
+    (void)ahora_ms;
+#endif
+}
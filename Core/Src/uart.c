@@ -20,39 +20,262 @@
  * @{
  */
 
-/** @brief Buffer de mensaje para transmisión (máximo 16 caracteres) */
-char mensaje[16];
+/** @brief Buffer de mensaje para transmisión (máximo 21 caracteres: Transmision() agrega CRLF) */
+char mensaje[24];
 
 /** @brief Timeout para transmisión UART en milisegundos */
 const uint8_t delay = 50;
 
-/** @brief Buffer para recepción de datos por interrupción */
-uint8_t buffer[16];
+/** @brief Byte que está recibiendo la interrupción de UART5 */
+static uint8_t byte_rx;
+
+/** @brief Cola circular de recepción: la llena la interrupción, la vacía uart_leer() */
+static uint8_t cola_rx[TAMAÑO_COLA_RX];
+
+/** @brief Próxima posición a leer (solo la mueve uart_leer()) */
+static volatile uint16_t inicio_rx = 0;
+
+/** @brief Próxima posición a escribir (solo la mueve la interrupción) */
+static volatile uint16_t fin_rx = 0;
+
+/** @brief Bytes recibidos con la cola llena o perdidos por error de la UART */
+static volatile uint32_t bytes_perdidos_rx = 0;
+
+/** @brief Cola circular de transmisión (en SRAM: el DMA1 no llega a la CCMRAM) */
+static uint8_t cola_tx[TAMAÑO_COLA_TX];
+
+/** @brief Posición del primer byte sin enviar (o que está enviando el DMA) */
+static volatile uint16_t inicio_tx = 0;
+
+/** @brief Próxima posición libre de la cola */
+static volatile uint16_t fin_tx = 0;
+
+/** @brief Bytes en la cola, incluidos los del envío en curso */
+static volatile uint16_t ocupados_tx = 0;
+
+/** @brief Bytes del envío DMA en curso (0 = DMA libre) */
+static volatile uint16_t enviando_tx = 0;
+
+/** @brief Bytes descartados por cola llena */
+static volatile uint32_t bytes_descartados = 0;
 
 /**
  * @}
  */
 
+/**
+ * @brief Arranca un envío DMA con lo que haya en la cola si el DMA está libre
+ * @details Manda el tramo contiguo desde inicio_tx; si la cola da la vuelta,
+ *          el resto sale en el envío siguiente (lo encadena el callback)
+ */
+static void iniciar_envio_tx(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (enviando_tx != 0 || ocupados_tx == 0)
+    {
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    uint16_t inicio = inicio_tx;
+    uint16_t largo = (inicio + ocupados_tx <= TAMAÑO_COLA_TX) ? ocupados_tx : TAMAÑO_COLA_TX - inicio;
+    enviando_tx = largo; // Reservar el DMA antes de soltar las interrupciones
+
+    __set_PRIMASK(primask);
+
+    if (HAL_UART_Transmit_DMA(&huart5, &cola_tx[inicio], largo) != HAL_OK)
+    {
+        enviando_tx = 0; // UART ocupada: se reintenta en el próximo encolado
+    }
+}
+
+/**
+ * @brief Copia datos a la cola de transmisión
+ * @param datos Bytes a enviar
+ * @param largo Cantidad de bytes
+ * @return true si se encolaron, false si no entraban
+ *
+ * @details La copia se hace con las interrupciones deshabilitadas (unos pocos
+ *          ciclos por byte) para que el bucle principal y las interrupciones
+ *          puedan encolar a la vez sin mezclar mensajes. Si el mensaje no entra
+ *          entero se descarta y se suma a bytes_descartados.
+ */
+bool uart_encolar(const uint8_t *datos, uint16_t largo)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (largo > TAMAÑO_COLA_TX - ocupados_tx)
+    {
+        bytes_descartados += largo;
+        __set_PRIMASK(primask);
+        return false;
+    }
+
+    uint16_t fin = fin_tx;
+    for (uint16_t i = 0; i < largo; i++)
+    {
+        cola_tx[fin] = datos[i];
+        fin = (fin + 1 == TAMAÑO_COLA_TX) ? 0 : fin + 1;
+    }
+    fin_tx = fin;
+    ocupados_tx += largo;
+
+    __set_PRIMASK(primask);
+
+    iniciar_envio_tx();
+    return true;
+}
+
+/**
+ * @brief Espera hasta que entren largo bytes en la cola de transmisión
+ * @param largo Bytes que se quieren encolar
+ * @note Pensada para volcados largos con el robot detenido
+ */
+void uart_esperar_espacio(uint16_t largo)
+{
+    if (largo > TAMAÑO_COLA_TX)
+    {
+        return; // Nunca va a entrar
+    }
+
+    while (TAMAÑO_COLA_TX - ocupados_tx < largo)
+    {
+        iniciar_envio_tx(); // Por si un envío no pudo arrancar
+    }
+}
+
+/**
+ * @brief Bytes que entran ahora en la cola de transmisión
+ */
+uint16_t uart_get_espacio_libre(void)
+{
+    return TAMAÑO_COLA_TX - ocupados_tx;
+}
+
+/**
+ * @brief Bytes descartados desde el arranque por tener la cola llena
+ */
+uint32_t uart_get_bytes_descartados(void)
+{
+    return bytes_descartados;
+}
+
+/**
+ * @brief Fin de un envío DMA: libera lo enviado y encadena el siguiente
+ * @param huart UART que terminó de transmitir
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != UART5)
+    {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint16_t inicio = inicio_tx + enviando_tx;
+    inicio_tx = (inicio >= TAMAÑO_COLA_TX) ? inicio - TAMAÑO_COLA_TX : inicio;
+    ocupados_tx -= enviando_tx;
+    enviando_tx = 0;
+    __set_PRIMASK(primask);
+
+    iniciar_envio_tx();
+}
+
+/**
+ * @brief Llegó un byte por UART5: lo guarda y vuelve a armar la recepción
+ * @param huart UART que terminó de recibir
+ * @note Un solo productor (esta interrupción) y un solo consumidor (uart_leer()),
+ *       así que la cola no necesita deshabilitar interrupciones
+ */
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != UART5)
+    {
+        return;
+    }
+
+    uint16_t siguiente = (fin_rx + 1 == TAMAÑO_COLA_RX) ? 0 : fin_rx + 1;
+    if (siguiente != inicio_rx)
+    {
+        cola_rx[fin_rx] = byte_rx;
+        fin_rx = siguiente;
+    }
+    else
+    {
+        bytes_perdidos_rx++;
+    }
+
+    HAL_UART_Receive_IT(&huart5, &byte_rx, 1);
+}
+
+/**
+ * @brief Error de UART5 (overrun, ruido, framing): la HAL corta la recepción
+ * @param huart UART con error
+ * @details Se cuenta el byte perdido y se vuelve a armar la recepción para que
+ *          el canal de comandos no quede sordo
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != UART5)
+    {
+        return;
+    }
+
+    bytes_perdidos_rx++;
+    HAL_UART_Receive_IT(&huart5, &byte_rx, 1);
+}
+
+/**
+ * @brief Saca un byte de la cola de recepción
+ * @param dato Destino del byte
+ * @return false si no había nada recibido
+ */
+bool uart_leer(uint8_t *dato)
+{
+    uint16_t inicio = inicio_rx;
+
+    if (inicio == fin_rx)
+    {
+        return false;
+    }
+
+    *dato = cola_rx[inicio];
+    inicio_rx = (inicio + 1 == TAMAÑO_COLA_RX) ? 0 : inicio + 1;
+    return true;
+}
+
+/**
+ * @brief Bytes recibidos que se perdieron desde el arranque
+ */
+uint32_t uart_get_bytes_perdidos_rx(void)
+{
+    return bytes_perdidos_rx;
+}
+
 /**
  * @brief Transmite el mensaje actual por UART
  * @details Funcionamiento:
  * 1. Agrega terminador CRLF ("\r\n") al mensaje
- * 2. Transmite usando HAL_UART_Transmit con timeout
- * 3. Utiliza transmisión bloqueante para garantizar envío
+ * 2. Lo copia a la cola de transmisión
+ * 3. El DMA de UART5 lo envía en segundo plano
  *
  * @note Requiere que la variable global 'mensaje' esté configurada previamente
- * @warning Transmisión bloqueante - puede causar delay de hasta 50ms
+ * @note No bloquea: 'mensaje' se puede reutilizar apenas vuelve
  */
 void Transmision(void)
 {
     strcat(mensaje, "\r\n");
-    HAL_UART_Transmit(&huart5, (uint8_t *)mensaje, strlen(mensaje), delay);
+    uart_encolar((const uint8_t *)mensaje, strlen(mensaje));
 }
 
 /**
  * @brief Inicializa la comunicación UART y envía mensaje de conexión
  * @details Secuencia de inicialización:
- * 1. Configura recepción por interrupciones
+ * 1. Arma la recepción por interrupciones de a un byte (ver uart_leer())
  * 2. Limpia buffer de mensaje
  * 3. Envía línea en blanco para sincronización
  * 4. Transmite mensaje de confirmación "UART conectada"
@@ -63,7 +286,7 @@ void Transmision(void)
  */
 void Inicializar_UART(void)
 {
-    HAL_UART_Receive_IT(&huart5, buffer, sizeof(buffer));
+    HAL_UART_Receive_IT(&huart5, &byte_rx, 1);
     mensaje[0] = '\r';
     mensaje[1] = '\n';
     mensaje[2] = '\0';
@@ -0,0 +1,584 @@
+/**
+ * @file hal_falso.c
+ * @brief Implementación del HAL simulado
+ * @author demianmozo
+ */
+
+#include "hal_falso.h"
+#include "main.h"
+#include "control_linearecta.h"
+#include <string.h>
+
+#define CANTIDAD_TIMERS 15
+#define TAMAÑO_SALIDA_UART (1u << 20) ///< Bytes transmitidos que se guardan hasta hal_falso_uart_tomar()
+#define TAMAÑO_COLA_ADC 64            ///< Pares de hal_falso_adc_encolar() sin usar
+#define EXTI_FLANCO_BAJADA LineSensor_Pin ///< Como en MX_GPIO_Init(): solo PC7, por flanco de bajada
+#define EXTI_PUERTO LineSensor_GPIO_Port
+
+/* Registros */
+DWT_Type hal_falso_dwt;
+CoreDebug_Type hal_falso_core_debug;
+GPIO_TypeDef hal_falso_gpio[8];
+TIM_TypeDef hal_falso_tim[CANTIDAD_TIMERS];
+USART_TypeDef hal_falso_uart5;
+uint32_t SystemCoreClock = 168000000u;
+
+/* Lo que en el micro define main.c */
+TIM_HandleTypeDef htim1 = {TIM1};
+TIM_HandleTypeDef htim2 = {TIM2};
+TIM_HandleTypeDef htim3 = {TIM3};
+TIM_HandleTypeDef htim6 = {TIM6};
+UART_HandleTypeDef huart5 = {UART5};
+ADC_HandleTypeDef hadc1 = {1};
+uint16_t dma_buffer[BUFFER_TOTAL];
+
+/** @brief Estado de cada timer que no está en sus registros */
+typedef struct
+{
+    uint32_t activo[4];              ///< Compare que usa el PWM, por canal
+    bool pwm;                        ///< Arrancado con HAL_TIM_PWM_Start()
+    TIM_HandleTypeDef *interrupcion; ///< Arrancado con HAL_TIM_Base_Start_IT()
+    uint32_t microsegundos;          ///< Tiempo acumulado hacia el próximo período
+    uint32_t evento_en_escritura;    ///< 0 = ninguno; ver hal_falso_tim_evento_en_escritura()
+} timer_falso_t;
+
+static timer_falso_t timers[CANTIDAD_TIMERS];
+static uint32_t reloj_ms = 0;
+static uint32_t primask = 0;
+static bool exti9_5_habilitada = true;
+static bool exti9_5_pendiente = false;
+static hal_falso_paso_t paso_robot = NULL;
+
+static uint16_t *buffer_adc = NULL;
+static uint32_t largo_adc = 0;
+static uint16_t lectura_canal_8 = 0;
+static uint16_t lectura_canal_9 = 0;
+static uint16_t anterior_canal_8 = 0;     ///< Lecturas al empezar el ms, para interpolar
+static uint16_t anterior_canal_9 = 0;
+static uint32_t periodo_adc_us = 500;     ///< Entre dos mitades del buffer (dos por ms)
+static uint32_t microsegundos_adc = 0;    ///< Tiempo acumulado hacia la próxima mitad
+static bool mitad_adc = true;             ///< La próxima en completarse es la primera mitad
+static uint16_t cola_adc[TAMAÑO_COLA_ADC][2]; ///< Canal 8 y 9 de las próximas mitades
+static uint32_t inicio_cola_adc = 0;
+static uint32_t ocupados_cola_adc = 0;
+
+static uint8_t *destino_rx = NULL;
+static uint8_t salida_uart[TAMAÑO_SALIDA_UART];
+static size_t inicio_salida = 0;
+static size_t ocupados_salida = 0;
+static uint32_t transmitidos = 0;
+static uint32_t uart_bytes_por_ms = 0;
+static const uint8_t *envio_dma = NULL; ///< Lo que falta del envío DMA en curso
+static uint16_t restantes_dma = 0;
+
+/**
+ * @brief Estado simulado de un timer de hal_falso_tim
+ */
+static timer_falso_t *timer(TIM_TypeDef *tim)
+{
+    return &timers[tim - hal_falso_tim];
+}
+
+/**
+ * @brief Registro de precarga de un canal
+ */
+static volatile uint32_t *registro_compare(TIM_TypeDef *tim, uint32_t canal)
+{
+    switch (canal)
+    {
+    case TIM_CHANNEL_1:
+        return &tim->CCR1;
+    case TIM_CHANNEL_2:
+        return &tim->CCR2;
+    case TIM_CHANNEL_3:
+        return &tim->CCR3;
+    default:
+        return &tim->CCR4;
+    }
+}
+
+/**
+ * @brief Evento de actualización: los compare precargados pasan al PWM
+ * @note Con UDIS en CR1 el evento no ocurre (el contador vuelve a cero igual)
+ */
+static void evento_actualizacion(TIM_TypeDef *tim)
+{
+    if (tim->CR1 & TIM_CR1_UDIS)
+    {
+        return;
+    }
+
+    timer_falso_t *estado = timer(tim);
+    estado->activo[0] = tim->CCR1;
+    estado->activo[1] = tim->CCR2;
+    estado->activo[2] = tim->CCR3;
+    estado->activo[3] = tim->CCR4;
+}
+
+/**
+ * @brief Pasa lo escrito en BSRR a ODR (los bits de set ganan, como en el micro)
+ */
+static void aplicar_bsrr(GPIO_TypeDef *puerto)
+{
+    uint32_t bsrr = puerto->BSRR;
+
+    if (bsrr != 0)
+    {
+        puerto->ODR = (puerto->ODR & ~(bsrr >> 16)) | (bsrr & 0xFFFFu);
+        puerto->BSRR = 0;
+    }
+}
+
+void hal_falso_reiniciar(void)
+{
+    memset(&hal_falso_dwt, 0, sizeof(hal_falso_dwt));
+    memset(&hal_falso_core_debug, 0, sizeof(hal_falso_core_debug));
+    memset(hal_falso_tim, 0, sizeof(hal_falso_tim));
+    memset(timers, 0, sizeof(timers));
+    memset(&hal_falso_uart5, 0, sizeof(hal_falso_uart5));
+    for (int i = 0; i < 8; i++)
+    {
+        hal_falso_gpio[i].IDR = 0xFFFFu;
+        hal_falso_gpio[i].ODR = 0;
+        hal_falso_gpio[i].BSRR = 0;
+    }
+
+    reloj_ms = 0;
+    primask = 0;
+    exti9_5_habilitada = true;
+    exti9_5_pendiente = false;
+    paso_robot = NULL;
+    buffer_adc = NULL;
+    largo_adc = 0;
+    lectura_canal_8 = 0;
+    lectura_canal_9 = 0;
+    anterior_canal_8 = 0;
+    anterior_canal_9 = 0;
+    periodo_adc_us = 500;
+    microsegundos_adc = 0;
+    mitad_adc = true;
+    inicio_cola_adc = 0;
+    ocupados_cola_adc = 0;
+    destino_rx = NULL;
+    inicio_salida = 0;
+    ocupados_salida = 0;
+    transmitidos = 0;
+    uart_bytes_por_ms = 0;
+    envio_dma = NULL;
+    restantes_dma = 0;
+}
+
+/**
+ * @brief Guarda bytes transmitidos por UART5 para hal_falso_uart_tomar()
+ */
+static void guardar_salida_uart(const uint8_t *datos, uint16_t largo)
+{
+    for (uint16_t i = 0; i < largo; i++)
+    {
+        if (ocupados_salida == TAMAÑO_SALIDA_UART)
+        {
+            inicio_salida = (inicio_salida + 1) % TAMAÑO_SALIDA_UART; // Nadie lo leyó: perder lo más viejo
+            ocupados_salida--;
+        }
+        salida_uart[(inicio_salida + ocupados_salida) % TAMAÑO_SALIDA_UART] = datos[i];
+        ocupados_salida++;
+    }
+    transmitidos += largo;
+}
+
+/**
+ * @brief Indica si algo tiene que pasar en cada ms (modelo, ADC o interrupción de un timer)
+ */
+static bool hay_eventos_periodicos(void)
+{
+    if (paso_robot != NULL || buffer_adc != NULL || restantes_dma > 0)
+    {
+        return true;
+    }
+    for (int t = 0; t < CANTIDAD_TIMERS; t++)
+    {
+        if (timers[t].interrupcion != NULL)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Lectura del ADC en un instante del ms, entre la del comienzo y la del final
+ */
+static uint16_t interpolar(uint16_t anterior, uint16_t actual, uint32_t instante_us)
+{
+    return (uint16_t)(anterior + ((int32_t)actual - anterior) * (int32_t)instante_us / 1000);
+}
+
+void hal_falso_avanzar(uint32_t ms)
+{
+    // Sin nada periódico se salta directo al final: los eventos de los
+    // timers PWM dan lo mismo una vez que muchas
+    if (ms > 0 && !hay_eventos_periodicos())
+    {
+        reloj_ms += ms;
+        hal_falso_dwt.CYCCNT += ms * (SystemCoreClock / 1000u);
+        for (int t = 0; t < CANTIDAD_TIMERS; t++)
+        {
+            if (timers[t].pwm)
+            {
+                evento_actualizacion(&hal_falso_tim[t]);
+            }
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        uint32_t ciclos_inicio = hal_falso_dwt.CYCCNT;
+
+        reloj_ms++;
+
+        for (int t = 0; t < CANTIDAD_TIMERS; t++)
+        {
+            if (timers[t].pwm)
+            {
+                evento_actualizacion(&hal_falso_tim[t]);
+            }
+        }
+        for (int p = 0; p < 8; p++)
+        {
+            aplicar_bsrr(&hal_falso_gpio[p]);
+        }
+
+        if (paso_robot != NULL)
+        {
+            paso_robot(reloj_ms);
+        }
+
+        if (buffer_adc != NULL)
+        {
+            // Cada mitad del buffer con DWT->CYCCNT en el instante en que se completa
+            for (microsegundos_adc += 1000u; microsegundos_adc >= periodo_adc_us; microsegundos_adc -= periodo_adc_us)
+            {
+                uint32_t instante_us = 1000u - (microsegundos_adc - periodo_adc_us);
+                hal_falso_dwt.CYCCNT = ciclos_inicio + instante_us * (SystemCoreClock / 1000000u);
+                uint16_t canal_8 = interpolar(anterior_canal_8, lectura_canal_8, instante_us);
+                uint16_t canal_9 = interpolar(anterior_canal_9, lectura_canal_9, instante_us);
+                if (ocupados_cola_adc > 0)
+                {
+                    canal_8 = cola_adc[inicio_cola_adc][0];
+                    canal_9 = cola_adc[inicio_cola_adc][1];
+                    inicio_cola_adc = (inicio_cola_adc + 1) % TAMAÑO_COLA_ADC;
+                    ocupados_cola_adc--;
+                }
+                for (uint32_t j = 0; j + 1 < largo_adc; j += 2)
+                {
+                    buffer_adc[j] = canal_8;
+                    buffer_adc[j + 1] = canal_9;
+                }
+                if (mitad_adc)
+                    HAL_ADC_ConvHalfCpltCallback(&hadc1);
+                else
+                    HAL_ADC_ConvCpltCallback(&hadc1);
+                mitad_adc = !mitad_adc;
+            }
+        }
+        hal_falso_dwt.CYCCNT = ciclos_inicio + SystemCoreClock / 1000u;
+        anterior_canal_8 = lectura_canal_8;
+        anterior_canal_9 = lectura_canal_9;
+
+        if (restantes_dma > 0)
+        {
+            uint16_t largo = restantes_dma < uart_bytes_por_ms ? restantes_dma : (uint16_t)uart_bytes_por_ms;
+            guardar_salida_uart(envio_dma, largo);
+            envio_dma += largo;
+            restantes_dma -= largo;
+            if (restantes_dma == 0)
+            {
+                HAL_UART_TxCpltCallback(&huart5);
+            }
+        }
+
+        for (int t = 0; t < CANTIDAD_TIMERS; t++)
+        {
+            timer_falso_t *estado = &timers[t];
+            if (estado->interrupcion == NULL)
+            {
+                continue;
+            }
+            uint32_t periodo = hal_falso_tim[t].ARR + 1u; // Los timers del lazo cuentan a 1 MHz
+            estado->microsegundos += 1000u;
+            while (estado->microsegundos >= periodo)
+            {
+                estado->microsegundos -= periodo;
+                HAL_TIM_PeriodElapsedCallback(estado->interrupcion);
+            }
+        }
+    }
+}
+
+void hal_falso_set_paso(hal_falso_paso_t paso)
+{
+    paso_robot = paso;
+}
+
+uint32_t hal_falso_tim_get_compare_activo(TIM_TypeDef *tim, uint32_t canal)
+{
+    return timer(tim)->activo[canal / 4u];
+}
+
+void hal_falso_tim_evento_en_escritura(TIM_TypeDef *tim, uint32_t escrituras)
+{
+    timer(tim)->evento_en_escritura = escrituras;
+}
+
+void hal_falso_gpio_set_entrada(GPIO_TypeDef *puerto, uint16_t pin, GPIO_PinState estado)
+{
+    bool antes = (puerto->IDR & pin) != 0;
+
+    if (estado == GPIO_PIN_SET)
+        puerto->IDR |= pin;
+    else
+        puerto->IDR &= ~(uint32_t)pin;
+
+    if (puerto == EXTI_PUERTO && (pin & EXTI_FLANCO_BAJADA) && antes && estado == GPIO_PIN_RESET)
+    {
+        if (exti9_5_habilitada && primask == 0)
+        {
+            HAL_GPIO_EXTI_Callback(EXTI_FLANCO_BAJADA);
+        }
+        else
+        {
+            exti9_5_pendiente = true;
+        }
+    }
+}
+
+GPIO_PinState hal_falso_gpio_get_salida(GPIO_TypeDef *puerto, uint16_t pin)
+{
+    aplicar_bsrr(puerto);
+    return (puerto->ODR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+bool hal_falso_irq_habilitada(IRQn_Type irq)
+{
+    return irq == EXTI9_5_IRQn ? exti9_5_habilitada : true;
+}
+
+void hal_falso_adc_set_lecturas(uint16_t canal_8, uint16_t canal_9)
+{
+    lectura_canal_8 = canal_8;
+    lectura_canal_9 = canal_9;
+}
+
+bool hal_falso_adc_encolar(uint16_t canal_8, uint16_t canal_9)
+{
+    if (ocupados_cola_adc == TAMAÑO_COLA_ADC)
+    {
+        return false;
+    }
+    uint32_t fin = (inicio_cola_adc + ocupados_cola_adc) % TAMAÑO_COLA_ADC;
+    cola_adc[fin][0] = canal_8;
+    cola_adc[fin][1] = canal_9;
+    ocupados_cola_adc++;
+    return true;
+}
+
+void hal_falso_adc_set_periodo_us(uint32_t periodo_us)
+{
+    periodo_adc_us = (periodo_us > 0) ? periodo_us : 1u;
+}
+
+void hal_falso_uart_recibir(const uint8_t *datos, size_t largo)
+{
+    for (size_t i = 0; i < largo; i++)
+    {
+        if (destino_rx == NULL)
+        {
+            HAL_UART_ErrorCallback(&huart5); // Overrun: llegó sin recepción armada
+            continue;
+        }
+        uint8_t *destino = destino_rx;
+        destino_rx = NULL; // La recepción es de a un byte: la vuelve a armar el callback
+        *destino = datos[i];
+        HAL_UART_RxCpltCallback(&huart5);
+    }
+}
+
+size_t hal_falso_uart_tomar(uint8_t *destino, size_t maximo)
+{
+    size_t cantidad = (ocupados_salida < maximo || destino == NULL) ? ocupados_salida : maximo;
+
+    for (size_t i = 0; i < cantidad; i++)
+    {
+        if (destino != NULL)
+        {
+            destino[i] = salida_uart[inicio_salida];
+        }
+        inicio_salida = (inicio_salida + 1) % TAMAÑO_SALIDA_UART;
+    }
+    ocupados_salida -= cantidad;
+
+    return cantidad;
+}
+
+uint32_t hal_falso_uart_get_transmitidos(void)
+{
+    return transmitidos;
+}
+
+void hal_falso_uart_set_bytes_por_ms(uint32_t bytes_por_ms)
+{
+    uart_bytes_por_ms = bytes_por_ms;
+}
+
+/* Funciones del HAL ------------------------------------------------------- */
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t valor)
+{
+    primask = valor;
+    if (primask == 0 && exti9_5_pendiente && exti9_5_habilitada)
+    {
+        exti9_5_pendiente = false;
+        HAL_GPIO_EXTI_Callback(EXTI_FLANCO_BAJADA);
+    }
+}
+
+void __disable_irq(void)
+{
+    primask = 1;
+}
+
+void __enable_irq(void)
+{
+    __set_PRIMASK(0);
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return reloj_ms;
+}
+
+/**
+ * @brief Como el HAL del micro: espera al menos Delay + 1 ms
+ */
+void HAL_Delay(uint32_t Delay)
+{
+    hal_falso_avanzar(Delay + 1u);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn != EXTI9_5_IRQn)
+    {
+        return;
+    }
+    exti9_5_habilitada = true;
+    if (exti9_5_pendiente && primask == 0)
+    {
+        exti9_5_pendiente = false;
+        HAL_GPIO_EXTI_Callback(EXTI_FLANCO_BAJADA);
+    }
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == EXTI9_5_IRQn)
+    {
+        exti9_5_habilitada = false;
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    aplicar_bsrr(GPIOx);
+    if (PinState == GPIO_PIN_SET)
+        GPIOx->ODR |= GPIO_Pin;
+    else
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    aplicar_bsrr(GPIOx);
+    GPIOx->ODR ^= GPIO_Pin;
+}
+
+void hal_falso_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t canal, uint32_t valor)
+{
+    timer_falso_t *estado = timer(htim->Instance);
+
+    *registro_compare(htim->Instance, canal) = valor;
+
+    if (estado->evento_en_escritura != 0 && --estado->evento_en_escritura == 0)
+    {
+        evento_actualizacion(htim->Instance);
+    }
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)Channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    timer(htim->Instance)->pwm = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)Channel;
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+    timer(htim->Instance)->interrupcion = htim;
+    timer(htim->Instance)->microsegundos = 0;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length)
+{
+    (void)hadc;
+    buffer_adc = (uint16_t *)pData; // El DMA del ADC escribe medias palabras
+    largo_adc = Length;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (restantes_dma > 0)
+    {
+        return HAL_BUSY;
+    }
+
+    if (uart_bytes_por_ms > 0 && Size > 0)
+    {
+        envio_dma = pData; // Sale en hal_falso_avanzar()
+        restantes_dma = Size;
+        return HAL_OK;
+    }
+
+    guardar_salida_uart(pData, Size);
+    HAL_UART_TxCpltCallback(huart);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    (void)huart;
+    (void)Size;
+    destino_rx = pData;
+    return HAL_OK;
+}
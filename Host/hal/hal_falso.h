@@ -0,0 +1,157 @@
+/**
+ * @file hal_falso.h
+ * @brief Manejo del HAL simulado desde las pruebas y el simulador
+ * @author demianmozo
+ *
+ * El tiempo solo avanza con hal_falso_avanzar() (o con HAL_Delay() desde el
+ * firmware). Cada ms virtual, en este orden:
+ * 1. HAL_GetTick() suma 1
+ * 2. Evento de actualización de los timers en modo PWM: los compare
+ *    precargados pasan a los activos, salvo que CR1 tenga UDIS
+ * 3. El paso registrado con hal_falso_set_paso() (el modelo del robot)
+ * 4. Las mitades del buffer del ADC que se completaron en ese ms (una cada
+ *    hal_falso_adc_set_periodo_us(), dos por ms si no se cambió), alternando
+ *    HAL_ADC_ConvHalfCpltCallback() y HAL_ADC_ConvCpltCallback(), con
+ *    DWT->CYCCNT en el instante de cada una y las lecturas interpoladas a ese
+ *    instante entre las de hal_falso_adc_set_lecturas() del ms anterior y las
+ *    actuales (o las de hal_falso_adc_encolar(), si hay)
+ * 5. DWT->CYCCNT llega al final del ms (SystemCoreClock / 1000 más)
+ * 6. HAL_TIM_PeriodElapsedCallback() de los timers arrancados con
+ *    HAL_TIM_Base_Start_IT(), tantas veces como períodos (ARR + 1 us) entren
+ *
+ * Si no hay nada de eso (sin modelo, sin ADC ni interrupciones de timers)
+ * el reloj salta directo al final, como un simulador de eventos discretos.
+ *
+ * El bucle principal del firmware corre entre dos llamadas: quien maneja la
+ * simulación llama a recorrido_paso() y después a hal_falso_avanzar(1).
+ *
+ * La UART transmite al instante: HAL_UART_Transmit_DMA() pasa los bytes a la
+ * salida capturada y llama enseguida a HAL_UART_TxCpltCallback(). Así los
+ * volcados que esperan lugar en la cola no se quedan esperando un reloj que
+ * no corre.
+ */
+
+#ifndef __HAL_FALSO_H
+#define __HAL_FALSO_H
+
+#include "stm32f4xx_hal.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Lo que hace el modelo del robot en cada ms virtual */
+typedef void (*hal_falso_paso_t)(uint32_t ahora_ms);
+
+/**
+ * @brief Deja el HAL simulado como recién encendido
+ * @details Reloj en 0, registros en 0, entradas en 1 (sensores activos en
+ *          bajo sin detectar), interrupciones habilitadas, sin paso ni salida
+ *          capturada
+ * @note No toca el estado de los módulos del firmware
+ */
+void hal_falso_reiniciar(void);
+
+/**
+ * @brief Avanza el reloj virtual de a 1 ms con los eventos de cada ms
+ */
+void hal_falso_avanzar(uint32_t ms);
+
+/**
+ * @brief Registra el paso del modelo del robot (NULL = ninguno)
+ */
+void hal_falso_set_paso(hal_falso_paso_t paso);
+
+/**
+ * @brief Compare que está usando el PWM de un canal (el último que se copió)
+ */
+uint32_t hal_falso_tim_get_compare_activo(TIM_TypeDef *tim, uint32_t canal);
+
+/**
+ * @brief Genera un evento de actualización del timer en medio de una escritura
+ * @param escrituras El evento ocurre justo después de la escritura número
+ *                   escrituras (contando desde 1) de un compare de ese timer
+ * @note Para probar que set_motores() cambia los dos canales en el mismo período
+ */
+void hal_falso_tim_evento_en_escritura(TIM_TypeDef *tim, uint32_t escrituras);
+
+/**
+ * @brief Cambia el nivel de una entrada
+ * @details En PC7 (LineSensor) un flanco de bajada llama a
+ *          HAL_GPIO_EXTI_Callback() como el EXTI de MX_GPIO_Init(); si
+ *          EXTI9_5 está deshabilitada queda pendiente hasta que se habilite
+ */
+void hal_falso_gpio_set_entrada(GPIO_TypeDef *puerto, uint16_t pin, GPIO_PinState estado);
+
+/**
+ * @brief Nivel de una salida, con lo escrito en BSRR ya aplicado
+ */
+GPIO_PinState hal_falso_gpio_get_salida(GPIO_TypeDef *puerto, uint16_t pin);
+
+/**
+ * @brief Indica si una interrupción está habilitada en el NVIC simulado
+ */
+bool hal_falso_irq_habilitada(IRQn_Type irq);
+
+/**
+ * @brief Lecturas que va a entregar el ADC al final del ms (en el medio, interpoladas)
+ * @param canal_8 Sensor IR derecho (PB0)
+ * @param canal_9 Sensor IR izquierdo (PB1)
+ */
+void hal_falso_adc_set_lecturas(uint16_t canal_8, uint16_t canal_9);
+
+/**
+ * @brief Lecturas exactas para la próxima mitad del buffer del ADC que se complete
+ * @details Cada mitad toma el par más viejo de la cola en vez de interpolar;
+ *          con la cola vacía se vuelve a hal_falso_adc_set_lecturas(). Sirve
+ *          para entregar los mismos promedios que registró una corrida
+ * @return false si la cola está llena (64 pares)
+ */
+bool hal_falso_adc_encolar(uint16_t canal_8, uint16_t canal_9);
+
+/**
+ * @brief Cada cuánto se completa una mitad del buffer del ADC
+ * @param periodo_us Microsegundos entre dos promedios nuevos (500 al reiniciar;
+ *        en el robot cerca de 1200, que no coincide con el lazo de 1 ms)
+ */
+void hal_falso_adc_set_periodo_us(uint32_t periodo_us);
+
+/**
+ * @brief Bytes recibidos por UART5, de a uno por HAL_UART_RxCpltCallback()
+ * @note Los que llegan sin una recepción armada se pierden, como en el micro
+ */
+void hal_falso_uart_recibir(const uint8_t *datos, size_t largo);
+
+/**
+ * @brief Saca lo transmitido por UART5 desde la última llamada
+ * @param destino Donde copiarlo (NULL = descartar)
+ * @param maximo Tamaño de destino
+ * @return Bytes copiados; lo que no entra queda para la próxima llamada
+ */
+size_t hal_falso_uart_tomar(uint8_t *destino, size_t maximo);
+
+/**
+ * @brief Bytes transmitidos por UART5 desde hal_falso_reiniciar()
+ */
+uint32_t hal_falso_uart_get_transmitidos(void);
+
+/**
+ * @brief Velocidad del DMA de transmisión de UART5
+ * @param bytes_por_ms 0 = cada envío termina en el mismo llamado (por defecto);
+ *                     si no, sale de a esa cantidad por ms de hal_falso_avanzar()
+ *                     y HAL_UART_TxCpltCallback() llega al terminar (115200
+ *                     baudios son 11 bytes por ms)
+ */
+void hal_falso_uart_set_bytes_por_ms(uint32_t bytes_por_ms);
+
+/* Objetos que en el micro define main.c */
+extern TIM_HandleTypeDef htim1, htim2, htim3, htim6;
+extern UART_HandleTypeDef huart5;
+extern ADC_HandleTypeDef hadc1;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HAL_FALSO_H */
@@ -0,0 +1,220 @@
+/**
+ * @file stm32f4xx_hal.h
+ * @brief HAL simulado para compilar el firmware en la PC
+ * @author demianmozo
+ *
+ * Con Host/CMakeLists.txt este archivo tapa al stm32f4xx_hal.h de Drivers/:
+ * main.h lo incluye igual que en el micro. Tiene solo los tipos, macros y
+ * funciones que usan los módulos de Core/Src (todos menos main.c y los
+ * archivos generados por CubeMX). Los registros de los periféricos son
+ * estructuras en RAM y el tiempo es un reloj virtual en milisegundos que
+ * avanza hal_falso_avanzar(); ver hal_falso.h para manejarlos desde las
+ * pruebas y el simulador.
+ *
+ * No define USE_HAL_DRIVER: laberinto.c, persistencia.c y odometria.c toman
+ * sus variantes para la PC (sin DWT, flash en RAM, encoders simulados).
+ */
+
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    HAL_OK = 0x00U,
+    HAL_ERROR = 0x01U,
+    HAL_BUSY = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+/* Núcleo ------------------------------------------------------------------ */
+
+/** @brief Interrupciones que el firmware habilita y deshabilita */
+typedef enum
+{
+    EXTI9_5_IRQn = 23,
+    TIM6_DAC_IRQn = 54,
+    UART5_IRQn = 53
+} IRQn_Type;
+
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT; ///< Avanza SystemCoreClock / 1000 por cada ms virtual
+} DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+extern DWT_Type hal_falso_dwt;
+extern CoreDebug_Type hal_falso_core_debug;
+#define DWT (&hal_falso_dwt)
+#define CoreDebug (&hal_falso_core_debug)
+
+extern uint32_t SystemCoreClock;
+
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __disable_irq(void);
+void __enable_irq(void);
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+
+/* GPIO -------------------------------------------------------------------- */
+
+typedef enum
+{
+    GPIO_PIN_RESET = 0U,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+/**
+ * @brief Puerto GPIO
+ * @note Lo escrito en BSRR pasa a ODR en la próxima función del HAL simulado
+ *       o en el próximo ms, como si el hardware lo aplicara en seguida
+ */
+typedef struct
+{
+    volatile uint32_t IDR;
+    volatile uint32_t ODR;
+    volatile uint32_t BSRR;
+} GPIO_TypeDef;
+
+#define GPIO_PIN_0 ((uint16_t)0x0001)
+#define GPIO_PIN_1 ((uint16_t)0x0002)
+#define GPIO_PIN_2 ((uint16_t)0x0004)
+#define GPIO_PIN_3 ((uint16_t)0x0008)
+#define GPIO_PIN_4 ((uint16_t)0x0010)
+#define GPIO_PIN_5 ((uint16_t)0x0020)
+#define GPIO_PIN_6 ((uint16_t)0x0040)
+#define GPIO_PIN_7 ((uint16_t)0x0080)
+#define GPIO_PIN_8 ((uint16_t)0x0100)
+#define GPIO_PIN_9 ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+extern GPIO_TypeDef hal_falso_gpio[8];
+#define GPIOA (&hal_falso_gpio[0])
+#define GPIOB (&hal_falso_gpio[1])
+#define GPIOC (&hal_falso_gpio[2])
+#define GPIOD (&hal_falso_gpio[3])
+#define GPIOE (&hal_falso_gpio[4])
+#define GPIOF (&hal_falso_gpio[5])
+#define GPIOG (&hal_falso_gpio[6])
+#define GPIOH (&hal_falso_gpio[7])
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+
+/* Timers ------------------------------------------------------------------ */
+
+/**
+ * @brief Timer
+ * @details CCRx son los registros de precarga: el PWM usa el valor que se
+ *          copió en el último evento de actualización (uno por ms), salvo
+ *          que CR1 tenga UDIS en ese momento. Ver hal_falso_tim_get_compare_activo()
+ */
+typedef struct
+{
+    volatile uint32_t CR1;
+    volatile uint32_t CNT;
+    volatile uint32_t ARR;
+    volatile uint32_t CCR1;
+    volatile uint32_t CCR2;
+    volatile uint32_t CCR3;
+    volatile uint32_t CCR4;
+} TIM_TypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+extern TIM_TypeDef hal_falso_tim[15];
+#define TIM1 (&hal_falso_tim[1])
+#define TIM2 (&hal_falso_tim[2])
+#define TIM3 (&hal_falso_tim[3])
+#define TIM6 (&hal_falso_tim[6])
+
+#define TIM_CHANNEL_1 0x00000000U
+#define TIM_CHANNEL_2 0x00000004U
+#define TIM_CHANNEL_3 0x00000008U
+#define TIM_CHANNEL_4 0x0000000CU
+#define TIM_CHANNEL_ALL 0x0000003CU
+
+#define TIM_CR1_CEN (1UL << 0)
+#define TIM_CR1_UDIS (1UL << 1)
+
+/** @brief Función (no acceso directo) para que las pruebas puedan meter un evento entre dos escrituras */
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+    hal_falso_tim_set_compare((__HANDLE__), (__CHANNEL__), (__COMPARE__))
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) ((__HANDLE__)->Instance->ARR = (__AUTORELOAD__))
+
+void hal_falso_tim_set_compare(TIM_HandleTypeDef *htim, uint32_t canal, uint32_t valor);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+
+/* ADC y DMA --------------------------------------------------------------- */
+
+typedef struct
+{
+    uint32_t Instance;
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    uint32_t Instance;
+} ADC_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+/* UART -------------------------------------------------------------------- */
+
+typedef struct
+{
+    volatile uint32_t SR;
+} USART_TypeDef;
+
+typedef struct
+{
+    USART_TypeDef *Instance;
+} UART_HandleTypeDef;
+
+extern USART_TypeDef hal_falso_uart5;
+#define UART5 (&hal_falso_uart5)
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_IT(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_HAL_H */
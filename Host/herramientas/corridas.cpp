@@ -0,0 +1,264 @@
+/**
+ * @file corridas.cpp
+ * @brief Corridas de simular en paralelo, para las herramientas de la PC
+ * @author demianmozo
+ */
+
+#include "corridas.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char **environ;
+
+Corrida ejecutar(const std::vector<std::string> &argumentos)
+{
+    Corrida corrida;
+    int tubo[2];
+    if (argumentos.empty() || pipe2(tubo, O_CLOEXEC) != 0)
+        return corrida;
+
+    posix_spawn_file_actions_t acciones;
+    posix_spawn_file_actions_init(&acciones);
+    posix_spawn_file_actions_adddup2(&acciones, tubo[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&acciones, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    std::vector<char *> argv;
+    for (const std::string &argumento : argumentos)
+        argv.push_back(const_cast<char *>(argumento.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    int error = posix_spawn(&pid, argv[0], &acciones, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&acciones);
+    close(tubo[1]);
+
+    if (error == 0)
+    {
+        char bloque[4096];
+        ssize_t leidos;
+        while ((leidos = read(tubo[0], bloque, sizeof(bloque))) > 0 || (leidos < 0 && errno == EINTR))
+        {
+            if (leidos > 0)
+                corrida.salida.append(bloque, static_cast<size_t>(leidos));
+        }
+
+        int estado;
+        while (waitpid(pid, &estado, 0) < 0 && errno == EINTR)
+        {
+        }
+        corrida.codigo = WIFEXITED(estado) ? WEXITSTATUS(estado) : -1;
+    }
+    close(tubo[0]);
+
+    corrida.valores = leer_valores(corrida.salida);
+    return corrida;
+}
+
+Valores leer_valores(const std::string &salida)
+{
+    Valores valores;
+    std::istringstream entrada(salida);
+    std::string linea;
+    while (std::getline(entrada, linea))
+    {
+        size_t igual = linea.find('=');
+        if (igual == std::string::npos)
+            continue;
+
+        const char *texto = linea.c_str() + igual + 1;
+        char *fin;
+        double valor = std::strtod(texto, &fin);
+        if (fin != texto && *fin == '\0')
+            valores[linea.substr(0, igual)] = valor;
+    }
+    return valores;
+}
+
+bool leer_configuracion(const std::string &simulador, Configuracion &configuracion)
+{
+    Corrida corrida = ejecutar({simulador, "--config"});
+    if (corrida.codigo != 0)
+        return false;
+
+    const Valores &v = corrida.valores;
+    for (const char *clave : {"filas", "columnas", "inicio_fila", "inicio_columna"})
+    {
+        if (v.count(clave) == 0)
+            return false;
+    }
+    configuracion.filas = static_cast<int>(v.at("filas"));
+    configuracion.columnas = static_cast<int>(v.at("columnas"));
+    configuracion.inicio = {static_cast<int>(v.at("inicio_fila")), static_cast<int>(v.at("inicio_columna"))};
+    configuracion.planificar_con_giros = v.count("planificar_con_giros") && v.at("planificar_con_giros") != 0;
+    configuracion.odometria_encoders = v.count("odometria_encoders") && v.at("odometria_encoders") != 0;
+
+    // Las claves de texto: "metas=f,c f,c ...", "orden=..." y los ajustes en su orden
+    std::istringstream entrada(corrida.salida);
+    std::string linea;
+    configuracion.metas.clear();
+    configuracion.ajustes.clear();
+    while (std::getline(entrada, linea))
+    {
+        size_t igual = linea.find('=');
+        if (linea.rfind("ajuste_", 0) == 0 && igual != std::string::npos)
+        {
+            std::string nombre = linea.substr(7, igual - 7);
+            configuracion.ajustes.push_back({nombre, "", static_cast<int>(v.at(linea.substr(0, igual)))});
+        }
+        else if (linea.rfind("simbolo_", 0) == 0 && igual != std::string::npos)
+        {
+            std::string nombre = linea.substr(8, igual - 8);
+            for (Ajuste &ajuste : configuracion.ajustes)
+            {
+                if (ajuste.nombre == nombre)
+                    ajuste.simbolo = linea.substr(igual + 1);
+            }
+        }
+
+        if (linea.rfind("metas=", 0) == 0)
+        {
+            std::istringstream metas(linea.substr(6));
+            int fila, columna;
+            char coma;
+            while (metas >> fila >> coma >> columna)
+                configuracion.metas.push_back({fila, columna});
+        }
+        else if (linea.rfind("orden=", 0) == 0)
+            configuracion.orden = linea.substr(6);
+    }
+    return !configuracion.metas.empty();
+}
+
+std::vector<Entrada> generar_corpus(const Configuracion &configuracion, const std::vector<TipoLaberinto> &tipos,
+                                    size_t n, uint32_t semilla, const std::string &directorio)
+{
+    std::vector<Entrada> corpus;
+    std::filesystem::create_directories(directorio);
+
+    std::mt19937 aleatorio(semilla);
+    for (TipoLaberinto tipo : tipos)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            Laberinto laberinto = generar_laberinto(tipo, configuracion.filas, configuracion.columnas,
+                                                    configuracion.inicio, configuracion.metas, aleatorio);
+            char nombre[64];
+            std::snprintf(nombre, sizeof(nombre), "%s_%04zu.txt", nombre_tipo(tipo), i);
+            std::filesystem::path ruta = std::filesystem::path(directorio) / nombre;
+            std::ofstream(ruta) << laberinto.texto();
+            corpus.push_back({nombre_tipo(tipo), ruta.string()});
+        }
+    }
+    return corpus;
+}
+
+std::vector<Entrada> leer_corpus(const Configuracion &configuracion, const std::string &directorio)
+{
+    std::vector<Entrada> corpus;
+    std::set<std::filesystem::path> rutas;
+    std::error_code error;
+    for (const auto &archivo : std::filesystem::directory_iterator(directorio, error))
+    {
+        if (archivo.path().extension() == ".txt")
+            rutas.insert(archivo.path());
+    }
+    if (error)
+        std::fprintf(stderr, "%s: %s\n", directorio.c_str(), error.message().c_str());
+
+    for (const std::filesystem::path &ruta : rutas)
+    {
+        std::ifstream entrada(ruta);
+        std::stringstream texto;
+        texto << entrada.rdbuf();
+        Laberinto laberinto(1, 1);
+        if (!laberinto.leer(texto.str()) || laberinto.filas() != configuracion.filas ||
+            laberinto.columnas() != configuracion.columnas)
+        {
+            std::fprintf(stderr, "%s: no es un laberinto de %dx%d, se saltea\n", ruta.c_str(), configuracion.filas,
+                         configuracion.columnas);
+            continue;
+        }
+        corpus.push_back({"archivo", ruta.string()});
+    }
+    return corpus;
+}
+
+std::string crear_directorio_temporal(const char *prefijo)
+{
+    std::string plantilla = (std::filesystem::temp_directory_path() / (std::string(prefijo) + ".XXXXXX")).string();
+    if (mkdtemp(plantilla.data()) == nullptr)
+    {
+        std::perror("mkdtemp");
+        return "";
+    }
+    return plantilla;
+}
+
+void en_paralelo(size_t cantidad, unsigned hilos, const std::function<void(size_t)> &tarea,
+                 const std::function<void(size_t hechas)> &progreso)
+{
+    if (hilos == 0)
+        hilos = std::max(1u, std::thread::hardware_concurrency());
+    hilos = static_cast<unsigned>(std::min<size_t>(hilos, std::max<size_t>(cantidad, 1)));
+
+    std::atomic<size_t> siguiente{0};
+    size_t hechas = 0;
+    std::mutex candado;
+
+    auto trabajar = [&]() {
+        for (size_t i = siguiente++; i < cantidad; i = siguiente++)
+        {
+            tarea(i);
+            if (progreso)
+            {
+                std::lock_guard<std::mutex> bloqueo(candado);
+                progreso(++hechas);
+            }
+        }
+    };
+
+    std::vector<std::thread> trabajadores;
+    for (unsigned h = 0; h < hilos; h++)
+        trabajadores.emplace_back(trabajar);
+    for (std::thread &trabajador : trabajadores)
+        trabajador.join();
+}
+
+Resumen resumir(std::vector<double> muestras)
+{
+    Resumen resumen;
+    resumen.cantidad = muestras.size();
+    if (muestras.empty())
+        return resumen;
+
+    std::sort(muestras.begin(), muestras.end());
+    auto percentil = [&](double p) {
+        double posicion = p * static_cast<double>(muestras.size() - 1);
+        size_t abajo = static_cast<size_t>(std::floor(posicion));
+        size_t arriba = std::min(abajo + 1, muestras.size() - 1);
+        return muestras[abajo] + (posicion - static_cast<double>(abajo)) * (muestras[arriba] - muestras[abajo]);
+    };
+
+    resumen.media = std::accumulate(muestras.begin(), muestras.end(), 0.0) / static_cast<double>(muestras.size());
+    resumen.p10 = percentil(0.10);
+    resumen.p50 = percentil(0.50);
+    resumen.p90 = percentil(0.90);
+    resumen.maximo = muestras.back();
+    return resumen;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file corridas.hpp
+ * @brief Corridas de simular en paralelo, para las herramientas de la PC
+ * @author demianmozo
+ *
+ * El estado del firmware son variables globales, así que cada corrida es un
+ * proceso simular aparte; los hilos solo lanzan procesos y leen su salida
+ * "clave=valor".
+ */
+
+#ifndef __CORRIDAS_HPP
+#define __CORRIDAS_HPP
+
+#include "laberintos.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/** @brief Salida de simular: clave -> valor */
+using Valores = std::map<std::string, double>;
+
+/**
+ * @brief Un parámetro de ajuste del firmware (simulador_get_ajustes())
+ */
+struct Ajuste
+{
+    std::string nombre;  ///< Como en simular --ajuste y el "set" por UART
+    std::string simbolo; ///< #define que le da el valor inicial
+    int valor = 0;       ///< Valor con que se compiló
+};
+
+/**
+ * @brief Con qué se compiló una variante de simular (simular --config)
+ */
+struct Configuracion
+{
+    int filas = 0;
+    int columnas = 0;
+    Casilla inicio;
+    std::vector<Casilla> metas;
+    std::string orden;
+    bool planificar_con_giros = false;
+    bool odometria_encoders = false;
+    std::vector<Ajuste> ajustes;
+};
+
+/**
+ * @brief Un laberinto del corpus
+ */
+struct Entrada
+{
+    std::string tipo; ///< nombre_tipo() o "archivo"
+    std::string ruta;
+};
+
+/**
+ * @brief Resultado de una corrida de simular
+ */
+struct Corrida
+{
+    int codigo = -1; ///< Código de salida (0 = limpia, 1 = llegó mal o no llegó, otro = no corrió)
+    Valores valores;
+    std::string salida; ///< Texto tal cual, para las salidas que no son "clave=valor"
+};
+
+/**
+ * @brief Corre un programa con argumentos y toma su salida estándar
+ * @note stderr se descarta (la --traza no sirve con muchas corridas)
+ */
+Corrida ejecutar(const std::vector<std::string> &argumentos);
+
+/** @brief Lee las líneas "clave=valor" numéricas */
+Valores leer_valores(const std::string &salida);
+
+/**
+ * @brief Pide la configuración a una variante de simular
+ * @return false si no corrió o la salida no se entiende
+ */
+bool leer_configuracion(const std::string &simulador, Configuracion &configuracion);
+
+/**
+ * @brief Genera n laberintos de cada tipo para la cancha de una configuración
+ * @param directorio Donde se escriben (tipo_NNNN.txt); tiene que existir o poder crearse
+ */
+std::vector<Entrada> generar_corpus(const Configuracion &configuracion, const std::vector<TipoLaberinto> &tipos,
+                                    size_t n, uint32_t semilla, const std::string &directorio);
+
+/**
+ * @brief Los .txt de un directorio con el tamaño de la configuración (avisa por stderr los que no)
+ */
+std::vector<Entrada> leer_corpus(const Configuracion &configuracion, const std::string &directorio);
+
+/**
+ * @brief Crea un directorio temporal nuevo
+ * @return Su ruta, vacía si no se pudo (avisa por stderr)
+ */
+std::string crear_directorio_temporal(const char *prefijo);
+
+/**
+ * @brief Llama a tarea(i) para i en [0, cantidad) desde varios hilos
+ * @param hilos 0 = uno por núcleo
+ * @param progreso Si no es nulo, se llama (de a uno) cada vez que termina una tarea
+ */
+void en_paralelo(size_t cantidad, unsigned hilos, const std::function<void(size_t)> &tarea,
+                 const std::function<void(size_t hechas)> &progreso = nullptr);
+
+/**
+ * @brief Resumen de una distribución
+ */
+struct Resumen
+{
+    size_t cantidad = 0;
+    double media = 0;
+    double p10 = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double maximo = 0;
+};
+
+Resumen resumir(std::vector<double> muestras);
+
+#endif /* __CORRIDAS_HPP */
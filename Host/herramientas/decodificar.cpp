@@ -0,0 +1,408 @@
+/**
+ * @file decodificar.cpp
+ * @brief Pasa una captura de la UART del robot (tramas COBS + CRC16) a CSV o JSON
+ * @author demianmozo
+ *
+ *   decodificar [captura.bin | -] [--json] [--salida ARCHIVO]
+ *
+ *   --json              Una línea JSON por trama en vez de CSV
+ *   --salida ARCHIVO    Escribir ahí en vez de la salida estándar
+ *
+ * Lee la captura cruda (p. ej. simular --captura o lo que se grabó del puerto
+ * serie) y decodifica las tramas de telemetria.h: la telemetría (salvo con
+ * TELEMETRIA_BINARIA=0) y el volcado de registro_volcar(). Lo que no es una
+ * trama (el texto de la telemetría en modo texto, las respuestas a comandos)
+ * se saltea. Al final avisa por stderr cuántas tramas leyó, cuántas tenían el
+ * CRC mal y cuántas se perdieron según los saltos de secuencia. Termina con 1
+ * si hubo tramas rotas o perdidas.
+ *
+ * El CSV tiene una columna por campo de todos los tipos de trama; cada fila
+ * llena solo los de su tipo.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/* Igual que telemetria.h y registro.h */
+enum TipoTrama : uint8_t
+{
+    casilla = 1,
+    muro,
+    giro,
+    sensores,
+    tiempo,
+    evento,
+    registro,
+    volcado
+};
+
+enum TipoRegistro : uint8_t
+{
+    registro_adc = 0,
+    registro_linea,
+    registro_muro,
+    registro_posicion,
+    registro_motor,
+    registro_calibracion
+};
+
+const size_t largo_cabecera = 6; ///< tipo + secuencia + tiempo_ms
+
+/** @brief Columnas del CSV, en orden */
+const char *const columnas[] = {"tiempo_ms", "secuencia", "tipo",   "fila",  "columna",  "sentido", "direccion",
+                                "peso",      "ciclos",    "desde",  "hacia", "izq",      "der",     "etapa",
+                                "evento",    "motor",     "estado", "pwm",   "cantidad", "umbral"};
+
+/**
+ * @brief Una trama decodificada: tipo y campos (nombre, valor) en orden
+ */
+struct Trama
+{
+    uint32_t tiempo_ms;
+    uint8_t secuencia;
+    std::string tipo;
+    std::vector<std::pair<std::string, std::string>> campos;
+};
+
+/** @brief Mismo CRC16-CCITT (0x1021, inicial 0xFFFF) que telemetria.c */
+uint16_t crc16(const uint8_t *datos, size_t largo)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < largo; i++)
+    {
+        crc ^= static_cast<uint16_t>(datos[i] << 8);
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * @brief Decodifica COBS (sin el 0x00 separador)
+ * @return false si no es COBS válido
+ */
+bool cobs_decodificar(const std::vector<uint8_t> &entrada, std::vector<uint8_t> &salida)
+{
+    salida.clear();
+    size_t i = 0;
+    while (i < entrada.size())
+    {
+        uint8_t codigo = entrada[i++];
+        if (codigo == 0 || i + codigo - 1 > entrada.size())
+            return false;
+        salida.insert(salida.end(), entrada.begin() + i, entrada.begin() + i + codigo - 1);
+        i += codigo - 1;
+        if (codigo != 0xFF && i < entrada.size())
+            salida.push_back(0);
+    }
+    return true;
+}
+
+uint32_t leer_u16(const uint8_t *datos)
+{
+    return datos[0] | (datos[1] << 8);
+}
+
+uint32_t leer_u32(const uint8_t *datos)
+{
+    return datos[0] | (datos[1] << 8) | (datos[2] << 16) | (static_cast<uint32_t>(datos[3]) << 24);
+}
+
+std::string nombre_sentido(uint8_t sentido)
+{
+    static const char *const nombres[] = {"norte", "este", "sur", "oeste"};
+    return sentido < 4 ? nombres[sentido] : std::to_string(sentido);
+}
+
+/**
+ * @brief Campos de una trama según su tipo
+ * @return false si el tipo no se conoce o el largo no coincide
+ */
+bool leer_campos(const uint8_t *datos, size_t largo, uint8_t tipo, Trama &trama)
+{
+    auto numero = [&](const char *nombre, uint32_t valor) { trama.campos.push_back({nombre, std::to_string(valor)}); };
+    auto nombre = [&](const char *campo, std::string valor) { trama.campos.push_back({campo, std::move(valor)}); };
+
+    switch (tipo)
+    {
+    case casilla:
+        if (largo != 5)
+            return false;
+        trama.tipo = "casilla";
+        numero("fila", datos[0]);
+        numero("columna", datos[1]);
+        nombre("sentido", nombre_sentido(datos[2]));
+        numero("peso", leer_u16(&datos[3]));
+        return true;
+
+    case muro:
+        if (largo != 7)
+            return false;
+        trama.tipo = "muro";
+        numero("fila", datos[0]);
+        numero("columna", datos[1]);
+        nombre("direccion", nombre_sentido(datos[2]));
+        numero("ciclos", leer_u32(&datos[3]));
+        return true;
+
+    case giro:
+        if (largo != 2)
+            return false;
+        trama.tipo = "giro";
+        nombre("desde", nombre_sentido(datos[0]));
+        nombre("hacia", nombre_sentido(datos[1]));
+        return true;
+
+    case sensores:
+        if (largo != 4)
+            return false;
+        trama.tipo = "sensores";
+        numero("izq", leer_u16(&datos[0]));
+        numero("der", leer_u16(&datos[2]));
+        return true;
+
+    case tiempo:
+        if (largo != 5)
+            return false;
+        trama.tipo = "tiempo";
+        nombre("etapa", datos[0] == 0 ? "decision" : datos[0] == 1 ? "ruta" : std::to_string(datos[0]));
+        numero("ciclos", leer_u32(&datos[1]));
+        return true;
+
+    case evento:
+        if (largo != 1)
+            return false;
+        trama.tipo = "evento";
+        nombre("evento", datos[0] == 0   ? "inicio"
+                         : datos[0] == 1 ? "meta"
+                         : datos[0] == 2 ? "sprint"
+                                         : std::to_string(datos[0]));
+        return true;
+
+    case registro:
+    {
+        if (largo != 6)
+            return false;
+        uint8_t extra = datos[1];
+        uint32_t a = leer_u16(&datos[2]);
+        uint32_t b = leer_u16(&datos[4]);
+        switch (datos[0])
+        {
+        case registro_adc:
+            trama.tipo = "registro_adc";
+            numero("izq", a);
+            numero("der", b);
+            return true;
+        case registro_linea:
+            trama.tipo = "registro_linea";
+            numero("fila", a);
+            numero("columna", b);
+            return true;
+        case registro_muro:
+        case registro_posicion:
+            trama.tipo = datos[0] == registro_muro ? "registro_muro" : "registro_posicion";
+            nombre("sentido", nombre_sentido(extra));
+            numero("fila", a);
+            numero("columna", b);
+            return true;
+        case registro_motor:
+            trama.tipo = "registro_motor";
+            numero("motor", extra);
+            numero("estado", a);
+            numero("pwm", b);
+            return true;
+        case registro_calibracion:
+            trama.tipo = "registro_calibracion";
+            nombre("umbral", extra == 0   ? "cerca"
+                             : extra == 1 ? "lejos"
+                             : extra == 2 ? "centrado"
+                                          : std::to_string(extra));
+            numero("izq", a);
+            numero("der", b);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    case volcado:
+        if (largo != 3)
+            return false;
+        trama.tipo = datos[0] ? "volcado_fin" : "volcado_inicio";
+        numero("cantidad", leer_u16(&datos[1]));
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Cuentas de la decodificación, para el resumen
+ */
+struct Resumen
+{
+    size_t tramas = 0;
+    size_t crc_mal = 0;
+    size_t desconocidas = 0;
+    size_t no_tramas = 0;
+    size_t perdidas = 0;
+};
+
+void escribir_csv(std::ostream &salida, const Trama &trama)
+{
+    salida << trama.tiempo_ms << "," << static_cast<unsigned>(trama.secuencia) << "," << trama.tipo;
+    for (size_t c = 3; c < std::size(columnas); c++)
+    {
+        salida << ",";
+        for (const auto &[nombre, valor] : trama.campos)
+        {
+            if (nombre == columnas[c])
+                salida << valor;
+        }
+    }
+    salida << "\n";
+}
+
+void escribir_json(std::ostream &salida, const Trama &trama)
+{
+    salida << "{\"tiempo_ms\":" << trama.tiempo_ms << ",\"secuencia\":" << static_cast<unsigned>(trama.secuencia)
+           << ",\"tipo\":\"" << trama.tipo << "\"";
+    for (const auto &[nombre, valor] : trama.campos)
+    {
+        bool es_numero = !valor.empty() && valor.find_first_not_of("0123456789") == std::string::npos;
+        salida << ",\"" << nombre << "\":";
+        if (es_numero)
+            salida << valor;
+        else
+            salida << "\"" << valor << "\"";
+    }
+    salida << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string entrada_ruta = "-", salida_ruta;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string opcion = argv[i];
+        if (opcion == "--json")
+            json = true;
+        else if (opcion == "--salida" && i + 1 < argc)
+            salida_ruta = argv[++i];
+        else if ((opcion == "-" || opcion[0] != '-') && entrada_ruta == "-")
+            entrada_ruta = opcion;
+        else
+        {
+            std::fprintf(stderr, "uso: %s [captura.bin | -] [--json] [--salida ARCHIVO]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<uint8_t> captura;
+    if (entrada_ruta == "-")
+    {
+        captura.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    }
+    else
+    {
+        std::ifstream archivo(entrada_ruta, std::ios::binary);
+        if (!archivo)
+        {
+            std::fprintf(stderr, "%s: no se puede leer\n", entrada_ruta.c_str());
+            return 2;
+        }
+        captura.assign(std::istreambuf_iterator<char>(archivo), std::istreambuf_iterator<char>());
+    }
+
+    std::ofstream archivo_salida;
+    if (!salida_ruta.empty())
+    {
+        archivo_salida.open(salida_ruta);
+        if (!archivo_salida)
+        {
+            std::fprintf(stderr, "%s: no se puede escribir\n", salida_ruta.c_str());
+            return 2;
+        }
+    }
+    std::ostream &salida = salida_ruta.empty() ? std::cout : archivo_salida;
+
+    if (!json)
+    {
+        for (size_t c = 0; c < std::size(columnas); c++)
+            salida << (c ? "," : "") << columnas[c];
+        salida << "\n";
+    }
+
+    Resumen resumen;
+    bool hay_anterior = false;
+    uint8_t secuencia_anterior = 0;
+    std::vector<uint8_t> trozo, trama_cruda;
+
+    for (uint8_t byte : captura)
+    {
+        if (byte != 0)
+        {
+            trozo.push_back(byte);
+            continue;
+        }
+        if (trozo.empty())
+            continue; // Separador suelto (ver telemetria_volcado())
+
+        // Texto de la telemetría en modo texto o respuestas a comandos
+        bool es_texto = std::all_of(trozo.begin(), trozo.end(), [](uint8_t c) {
+            return c == '\r' || c == '\n' || (c >= 0x20 && c < 0x7F);
+        });
+        bool cobs_bien = cobs_decodificar(trozo, trama_cruda);
+        trozo.clear();
+        size_t largo = trama_cruda.size() - 2;
+        if (!cobs_bien || trama_cruda.size() < largo_cabecera + 2 ||
+            crc16(trama_cruda.data(), largo) != leer_u16(&trama_cruda[largo]))
+        {
+            if (es_texto || !cobs_bien)
+                resumen.no_tramas++;
+            else
+                resumen.crc_mal++;
+            continue;
+        }
+
+        Trama trama;
+        trama.secuencia = trama_cruda[1];
+        trama.tiempo_ms = leer_u32(&trama_cruda[2]);
+        if (hay_anterior)
+            resumen.perdidas += static_cast<uint8_t>(trama.secuencia - secuencia_anterior - 1);
+        hay_anterior = true;
+        secuencia_anterior = trama.secuencia;
+
+        if (!leer_campos(&trama_cruda[largo_cabecera], largo - largo_cabecera, trama_cruda[0], trama))
+        {
+            resumen.desconocidas++;
+            continue;
+        }
+
+        resumen.tramas++;
+        if (json)
+            escribir_json(salida, trama);
+        else
+            escribir_csv(salida, trama);
+    }
+
+    std::fprintf(stderr, "%zu tramas, %zu con el CRC mal, %zu de tipo desconocido, %zu perdidas por secuencia, "
+                         "%zu trozos que no son tramas\n",
+                 resumen.tramas, resumen.crc_mal, resumen.desconocidas, resumen.perdidas, resumen.no_tramas);
+    return resumen.crc_mal + resumen.desconocidas + resumen.perdidas == 0 ? 0 : 1;
+}
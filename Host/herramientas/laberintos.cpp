@@ -0,0 +1,414 @@
+/**
+ * @file laberintos.cpp
+ * @brief Generación de laberintos y formato de texto
+ * @author demianmozo
+ */
+
+#include "laberintos.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+
+namespace
+{
+
+/** @brief Direcciones en el orden de brujula.h */
+enum Direccion
+{
+    norte = 0,
+    este,
+    sur,
+    oeste
+};
+
+const int delta_fila[4] = {-1, 0, 1, 0};
+const int delta_columna[4] = {0, 1, 0, -1};
+
+/**
+ * @brief Un muro visto desde una casilla
+ */
+struct Muro
+{
+    int fila;
+    int columna;
+    Direccion direccion;
+};
+
+bool hay_muro(const Laberinto &laberinto, int fila, int columna, Direccion direccion)
+{
+    switch (direccion)
+    {
+    case norte:
+        return laberinto.horizontal(fila - 1, columna);
+    case sur:
+        return laberinto.horizontal(fila, columna);
+    case oeste:
+        return laberinto.vertical(fila, columna - 1);
+    case este:
+    default:
+        return laberinto.vertical(fila, columna);
+    }
+}
+
+void poner_muro(Laberinto &laberinto, int fila, int columna, Direccion direccion, bool muro)
+{
+    switch (direccion)
+    {
+    case norte:
+        laberinto.set_horizontal(fila - 1, columna, muro);
+        break;
+    case sur:
+        laberinto.set_horizontal(fila, columna, muro);
+        break;
+    case oeste:
+        laberinto.set_vertical(fila, columna - 1, muro);
+        break;
+    case este:
+    default:
+        laberinto.set_vertical(fila, columna, muro);
+        break;
+    }
+}
+
+bool adentro(const Laberinto &laberinto, int fila, int columna)
+{
+    return fila >= 1 && fila <= laberinto.filas() && columna >= 1 && columna <= laberinto.columnas();
+}
+
+/**
+ * @brief Muros interiores (cada uno una vez: hacia el este o el sur de su casilla)
+ */
+std::vector<Muro> muros_interiores(const Laberinto &laberinto)
+{
+    std::vector<Muro> muros;
+    for (int f = 1; f <= laberinto.filas(); f++)
+    {
+        for (int c = 1; c <= laberinto.columnas(); c++)
+        {
+            if (c < laberinto.columnas())
+                muros.push_back({f, c, este});
+            if (f < laberinto.filas())
+                muros.push_back({f, c, sur});
+        }
+    }
+    return muros;
+}
+
+/**
+ * @brief Conjuntos disjuntos de casillas, para saber qué está conectado
+ */
+class Componentes
+{
+public:
+    explicit Componentes(int cantidad) : padre_(cantidad)
+    {
+        std::iota(padre_.begin(), padre_.end(), 0);
+    }
+
+    int raiz(int i)
+    {
+        while (padre_[i] != i)
+        {
+            padre_[i] = padre_[padre_[i]];
+            i = padre_[i];
+        }
+        return i;
+    }
+
+    /** @brief Une dos conjuntos; false si ya estaban unidos */
+    bool unir(int a, int b)
+    {
+        a = raiz(a);
+        b = raiz(b);
+        if (a == b)
+            return false;
+        padre_[a] = b;
+        return true;
+    }
+
+private:
+    std::vector<int> padre_;
+};
+
+/**
+ * @brief Laberinto perfecto por backtracking desde una casilla
+ */
+void tallar_perfecto(Laberinto &laberinto, Casilla inicio, std::mt19937 &aleatorio)
+{
+    std::vector<uint8_t> visitada(laberinto.filas() * laberinto.columnas(), 0);
+    auto indice = [&](int f, int c) { return (f - 1) * laberinto.columnas() + (c - 1); };
+    std::vector<Casilla> pila = {inicio};
+    visitada[indice(inicio.first, inicio.second)] = 1;
+
+    while (!pila.empty())
+    {
+        auto [fila, columna] = pila.back();
+        std::vector<Direccion> opciones;
+        for (int d = 0; d < 4; d++)
+        {
+            int f = fila + delta_fila[d];
+            int c = columna + delta_columna[d];
+            if (adentro(laberinto, f, c) && !visitada[indice(f, c)])
+                opciones.push_back(static_cast<Direccion>(d));
+        }
+
+        if (opciones.empty())
+        {
+            pila.pop_back();
+            continue;
+        }
+
+        Direccion d = opciones[std::uniform_int_distribution<size_t>(0, opciones.size() - 1)(aleatorio)];
+        poner_muro(laberinto, fila, columna, d, false);
+        int f = fila + delta_fila[d];
+        int c = columna + delta_columna[d];
+        visitada[indice(f, c)] = 1;
+        pila.push_back({f, c});
+    }
+}
+
+/**
+ * @brief Abre muros interiores al azar para dejar caminos alternativos
+ */
+void abrir_lazos(Laberinto &laberinto, std::mt19937 &aleatorio)
+{
+    std::vector<Muro> cerrados;
+    for (const Muro &muro : muros_interiores(laberinto))
+    {
+        if (hay_muro(laberinto, muro.fila, muro.columna, muro.direccion))
+            cerrados.push_back(muro);
+    }
+    std::shuffle(cerrados.begin(), cerrados.end(), aleatorio);
+
+    size_t cantidad = std::max<size_t>(1, laberinto.filas() * laberinto.columnas() / 10);
+    for (size_t i = 0; i < cantidad && i < cerrados.size(); i++)
+    {
+        poner_muro(laberinto, cerrados[i].fila, cerrados[i].columna, cerrados[i].direccion, false);
+    }
+}
+
+/**
+ * @brief Indica si las metas son un bloque de 2x2; deja su esquina noroeste
+ */
+bool bloque_2x2(const std::vector<Casilla> &metas, Casilla &esquina)
+{
+    if (metas.size() != 4)
+        return false;
+
+    esquina = *std::min_element(metas.begin(), metas.end());
+    for (int f = 0; f < 2; f++)
+    {
+        for (int c = 0; c < 2; c++)
+        {
+            Casilla casilla = {esquina.first + f, esquina.second + c};
+            if (std::find(metas.begin(), metas.end(), casilla) == metas.end())
+                return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reglas de las canchas de competencia: sala de meta con una entrada e inicio con una salida
+ * @details Después vuelve a conectar lo que quedó aislado abriendo muros que
+ *          no sean de la sala ni del inicio
+ */
+void aplicar_reglas_clasicas(Laberinto &laberinto, Casilla inicio, const std::vector<Casilla> &metas,
+                             std::mt19937 &aleatorio)
+{
+    std::vector<Muro> protegidos;
+    auto proteger = [&](int f, int c, Direccion d, bool muro) {
+        poner_muro(laberinto, f, c, d, muro);
+        protegidos.push_back({f, c, d});
+    };
+
+    Casilla esquina;
+    if (bloque_2x2(metas, esquina))
+    {
+        auto [f0, c0] = esquina;
+        proteger(f0, c0, este, false); // Adentro de la sala, abierta
+        proteger(f0 + 1, c0, este, false);
+        proteger(f0, c0, sur, false);
+        proteger(f0, c0 + 1, sur, false);
+
+        std::vector<Muro> borde = {{f0, c0, norte},     {f0, c0 + 1, norte}, {f0, c0 + 1, este},
+                                   {f0 + 1, c0 + 1, este}, {f0 + 1, c0 + 1, sur}, {f0 + 1, c0, sur},
+                                   {f0 + 1, c0, oeste},   {f0, c0, oeste}};
+        std::vector<Muro> posibles;
+        for (const Muro &muro : borde)
+        {
+            if (adentro(laberinto, muro.fila + delta_fila[muro.direccion], muro.columna + delta_columna[muro.direccion]))
+                posibles.push_back(muro);
+        }
+        size_t entrada = std::uniform_int_distribution<size_t>(0, posibles.size() - 1)(aleatorio);
+        for (size_t i = 0; i < posibles.size(); i++)
+        {
+            proteger(posibles[i].fila, posibles[i].columna, posibles[i].direccion, i != entrada);
+        }
+    }
+
+    auto [fi, ci] = inicio;
+    for (int d = 0; d < 4; d++)
+    {
+        Direccion direccion = static_cast<Direccion>(d);
+        if (adentro(laberinto, fi + delta_fila[d], ci + delta_columna[d]))
+            proteger(fi, ci, direccion, direccion != norte);
+    }
+
+    // Volver a conectar todo sin tocar los muros protegidos
+    auto indice = [&](int f, int c) { return (f - 1) * laberinto.columnas() + (c - 1); };
+    auto es_protegido = [&](const Muro &muro) {
+        int f = muro.fila + delta_fila[muro.direccion];
+        int c = muro.columna + delta_columna[muro.direccion];
+        for (const Muro &p : protegidos)
+        {
+            int pf = p.fila + delta_fila[p.direccion];
+            int pc = p.columna + delta_columna[p.direccion];
+            if ((p.fila == muro.fila && p.columna == muro.columna && pf == f && pc == c) ||
+                (p.fila == f && p.columna == c && pf == muro.fila && pc == muro.columna))
+                return true;
+        }
+        return false;
+    };
+
+    Componentes componentes(laberinto.filas() * laberinto.columnas());
+    std::vector<Muro> cerrados;
+    for (const Muro &muro : muros_interiores(laberinto))
+    {
+        int f = muro.fila + delta_fila[muro.direccion];
+        int c = muro.columna + delta_columna[muro.direccion];
+        if (!hay_muro(laberinto, muro.fila, muro.columna, muro.direccion))
+            componentes.unir(indice(muro.fila, muro.columna), indice(f, c));
+        else if (!es_protegido(muro))
+            cerrados.push_back(muro);
+    }
+    std::shuffle(cerrados.begin(), cerrados.end(), aleatorio);
+    for (const Muro &muro : cerrados)
+    {
+        int f = muro.fila + delta_fila[muro.direccion];
+        int c = muro.columna + delta_columna[muro.direccion];
+        if (componentes.unir(indice(muro.fila, muro.columna), indice(f, c)))
+            poner_muro(laberinto, muro.fila, muro.columna, muro.direccion, false);
+    }
+}
+
+} // namespace
+
+Laberinto::Laberinto(int filas, int columnas)
+    : filas_(filas), columnas_(columnas), horizontal_((filas + 1) * columnas, 1), vertical_(filas * (columnas + 1), 1)
+{
+}
+
+std::string Laberinto::texto() const
+{
+    std::ostringstream salida;
+    for (int n = 0; n <= filas_; n++)
+    {
+        for (int c = 1; c <= columnas_; c++)
+            salida << (horizontal(n, c) ? "o---" : "o   ");
+        salida << "o\n";
+
+        if (n == filas_)
+            break;
+
+        for (int l = 0; l <= columnas_; l++)
+        {
+            salida << (vertical(n + 1, l) ? "|" : " ");
+            if (l < columnas_)
+                salida << "   ";
+        }
+        salida << "\n";
+    }
+    return salida.str();
+}
+
+bool Laberinto::leer(const std::string &texto)
+{
+    std::vector<std::string> lineas;
+    std::istringstream entrada(texto);
+    std::string linea;
+    size_t ancho = 0;
+
+    while (std::getline(entrada, linea))
+    {
+        if (!linea.empty() && linea.back() == '\r')
+            linea.pop_back();
+        if (linea.empty())
+        {
+            if (lineas.empty())
+                continue;
+            break;
+        }
+        ancho = std::max(ancho, linea.size());
+        lineas.push_back(linea);
+    }
+
+    if (lineas.size() < 3 || lineas.size() % 2 == 0 || ancho < 5)
+        return false;
+
+    *this = Laberinto(static_cast<int>(lineas.size() - 1) / 2, static_cast<int>(ancho - 1) / 4);
+    auto muro = [&](const std::string &l, size_t posicion) { return posicion < l.size() && l[posicion] != ' '; };
+
+    for (int n = 0; n <= filas_; n++)
+    {
+        for (int c = 1; c <= columnas_; c++)
+            set_horizontal(n, c, n == 0 || n == filas_ || muro(lineas[2 * n], 4 * (c - 1) + 2));
+    }
+    for (int f = 1; f <= filas_; f++)
+    {
+        for (int l = 0; l <= columnas_; l++)
+            set_vertical(f, l, l == 0 || l == columnas_ || muro(lineas[2 * f - 1], 4 * l));
+    }
+    return true;
+}
+
+const char *nombre_tipo(TipoLaberinto tipo)
+{
+    switch (tipo)
+    {
+    case TipoLaberinto::perfecto:
+        return "perfecto";
+    case TipoLaberinto::lazos:
+        return "lazos";
+    case TipoLaberinto::clasico:
+    default:
+        return "clasico";
+    }
+}
+
+bool leer_tipos(const std::string &texto, std::vector<TipoLaberinto> &tipos)
+{
+    tipos.clear();
+    std::istringstream entrada(texto);
+    std::string nombre;
+    while (std::getline(entrada, nombre, ','))
+    {
+        bool conocido = false;
+        for (TipoLaberinto tipo : {TipoLaberinto::perfecto, TipoLaberinto::lazos, TipoLaberinto::clasico})
+        {
+            if (nombre == nombre_tipo(tipo))
+            {
+                tipos.push_back(tipo);
+                conocido = true;
+            }
+        }
+        if (!conocido)
+            return false;
+    }
+    return !tipos.empty();
+}
+
+Laberinto generar_laberinto(TipoLaberinto tipo, int filas, int columnas, Casilla inicio,
+                            const std::vector<Casilla> &metas, std::mt19937 &aleatorio)
+{
+    Laberinto laberinto(filas, columnas);
+
+    tallar_perfecto(laberinto, inicio, aleatorio);
+    if (tipo != TipoLaberinto::perfecto)
+        abrir_lazos(laberinto, aleatorio);
+    if (tipo == TipoLaberinto::clasico)
+        aplicar_reglas_clasicas(laberinto, inicio, metas, aleatorio);
+
+    return laberinto;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file laberintos.hpp
+ * @brief Laberintos para las herramientas de la PC: generación y formato de texto
+ * @author demianmozo
+ *
+ * Mismo formato de texto que modelo_leer_laberinto() (Host/simulador), así
+ * los laberintos generados se pueden pasar tal cual a simular.
+ */
+
+#ifndef __LABERINTOS_HPP
+#define __LABERINTOS_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** @brief Casilla (fila, columna), numeradas desde 1 como en laberinto.h */
+using Casilla = std::pair<int, int>;
+
+/**
+ * @brief Muros de un laberinto de filas x columnas
+ */
+class Laberinto
+{
+public:
+    Laberinto(int filas, int columnas);
+
+    int filas() const { return filas_; }
+    int columnas() const { return columnas_; }
+
+    /** @brief Muro horizontal en la línea n (0 = borde norte) de la columna c (desde 1) */
+    bool horizontal(int n, int c) const { return horizontal_[n * columnas_ + (c - 1)] != 0; }
+    void set_horizontal(int n, int c, bool muro) { horizontal_[n * columnas_ + (c - 1)] = muro; }
+
+    /** @brief Muro vertical en la línea l (0 = borde oeste) de la fila f (desde 1) */
+    bool vertical(int f, int l) const { return vertical_[(f - 1) * (columnas_ + 1) + l] != 0; }
+    void set_vertical(int f, int l, bool muro) { vertical_[(f - 1) * (columnas_ + 1) + l] = muro; }
+
+    /** @brief Texto en el formato de modelo_leer_laberinto() */
+    std::string texto() const;
+
+    /** @brief Lee el formato de texto; false si no sirve */
+    bool leer(const std::string &texto);
+
+private:
+    int filas_;
+    int columnas_;
+    std::vector<uint8_t> horizontal_;
+    std::vector<uint8_t> vertical_;
+};
+
+/** @brief Clases de laberinto que arma generar_laberinto() */
+enum class TipoLaberinto
+{
+    perfecto, ///< Un solo camino entre dos casillas (backtracking)
+    lazos,    ///< Perfecto con muros de más abiertos: caminos alternativos
+    clasico   ///< Lazos, meta en una sala con una sola entrada e inicio con una sola salida al norte
+};
+
+/** @brief Nombre para los informes ("perfecto", "lazos", "clasico") */
+const char *nombre_tipo(TipoLaberinto tipo);
+
+/** @brief Lee una lista de nombres de tipo separados por comas; false si alguno no existe */
+bool leer_tipos(const std::string &texto, std::vector<TipoLaberinto> &tipos);
+
+/**
+ * @brief Genera un laberinto conexo al azar
+ * @param inicio Casilla de largada (en clasico queda abierta solo al norte)
+ * @param metas Casillas meta (en clasico, si son un bloque de 2x2, una sala con una entrada)
+ */
+Laberinto generar_laberinto(TipoLaberinto tipo, int filas, int columnas, Casilla inicio,
+                            const std::vector<Casilla> &metas, std::mt19937 &aleatorio);
+
+#endif /* __LABERINTOS_HPP */
@@ -0,0 +1,201 @@
+/**
+ * @file memoria_muros.c
+ * @brief RAM y costo en la PC de laberinto_hay_muro(): muros empaquetados contra casilla_t
+ * @author demianmozo
+ *
+ * Compara el almacenamiento actual del laberinto (un bit por tramo en
+ * muros_horizontales[] y muros_verticales[], pesos en un arreglo aparte y la
+ * caché direcciones_libres[]) con el de antes: una matriz de casilla_t con la
+ * posición, el peso y cuatro bool por casilla, donde cada muro interior
+ * estaba dos veces. Los tamaños salen de los mismos tipos que usa laberinto.c;
+ * el peso de casilla_t se toma de 16 bits (peso_t) para que las dos versiones
+ * sirvan hasta 32x32.
+ *
+ * Para el costo arma un laberinto al azar con laberinto_set_muro(), copia sus
+ * muros a la matriz de casilla_t (y verifica que las dos digan lo mismo) y
+ * recorre PASADAS veces todas las casillas y direcciones con cada versión de
+ * laberinto_hay_muro(); queda la pasada más rápida, en ns por consulta. La
+ * versión de casilla_t es una copia de la de antes, sin inline, como la
+ * actual que llega desde otro archivo. Se compila una vez por tamaño:
+ * memoria_muros es el 4x4 por defecto, memoria_muros_16x16 y memoria_muros_32x32.
+ *
+ *   memoria_muros [consultas por pasada en millones, 20 por defecto]
+ */
+
+#include "laberinto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PASADAS 5 ///< Se queda la más rápida
+
+/** @brief Casilla como era antes de empaquetar los muros */
+typedef struct
+{
+    posicion_t posicion; ///< Identificación de la casilla (fila, columna)
+    peso_t peso;         ///< Peso actual de la casilla (distancia a meta)
+    bool muros[4];       ///< Muros en cada dirección [norte, este, sur, oeste]
+} casilla_t;
+
+/** @brief Laberinto como era antes, con los mismos muros que el actual */
+static casilla_t laberinto_anterior[FILAS_LABERINTO][COLUMNAS_LABERINTO];
+
+/**
+ * @brief laberinto_hay_muro() sobre casilla_t, como era antes
+ * @details laberinto_posicion_valida() está escrita acá: antes estaba en el
+ *          mismo archivo y el compilador la podía expandir
+ */
+__attribute__((noinline)) static bool hay_muro_anterior(uint8_t fila, uint8_t columna, brujula direccion)
+{
+    if (fila < 1 || fila > FILAS_LABERINTO || columna < 1 || columna > COLUMNAS_LABERINTO)
+    {
+        return true; // Considerar bordes como muros
+    }
+
+    return laberinto_anterior[fila - 1][columna - 1].muros[direccion];
+}
+
+/**
+ * @brief Nanosegundos de reloj real (monotónico)
+ */
+static uint64_t nanosegundos(void)
+{
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (uint64_t)ahora.tv_sec * 1000000000u + (uint64_t)ahora.tv_nsec;
+}
+
+/**
+ * @brief Laberinto al azar: cada tramo interior con muro con probabilidad 1/2
+ */
+static void armar_laberinto(void)
+{
+    uint32_t aleatorio = 1; // xorshift32, el mismo laberinto en cualquier PC
+
+    laberinto_init();
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula direccion = este; direccion <= sur; direccion++)
+            {
+                aleatorio ^= aleatorio << 13;
+                aleatorio ^= aleatorio >> 17;
+                aleatorio ^= aleatorio << 5;
+                if (aleatorio & 1u)
+                    laberinto_set_muro(fila, columna, direccion);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Copia los muros y pesos del laberinto actual a laberinto_anterior
+ * @return false si alguna consulta da distinto en las dos versiones
+ */
+static bool copiar_laberinto(void)
+{
+    bool iguales = true;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            casilla_t *casilla = &laberinto_anterior[fila - 1][columna - 1];
+            casilla->posicion = (posicion_t){fila, columna};
+            casilla->peso = laberinto_get_peso(fila, columna);
+            for (brujula direccion = norte; direccion <= oeste; direccion++)
+            {
+                casilla->muros[direccion] = laberinto_hay_muro(fila, columna, direccion);
+            }
+        }
+    }
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula direccion = norte; direccion <= oeste; direccion++)
+            {
+                if (hay_muro_anterior(fila, columna, direccion) != laberinto_hay_muro(fila, columna, direccion))
+                    iguales = false;
+            }
+        }
+    }
+    return iguales;
+}
+
+/**
+ * @brief Recorre todas las casillas y direcciones vueltas veces con una versión
+ * @param muros Cantidad de consultas que dieron muro (para que no se descarte el bucle)
+ * @return ns de la pasada más rápida
+ */
+static uint64_t medir(bool (*hay_muro)(uint8_t, uint8_t, brujula), uint32_t vueltas, uint64_t *muros)
+{
+    uint64_t mejor = UINT64_MAX;
+
+    for (uint32_t pasada = 0; pasada < PASADAS; pasada++)
+    {
+        uint64_t cuenta = 0;
+        uint64_t inicio = nanosegundos();
+        for (uint32_t vuelta = 0; vuelta < vueltas; vuelta++)
+        {
+            for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+            {
+                for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+                {
+                    for (brujula direccion = norte; direccion <= oeste; direccion++)
+                    {
+                        cuenta += hay_muro(fila, columna, direccion);
+                    }
+                }
+            }
+        }
+        uint64_t ns = nanosegundos() - inicio;
+        if (ns < mejor)
+            mejor = ns;
+        *muros = cuenta;
+    }
+    return mejor;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t millones = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 20u;
+    if (millones == 0)
+    {
+        fprintf(stderr, "uso: %s [consultas por pasada en millones]\n", argv[0]);
+        return 2;
+    }
+
+    size_t anterior = sizeof(laberinto_anterior);
+    size_t muros = sizeof(mascara_fila_t) * (FILAS_LABERINTO + 1) + sizeof(mascara_columna_t) * (COLUMNAS_LABERINTO + 1);
+    size_t pesos = sizeof(peso_t) * CANTIDAD_CASILLAS;
+    size_t libres = sizeof(uint8_t) * CANTIDAD_CASILLAS; // direcciones_libres[]
+
+    printf("%dx%d: casilla_t de %lu bytes\n", FILAS_LABERINTO, COLUMNAS_LABERINTO, (unsigned long)sizeof(casilla_t));
+    printf("  antes   casilla_t[][]                      %6lu bytes (muros %lu)\n", (unsigned long)anterior,
+           (unsigned long)(4 * sizeof(bool) * CANTIDAD_CASILLAS));
+    printf("  ahora   muros %lu + pesos %lu + libres %lu = %6lu bytes\n", (unsigned long)muros, (unsigned long)pesos,
+           (unsigned long)libres, (unsigned long)(muros + pesos + libres));
+
+    armar_laberinto();
+    if (!copiar_laberinto())
+    {
+        fprintf(stderr, "las dos versiones no ven los mismos muros\n");
+        return 1;
+    }
+
+    uint32_t vueltas = (uint32_t)((uint64_t)millones * 1000000u / (4u * CANTIDAD_CASILLAS));
+    if (vueltas == 0)
+        vueltas = 1;
+    uint64_t consultas = (uint64_t)vueltas * 4u * CANTIDAD_CASILLAS;
+    uint64_t muros_anterior, muros_ahora;
+    uint64_t ns_anterior = medir(hay_muro_anterior, vueltas, &muros_anterior);
+    uint64_t ns_ahora = medir(laberinto_hay_muro, vueltas, &muros_ahora);
+
+    printf("  laberinto_hay_muro() en %llu consultas, lo mejor de %d pasadas:\n", (unsigned long long)consultas, PASADAS);
+    printf("  antes   %.2f ns por consulta\n", (double)ns_anterior / (double)consultas);
+    printf("  ahora   %.2f ns por consulta\n", (double)ns_ahora / (double)consultas);
+
+    return muros_anterior == muros_ahora ? 0 : 1;
+}
@@ -0,0 +1,370 @@
+/**
+ * @file montecarlo.cpp
+ * @brief Exploración y sprint del firmware sobre muchos laberintos, en paralelo
+ * @author demianmozo
+ *
+ *   montecarlo --simulador simular [--simulador otro ...] (--generar N | --laberintos DIR) [opciones]
+ *
+ *   --simulador PATH    Variante de simular (se puede repetir: p. ej. una por ORDEN_EVALUACION)
+ *   --generar N         N laberintos al azar de cada tipo
+ *   --tipos A,B         Tipos a generar: perfecto, lazos, clasico (todos por defecto)
+ *   --laberintos DIR    En vez de generar, los .txt de un directorio
+ *   --guardar DIR       Dejar los laberintos generados en DIR (si no, van a uno temporal)
+ *   --semilla N         Semilla de la generación y del ruido de cada corrida
+ *   --ruido X           Ruido de los IR de simular (--ruido)
+ *   --hilos N           Corridas a la vez (uno por núcleo por defecto)
+ *   --csv ARCHIVO       Una fila por corrida con todos los valores
+ *
+ * Todas las variantes tienen que estar compiladas con el mismo laberinto
+ * (tamaño, inicio y metas; ver simular --config). Por cada variante y tipo de
+ * laberinto informa cuántas corridas llegaron limpias y la distribución de
+ * casillas exploradas, giros y tiempos; con más de una variante, además, la
+ * diferencia corrida a corrida contra la primera. Termina con 0 si todas las
+ * corridas salieron limpias.
+ */
+
+#include "corridas.hpp"
+#include "laberintos.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace
+{
+
+/**
+ * @brief Claves de simular que se resumen, con su nombre en el informe y escala
+ */
+struct Metrica
+{
+    const char *clave;
+    const char *titulo;
+    double escala;
+};
+
+const Metrica metricas[] = {
+    {"exploracion_casillas_distintas", "casillas exploradas", 1.0},
+    {"exploracion_casillas", "pasos de exploración", 1.0},
+    {"exploracion_giros", "giros de exploración", 1.0},
+    {"exploracion_ms", "exploración [s]", 0.001},
+    {"sprint_casillas", "pasos de sprint", 1.0},
+    {"sprint_giros", "giros de sprint", 1.0},
+    {"sprint_ms", "sprint [s]", 0.001},
+    {"total_ms", "total [s]", 0.001},
+};
+
+void uso(const char *programa)
+{
+    std::fprintf(stderr,
+                 "uso: %s --simulador PATH [--simulador PATH ...] (--generar N | --laberintos DIR)\n"
+                 "       [--tipos perfecto,lazos,clasico] [--guardar DIR] [--semilla N] [--ruido X]\n"
+                 "       [--hilos N] [--csv ARCHIVO]\n",
+                 programa);
+}
+
+bool misma_cancha(const Configuracion &a, const Configuracion &b)
+{
+    return a.filas == b.filas && a.columnas == b.columnas && a.inicio == b.inicio && a.metas == b.metas;
+}
+
+double valor(const Valores &valores, const char *clave)
+{
+    auto it = valores.find(clave);
+    return it == valores.end() ? 0.0 : it->second;
+}
+
+/** @brief Llegó a la meta sin choques ni errores de posición en las dos etapas */
+bool limpia(const Corrida &corrida)
+{
+    return corrida.codigo == 0;
+}
+
+/**
+ * @brief Informe de las corridas de una variante sobre un subconjunto del corpus
+ */
+void informar(const std::vector<Corrida> &corridas, const std::vector<size_t> &indices)
+{
+    size_t limpias = 0;
+    for (size_t i : indices)
+        limpias += limpia(corridas[i]);
+    std::printf("    corridas %zu, limpias %zu\n", indices.size(), limpias);
+
+    for (const char *etapa : {"exploracion", "sprint"})
+    {
+        size_t llego = 0, choques = 0, errores = 0;
+        for (size_t i : indices)
+        {
+            const Valores &v = corridas[i].valores;
+            llego += valor(v, (std::string(etapa) + "_llego").c_str()) != 0;
+            choques += valor(v, (std::string(etapa) + "_choques").c_str()) > 0;
+            errores += valor(v, (std::string(etapa) + "_errores_posicion").c_str()) > 0;
+        }
+        std::printf("    %-12s llegó %zu, con choques %zu, con errores de posición %zu\n", etapa, llego, choques,
+                    errores);
+    }
+    std::printf("    %-24s %9s %9s %9s %9s %9s\n", "", "media", "p10", "p50", "p90", "máximo");
+
+    for (const Metrica &metrica : metricas)
+    {
+        std::vector<double> muestras;
+        for (size_t i : indices)
+        {
+            // Solo las etapas que llegaron: las otras se cortan en el tope
+            const Valores &v = corridas[i].valores;
+            bool sprint_metrica = std::strncmp(metrica.clave, "sprint", 6) == 0;
+            bool total = std::strcmp(metrica.clave, "total_ms") == 0;
+            if (!valor(v, "exploracion_llego") || ((sprint_metrica || total) && !valor(v, "sprint_llego")))
+                continue;
+            double x = total ? valor(v, "exploracion_ms") + valor(v, "sprint_ms") : valor(v, metrica.clave);
+            muestras.push_back(x * metrica.escala);
+        }
+
+        Resumen r = resumir(muestras);
+        if (r.cantidad > 0)
+            std::printf("    %-24s %9.2f %9.2f %9.2f %9.2f %9.2f\n", metrica.titulo, r.media, r.p10, r.p50, r.p90,
+                        r.maximo);
+    }
+}
+
+/**
+ * @brief Diferencia corrida a corrida de una variante contra la primera
+ * @details Sobre los laberintos en que las dos salieron limpias
+ */
+void comparar(const std::vector<Corrida> &base, const std::vector<Corrida> &otra, const std::vector<size_t> &indices)
+{
+    for (const char *clave : {"exploracion_ms", "total_ms"})
+    {
+        std::vector<double> diferencias;
+        size_t mejor = 0, peor = 0;
+        for (size_t i : indices)
+        {
+            if (!limpia(base[i]) || !limpia(otra[i]))
+                continue;
+            auto tiempo = [&](const Valores &v) {
+                return std::strcmp(clave, "total_ms") == 0 ? valor(v, "exploracion_ms") + valor(v, "sprint_ms")
+                                                          : valor(v, clave);
+            };
+            double d = (tiempo(otra[i].valores) - tiempo(base[i].valores)) / 1000.0;
+            diferencias.push_back(d);
+            mejor += d < 0;
+            peor += d > 0;
+        }
+
+        Resumen r = resumir(diferencias);
+        if (r.cantidad > 0)
+            std::printf("    %-24s media %+.2f s, p10 %+.2f, p50 %+.2f, p90 %+.2f; más rápida en %zu de %zu, "
+                        "más lenta en %zu\n",
+                        clave, r.media, r.p10, r.p50, r.p90, mejor, r.cantidad, peor);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> simuladores;
+    std::vector<TipoLaberinto> tipos = {TipoLaberinto::perfecto, TipoLaberinto::lazos, TipoLaberinto::clasico};
+    size_t generar = 0;
+    std::string directorio, guardar, csv, ruido;
+    uint32_t semilla = 1;
+    unsigned hilos = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool con_valor = i + 1 < argc;
+        std::string opcion = argv[i];
+
+        if (opcion == "--simulador" && con_valor)
+            simuladores.push_back(argv[++i]);
+        else if (opcion == "--generar" && con_valor)
+            generar = std::strtoul(argv[++i], nullptr, 10);
+        else if (opcion == "--tipos" && con_valor)
+        {
+            if (!leer_tipos(argv[++i], tipos))
+            {
+                std::fprintf(stderr, "tipos desconocidos: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (opcion == "--laberintos" && con_valor)
+            directorio = argv[++i];
+        else if (opcion == "--guardar" && con_valor)
+            guardar = argv[++i];
+        else if (opcion == "--semilla" && con_valor)
+            semilla = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (opcion == "--ruido" && con_valor)
+            ruido = argv[++i];
+        else if (opcion == "--hilos" && con_valor)
+            hilos = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (opcion == "--csv" && con_valor)
+            csv = argv[++i];
+        else
+        {
+            uso(argv[0]);
+            return 2;
+        }
+    }
+
+    if (simuladores.empty() || (generar == 0) == directorio.empty())
+    {
+        uso(argv[0]);
+        return 2;
+    }
+
+    std::vector<Configuracion> configuraciones(simuladores.size());
+    for (size_t s = 0; s < simuladores.size(); s++)
+    {
+        if (!leer_configuracion(simuladores[s], configuraciones[s]))
+        {
+            std::fprintf(stderr, "%s: no responde a --config\n", simuladores[s].c_str());
+            return 2;
+        }
+        if (!misma_cancha(configuraciones[0], configuraciones[s]))
+        {
+            std::fprintf(stderr, "%s: compilado para otro laberinto que %s\n", simuladores[s].c_str(),
+                         simuladores[0].c_str());
+            return 2;
+        }
+    }
+    const Configuracion &cancha = configuraciones[0];
+
+    // Corpus
+    std::vector<Entrada> corpus;
+    std::string temporal;
+    if (generar > 0)
+    {
+        if (guardar.empty())
+        {
+            temporal = guardar = crear_directorio_temporal("montecarlo");
+            if (temporal.empty())
+                return 2;
+        }
+        corpus = generar_corpus(cancha, tipos, generar, semilla, guardar);
+    }
+    else
+    {
+        corpus = leer_corpus(cancha, directorio);
+    }
+
+    if (corpus.empty())
+    {
+        std::fprintf(stderr, "no hay laberintos\n");
+        return 2;
+    }
+
+    // Corridas: cada variante sobre cada laberinto, con la misma semilla por laberinto
+    std::vector<std::vector<Corrida>> corridas(simuladores.size(), std::vector<Corrida>(corpus.size()));
+    size_t total = simuladores.size() * corpus.size();
+    en_paralelo(
+        total, hilos,
+        [&](size_t i) {
+            size_t s = i / corpus.size();
+            size_t l = i % corpus.size();
+            std::vector<std::string> argumentos = {simuladores[s], corpus[l].ruta, "--semilla",
+                                                   std::to_string(semilla + l)};
+            if (!ruido.empty())
+            {
+                argumentos.push_back("--ruido");
+                argumentos.push_back(ruido);
+            }
+            corridas[s][l] = ejecutar(argumentos);
+        },
+        [&](size_t hechas) {
+            std::fprintf(stderr, "\r%zu/%zu corridas", hechas, total);
+            if (hechas == total)
+                std::fprintf(stderr, "\n");
+        });
+
+    // Informe
+    std::vector<std::string> grupos;
+    for (const Entrada &entrada : corpus)
+    {
+        if (std::find(grupos.begin(), grupos.end(), entrada.tipo) == grupos.end())
+            grupos.push_back(entrada.tipo);
+    }
+    if (grupos.size() > 1)
+        grupos.push_back("todos");
+
+    auto indices_de = [&](const std::string &grupo) {
+        std::vector<size_t> indices;
+        for (size_t l = 0; l < corpus.size(); l++)
+        {
+            if (grupo == "todos" || corpus[l].tipo == grupo)
+                indices.push_back(l);
+        }
+        return indices;
+    };
+
+    std::printf("laberinto %dx%d, inicio (%d,%d), %zu laberintos\n", cancha.filas, cancha.columnas,
+                cancha.inicio.first, cancha.inicio.second, corpus.size());
+
+    bool todas_limpias = true;
+    for (size_t s = 0; s < simuladores.size(); s++)
+    {
+        const Configuracion &c = configuraciones[s];
+        std::printf("\n%s: orden %s, planificar_con_giros %d, odometria_encoders %d\n", simuladores[s].c_str(),
+                    c.orden.c_str(), c.planificar_con_giros, c.odometria_encoders);
+        for (const std::string &grupo : grupos)
+        {
+            std::printf("  %s\n", grupo.c_str());
+            informar(corridas[s], indices_de(grupo));
+            if (s > 0)
+            {
+                std::printf("   contra %s:\n", simuladores[0].c_str());
+                comparar(corridas[0], corridas[s], indices_de(grupo));
+            }
+        }
+
+        size_t listadas = 0;
+        for (size_t l = 0; l < corpus.size(); l++)
+        {
+            if (limpia(corridas[s][l]))
+                continue;
+            todas_limpias = false;
+            if (listadas++ < 20)
+                std::printf("  no salió limpia (código %d): %s\n", corridas[s][l].codigo, corpus[l].ruta.c_str());
+        }
+        if (listadas > 20)
+            std::printf("  ... y %zu más\n", listadas - 20);
+    }
+
+    if (!csv.empty())
+    {
+        std::set<std::string> claves;
+        for (const auto &por_variante : corridas)
+        {
+            for (const Corrida &corrida : por_variante)
+            {
+                for (const auto &[clave, x] : corrida.valores)
+                    claves.insert(clave);
+            }
+        }
+
+        std::ofstream salida(csv);
+        salida << "simulador,tipo,laberinto,codigo";
+        for (const std::string &clave : claves)
+            salida << "," << clave;
+        salida << "\n";
+        for (size_t s = 0; s < simuladores.size(); s++)
+        {
+            for (size_t l = 0; l < corpus.size(); l++)
+            {
+                salida << simuladores[s] << "," << corpus[l].tipo << "," << corpus[l].ruta << ","
+                       << corridas[s][l].codigo;
+                for (const std::string &clave : claves)
+                    salida << "," << valor(corridas[s][l].valores, clave.c_str());
+                salida << "\n";
+            }
+        }
+    }
+
+    if (!temporal.empty())
+        std::filesystem::remove_all(temporal);
+
+    return todas_limpias ? 0 : 1;
+}
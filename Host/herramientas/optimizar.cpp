@@ -0,0 +1,682 @@
+/**
+ * @file optimizar.cpp
+ * @brief Búsqueda de velocidades y tiempos del firmware sobre el modelo y un corpus de laberintos
+ * @author demianmozo
+ *
+ *   optimizar --simulador simular (--generar N | --laberintos DIR) [opciones]
+ *
+ *   --simulador PATH       Variante de simular a ajustar
+ *   --generar N            N laberintos al azar de cada tipo (ver montecarlo)
+ *   --tipos A,B            Tipos a generar: perfecto, lazos, clasico (todos por defecto)
+ *   --laberintos DIR       En vez de generar, los .txt de un directorio
+ *   --ajuste A[,B]=MIN:MAX:PASO
+ *                          Dimensión de la búsqueda; los nombres de simular --ajuste
+ *                          separados por coma toman el mismo valor (se puede repetir)
+ *   --estrategia E         evolutiva (por defecto) o grilla
+ *   --poblacion N          Candidatos por generación de la evolutiva (12)
+ *   --generaciones N       Generaciones de la evolutiva (10)
+ *   --maximo N             Tope de candidatos de la grilla (5000)
+ *   --semilla N            Semilla de los laberintos, el ruido y la búsqueda
+ *   --ruido X              Ruido de los IR de simular (--ruido)
+ *   --hilos N              Corridas a la vez (uno por núcleo por defecto)
+ *   --header ARCHIVO       Header con los valores ganadores (parametros_robot.h)
+ *   --informe ARCHIVO      Frente de Pareto (pareto.txt)
+ *
+ * Cada candidato corre la exploración y el sprint en todos los laberintos,
+ * con la misma semilla de ruido por laberinto para todos. Gana el de menor
+ * tiempo total medio entre los que salieron limpios en todas las corridas
+ * (llegaron, sin choques y sin errores de posición: ninguna casilla salteada);
+ * si ninguno, el de menos corridas con falla. El header se usa con
+ * -include parametros_robot.h (ver control_motor.h). El informe lista el
+ * frente de Pareto entre violaciones (choques, errores de posición y etapas
+ * sin llegar, sumados) y tiempo total de todo lo evaluado: cuánto tiempo se
+ * gana aceptando qué riesgo. Termina con 0 si el ganador salió limpio en todas.
+ *
+ * Sin --ajuste busca en las velocidades de avance, sprint y giro (cada par
+ * izquierda/derecha con un solo valor) y en los tiempos de giro y de avance
+ * desde la línea; con ODOMETRIA_ENCODERS esos tiempos son solo topes, así que
+ * en su lugar busca en los ángulos de giro y la distancia de avance.
+ */
+
+#include "corridas.hpp"
+#include "laberintos.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+namespace
+{
+
+/**
+ * @brief Una dimensión de la búsqueda: uno o más ajustes con el mismo valor
+ */
+struct Dimension
+{
+    std::vector<std::string> nombres;
+    int minimo;
+    int maximo;
+    int paso;
+};
+
+/** @brief Un valor por dimensión */
+using Candidato = std::vector<int>;
+
+/**
+ * @brief Resultado de un candidato sobre todo el corpus
+ */
+struct Evaluacion
+{
+    size_t fallas = 0;       ///< Corridas que no salieron limpias
+    size_t choques = 0;      ///< Suma de choques de las dos etapas
+    size_t errores = 0;      ///< Suma de errores de posición de las dos etapas
+    size_t no_llego = 0;     ///< Etapas que no llegaron a la meta
+    double total_s = 0;      ///< Exploración + sprint, medio
+    double exploracion_s = 0;
+    double sprint_s = 0;
+
+    /** @brief Choques, errores de posición y etapas sin llegar: 0 solo si no hay fallas */
+    size_t violaciones() const
+    {
+        return choques + errores + no_llego;
+    }
+};
+
+/**
+ * @brief Orden de la búsqueda: menos fallas, menos violaciones y menos tiempo
+ * @details Las violaciones desempatan cuando todos fallan en algo, para que
+ *          la búsqueda vaya hacia donde falla menos y no solo hacia lo rápido
+ */
+bool mejor(const Evaluacion &a, const Evaluacion &b)
+{
+    if (a.fallas != b.fallas)
+        return a.fallas < b.fallas;
+    if (a.violaciones() != b.violaciones())
+        return a.violaciones() < b.violaciones();
+    return a.total_s < b.total_s;
+}
+
+/** @brief a domina a b en (violaciones, tiempo total) */
+bool domina(const Evaluacion &a, const Evaluacion &b)
+{
+    return a.violaciones() <= b.violaciones() && a.total_s <= b.total_s &&
+           (a.violaciones() < b.violaciones() || a.total_s < b.total_s);
+}
+
+void uso(const char *programa)
+{
+    std::fprintf(stderr,
+                 "uso: %s --simulador PATH (--generar N | --laberintos DIR) [--tipos A,B]\n"
+                 "       [--ajuste A[,B]=MIN:MAX:PASO ...] [--estrategia evolutiva|grilla] [--poblacion N]\n"
+                 "       [--generaciones N] [--maximo N] [--semilla N] [--ruido X] [--hilos N]\n"
+                 "       [--header ARCHIVO] [--informe ARCHIVO]\n",
+                 programa);
+}
+
+/**
+ * @brief Lee "A[,B]=MIN:MAX:PASO"
+ */
+bool leer_dimension(const std::string &texto, Dimension &dimension)
+{
+    size_t igual = texto.find('=');
+    if (igual == std::string::npos)
+        return false;
+
+    dimension.nombres.clear();
+    std::istringstream nombres(texto.substr(0, igual));
+    std::string nombre;
+    while (std::getline(nombres, nombre, ','))
+        dimension.nombres.push_back(nombre);
+
+    char dos_puntos_1, dos_puntos_2;
+    std::istringstream rango(texto.substr(igual + 1));
+    rango >> dimension.minimo >> dos_puntos_1 >> dimension.maximo >> dos_puntos_2 >> dimension.paso;
+    return !dimension.nombres.empty() && rango && rango.eof() && dos_puntos_1 == ':' && dos_puntos_2 == ':' &&
+           dimension.minimo >= 0 && dimension.minimo <= dimension.maximo && dimension.paso > 0;
+}
+
+/**
+ * @brief Espacio de búsqueda por defecto (ver el comentario del archivo)
+ */
+std::vector<Dimension> dimensiones_defecto(const Configuracion &configuracion)
+{
+    std::vector<Dimension> dimensiones = {
+        {{"vel_izq", "vel_der"}, 500, 1000, 50},
+        {{"vel_sprint_izq", "vel_sprint_der"}, 600, 1000, 50},
+        {{"vel_giro_izq", "vel_giro_der"}, 400, 1000, 50},
+    };
+
+    if (configuracion.odometria_encoders)
+    {
+        dimensiones.push_back({{"angulo_90"}, 750, 950, 10});
+        dimensiones.push_back({{"angulo_180"}, 1600, 1850, 10});
+        dimensiones.push_back({{"avance_mm"}, 50, 130, 5});
+    }
+    else
+    {
+        dimensiones.push_back({{"giro_izq"}, 250, 900, 10});
+        dimensiones.push_back({{"giro_der"}, 250, 900, 10});
+        dimensiones.push_back({{"giro_180"}, 500, 1800, 20});
+        dimensiones.push_back({{"avance"}, 100, 500, 10});
+        dimensiones.push_back({{"avance_sprint"}, 100, 500, 10});
+    }
+    return dimensiones;
+}
+
+const Ajuste *buscar_ajuste(const Configuracion &configuracion, const std::string &nombre)
+{
+    for (const Ajuste &ajuste : configuracion.ajustes)
+    {
+        if (ajuste.nombre == nombre)
+            return &ajuste;
+    }
+    return nullptr;
+}
+
+int acotar(const Dimension &dimension, int valor)
+{
+    return std::min(dimension.maximo, std::max(dimension.minimo, valor));
+}
+
+/**
+ * @brief Corre candidatos sobre el corpus y guarda su evaluación
+ * @details Los que ya están evaluados no se vuelven a correr
+ */
+class Evaluador
+{
+public:
+    Evaluador(std::string simulador, std::vector<Entrada> corpus, std::vector<Dimension> dimensiones,
+              uint32_t semilla, std::string ruido, unsigned hilos)
+        : simulador_(std::move(simulador)), corpus_(std::move(corpus)), dimensiones_(std::move(dimensiones)),
+          semilla_(semilla), ruido_(std::move(ruido)), hilos_(hilos)
+    {
+    }
+
+    void evaluar(const std::vector<Candidato> &candidatos, const char *etapa)
+    {
+        std::vector<Candidato> nuevos;
+        for (const Candidato &candidato : candidatos)
+        {
+            if (evaluaciones_.count(candidato) == 0 &&
+                std::find(nuevos.begin(), nuevos.end(), candidato) == nuevos.end())
+                nuevos.push_back(candidato);
+        }
+
+        std::vector<Evaluacion> parciales(nuevos.size());
+        std::mutex candado;
+        size_t total = nuevos.size() * corpus_.size();
+        en_paralelo(
+            total, hilos_,
+            [&](size_t i) {
+                size_t c = i / corpus_.size();
+                size_t l = i % corpus_.size();
+                Corrida corrida = ejecutar(argumentos(nuevos[c], l));
+                const Valores &v = corrida.valores;
+                auto valor = [&](const char *clave) {
+                    auto it = v.find(clave);
+                    return it == v.end() ? 0.0 : it->second;
+                };
+
+                std::lock_guard<std::mutex> bloqueo(candado);
+                Evaluacion &e = parciales[c];
+                e.fallas += corrida.codigo != 0;
+                e.choques += static_cast<size_t>(valor("exploracion_choques") + valor("sprint_choques"));
+                e.errores +=
+                    static_cast<size_t>(valor("exploracion_errores_posicion") + valor("sprint_errores_posicion"));
+                e.no_llego += (valor("exploracion_llego") == 0) + (valor("sprint_llego") == 0);
+                e.exploracion_s += valor("exploracion_ms") / 1000.0;
+                e.sprint_s += valor("sprint_ms") / 1000.0;
+            },
+            [&](size_t hechas) {
+                std::fprintf(stderr, "\r%s: %zu/%zu corridas   ", etapa, hechas, total);
+            });
+        if (total > 0)
+            std::fprintf(stderr, "\n");
+
+        for (size_t c = 0; c < nuevos.size(); c++)
+        {
+            Evaluacion &e = parciales[c];
+            e.exploracion_s /= static_cast<double>(corpus_.size());
+            e.sprint_s /= static_cast<double>(corpus_.size());
+            e.total_s = e.exploracion_s + e.sprint_s;
+            evaluaciones_[nuevos[c]] = e;
+        }
+    }
+
+    const Evaluacion &evaluacion(const Candidato &candidato) const
+    {
+        return evaluaciones_.at(candidato);
+    }
+
+    const std::map<Candidato, Evaluacion> &evaluaciones() const
+    {
+        return evaluaciones_;
+    }
+
+private:
+    std::vector<std::string> argumentos(const Candidato &candidato, size_t laberinto) const
+    {
+        std::vector<std::string> argumentos = {simulador_, corpus_[laberinto].ruta, "--semilla",
+                                               std::to_string(semilla_ + laberinto)};
+        if (!ruido_.empty())
+        {
+            argumentos.push_back("--ruido");
+            argumentos.push_back(ruido_);
+        }
+        for (size_t d = 0; d < dimensiones_.size(); d++)
+        {
+            for (const std::string &nombre : dimensiones_[d].nombres)
+            {
+                argumentos.push_back("--ajuste");
+                argumentos.push_back(nombre + "=" + std::to_string(candidato[d]));
+            }
+        }
+        return argumentos;
+    }
+
+    std::string simulador_;
+    std::vector<Entrada> corpus_;
+    std::vector<Dimension> dimensiones_;
+    uint32_t semilla_;
+    std::string ruido_;
+    unsigned hilos_;
+    std::map<Candidato, Evaluacion> evaluaciones_;
+};
+
+/**
+ * @brief Todos los puntos de la grilla
+ * @return Vacío si son más que maximo
+ */
+std::vector<Candidato> grilla(const std::vector<Dimension> &dimensiones, size_t maximo)
+{
+    size_t cantidad = 1;
+    for (const Dimension &d : dimensiones)
+    {
+        cantidad *= static_cast<size_t>((d.maximo - d.minimo) / d.paso + 1);
+        if (cantidad > maximo)
+            return {};
+    }
+
+    std::vector<Candidato> candidatos;
+    Candidato actual;
+    for (const Dimension &d : dimensiones)
+        actual.push_back(d.minimo);
+
+    while (true)
+    {
+        candidatos.push_back(actual);
+        size_t d = 0;
+        for (; d < dimensiones.size(); d++)
+        {
+            actual[d] += dimensiones[d].paso;
+            if (actual[d] <= dimensiones[d].maximo)
+                break;
+            actual[d] = dimensiones[d].minimo;
+        }
+        if (d == dimensiones.size())
+            return candidatos;
+    }
+}
+
+/**
+ * @brief Cambia al menos una dimensión en un número entero de pasos
+ * @param sigma Desvío en pasos
+ */
+Candidato mutar(Candidato candidato, const std::vector<Dimension> &dimensiones, double sigma, std::mt19937 &aleatorio)
+{
+    std::normal_distribution<double> salto(0.0, sigma);
+    std::uniform_real_distribution<double> uniforme(0.0, 1.0);
+    std::uniform_int_distribution<size_t> cual(0, dimensiones.size() - 1);
+    double probabilidad = 1.0 / static_cast<double>(dimensiones.size());
+    size_t obligada = cual(aleatorio);
+
+    for (size_t d = 0; d < dimensiones.size(); d++)
+    {
+        if (d != obligada && uniforme(aleatorio) >= probabilidad)
+            continue;
+
+        int pasos = static_cast<int>(std::lround(salto(aleatorio)));
+        if (pasos == 0)
+            pasos = uniforme(aleatorio) < 0.5 ? -1 : 1;
+        candidato[d] = acotar(dimensiones[d], candidato[d] + pasos * dimensiones[d].paso);
+    }
+    return candidato;
+}
+
+/**
+ * @brief Estrategia evolutiva (mu + lambda) con torneo, cruza uniforme y elitismo
+ */
+Candidato evolucionar(Evaluador &evaluador, const std::vector<Dimension> &dimensiones, const Candidato &base,
+                      size_t tamaño, size_t generaciones, std::mt19937 &aleatorio)
+{
+    auto ordenar = [&](std::vector<Candidato> &candidatos) {
+        std::sort(candidatos.begin(), candidatos.end(), [&](const Candidato &a, const Candidato &b) {
+            return mejor(evaluador.evaluacion(a), evaluador.evaluacion(b));
+        });
+    };
+
+    // Arranca alrededor de los valores actuales del firmware
+    std::vector<Candidato> poblacion = {base};
+    for (size_t i = 1; i < tamaño; i++)
+        poblacion.push_back(mutar(base, dimensiones, 3.0, aleatorio));
+    evaluador.evaluar(poblacion, "generación 0");
+    ordenar(poblacion);
+
+    std::uniform_int_distribution<size_t> elegir(0, poblacion.size() - 1);
+    std::uniform_real_distribution<double> uniforme(0.0, 1.0);
+    auto torneo = [&]() {
+        size_t a = elegir(aleatorio);
+        size_t b = elegir(aleatorio);
+        return poblacion[std::min(a, b)]; // La población está ordenada
+    };
+
+    for (size_t g = 1; g <= generaciones; g++)
+    {
+        std::vector<Candidato> hijos;
+        for (size_t i = 0; i < tamaño; i++)
+        {
+            Candidato hijo = torneo();
+            if (uniforme(aleatorio) < 0.5)
+            {
+                Candidato otro = torneo();
+                for (size_t d = 0; d < dimensiones.size(); d++)
+                {
+                    if (uniforme(aleatorio) < 0.5)
+                        hijo[d] = otro[d];
+                }
+            }
+            hijos.push_back(mutar(hijo, dimensiones, 2.0, aleatorio));
+        }
+
+        std::string etapa = "generación " + std::to_string(g);
+        evaluador.evaluar(hijos, etapa.c_str());
+
+        // Los mejores entre padres e hijos, sin repetidos
+        std::set<Candidato> unicos(poblacion.begin(), poblacion.end());
+        unicos.insert(hijos.begin(), hijos.end());
+        poblacion.assign(unicos.begin(), unicos.end());
+        ordenar(poblacion);
+        poblacion.resize(std::min(poblacion.size(), tamaño));
+        elegir = std::uniform_int_distribution<size_t>(0, poblacion.size() - 1);
+
+        const Evaluacion &e = evaluador.evaluacion(poblacion.front());
+        std::fprintf(stderr, "%s: mejor %zu con falla, %.2f s\n", etapa.c_str(), e.fallas, e.total_s);
+    }
+
+    return poblacion.front();
+}
+
+std::string describir(const std::vector<Dimension> &dimensiones, const Candidato &candidato)
+{
+    std::string texto;
+    for (size_t d = 0; d < dimensiones.size(); d++)
+    {
+        for (const std::string &nombre : dimensiones[d].nombres)
+            texto += (texto.empty() ? "" : " ") + nombre + "=" + std::to_string(candidato[d]);
+    }
+    return texto;
+}
+
+void escribir_evaluacion(FILE *archivo, const char *titulo, const Evaluacion &e, size_t corridas)
+{
+    std::fprintf(archivo,
+                 "%s: %zu de %zu corridas con falla (%zu choques, %zu errores de posición, %zu etapas sin llegar); "
+                 "total %.2f s (exploración %.2f s, sprint %.2f s)\n",
+                 titulo, e.fallas, corridas, e.choques, e.errores, e.no_llego, e.total_s, e.exploracion_s,
+                 e.sprint_s);
+}
+
+bool escribir_header(const std::string &ruta, const Configuracion &configuracion,
+                     const std::vector<Dimension> &dimensiones, const Candidato &ganador, const Evaluacion &e,
+                     const std::string &origen)
+{
+    std::ofstream salida(ruta);
+    std::string nombre = std::filesystem::path(ruta).filename().string();
+    std::string guarda = "__";
+    for (char c : nombre)
+        guarda += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(c)) : '_';
+
+    char resumen[160];
+    std::snprintf(resumen, sizeof(resumen), "tiempo total medio %.2f s, %zu corridas con falla", e.total_s, e.fallas);
+
+    salida << "/**\n"
+           << " * @file " << nombre << "\n"
+           << " * @brief Parámetros de ajuste elegidos por optimizar (archivo generado)\n"
+           << " *\n"
+           << " * Compilar el firmware con -include " << nombre << " (ver control_motor.h).\n"
+           << " * " << origen << "\n"
+           << " * " << resumen << "\n"
+           << " */\n\n"
+           << "#ifndef " << guarda << "\n"
+           << "#define " << guarda << "\n\n";
+
+    for (size_t d = 0; d < dimensiones.size(); d++)
+    {
+        for (const std::string &ajuste : dimensiones[d].nombres)
+        {
+            const Ajuste *a = buscar_ajuste(configuracion, ajuste);
+            salida << "#define " << a->simbolo << " " << ganador[d] << " // set " << ajuste << "; antes "
+                   << a->valor << "\n";
+        }
+    }
+
+    salida << "\n#endif /* " << guarda << " */\n";
+    return static_cast<bool>(salida);
+}
+
+bool escribir_informe(const std::string &ruta, const Evaluador &evaluador, const std::vector<Dimension> &dimensiones,
+                      size_t corridas, const std::string &origen)
+{
+    std::vector<std::pair<Candidato, Evaluacion>> frente;
+    for (const auto &[candidato, e] : evaluador.evaluaciones())
+    {
+        bool dominado = false;
+        for (const auto &[otro, f] : evaluador.evaluaciones())
+        {
+            if (domina(f, e))
+            {
+                dominado = true;
+                break;
+            }
+        }
+        if (!dominado)
+            frente.push_back({candidato, e});
+    }
+    std::sort(frente.begin(), frente.end(),
+              [](const auto &a, const auto &b) { return mejor(a.second, b.second); });
+
+    FILE *archivo = std::fopen(ruta.c_str(), "w");
+    if (archivo == nullptr)
+        return false;
+
+    std::fprintf(archivo, "Frente de Pareto (violaciones, tiempo total medio) de %zu candidatos\n%s\n\n",
+                 evaluador.evaluaciones().size(), origen.c_str());
+    std::fprintf(archivo, "%7s %8s %8s %8s %8s %8s %8s  ajustes\n", "fallas", "total_s", "explo_s", "sprint_s",
+                 "choques", "errores", "sin_meta");
+    for (const auto &[candidato, e] : frente)
+    {
+        std::fprintf(archivo, "%3zu/%-3zu %8.2f %8.2f %8.2f %8zu %8zu %8zu  %s\n", e.fallas, corridas, e.total_s,
+                     e.exploracion_s, e.sprint_s, e.choques, e.errores, e.no_llego,
+                     describir(dimensiones, candidato).c_str());
+    }
+    return std::fclose(archivo) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string simulador, directorio, ruido, estrategia = "evolutiva";
+    std::string header = "parametros_robot.h", informe = "pareto.txt";
+    std::vector<TipoLaberinto> tipos = {TipoLaberinto::perfecto, TipoLaberinto::lazos, TipoLaberinto::clasico};
+    std::vector<Dimension> dimensiones;
+    size_t generar = 0, poblacion = 12, generaciones = 10, maximo = 5000;
+    uint32_t semilla = 1;
+    unsigned hilos = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool con_valor = i + 1 < argc;
+        std::string opcion = argv[i];
+
+        if (opcion == "--simulador" && con_valor)
+            simulador = argv[++i];
+        else if (opcion == "--generar" && con_valor)
+            generar = std::strtoul(argv[++i], nullptr, 10);
+        else if (opcion == "--tipos" && con_valor)
+        {
+            if (!leer_tipos(argv[++i], tipos))
+            {
+                std::fprintf(stderr, "tipos desconocidos: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (opcion == "--laberintos" && con_valor)
+            directorio = argv[++i];
+        else if (opcion == "--ajuste" && con_valor)
+        {
+            Dimension dimension;
+            if (!leer_dimension(argv[++i], dimension))
+            {
+                std::fprintf(stderr, "ajuste inválido (A[,B]=MIN:MAX:PASO): %s\n", argv[i]);
+                return 2;
+            }
+            dimensiones.push_back(dimension);
+        }
+        else if (opcion == "--estrategia" && con_valor)
+            estrategia = argv[++i];
+        else if (opcion == "--poblacion" && con_valor)
+            poblacion = std::max<size_t>(2, std::strtoul(argv[++i], nullptr, 10));
+        else if (opcion == "--generaciones" && con_valor)
+            generaciones = std::strtoul(argv[++i], nullptr, 10);
+        else if (opcion == "--maximo" && con_valor)
+            maximo = std::strtoul(argv[++i], nullptr, 10);
+        else if (opcion == "--semilla" && con_valor)
+            semilla = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (opcion == "--ruido" && con_valor)
+            ruido = argv[++i];
+        else if (opcion == "--hilos" && con_valor)
+            hilos = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if (opcion == "--header" && con_valor)
+            header = argv[++i];
+        else if (opcion == "--informe" && con_valor)
+            informe = argv[++i];
+        else
+        {
+            uso(argv[0]);
+            return 2;
+        }
+    }
+
+    if (simulador.empty() || (generar == 0) == directorio.empty() ||
+        (estrategia != "evolutiva" && estrategia != "grilla"))
+    {
+        uso(argv[0]);
+        return 2;
+    }
+
+    Configuracion configuracion;
+    if (!leer_configuracion(simulador, configuracion))
+    {
+        std::fprintf(stderr, "%s: no responde a --config\n", simulador.c_str());
+        return 2;
+    }
+
+    if (dimensiones.empty())
+        dimensiones = dimensiones_defecto(configuracion);
+    for (const Dimension &dimension : dimensiones)
+    {
+        for (const std::string &nombre : dimension.nombres)
+        {
+            if (buscar_ajuste(configuracion, nombre) == nullptr)
+            {
+                std::fprintf(stderr, "%s: no es un ajuste de %s (ver simular --config)\n", nombre.c_str(),
+                             simulador.c_str());
+                return 2;
+            }
+        }
+    }
+
+    // Corpus
+    std::vector<Entrada> corpus;
+    std::string temporal;
+    if (generar > 0)
+    {
+        temporal = crear_directorio_temporal("optimizar");
+        if (temporal.empty())
+            return 2;
+        corpus = generar_corpus(configuracion, tipos, generar, semilla, temporal);
+    }
+    else
+    {
+        corpus = leer_corpus(configuracion, directorio);
+    }
+    if (corpus.empty())
+    {
+        std::fprintf(stderr, "no hay laberintos\n");
+        return 2;
+    }
+
+    // Los valores con que se compiló el firmware: la referencia
+    Candidato base;
+    for (const Dimension &dimension : dimensiones)
+        base.push_back(acotar(dimension, buscar_ajuste(configuracion, dimension.nombres.front())->valor));
+
+    Evaluador evaluador(simulador, corpus, dimensiones, semilla, ruido, hilos);
+    evaluador.evaluar({base}, "actual");
+
+    Candidato ganador;
+    std::mt19937 aleatorio(semilla);
+    if (estrategia == "grilla")
+    {
+        std::vector<Candidato> candidatos = grilla(dimensiones, maximo);
+        if (candidatos.empty())
+        {
+            std::fprintf(stderr, "la grilla tiene más de %zu puntos: usar menos --ajuste, pasos más grandes, "
+                                 "--maximo o la estrategia evolutiva\n", maximo);
+            if (!temporal.empty())
+                std::filesystem::remove_all(temporal);
+            return 2;
+        }
+        evaluador.evaluar(candidatos, "grilla");
+        candidatos.push_back(base);
+        ganador = *std::min_element(candidatos.begin(), candidatos.end(), [&](const Candidato &a, const Candidato &b) {
+            return mejor(evaluador.evaluacion(a), evaluador.evaluacion(b));
+        });
+    }
+    else
+    {
+        ganador = evolucionar(evaluador, dimensiones, base, poblacion, generaciones, aleatorio);
+    }
+
+    char origen[256];
+    std::snprintf(origen, sizeof(origen), "%s, %zu laberintos%s%s, semilla %u, estrategia %s, %zu candidatos",
+                  std::filesystem::path(simulador).filename().c_str(), corpus.size(),
+                  ruido.empty() ? "" : ", ruido ", ruido.c_str(), semilla, estrategia.c_str(),
+                  evaluador.evaluaciones().size());
+
+    const Evaluacion &e = evaluador.evaluacion(ganador);
+    std::printf("%s\n", origen);
+    escribir_evaluacion(stdout, "actual", evaluador.evaluacion(base), corpus.size());
+    escribir_evaluacion(stdout, "ganador", e, corpus.size());
+    std::printf("  %s\n", describir(dimensiones, ganador).c_str());
+
+    bool escrito = escribir_header(header, configuracion, dimensiones, ganador, e, origen) &&
+                   escribir_informe(informe, evaluador, dimensiones, corpus.size(), origen);
+    if (escrito)
+        std::printf("%s y %s escritos\n", header.c_str(), informe.c_str());
+    else
+        std::fprintf(stderr, "no se pudo escribir %s o %s\n", header.c_str(), informe.c_str());
+
+    if (!temporal.empty())
+        std::filesystem::remove_all(temporal);
+
+    return escrito && e.fallas == 0 ? 0 : 1;
+}
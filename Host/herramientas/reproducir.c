@@ -0,0 +1,561 @@
+/**
+ * @file reproducir.c
+ * @brief Vuelve a correr el firmware con lo que grabó el registro de una corrida
+ * @author demianmozo
+ *
+ *   reproducir registro.csv [--ajuste N=V] [--periodo-adc-us N]
+ *
+ * Lee el CSV de decodificar (de simular --captura o del puerto serie del
+ * robot). Cada volcado del registro es una etapa: el primero la exploración y
+ * el segundo, si está, el sprint. Corre el firmware sobre el HAL simulado, sin
+ * modelo del robot, con las entradas que registró el robot:
+ * - Los umbrales de REGISTRO_CALIBRACION se guardan en la flash, así
+ *   recorrido_iniciar() arranca como en el robot
+ * - Cada REGISTRO_ADC entra con hal_falso_adc_encolar() en el ms en que se
+ *   registró: promediar_sensores() y controlar_linea_recta() ven los mismos
+ *   promedios
+ * - Cada REGISTRO_LINEA activa flag_linea_detectada antes de recorrido_paso()
+ *   y cada REGISTRO_MURO llama a chequeomuro() después, en el ms en que el
+ *   robot los confirmó
+ * - El sprint arranca con el comando "sprint" en el ms de su primera entrada
+ *
+ * Posiciones, Flood Fill, giros y motores los decide el firmware. Al llegar
+ * al volcado de cada etapa compara, entrada por entrada, lo que registró la
+ * reproducción con lo capturado. Escribe una línea "clave=valor" por dato,
+ * como simular, describe la primera diferencia por stderr y termina con 0 si
+ * todas las etapas coinciden.
+ *
+ * Lo que no se puede reproducir exacto:
+ * - Con REGISTRO_DIVISOR_ADC mayor que 1 se registró 1 de cada N promedios:
+ *   los del medio se interpolan entre los dos registrados (o se repite el
+ *   último si quedan más lejos, como al arrancar) y el PID no da exacto. Con
+ *   el 8 por defecto, en el 4x4 de simular las dos etapas llegan igual pero
+ *   casi ningún comando de motor cae en el mismo ms con el mismo PWM; la
+ *   variante reproducir_registro_completo (divisor 1) los reproduce todos
+ * - Con ODOMETRIA_ENCODERS los giros y avances terminan por los encoders,
+ *   cuyos pulsos no se registran
+ * - Los "set" por UART no quedan en el registro: se pasan con --ajuste, y
+ *   este programa tiene que estar compilado con las mismas opciones que el
+ *   firmware que grabó
+ * - Si el registro dio la vuelta (más de CANTIDAD_REGISTROS entradas en la
+ *   etapa) falta el comienzo y la etapa no se reproduce
+ */
+
+#include "simulador.h"
+#include "hal_falso.h"
+#include "control_linearecta.h"
+#include "laberinto.h"
+#include "persistencia.h"
+#include "recorrido.h"
+#include "registro.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define LARGO_LINEA 512        ///< Más que una fila del CSV de decodificar
+#define MAXIMO_ETAPAS 2        ///< Exploración y sprint
+#define ESPERA_MAXIMA_MS 60000 ///< Tope entre el final de una etapa y el comienzo de la siguiente
+
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+extern volatile bool flag_linea_detectada;
+
+/** @brief Entradas de un volcado, en el orden en que se grabaron */
+typedef struct
+{
+    registro_t *entradas;
+    uint32_t cantidad;
+    uint32_t capacidad;
+    uint32_t volcado_ms; ///< Tiempo de la trama de inicio del volcado
+} etapa_t;
+
+static etapa_t etapas[MAXIMO_ETAPAS];
+static uint32_t cantidad_etapas = 0;
+
+/** @brief Nombres de las etapas en la salida */
+static const char *const nombres_etapa[MAXIMO_ETAPAS] = {"exploracion", "sprint"};
+
+/** @brief Nombres de tipo_registro_t, como los escribe decodificar */
+static const char *const nombres_tipo[] = {"registro_adc",      "registro_linea", "registro_muro",
+                                           "registro_posicion", "registro_motor", "registro_calibracion"};
+
+#define CANTIDAD_TIPOS (sizeof(nombres_tipo) / sizeof(nombres_tipo[0]))
+
+/** @brief Columnas del CSV que hacen falta (índice en el encabezado) */
+enum
+{
+    COLUMNA_TIEMPO,
+    COLUMNA_TIPO,
+    COLUMNA_FILA,
+    COLUMNA_COLUMNA,
+    COLUMNA_SENTIDO,
+    COLUMNA_IZQ,
+    COLUMNA_DER,
+    COLUMNA_MOTOR,
+    COLUMNA_ESTADO,
+    COLUMNA_PWM,
+    COLUMNA_UMBRAL,
+    CANTIDAD_COLUMNAS
+};
+
+static const char *const nombres_columna[CANTIDAD_COLUMNAS] = {
+    "tiempo_ms", "tipo", "fila", "columna", "sentido", "izq", "der", "motor", "estado", "pwm", "umbral"};
+
+/**
+ * @brief Aplica "nombre=valor" con simulador_ajustar()
+ */
+static bool leer_ajuste(const char *texto)
+{
+    char nombre[32];
+    const char *igual = strchr(texto, '=');
+    if (igual == NULL || (size_t)(igual - texto) >= sizeof(nombre))
+        return false;
+
+    memcpy(nombre, texto, (size_t)(igual - texto));
+    nombre[igual - texto] = '\0';
+
+    char *fin;
+    unsigned long valor = strtoul(igual + 1, &fin, 10);
+    return igual[1] != '\0' && *fin == '\0' && valor <= UINT16_MAX && simulador_ajustar(nombre, (uint16_t)valor);
+}
+
+/**
+ * @brief Parte una línea del CSV en sus campos (la modifica)
+ * @return Cantidad de campos
+ */
+static int separar_campos(char *linea, char **campos, int maximo)
+{
+    int cantidad = 0;
+    linea[strcspn(linea, "\r\n")] = '\0';
+    while (cantidad < maximo)
+    {
+        campos[cantidad++] = linea;
+        char *coma = strchr(linea, ',');
+        if (coma == NULL)
+            break;
+        *coma = '\0';
+        linea = coma + 1;
+    }
+    return cantidad;
+}
+
+/**
+ * @brief Valor de un nombre en una lista (sentidos, umbrales)
+ * @return -1 si no está
+ */
+static int buscar_nombre(const char *texto, const char *const *nombres, int cantidad)
+{
+    for (int i = 0; i < cantidad; i++)
+    {
+        if (strcmp(texto, nombres[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Arma la entrada del registro de una fila registro_* del CSV
+ * @return false si a la fila le falta algún campo
+ */
+static bool leer_entrada(char **campos, const int *columnas, int tipo, registro_t *entrada)
+{
+    static const char *const sentidos[] = {"norte", "este", "sur", "oeste"};
+    static const char *const umbrales[] = {"cerca", "lejos", "centrado"};
+    const char *a = "", *b = "";
+    int extra = 0;
+
+    switch (tipo)
+    {
+    case REGISTRO_ADC:
+        a = campos[columnas[COLUMNA_IZQ]];
+        b = campos[columnas[COLUMNA_DER]];
+        break;
+    case REGISTRO_LINEA:
+        a = campos[columnas[COLUMNA_FILA]];
+        b = campos[columnas[COLUMNA_COLUMNA]];
+        break;
+    case REGISTRO_MURO:
+    case REGISTRO_POSICION:
+        extra = buscar_nombre(campos[columnas[COLUMNA_SENTIDO]], sentidos, 4);
+        a = campos[columnas[COLUMNA_FILA]];
+        b = campos[columnas[COLUMNA_COLUMNA]];
+        break;
+    case REGISTRO_MOTOR:
+        extra = atoi(campos[columnas[COLUMNA_MOTOR]]);
+        a = campos[columnas[COLUMNA_ESTADO]];
+        b = campos[columnas[COLUMNA_PWM]];
+        break;
+    case REGISTRO_CALIBRACION:
+        extra = buscar_nombre(campos[columnas[COLUMNA_UMBRAL]], umbrales, 3);
+        a = campos[columnas[COLUMNA_IZQ]];
+        b = campos[columnas[COLUMNA_DER]];
+        break;
+    default:
+        return false;
+    }
+
+    if (extra < 0 || *a == '\0' || *b == '\0')
+        return false;
+    memset(entrada, 0, sizeof(*entrada));
+    entrada->tiempo_ms = (uint32_t)strtoul(campos[columnas[COLUMNA_TIEMPO]], NULL, 10);
+    entrada->tipo = (uint8_t)tipo;
+    entrada->extra = (uint8_t)extra;
+    entrada->a = (uint16_t)strtoul(a, NULL, 10);
+    entrada->b = (uint16_t)strtoul(b, NULL, 10);
+    return true;
+}
+
+/**
+ * @brief Lee los volcados del registro del CSV de decodificar
+ * @return false si el formato no sirve (ya avisó por stderr)
+ */
+static bool leer_csv(FILE *archivo, const char *ruta)
+{
+    char linea[LARGO_LINEA];
+    char *campos[32];
+    int columnas[CANTIDAD_COLUMNAS];
+    etapa_t *etapa = NULL;
+
+    if (fgets(linea, sizeof(linea), archivo) == NULL)
+    {
+        fprintf(stderr, "%s: vacío\n", ruta);
+        return false;
+    }
+    int cantidad = separar_campos(linea, campos, 32);
+    for (int c = 0; c < CANTIDAD_COLUMNAS; c++)
+    {
+        columnas[c] = buscar_nombre(nombres_columna[c], (const char *const *)campos, cantidad);
+        if (columnas[c] < 0)
+        {
+            fprintf(stderr, "%s: falta la columna %s (¿es un CSV de decodificar?)\n", ruta, nombres_columna[c]);
+            return false;
+        }
+    }
+
+    for (uint32_t numero = 2; fgets(linea, sizeof(linea), archivo) != NULL; numero++)
+    {
+        if (separar_campos(linea, campos, 32) != cantidad)
+        {
+            fprintf(stderr, "%s:%lu: cantidad de campos distinta del encabezado\n", ruta, (unsigned long)numero);
+            return false;
+        }
+
+        const char *tipo = campos[columnas[COLUMNA_TIPO]];
+        if (strcmp(tipo, "volcado_inicio") == 0)
+        {
+            if (cantidad_etapas == MAXIMO_ETAPAS)
+            {
+                fprintf(stderr, "%s:%lu: más de %d volcados\n", ruta, (unsigned long)numero, MAXIMO_ETAPAS);
+                return false;
+            }
+            etapa = &etapas[cantidad_etapas++];
+            etapa->volcado_ms = (uint32_t)strtoul(campos[columnas[COLUMNA_TIEMPO]], NULL, 10);
+            continue;
+        }
+        if (strcmp(tipo, "volcado_fin") == 0)
+        {
+            etapa = NULL;
+            continue;
+        }
+
+        int tipo_registro = buscar_nombre(tipo, nombres_tipo, (int)CANTIDAD_TIPOS);
+        if (tipo_registro < 0 || etapa == NULL)
+            continue; // Telemetría, o una entrada de un volcado cortado
+
+        if (etapa->cantidad == etapa->capacidad)
+        {
+            etapa->capacidad = etapa->capacidad ? 2 * etapa->capacidad : 4096;
+            etapa->entradas = realloc(etapa->entradas, etapa->capacidad * sizeof(registro_t));
+            if (etapa->entradas == NULL)
+            {
+                fprintf(stderr, "sin memoria\n");
+                return false;
+            }
+        }
+        if (!leer_entrada(campos, columnas, tipo_registro, &etapa->entradas[etapa->cantidad]))
+        {
+            fprintf(stderr, "%s:%lu: %s incompleto\n", ruta, (unsigned long)numero, tipo);
+            return false;
+        }
+        etapa->cantidad++;
+    }
+    return true;
+}
+
+/**
+ * @brief Indica si una etapa empieza con los umbrales, como la deja empezar_registro()
+ */
+static bool empieza_con_calibracion(const etapa_t *etapa)
+{
+    if (etapa->cantidad < 3)
+        return false;
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (etapa->entradas[i].tipo != REGISTRO_CALIBRACION || etapa->entradas[i].extra != i ||
+            etapa->entradas[i].tiempo_ms != etapa->entradas[0].tiempo_ms)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Guarda en la flash los umbrales de la etapa, como los cargaría el robot
+ */
+static void guardar_calibracion(const etapa_t *etapa)
+{
+    izq_cerca = etapa->entradas[0].a;
+    der_cerca = etapa->entradas[0].b;
+    izq_lejos = etapa->entradas[1].a;
+    der_lejos = etapa->entradas[1].b;
+    izq_centrado = etapa->entradas[2].a;
+    der_centrado = etapa->entradas[2].b;
+
+    laberinto_init();
+    persistencia_borrar();
+    persistencia_guardar(false);
+}
+
+/** @brief Próxima entrada de cada clase a entregar y diferencia entre relojes */
+static struct
+{
+    uint32_t adc, linea, muro;
+    const registro_t *promedio; ///< Último REGISTRO_ADC entregado
+    int64_t desplazamiento_ms; ///< Tiempo del robot menos el de la reproducción
+} cursor;
+
+/**
+ * @brief Tiempo de una entrada en el reloj de la reproducción
+ */
+static int64_t tiempo_local(const registro_t *entrada)
+{
+    return (int64_t)entrada->tiempo_ms - cursor.desplazamiento_ms;
+}
+
+/**
+ * @brief Avanza un cursor hasta la próxima entrada de un tipo con tiempo local tiempo
+ * @return true si la encontró (y la deja consumida)
+ */
+static bool tomar(const etapa_t *etapa, uint32_t *indice, uint8_t tipo, int64_t tiempo)
+{
+    while (*indice < etapa->cantidad &&
+           (etapa->entradas[*indice].tipo != tipo || tiempo_local(&etapa->entradas[*indice]) < tiempo))
+    {
+        (*indice)++;
+    }
+    if (*indice < etapa->cantidad && tiempo_local(&etapa->entradas[*indice]) == tiempo)
+    {
+        (*indice)++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Un ms: línea antes del bucle principal, muro después y los promedios del ms siguiente
+ */
+static void paso(const etapa_t *etapa)
+{
+    int64_t ahora = HAL_GetTick();
+
+    while (tomar(etapa, &cursor.linea, REGISTRO_LINEA, ahora))
+    {
+        flag_linea_detectada = true;
+    }
+    recorrido_paso();
+    while (tomar(etapa, &cursor.muro, REGISTRO_MURO, ahora))
+    {
+        chequeomuro();
+    }
+
+    bool registrado = false;
+    while (tomar(etapa, &cursor.adc, REGISTRO_ADC, ahora + 1))
+    {
+        cursor.promedio = &etapa->entradas[cursor.adc - 1];
+        hal_falso_adc_encolar(cursor.promedio->b, cursor.promedio->a); // Canal 8 es el derecho
+        hal_falso_adc_set_lecturas(cursor.promedio->b, cursor.promedio->a);
+        registrado = true;
+    }
+    if (!registrado && cursor.promedio != NULL && cursor.adc < etapa->cantidad)
+    {
+        // Sin registrar: entre los dos registrados más cercanos, o el último si están lejos
+        const registro_t *anterior = cursor.promedio, *siguiente = &etapa->entradas[cursor.adc];
+        int64_t hueco = tiempo_local(siguiente) - tiempo_local(anterior);
+        if (hueco <= REGISTRO_DIVISOR_ADC)
+        {
+            int64_t pasado = ahora + 1 - tiempo_local(anterior);
+            hal_falso_adc_set_lecturas((uint16_t)(anterior->b + ((int64_t)siguiente->b - anterior->b) * pasado / hueco),
+                                       (uint16_t)(anterior->a + ((int64_t)siguiente->a - anterior->a) * pasado / hueco));
+        }
+    }
+
+    hal_falso_avanzar(1);
+    hal_falso_uart_tomar(NULL, 0);
+}
+
+/**
+ * @brief Indica si dos entradas son iguales (la capturada en el reloj del robot)
+ */
+static bool iguales(const registro_t *capturada, const registro_t *reproducida)
+{
+    return reproducida != NULL && tiempo_local(capturada) == reproducida->tiempo_ms &&
+           capturada->tipo == reproducida->tipo && capturada->extra == reproducida->extra &&
+           capturada->a == reproducida->a && capturada->b == reproducida->b;
+}
+
+/**
+ * @brief Compara lo registrado por la reproducción con lo capturado y lo escribe
+ * @details Las entradas van posición por posición; los comandos de motor, el
+ *          k-ésimo capturado con el k-ésimo reproducido, así un promedio de
+ *          más o de menos no corre todos los que siguen
+ * @return true si coincide todo
+ */
+static bool comparar(const char *nombre, const etapa_t *etapa)
+{
+    uint16_t reproducidas = registro_get_cantidad();
+    uint32_t distintas = 0, motores = 0, motores_distintos = 0;
+    uint32_t primera = etapa->cantidad;
+    uint16_t motor_reproducido = 0;
+
+    for (uint32_t i = 0; i < etapa->cantidad; i++)
+    {
+        const registro_t *capturada = &etapa->entradas[i];
+        const registro_t *reproducida = (i < reproducidas) ? registro_get_entrada((uint16_t)i) : NULL;
+
+        if (capturada->tipo == REGISTRO_MOTOR)
+        {
+            const registro_t *motor = NULL;
+            while (motor_reproducido < reproducidas && motor == NULL)
+            {
+                motor = registro_get_entrada(motor_reproducido++);
+                if (motor->tipo != REGISTRO_MOTOR)
+                    motor = NULL;
+            }
+            motores++;
+            if (!iguales(capturada, motor))
+                motores_distintos++;
+        }
+        if (!iguales(capturada, reproducida))
+        {
+            distintas++;
+            if (primera == etapa->cantidad)
+                primera = i;
+        }
+    }
+
+    printf("%s_entradas=%lu\n", nombre, (unsigned long)etapa->cantidad);
+    printf("%s_reproducidas=%lu\n", nombre, (unsigned long)reproducidas);
+    printf("%s_distintas=%lu\n", nombre, (unsigned long)distintas);
+    printf("%s_motores=%lu\n", nombre, (unsigned long)motores);
+    printf("%s_motores_distintos=%lu\n", nombre, (unsigned long)motores_distintos);
+
+    if (primera < etapa->cantidad)
+    {
+        const registro_t *capturada = &etapa->entradas[primera];
+        const registro_t *reproducida = registro_get_entrada((uint16_t)primera);
+        fprintf(stderr, "%s: primera diferencia en la entrada %lu: capturada %s %u %u %u a los %lu ms", nombre,
+                (unsigned long)primera, nombres_tipo[capturada->tipo], capturada->extra, capturada->a, capturada->b,
+                (unsigned long)tiempo_local(capturada));
+        if (reproducida != NULL && reproducida->tipo < CANTIDAD_TIPOS)
+            fprintf(stderr, ", reproducida %s %u %u %u a los %lu ms\n", nombres_tipo[reproducida->tipo],
+                    reproducida->extra, reproducida->a, reproducida->b, (unsigned long)reproducida->tiempo_ms);
+        else
+            fprintf(stderr, ", la reproducción no llegó\n");
+    }
+    return distintas == 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ruta = NULL;
+    uint32_t periodo_adc_us = 500; // El de hal_falso y simular
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool con_valor = i + 1 < argc;
+
+        if (strcmp(argv[i], "--ajuste") == 0 && con_valor)
+        {
+            if (!leer_ajuste(argv[++i]))
+            {
+                fprintf(stderr, "ajuste inválido: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (strcmp(argv[i], "--periodo-adc-us") == 0 && con_valor)
+            periodo_adc_us = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-' && ruta == NULL)
+            ruta = argv[i];
+        else
+        {
+            fprintf(stderr, "opción desconocida: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (ruta == NULL)
+    {
+        fprintf(stderr, "uso: %s registro.csv [--ajuste N=V] [--periodo-adc-us N]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *archivo = fopen(ruta, "r");
+    if (archivo == NULL)
+    {
+        perror(ruta);
+        return 2;
+    }
+    bool leido = leer_csv(archivo, ruta);
+    fclose(archivo);
+    if (!leido)
+        return 2;
+    if (cantidad_etapas == 0)
+    {
+        fprintf(stderr, "%s: no hay ningún volcado del registro\n", ruta);
+        return 2;
+    }
+    for (uint32_t e = 0; e < cantidad_etapas; e++)
+    {
+        if (!empieza_con_calibracion(&etapas[e]))
+        {
+            fprintf(stderr, "%s: el volcado de %s no empieza con la calibración (¿dio la vuelta el registro?)\n", ruta,
+                    nombres_etapa[e]);
+            return 2;
+        }
+    }
+
+    // Arranque como en el robot: la calibración en la flash y la espera de la largada
+    hal_falso_reiniciar();
+    hal_falso_adc_set_periodo_us(periodo_adc_us);
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
+    guardar_calibracion(&etapas[0]);
+    recorrido_iniciar();
+    cursor.desplazamiento_ms = (int64_t)etapas[0].entradas[0].tiempo_ms - HAL_GetTick();
+    printf("desplazamiento_ms=%ld\n", (long)cursor.desplazamiento_ms);
+
+    bool iguales = true;
+    for (uint32_t e = 0; e < cantidad_etapas; e++)
+    {
+        const etapa_t *etapa = &etapas[e];
+        cursor.adc = cursor.linea = cursor.muro = 0;
+        cursor.promedio = NULL;
+
+        if (e > 0)
+        {
+            // Hasta el ms en que el robot arrancó el sprint, y ahí el comando
+            int64_t largada = tiempo_local(&etapa->entradas[0]);
+            for (uint32_t i = 0; HAL_GetTick() < largada && i < ESPERA_MAXIMA_MS; i++)
+            {
+                paso(etapa);
+            }
+            hal_falso_uart_recibir((const uint8_t *)"sprint\n", 7);
+        }
+
+        int64_t volcado = (int64_t)etapa->volcado_ms - cursor.desplazamiento_ms;
+        while ((int64_t)HAL_GetTick() <= volcado)
+        {
+            paso(etapa);
+        }
+        iguales = comparar(nombres_etapa[e], etapa) && iguales;
+    }
+
+    return iguales ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file simular.c
+ * @brief Exploración y sprint del firmware sobre el modelo físico del robot
+ * @author demianmozo
+ *
+ *   simular laberinto.txt [opciones]
+ *   simular --config
+ *
+ *   --sin-sprint        Solo la exploración
+ *   --semilla N         Semilla del ruido de los IR
+ *   --ruido X           Desvío estándar del ruido de los IR (cuentas del ADC)
+ *   --ganancia-izq X    Desparejo del motor izquierdo (1 = nominal)
+ *   --ganancia-der X    Idem derecho
+ *   --ajuste N=V        Parámetro del firmware, como "set N V" por UART (se puede repetir)
+ *   --traza             Eventos de la corrida por stderr (ver simulador_set_traza())
+ *   --captura ARCHIVO   Lo transmitido por UART, crudo (ver decodificar)
+ *
+ * El laberinto va en el formato de modelo_leer_laberinto() y tiene que tener
+ * el tamaño con que se compiló el firmware. Escribe una línea "clave=valor"
+ * por dato, para leerla desde otras herramientas, y termina con 0 si las dos
+ * etapas llegaron a la meta sin choques ni errores de posición.
+ *
+ * --config escribe, con el mismo formato, con qué se compiló el firmware
+ * (tamaño, inicio, metas y desempate), para armar laberintos que le sirvan,
+ * y los parámetros de ajuste: "ajuste_<nombre>=valor" y
+ * "simbolo_<nombre>=SIMBOLO" (el #define que les da el valor inicial).
+ */
+
+#include "simulador.h"
+#include "laberinto.h"
+#include "navegacion.h"
+#include "odometria.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COMO_TEXTO(...) #__VA_ARGS__
+#define TEXTO_EXPANDIDO(...) COMO_TEXTO(__VA_ARGS__)
+
+/**
+ * @brief Escribe la configuración con que se compiló el firmware
+ */
+static void escribir_configuracion(void)
+{
+    printf("filas=%u\n", FILAS_LABERINTO);
+    printf("columnas=%u\n", COLUMNAS_LABERINTO);
+    printf("inicio_fila=%u\n", POSICION_INICIO_FILA);
+    printf("inicio_columna=%u\n", POSICION_INICIO_COLUMNA);
+
+    laberinto_init();
+    printf("metas=");
+    const char *separador = "";
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (laberinto_es_meta(fila, columna))
+            {
+                printf("%s%u,%u", separador, fila, columna);
+                separador = " ";
+            }
+        }
+    }
+    printf("\n");
+
+    printf("orden=%s\n", TEXTO_EXPANDIDO(ORDEN_EVALUACION));
+    printf("planificar_con_giros=%d\n", PLANIFICAR_CON_GIROS);
+    printf("odometria_encoders=%d\n", ODOMETRIA_ENCODERS);
+
+    size_t cantidad;
+    const simulador_ajuste_t *ajustes = simulador_get_ajustes(&cantidad);
+    for (size_t i = 0; i < cantidad; i++)
+    {
+        printf("ajuste_%s=%u\n", ajustes[i].nombre, *ajustes[i].valor);
+        printf("simbolo_%s=%s\n", ajustes[i].nombre, ajustes[i].simbolo);
+    }
+}
+
+/**
+ * @brief Aplica "nombre=valor" con simulador_ajustar()
+ */
+static bool leer_ajuste(const char *texto)
+{
+    char nombre[32];
+    const char *igual = strchr(texto, '=');
+    if (igual == NULL || (size_t)(igual - texto) >= sizeof(nombre))
+        return false;
+
+    memcpy(nombre, texto, (size_t)(igual - texto));
+    nombre[igual - texto] = '\0';
+
+    char *fin;
+    unsigned long valor = strtoul(igual + 1, &fin, 10);
+    return igual[1] != '\0' && *fin == '\0' && valor <= UINT16_MAX && simulador_ajustar(nombre, (uint16_t)valor);
+}
+
+/**
+ * @brief Escribe el resultado de una etapa con un prefijo
+ */
+static void escribir_etapa(const char *nombre, const simulador_etapa_t *etapa)
+{
+    printf("%s_llego=%d\n", nombre, etapa->llego ? 1 : 0);
+    printf("%s_ms=%lu\n", nombre, (unsigned long)etapa->tiempo_ms);
+    printf("%s_choques=%lu\n", nombre, (unsigned long)etapa->choques);
+    printf("%s_casillas=%lu\n", nombre, (unsigned long)etapa->casillas);
+    printf("%s_casillas_distintas=%lu\n", nombre, (unsigned long)etapa->casillas_distintas);
+    printf("%s_giros=%lu\n", nombre, (unsigned long)etapa->giros);
+    printf("%s_errores_posicion=%lu\n", nombre, (unsigned long)etapa->errores_posicion);
+}
+
+/**
+ * @brief Indica si una etapa salió limpia
+ */
+static bool etapa_limpia(const simulador_etapa_t *etapa)
+{
+    return etapa->llego && etapa->choques == 0 && etapa->errores_posicion == 0;
+}
+
+int main(int argc, char **argv)
+{
+    modelo_parametros_t parametros;
+    modelo_parametros_defecto(&parametros);
+    bool con_sprint = true;
+    const char *ruta = NULL;
+    FILE *captura = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool con_valor = i + 1 < argc;
+
+        if (strcmp(argv[i], "--config") == 0)
+        {
+            escribir_configuracion();
+            return 0;
+        }
+        else if (strcmp(argv[i], "--sin-sprint") == 0)
+            con_sprint = false;
+        else if (strcmp(argv[i], "--traza") == 0)
+            simulador_set_traza(stderr);
+        else if (strcmp(argv[i], "--captura") == 0 && con_valor)
+        {
+            captura = fopen(argv[++i], "wb");
+            if (captura == NULL)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+            simulador_set_captura(captura);
+        }
+        else if (strcmp(argv[i], "--semilla") == 0 && con_valor)
+            parametros.semilla = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--ruido") == 0 && con_valor)
+            parametros.ruido_adc = strtof(argv[++i], NULL);
+        else if (strcmp(argv[i], "--ganancia-izq") == 0 && con_valor)
+            parametros.ganancia_izq = strtof(argv[++i], NULL);
+        else if (strcmp(argv[i], "--ganancia-der") == 0 && con_valor)
+            parametros.ganancia_der = strtof(argv[++i], NULL);
+        else if (strcmp(argv[i], "--ajuste") == 0 && con_valor)
+        {
+            if (!leer_ajuste(argv[++i]))
+            {
+                fprintf(stderr, "ajuste inválido: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (argv[i][0] != '-' && ruta == NULL)
+            ruta = argv[i];
+        else
+        {
+            fprintf(stderr, "opción desconocida: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (ruta == NULL)
+    {
+        fprintf(stderr, "uso: %s --config | laberinto.txt [--sin-sprint] [--semilla N] [--ruido X] "
+                        "[--ganancia-izq X] [--ganancia-der X] [--ajuste N=V] [--traza] [--captura ARCHIVO]\n", argv[0]);
+        return 2;
+    }
+
+    FILE *archivo = fopen(ruta, "r");
+    laberinto_modelo_t laberinto;
+    bool leido = archivo != NULL && modelo_leer_laberinto(&laberinto, archivo);
+    if (archivo != NULL)
+        fclose(archivo);
+    if (!leido)
+    {
+        fprintf(stderr, "%s: no es un laberinto válido\n", ruta);
+        return 2;
+    }
+
+    simulador_resultado_t resultado;
+    if (!simulador_correr(&laberinto, &parametros, con_sprint, &resultado))
+    {
+        fprintf(stderr, "%s: %ux%u casillas, el firmware se compiló para otro tamaño\n", ruta,
+                laberinto.filas, laberinto.columnas);
+        return 2;
+    }
+
+    escribir_etapa("exploracion", &resultado.exploracion);
+    if (con_sprint)
+    {
+        escribir_etapa("sprint", &resultado.sprint);
+    }
+
+    if (captura != NULL)
+        fclose(captura);
+
+    bool limpia = etapa_limpia(&resultado.exploracion) && (!con_sprint || etapa_limpia(&resultado.sprint));
+    return limpia ? 0 : 1;
+}
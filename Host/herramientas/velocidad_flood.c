@@ -0,0 +1,366 @@
+/**
+ * @file velocidad_flood.c
+ * @brief Cuánto tarda en la PC cada muro nuevo: repropagación incremental contra Flood Fill completo
+ * @author demianmozo
+ *
+ * En cada laberinto parte de laberinto_init() (sin muros) y agrega la mitad de
+ * los tramos interiores, elegidos y ordenados al azar, como los iría
+ * encontrando la exploración. Cada muro se mide dos veces con clock_gettime():
+ * laberinto_set_muro() (marca el muro y repropaga solo la zona afectada) y
+ * después laberinto_recalcular_pesos() sobre el mismo mapa, que es lo que
+ * costaba cada muro antes de la repropagación incremental. En la PC
+ * laberinto_get_ciclos_muro() vale 0 (no hay DWT), por eso se mide acá.
+ *
+ * Después, sobre el mismo mapa, se mide recalcular_anterior(): el Flood Fill
+ * completo como era antes del índice plano (cola de posicion_t, pesos en
+ * matriz, laberinto_get_posicion_adyacente() con su switch y
+ * laberinto_posicion_valida() por vecina), copiado acá con sus funciones en
+ * el mismo archivo como estaban en laberinto.c. Sus pesos tienen que dar
+ * igual que los de laberinto_get_peso(); si no, termina con 1.
+ *
+ * La misma secuencia de laberintos se corre PASADAS veces y de cada muro
+ * queda el menor tiempo: una interrupción del sistema operativo en una pasada
+ * no se confunde con el peor caso del algoritmo. Escribe mediana y peor caso
+ * de cada uno en ns; incluyen una lectura del reloj, que también se informa.
+ * Se compila una vez por tamaño: velocidad_flood es el 4x4 por defecto,
+ * velocidad_flood_8x8 y velocidad_flood_16x16.
+ *
+ *   velocidad_flood [laberintos, 200 por defecto] [semilla, 1 por defecto]
+ */
+
+#include "laberinto.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define PASADAS 5 ///< Corridas de la misma secuencia; de cada muro queda la más rápida
+#define TRAMOS_INTERIORES (FILAS_LABERINTO * (COLUMNAS_LABERINTO - 1) + (FILAS_LABERINTO - 1) * COLUMNAS_LABERINTO)
+
+/** @brief Tramo de muro interior: casilla y dirección hacia la vecina */
+typedef struct
+{
+    uint8_t fila;
+    uint8_t columna;
+    brujula direccion;
+} tramo_t;
+
+/** @brief Estado del generador (xorshift32, el mismo en cualquier PC) */
+static uint32_t aleatorio = 1;
+
+/**
+ * @brief Número al azar de 0 a maximo - 1
+ */
+static uint32_t azar(uint32_t maximo)
+{
+    aleatorio ^= aleatorio << 13;
+    aleatorio ^= aleatorio >> 17;
+    aleatorio ^= aleatorio << 5;
+    return aleatorio % maximo;
+}
+
+/**
+ * @brief Nanosegundos de reloj real (monotónico)
+ */
+static uint64_t nanosegundos(void)
+{
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (uint64_t)ahora.tv_sec * 1000000000u + (uint64_t)ahora.tv_nsec;
+}
+
+/**
+ * @defgroup Flood_Anterior Flood Fill anterior al índice plano
+ * @brief Copia de laberinto.c antes de desplazamiento_vecina[] y direcciones_libres[]
+ * @{
+ */
+
+/** @brief Pesos por fila y columna, como estaban */
+static peso_t pesos_anterior[FILAS_LABERINTO][COLUMNAS_LABERINTO];
+
+/** @brief Los mismos muros que el laberinto, empaquetados igual que en laberinto.c */
+static mascara_fila_t horizontales_anterior[FILAS_LABERINTO + 1];
+static mascara_columna_t verticales_anterior[COLUMNAS_LABERINTO + 1];
+
+/** @brief Metas como posiciones */
+static posicion_t metas_anterior[MAX_METAS];
+static uint8_t cantidad_metas_anterior = 0;
+
+/** @brief Cola del Flood Fill, de posiciones */
+static posicion_t cola_anterior[TAMAÑO_COLA_FLOOD];
+
+static inline bool muro_en_anterior(uint8_t fila, uint8_t columna, brujula direccion)
+{
+    switch (direccion)
+    {
+    case norte:
+        return (horizontales_anterior[fila - 1] >> (columna - 1)) & 1u;
+    case sur:
+        return (horizontales_anterior[fila] >> (columna - 1)) & 1u;
+    case oeste:
+        return (verticales_anterior[columna - 1] >> (fila - 1)) & 1u;
+    case este:
+    default:
+        return (verticales_anterior[columna] >> (fila - 1)) & 1u;
+    }
+}
+
+static posicion_t posicion_adyacente_anterior(posicion_t pos_actual, brujula direccion)
+{
+    posicion_t nueva_pos = pos_actual;
+
+    switch (direccion)
+    {
+    case norte:
+        nueva_pos.fila = pos_actual.fila - 1;
+        break;
+    case este:
+        nueva_pos.columna = pos_actual.columna + 1;
+        break;
+    case sur:
+        nueva_pos.fila = pos_actual.fila + 1;
+        break;
+    case oeste:
+        nueva_pos.columna = pos_actual.columna - 1;
+        break;
+    }
+
+    return nueva_pos;
+}
+
+static bool posicion_valida_anterior(uint8_t fila, uint8_t columna)
+{
+    return (fila >= 1 && fila <= FILAS_LABERINTO && columna >= 1 && columna <= COLUMNAS_LABERINTO);
+}
+
+static void recalcular_anterior(void)
+{
+    // Ninguna casilla alcanzada todavía
+    for (uint8_t fila = 0; fila < FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 0; columna < COLUMNAS_LABERINTO; columna++)
+        {
+            pesos_anterior[fila][columna] = PESO_MAXIMO;
+        }
+    }
+
+    uint16_t cabeza = 0;
+    uint16_t cola_fin = 0;
+
+    // Todas las metas son origen de la onda
+    for (uint8_t i = 0; i < cantidad_metas_anterior; i++)
+    {
+        pesos_anterior[metas_anterior[i].fila - 1][metas_anterior[i].columna - 1] = 0;
+        cola_anterior[cola_fin] = metas_anterior[i];
+        cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
+    }
+
+    while (cabeza != cola_fin)
+    {
+        posicion_t actual = cola_anterior[cabeza];
+        cabeza = (cabeza + 1) % TAMAÑO_COLA_FLOOD;
+
+        peso_t *peso_casilla = &pesos_anterior[actual.fila - 1][actual.columna - 1];
+
+        for (brujula dir = norte; dir <= oeste; dir++)
+        {
+            // Saltar si hay muro en esta dirección
+            if (muro_en_anterior(actual.fila, actual.columna, dir))
+            {
+                continue;
+            }
+
+            posicion_t pos_adyacente = posicion_adyacente_anterior(actual, dir);
+
+            if (!posicion_valida_anterior(pos_adyacente.fila, pos_adyacente.columna))
+            {
+                continue;
+            }
+
+            peso_t *peso_vecina = &pesos_anterior[pos_adyacente.fila - 1][pos_adyacente.columna - 1];
+
+            // Ya alcanzada por un camino igual o más corto
+            if (*peso_vecina != PESO_MAXIMO)
+            {
+                continue;
+            }
+
+            *peso_vecina = *peso_casilla + 1;
+            cola_anterior[cola_fin] = pos_adyacente;
+            cola_fin = (cola_fin + 1) % TAMAÑO_COLA_FLOOD;
+        }
+    }
+}
+
+/** @} */
+
+/**
+ * @brief Vacía los muros de la copia anterior y toma las metas del laberinto
+ */
+static void iniciar_anterior(void)
+{
+    for (uint8_t linea = 0; linea <= FILAS_LABERINTO; linea++)
+        horizontales_anterior[linea] = 0;
+    for (uint8_t linea = 0; linea <= COLUMNAS_LABERINTO; linea++)
+        verticales_anterior[linea] = 0;
+
+    cantidad_metas_anterior = 0;
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (laberinto_es_meta(fila, columna) && cantidad_metas_anterior < MAX_METAS)
+                metas_anterior[cantidad_metas_anterior++] = (posicion_t){fila, columna};
+        }
+    }
+}
+
+/**
+ * @brief Agrega a la copia anterior un tramo interior al sur o al este de la casilla
+ */
+static void agregar_muro_anterior(uint8_t fila, uint8_t columna, brujula direccion)
+{
+    if (direccion == sur)
+        horizontales_anterior[fila] |= (mascara_fila_t)1 << (columna - 1);
+    else
+        verticales_anterior[columna] |= (mascara_columna_t)1 << (fila - 1);
+}
+
+/**
+ * @brief Indica si los pesos de la copia anterior coinciden con los del laberinto
+ */
+static bool pesos_iguales(void)
+{
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (pesos_anterior[fila - 1][columna - 1] != laberinto_get_peso(fila, columna))
+                return false;
+        }
+    }
+    return true;
+}
+
+static int comparar_ns(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Ordena las mediciones y escribe mediana y peor caso
+ */
+static void informar(const char *nombre, uint64_t *ns, size_t cantidad)
+{
+    qsort(ns, cantidad, sizeof(ns[0]), comparar_ns);
+    printf("%2dx%-2d %-20s mediana %6llu ns, peor %7llu ns\n", FILAS_LABERINTO, COLUMNAS_LABERINTO, nombre,
+           (unsigned long long)ns[cantidad / 2], (unsigned long long)ns[cantidad - 1]);
+}
+
+/**
+ * @brief Todos los tramos interiores: el sur de cada fila menos la última y el este de cada columna menos la última
+ */
+static void listar_tramos(tramo_t *tramos)
+{
+    size_t cantidad = 0;
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (fila < FILAS_LABERINTO)
+                tramos[cantidad++] = (tramo_t){fila, columna, sur};
+            if (columna < COLUMNAS_LABERINTO)
+                tramos[cantidad++] = (tramo_t){fila, columna, este};
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t laberintos = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 200u;
+    aleatorio = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 1u;
+    if (laberintos == 0 || aleatorio == 0)
+    {
+        fprintf(stderr, "uso: %s [laberintos] [semilla distinta de 0]\n", argv[0]);
+        return 2;
+    }
+
+    static tramo_t tramos[TRAMOS_INTERIORES];
+    size_t por_laberinto = TRAMOS_INTERIORES / 2;
+    size_t cantidad = (size_t)laberintos * por_laberinto;
+    uint32_t semilla = aleatorio;
+    uint64_t *incremental = malloc(cantidad * sizeof(uint64_t));
+    uint64_t *completo = malloc(cantidad * sizeof(uint64_t));
+    uint64_t *anterior = malloc(cantidad * sizeof(uint64_t));
+    uint64_t *reloj = malloc(cantidad * sizeof(uint64_t));
+    if (incremental == NULL || completo == NULL || anterior == NULL || reloj == NULL)
+    {
+        fprintf(stderr, "sin memoria\n");
+        return 2;
+    }
+
+    size_t medidas = 0;
+    bool iguales = true;
+    for (uint32_t pasada = 0; pasada < PASADAS; pasada++)
+    {
+        aleatorio = semilla;
+        medidas = 0;
+        for (uint32_t l = 0; l < laberintos; l++)
+        {
+            listar_tramos(tramos);
+            for (size_t i = TRAMOS_INTERIORES - 1; i > 0; i--)
+            {
+                size_t j = azar((uint32_t)i + 1);
+                tramo_t tramo = tramos[i];
+                tramos[i] = tramos[j];
+                tramos[j] = tramo;
+            }
+
+            laberinto_init();
+            iniciar_anterior();
+            for (size_t i = 0; i < por_laberinto; i++, medidas++)
+            {
+                uint64_t inicio = nanosegundos();
+                laberinto_set_muro(tramos[i].fila, tramos[i].columna, tramos[i].direccion);
+                uint64_t medio = nanosegundos();
+                laberinto_recalcular_pesos();
+                uint64_t fin = nanosegundos();
+                uint64_t lectura = nanosegundos() - fin;
+
+                agregar_muro_anterior(tramos[i].fila, tramos[i].columna, tramos[i].direccion);
+                uint64_t antes = nanosegundos();
+                recalcular_anterior();
+                uint64_t tablas = nanosegundos() - antes;
+                iguales = iguales && pesos_iguales();
+
+                if (pasada == 0 || medio - inicio < incremental[medidas])
+                    incremental[medidas] = medio - inicio;
+                if (pasada == 0 || fin - medio < completo[medidas])
+                    completo[medidas] = fin - medio;
+                if (pasada == 0 || tablas < anterior[medidas])
+                    anterior[medidas] = tablas;
+                if (pasada == 0 || lectura < reloj[medidas])
+                    reloj[medidas] = lectura;
+            }
+        }
+    }
+
+    printf("%dx%d: %lu muros en %lu laberintos, lo mejor de %d pasadas\n", FILAS_LABERINTO, COLUMNAS_LABERINTO,
+           (unsigned long)medidas, (unsigned long)laberintos, PASADAS);
+    informar("muro incremental", incremental, medidas);
+    informar("recalculo completo", completo, medidas);
+    informar("recalculo anterior", anterior, medidas);
+    informar("lectura del reloj", reloj, medidas);
+
+    free(incremental);
+    free(completo);
+    free(anterior);
+    free(reloj);
+    if (!iguales)
+    {
+        fprintf(stderr, "el Flood Fill anterior no da los mismos pesos\n");
+        return 1;
+    }
+    return 0;
+}
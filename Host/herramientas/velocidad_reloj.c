@@ -0,0 +1,55 @@
+/**
+ * @file velocidad_reloj.c
+ * @brief Cuántos segundos simulados por segundo real corre el firmware en la PC
+ * @author demianmozo
+ *
+ * Arranca sin nada guardado (auto_calibracion() completa, con sus esperas de
+ * 3 s) y corre el bucle principal con el lazo de TIM6 y el ADC cada ms
+ * virtual durante los segundos pedidos. Sin el modelo del robot no hay
+ * líneas ni muros: mide el costo del reloj virtual y del firmware en recta.
+ *
+ *   velocidad_reloj [segundos simulados, 600 por defecto]
+ */
+
+#include "hal_falso.h"
+#include "control_linearecta.h"
+#include "recorrido.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Segundos de reloj real (monotónico)
+ */
+static double segundos_reales(void)
+{
+    struct timespec ahora;
+    clock_gettime(CLOCK_MONOTONIC, &ahora);
+    return (double)ahora.tv_sec + (double)ahora.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t segundos = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 10) : 600u;
+    double inicio = segundos_reales();
+
+    hal_falso_reiniciar();
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
+    hal_falso_adc_set_lecturas(2000, 2000);
+
+    recorrido_iniciar();
+    uint32_t fin = HAL_GetTick() + segundos * 1000u;
+    while (HAL_GetTick() < fin)
+    {
+        recorrido_paso();
+        hal_falso_avanzar(1);
+        hal_falso_uart_tomar(NULL, 0); // Descartar la telemetría
+    }
+
+    double reales = segundos_reales() - inicio;
+    double simulados = HAL_GetTick() / 1000.0;
+    printf("simulados %.1f s en %.3f s reales: %.0f s simulados por segundo\n",
+           simulados, reales, simulados / reales);
+
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file prueba.h
+ * @brief Verificaciones mínimas para las pruebas en la PC
+ * @author demianmozo
+ *
+ * Cada prueba es un programa: cuenta las verificaciones que fallan, las
+ * informa con archivo y línea y termina con error si hubo alguna (así la
+ * marca ctest). azar() da la misma secuencia en cualquier PC a partir de la
+ * semilla de prueba_semilla().
+ */
+
+#ifndef __PRUEBA_H
+#define __PRUEBA_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+static int fallas_prueba = 0;
+
+/** @brief Informa y cuenta la falla si la condición no se cumple */
+#define VERIFICAR(condicion)                                                   \
+    do                                                                         \
+    {                                                                          \
+        if (!(condicion))                                                      \
+        {                                                                      \
+            fprintf(stderr, "%s:%d: falló %s\n", __FILE__, __LINE__, #condicion); \
+            fallas_prueba++;                                                   \
+        }                                                                      \
+    } while (0)
+
+/** @brief Estado del generador (xorshift32, misma secuencia en cualquier PC) */
+static uint32_t aleatorio_prueba = 1;
+
+/** @brief Fija la semilla de azar(); cada prueba usa la suya (distinta de 0) */
+static inline void prueba_semilla(uint32_t semilla)
+{
+    aleatorio_prueba = semilla;
+}
+
+/** @brief Número aleatorio entre 0 y maximo - 1 */
+static inline uint32_t azar(uint32_t maximo)
+{
+    aleatorio_prueba ^= aleatorio_prueba << 13;
+    aleatorio_prueba ^= aleatorio_prueba >> 17;
+    aleatorio_prueba ^= aleatorio_prueba << 5;
+    return aleatorio_prueba % maximo;
+}
+
+/** @brief Código de salida del programa de prueba */
+static inline int prueba_resultado(void)
+{
+    if (fallas_prueba == 0)
+    {
+        printf("ok\n");
+    }
+    return fallas_prueba == 0 ? 0 : 1;
+}
+
+#endif /* __PRUEBA_H */
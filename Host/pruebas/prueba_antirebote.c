@@ -0,0 +1,134 @@
+/**
+ * @file prueba_antirebote.c
+ * @brief Antirebote de sensores y del botón contra el reloj virtual
+ * @author demianmozo
+ *
+ * El tiempo sale de HAL_GetTick() del HAL simulado y los pines de
+ * hal_falso_gpio_set_entrada(): la confirmación tiene que llegar exactamente
+ * al cumplirse el tiempo de filtrado, y los rebotes más cortos se descartan.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "antirebote.h"
+
+/**
+ * @brief Lee el sensor en cada ms durante ms milisegundos
+ * @return ms en que se confirmó la detección (0 = no se confirmó)
+ */
+static uint32_t leer_sensor(antirebote_sensor_t *sensor, uint16_t pin, uint32_t ms)
+{
+    uint32_t confirmado = 0;
+
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        if (antirebote_sensor(sensor, HAL_GPIO_ReadPin(GPIOC, pin), HAL_GetTick()))
+        {
+            VERIFICAR(confirmado == 0); // Una sola confirmación por flanco
+            confirmado = HAL_GetTick();
+        }
+        hal_falso_avanzar(1);
+    }
+
+    return confirmado;
+}
+
+/**
+ * @brief Lee el botón en cada ms y cuenta las pulsaciones confirmadas
+ */
+static uint32_t leer_boton(uint16_t pin, uint32_t ms, uint32_t *ultima)
+{
+    uint32_t pulsaciones = 0;
+
+    for (uint32_t i = 0; i < ms; i++)
+    {
+        if (antirebote(GPIOA, pin, HAL_GetTick()))
+        {
+            pulsaciones++;
+            *ultima = HAL_GetTick();
+        }
+        hal_falso_avanzar(1);
+    }
+
+    return pulsaciones;
+}
+
+int main(void)
+{
+    hal_falso_reiniciar();
+    hal_falso_avanzar(100);
+
+    // Sensor: una detección sostenida se confirma a los TREBOTES_SENSOR ms
+    antirebote_sensor_t sensor = ANTIREBOTE_SENSOR_INIT;
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 10) == 0);
+    uint32_t inicio = HAL_GetTick();
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_RESET);
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 100) == inicio + TREBOTES_SENSOR);
+    VERIFICAR(sensor.estable == GPIO_PIN_RESET);
+
+    // Mientras sigue en bajo no vuelve a confirmar; al soltar tampoco (activo en bajo)
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_SET);
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 100) == 0);
+    VERIFICAR(sensor.estable == GPIO_PIN_SET);
+
+    // Rebotes más cortos que el filtro se descartan
+    for (int rebote = 0; rebote < 5; rebote++)
+    {
+        hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_RESET);
+        VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, TREBOTES_SENSOR - 1) == 0);
+        hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_SET);
+        VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 3) == 0);
+    }
+
+    // Un rebote reinicia la cuenta: confirma TREBOTES_SENSOR ms después del último flanco
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_RESET);
+    leer_sensor(&sensor, GPIO_PIN_6, 5);
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_SET);
+    leer_sensor(&sensor, GPIO_PIN_6, 1);
+    inicio = HAL_GetTick();
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_RESET);
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 100) == inicio + TREBOTES_SENSOR);
+
+    // Después de reiniciarlo, el mismo nivel bajo vuelve a confirmarse
+    antirebote_sensor_reiniciar(&sensor);
+    inicio = HAL_GetTick();
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 100) == inicio + TREBOTES_SENSOR);
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_SET);
+
+    // Botón: la primera lectura solo toma el estado
+    uint32_t ultima = 0;
+    VERIFICAR(leer_boton(GPIO_PIN_0, 100, &ultima) == 0);
+
+    // Pulsación con rebotes cada 2 ms durante 10 ms: una sola, TREBOTES ms después del último
+    for (int i = 0; i < 5; i++)
+    {
+        hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_RESET);
+        VERIFICAR(leer_boton(GPIO_PIN_0, 1, &ultima) == 0);
+        hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);
+        VERIFICAR(leer_boton(GPIO_PIN_0, 1, &ultima) == 0);
+    }
+    hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_RESET);
+    inicio = HAL_GetTick();
+    VERIFICAR(leer_boton(GPIO_PIN_0, 500, &ultima) == 1);
+    VERIFICAR(ultima == inicio + TREBOTES);
+
+    // Soltar no cuenta; la segunda pulsación sí
+    hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);
+    VERIFICAR(leer_boton(GPIO_PIN_0, 200, &ultima) == 0);
+    hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_RESET);
+    VERIFICAR(leer_boton(GPIO_PIN_0, 200, &ultima) == 1);
+    hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_0, GPIO_PIN_SET);
+
+    // Un botón apretado desde el arranque no es una pulsación
+    hal_falso_gpio_set_entrada(GPIOA, GPIO_PIN_3, GPIO_PIN_RESET);
+    VERIFICAR(leer_boton(GPIO_PIN_3, 300, &ultima) == 0);
+
+    // La cuenta sobrevive a la vuelta de HAL_GetTick()
+    hal_falso_avanzar(0xFFFFFFFFu - HAL_GetTick() - 5);
+    antirebote_sensor_reiniciar(&sensor);
+    hal_falso_gpio_set_entrada(GPIOC, GPIO_PIN_6, GPIO_PIN_RESET);
+    inicio = HAL_GetTick();
+    VERIFICAR(leer_sensor(&sensor, GPIO_PIN_6, 100) == inicio + TREBOTES_SENSOR);
+
+    return prueba_resultado();
+}
@@ -0,0 +1,85 @@
+/**
+ * @file prueba_arranque.c
+ * @brief Arranque completo del firmware sobre el HAL simulado
+ * @author demianmozo
+ *
+ * Con una calibración guardada y sin mapa, recorrido_iniciar() tiene que
+ * esperar ESPERA_LARGADA_MS con los motores quietos antes de arrancar; después
+ * el bucle principal y el lazo de TIM6 corren sobre el reloj virtual.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "main.h"
+#include "control_linearecta.h"
+#include "laberinto.h"
+#include "persistencia.h"
+#include "recorrido.h"
+#include <string.h>
+
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+extern bool calibrado;
+
+static bool motores_antes_de_largar = false;
+
+/**
+ * @brief Marca si algún motor recibió PWM durante la espera de largada
+ */
+static void vigilar_motores(uint32_t ahora_ms)
+{
+    if (ahora_ms < ESPERA_LARGADA_MS &&
+        (hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3) != 0 ||
+         hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4) != 0))
+    {
+        motores_antes_de_largar = true;
+    }
+}
+
+int main(void)
+{
+    hal_falso_reiniciar();
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
+    hal_falso_adc_set_lecturas(2000, 2000);
+    hal_falso_set_paso(vigilar_motores);
+
+    // Calibración de un arranque anterior, sin mapa explorado
+    laberinto_init();
+    izq_cerca = der_cerca = 500;
+    izq_lejos = der_lejos = 2000;
+    izq_centrado = der_centrado = 1250;
+    VERIFICAR(persistencia_guardar(false));
+    calibrado = false;
+    izq_cerca = 0;
+
+    recorrido_iniciar();
+    VERIFICAR(calibrado);
+    VERIFICAR(izq_cerca == 500);
+    VERIFICAR(HAL_GetTick() >= ESPERA_LARGADA_MS);
+    VERIFICAR(!motores_antes_de_largar);
+    VERIFICAR(!terminado);
+
+    // Ya largó: avanzando con las dos ruedas
+    hal_falso_avanzar(1);
+    VERIFICAR(hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3) > 0);
+    VERIFICAR(hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4) > 0);
+    VERIFICAR(hal_falso_gpio_get_salida(MI0_GPIO_Port, MI0_Pin) == GPIO_PIN_SET);
+    VERIFICAR(hal_falso_gpio_get_salida(MD0_GPIO_Port, MD0_Pin) == GPIO_PIN_SET);
+
+    // Bucle principal y lazo de TIM6 sobre el reloj virtual
+    for (int i = 0; i < 200; i++)
+    {
+        recorrido_paso();
+        hal_falso_avanzar(1);
+    }
+    estadisticas_control_t estadisticas;
+    control_lazo_get_estadisticas(&estadisticas);
+    VERIFICAR(estadisticas.ejecuciones >= 200);
+
+    char salida[512];
+    size_t largo = hal_falso_uart_tomar((uint8_t *)salida, sizeof(salida) - 1);
+    salida[largo] = '\0';
+    VERIFICAR(strstr(salida, "UART conectada") != NULL);
+
+    return prueba_resultado();
+}
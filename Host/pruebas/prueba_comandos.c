@@ -0,0 +1,293 @@
+/**
+ * @file prueba_comandos.c
+ * @brief Intérprete de comandos por UART5: get/set, errores, líneas partidas y mapa
+ * @author demianmozo
+ *
+ * Los bytes entran por la interrupción de recepción del HAL simulado, como
+ * desde el puerto serie, y las respuestas se leen de lo transmitido. "set"
+ * tiene que cambiar la variable y rechazar valores fuera de rango sin tocarla;
+ * una línea puede llegar en pedazos y con "\r\n"; la que no entra en
+ * LARGO_LINEA_COMANDO se descarta entera sin romper la siguiente. Lo que
+ * imprime "laberinto" mandado de vuelta con "m" tiene que dejar el mismo mapa.
+ * Con el robot en marcha los comandos que tocan la flash, el mapa o la
+ * posición responden "error ocupado" sin hacer nada, y con la cola de
+ * transmisión llena las respuestas se descartan enteras en vez de esperar.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "uart.h"
+#include "comandos.h"
+#include "control_motor.h"
+#include "laberinto.h"
+#include "persistencia.h"
+#include "recorrido.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_RESPUESTA 4096u ///< Bytes de respuesta que se revisan por vez
+
+/** @brief Lo que respondió el robot, terminado en '\0' */
+static char respuesta[MAX_RESPUESTA + 1];
+
+/**
+ * @brief Manda texto por el puerto serie y lo procesa
+ * @return Acción que pidió el intérprete
+ */
+static accion_comando_t enviar(const char *texto)
+{
+    hal_falso_uart_recibir((const uint8_t *)texto, strlen(texto));
+    return comandos_procesar();
+}
+
+/** @brief Junta lo transmitido desde la última llamada */
+static const char *leer_respuesta(void)
+{
+    size_t largo = hal_falso_uart_tomar((uint8_t *)respuesta, MAX_RESPUESTA);
+    respuesta[largo] = '\0';
+    return respuesta;
+}
+
+/** @brief Manda una línea y compara la respuesta completa */
+static bool responde(const char *linea, const char *esperado)
+{
+    enviar(linea);
+    return strcmp(leer_respuesta(), esperado) == 0;
+}
+
+/**
+ * @brief get y set sobre un parámetro, con valores fuera de rango y mal escritos
+ */
+static void probar_parametros(void)
+{
+    tiempo_giro_180 = 700;
+    VERIFICAR(responde("get giro_180\n", "giro_180=700\r\n"));
+    VERIFICAR(responde("set giro_180 650\r\n", "giro_180=650\r\n"));
+    VERIFICAR(tiempo_giro_180 == 650);
+
+    // Límites: el máximo vale, uno más no; nada de signos, espacios ni texto
+    VERIFICAR(responde("set giro_180 5000\n", "giro_180=5000\r\n"));
+    VERIFICAR(responde("set giro_180 5001\n", "error valor\r\n"));
+    VERIFICAR(responde("set giro_180 -1\n", "error valor\r\n"));
+    VERIFICAR(responde("set giro_180 12x\n", "error valor\r\n"));
+    VERIFICAR(responde("set giro_180 99999999999999999999\n", "error valor\r\n"));
+    VERIFICAR(responde("set giro_180\n", "error valor\r\n"));
+    VERIFICAR(tiempo_giro_180 == 5000);
+
+    VERIFICAR(responde("get no_existe\n", "error parametro\r\n"));
+    VERIFICAR(responde("set no_existe 1\n", "error parametro\r\n"));
+    VERIFICAR(responde("set\n", "error parametro\r\n"));
+    VERIFICAR(responde("saltar\n", "error comando\r\n"));
+    VERIFICAR(responde("\n\r\n  \t \n", "")); // Líneas vacías no responden
+
+    // get sin nombre: una línea por parámetro, todas "nombre=valor"
+    enviar("get\n");
+    uint32_t lineas = 0;
+    for (const char *linea = leer_respuesta(); *linea != '\0'; lineas++)
+    {
+        const char *fin = strstr(linea, "\r\n");
+        VERIFICAR(fin != NULL && memchr(linea, '=', fin - linea) != NULL);
+        if (fin == NULL)
+            break;
+        linea = fin + 2;
+    }
+    VERIFICAR(lineas == 20);
+    VERIFICAR(strstr(respuesta, "giro_180=5000\r\n") != NULL);
+}
+
+/**
+ * @brief Líneas que llegan en pedazos y líneas demasiado largas
+ */
+static void probar_lineas(void)
+{
+    // De a un byte, con procesar() en el medio: responde recién con el '\n'
+    const char *linea = "set correccion 77\r\n";
+    for (size_t i = 0; linea[i] != '\0'; i++)
+    {
+        char byte[2] = {linea[i], '\0'};
+        VERIFICAR(enviar(byte) == ACCION_NINGUNA);
+        if (linea[i] != '\n')
+            VERIFICAR(strcmp(leer_respuesta(), "") == 0);
+    }
+    VERIFICAR(strcmp(leer_respuesta(), "correccion=77\r\n") == 0);
+    VERIFICAR(tiempo_correccion == 77);
+
+    // Justo LARGO_LINEA_COMANDO caracteres entra; uno más se descarta entero
+    char larga[LARGO_LINEA_COMANDO + 3];
+    memset(larga, ' ', sizeof(larga));
+    memcpy(larga, "set correccion 78", 17);
+    larga[LARGO_LINEA_COMANDO] = '\n';
+    larga[LARGO_LINEA_COMANDO + 1] = '\0';
+    VERIFICAR(responde(larga, "correccion=78\r\n"));
+
+    memcpy(larga, "set correccion 79", 17);
+    larga[LARGO_LINEA_COMANDO] = ' ';
+    larga[LARGO_LINEA_COMANDO + 1] = '\n';
+    larga[LARGO_LINEA_COMANDO + 2] = '\0';
+    VERIFICAR(responde(larga, "error largo\r\n"));
+    VERIFICAR(tiempo_correccion == 78);
+
+    // Una línea larga partida en pedazos no contamina la siguiente
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        VERIFICAR(enviar("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx") == ACCION_NINGUNA);
+    }
+    VERIFICAR(responde("\nget correccion\n", "error largo\r\ncorreccion=78\r\n"));
+
+    // Las acciones cortan el procesamiento; lo que sigue queda para la próxima vuelta
+    VERIFICAR(enviar("pos\nsprint\nget correccion\n") == ACCION_POSICION);
+    VERIFICAR(strcmp(leer_respuesta(), "ok\r\n") == 0);
+    VERIFICAR(comandos_procesar() == ACCION_SPRINT);
+    VERIFICAR(comandos_procesar() == ACCION_NINGUNA);
+    VERIFICAR(strcmp(leer_respuesta(), "ok\r\ncorreccion=78\r\n") == 0);
+    VERIFICAR(uart_get_bytes_perdidos_rx() == 0);
+}
+
+/**
+ * @brief Comandos rechazados y respuestas descartadas con el robot en marcha
+ */
+static void probar_ocupado(void)
+{
+    static uint8_t sector[TAMAÑO_SECTOR_PERSISTENCIA];
+    static const char *const mutantes[] = {"guardar\n", "borrar\n", "pos\n", "sprint\n", "m 1 0\n"};
+
+    laberinto_init();
+    laberinto_set_muro(1, 1, este);
+    peso_t peso = laberinto_get_peso(1, 1);
+    memcpy(sector, persistencia_get_imagen(), sizeof(sector));
+
+    // Explorando (corrida sin terminar) y con un giro en curso al llegar
+    for (uint32_t caso = 0; caso < 2; caso++)
+    {
+        terminado = (caso == 1);
+        if (terminado)
+            gira90der(norte);
+
+        for (uint32_t i = 0; i < sizeof(mutantes) / sizeof(mutantes[0]); i++)
+        {
+            VERIFICAR(enviar(mutantes[i]) == ACCION_NINGUNA);
+            VERIFICAR(strcmp(leer_respuesta(), "error ocupado\r\n") == 0);
+        }
+        VERIFICAR(responde("get correccion\n", "correccion=78\r\n")); // Leer sí se puede
+    }
+    movimiento_cancelar();
+    VERIFICAR(laberinto_get_peso(1, 1) == peso && !(laberinto_get_direcciones_libres(1, 2) & DIRECCION_BIT(oeste)));
+    VERIFICAR(memcmp(sector, persistencia_get_imagen(), sizeof(sector)) == 0);
+
+    // En marcha con la UART sin vaciar: se llena la cola y no se espera
+    terminado = false;
+    hal_falso_uart_set_bytes_por_ms(1);
+    uint32_t descartados = uart_get_bytes_descartados();
+    for (uint32_t i = 0; i < 2 * TAMAÑO_COLA_TX / 64; i++)
+    {
+        enviar("get\n"); // Vuelve aunque no entre
+    }
+    VERIFICAR(uart_get_espacio_libre() < 64);
+    VERIFICAR(uart_get_bytes_descartados() == descartados); // Ni medias líneas
+
+    // Quieto se vuelve a esperar la cola y no se pierde nada
+    hal_falso_uart_set_bytes_por_ms(TAMAÑO_COLA_TX);
+    hal_falso_avanzar(10);
+    leer_respuesta();
+    VERIFICAR(uart_get_espacio_libre() == TAMAÑO_COLA_TX);
+    hal_falso_uart_set_bytes_por_ms(0);
+    terminado = true;
+    VERIFICAR(responde("get correccion\n", "correccion=78\r\n"));
+}
+
+/**
+ * @brief Lee la dirección de cada casilla y los pesos del mapa actual
+ */
+static void copiar_mapa(uint8_t libres[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1],
+                        peso_t pesos[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1])
+{
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            libres[fila][columna] = laberinto_get_direcciones_libres(fila, columna);
+            pesos[fila][columna] = laberinto_get_peso(fila, columna);
+        }
+    }
+}
+
+/**
+ * @brief "laberinto" y de vuelta con "m": el mismo mapa y los mismos pesos
+ */
+static void probar_mapa(void)
+{
+    static uint8_t libres[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    static peso_t pesos[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    static uint8_t libres_cargado[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    static peso_t pesos_cargado[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    static char volcado[MAX_RESPUESTA + 1];
+
+    for (uint32_t vuelta = 0; vuelta < 20; vuelta++)
+    {
+        laberinto_init();
+        uint32_t muros = azar(3 * CANTIDAD_CASILLAS / 2 + 1);
+        for (uint32_t i = 0; i < muros; i++)
+        {
+            laberinto_set_muro(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO), (brujula)azar(4));
+        }
+        copiar_mapa(libres, pesos);
+
+        enviar("laberinto\n");
+        strcpy(volcado, leer_respuesta());
+        size_t largo = strlen(volcado);
+        VERIFICAR(largo >= 4 && strcmp(&volcado[largo - 4], "ok\r\n") == 0);
+
+        // Cada línea "m" se manda tal cual a un mapa vacío
+        laberinto_init();
+        uint32_t filas = 0;
+        for (char *linea = volcado; strncmp(linea, "m ", 2) == 0; filas++)
+        {
+            char *fin = strstr(linea, "\r\n");
+            char guardado = fin[2];
+            fin[2] = '\0';
+            VERIFICAR(responde(linea, "ok\r\n"));
+            fin[2] = guardado;
+            linea = fin + 2;
+        }
+        VERIFICAR(filas == FILAS_LABERINTO);
+
+        copiar_mapa(libres_cargado, pesos_cargado);
+        VERIFICAR(memcmp(libres, libres_cargado, sizeof(libres)) == 0);
+        VERIFICAR(memcmp(pesos, pesos_cargado, sizeof(pesos)) == 0);
+    }
+
+    // Filas mal escritas no tocan el mapa
+    laberinto_init();
+    copiar_mapa(libres, pesos);
+    char linea[16 + COLUMNAS_LABERINTO];
+    memset(linea, 0, sizeof(linea));
+    snprintf(linea, sizeof(linea), "m 1 %.*sg\n", COLUMNAS_LABERINTO - 1, "ffffffffffffffffffffffffffffffff");
+    VERIFICAR(responde(linea, "error muros\r\n"));
+    snprintf(linea, sizeof(linea), "m 1 %.*s\n", COLUMNAS_LABERINTO - 1, "ffffffffffffffffffffffffffffffff");
+    VERIFICAR(responde(linea, "error muros\r\n"));
+    snprintf(linea, sizeof(linea), "m 0 %.*s\n", COLUMNAS_LABERINTO, "ffffffffffffffffffffffffffffffff");
+    VERIFICAR(responde(linea, "error muros\r\n"));
+    snprintf(linea, sizeof(linea), "m %u %.*s\n", FILAS_LABERINTO + 1, COLUMNAS_LABERINTO,
+             "ffffffffffffffffffffffffffffffff");
+    VERIFICAR(responde(linea, "error muros\r\n"));
+    VERIFICAR(responde("m\n", "error muros\r\n"));
+    copiar_mapa(libres_cargado, pesos_cargado);
+    VERIFICAR(memcmp(libres, libres_cargado, sizeof(libres)) == 0);
+    VERIFICAR(memcmp(pesos, pesos_cargado, sizeof(pesos)) == 0);
+}
+
+int main(void)
+{
+    prueba_semilla(4242);
+    hal_falso_reiniciar();
+    Inicializar_UART();
+    leer_respuesta(); // "UART conectada"
+
+    terminado = true; // Quieto: se aceptan todos los comandos
+    probar_parametros();
+    probar_lineas();
+    probar_ocupado();
+    probar_mapa();
+
+    return prueba_resultado();
+}
@@ -0,0 +1,362 @@
+/**
+ * @file prueba_laberinto.c
+ * @brief Flood Fill contra un BFS de referencia sobre laberintos aleatorios
+ * @author demianmozo
+ *
+ * La referencia es un BFS ingenuo desde las metas que solo usa
+ * laberinto_hay_muro(), laberinto_get_posicion_adyacente() y
+ * laberinto_es_meta(): no comparte nada con la cola ni las máscaras de
+ * laberinto.c. Cada laberinto tiene muros al azar (a veces ninguno, a veces
+ * casi todos, así también hay casillas encerradas) y a veces una meta extra.
+ *
+ * laberinto_set_muro() actualiza los pesos en forma incremental: después de
+ * cada muro tienen que coincidir con la referencia y con lo que da el Flood
+ * Fill completo.
+ *
+ * Cada muro entre dos casillas se guarda una sola vez: visto desde cualquiera
+ * de las dos tiene que estar.
+ *
+ * El programa es el mismo para cualquier FILAS_LABERINTO x COLUMNAS_LABERINTO
+ * (ver las variantes en CMakeLists.txt). En una serpentina el camino pasa por
+ * todas las casillas, así que en 16x16 o más el peso no entra en 8 bits.
+ *
+ * Con META_CENTRAL las metas son las casillas centrales (una, dos o cuatro
+ * según la paridad de cada dimensión) y el BFS de referencia sale de todas.
+ *
+ * Las tablas de vecinas (máscara de direcciones libres y desplazamientos) se
+ * contrastan con los accesores de muros y pesos, y calcular_mejor_direccion()
+ * tiene que bajar siempre un paso de peso, desempatando según ORDEN_EVALUACION.
+ */
+
+#include "prueba.h"
+#include "laberinto.h"
+#include "navegacion.h"
+
+#define LABERINTOS (8000u / CANTIDAD_CASILLAS + 4u) ///< Laberintos aleatorios por prueba (menos cuanto más grandes)
+
+/**
+ * @brief Distancias de referencia: BFS casilla por casilla desde todas las metas
+ */
+static void calcular_referencia(peso_t referencia[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1])
+{
+    static posicion_t cola[CANTIDAD_CASILLAS];
+    uint16_t cabeza = 0, cola_fin = 0;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            referencia[fila][columna] = PESO_MAXIMO;
+            if (laberinto_es_meta(fila, columna))
+            {
+                referencia[fila][columna] = 0;
+                cola[cola_fin++] = (posicion_t){fila, columna};
+            }
+        }
+    }
+
+    while (cabeza < cola_fin)
+    {
+        posicion_t actual = cola[cabeza++];
+        for (brujula direccion = norte; direccion <= oeste; direccion++)
+        {
+            if (laberinto_hay_muro(actual.fila, actual.columna, direccion))
+                continue;
+
+            posicion_t vecina = laberinto_get_posicion_adyacente(actual, direccion);
+            if (!laberinto_posicion_valida(vecina.fila, vecina.columna) ||
+                referencia[vecina.fila][vecina.columna] != PESO_MAXIMO)
+                continue;
+
+            referencia[vecina.fila][vecina.columna] = referencia[actual.fila][actual.columna] + 1;
+            cola[cola_fin++] = vecina;
+        }
+    }
+}
+
+/**
+ * @brief Cuenta las casillas cuyo peso no coincide con la referencia
+ */
+static uint32_t diferencias_con_referencia(void)
+{
+    static peso_t referencia[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    uint32_t diferencias = 0;
+
+    calcular_referencia(referencia);
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (laberinto_get_peso(fila, columna) != referencia[fila][columna])
+                diferencias++;
+        }
+    }
+    return diferencias;
+}
+
+/**
+ * @brief Cuenta los muros que no se ven igual desde las dos casillas que separan
+ * @details Los bordes no tienen vecina: como en el mapa original, empiezan sin
+ *          muro hasta que se detecta
+ */
+static uint32_t muros_no_compartidos(void)
+{
+    uint32_t errores = 0;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula direccion = norte; direccion <= oeste; direccion++)
+            {
+                posicion_t vecina = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, direccion);
+                if (!laberinto_posicion_valida(vecina.fila, vecina.columna))
+                    continue;
+
+                if (laberinto_hay_muro(fila, columna, direccion) !=
+                    laberinto_hay_muro(vecina.fila, vecina.columna, (brujula)((direccion + 2) % 4)))
+                    errores++;
+            }
+        }
+    }
+    return errores;
+}
+
+/**
+ * @brief Cuenta las casillas donde las tablas de vecinas o la dirección elegida
+ *        no coinciden con los muros y pesos
+ */
+static uint32_t errores_de_vecinas(void)
+{
+    static const brujula orden[4] = {ORDEN_EVALUACION};
+    uint32_t errores = 0;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            uint8_t libres = laberinto_get_direcciones_libres(fila, columna);
+            peso_t minimo = PESO_MAXIMO;
+            for (brujula direccion = norte; direccion <= oeste; direccion++)
+            {
+                posicion_t vecina = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, direccion);
+                bool libre = laberinto_posicion_valida(vecina.fila, vecina.columna) &&
+                             !laberinto_hay_muro(fila, columna, direccion);
+                peso_t peso = libre ? laberinto_get_peso(vecina.fila, vecina.columna) : PESO_MAXIMO;
+
+                if (libre != ((libres & DIRECCION_BIT(direccion)) != 0) ||
+                    peso != laberinto_get_peso_adyacente(fila, columna, direccion))
+                    errores++;
+                if (peso < minimo)
+                    minimo = peso;
+            }
+
+            // Desde una casilla alcanzable que no es meta se baja un paso por la primera del orden
+            peso_t peso = laberinto_get_peso(fila, columna);
+            if (peso == 0 || peso == PESO_MAXIMO)
+                continue;
+
+            brujula elegida = calcular_mejor_direccion(fila, columna);
+            brujula esperada = norte;
+            for (int i = 3; i >= 0; i--)
+            {
+                if (laberinto_get_peso_adyacente(fila, columna, orden[i]) == minimo)
+                    esperada = orden[i];
+            }
+            if (minimo != peso - 1 || elegida != esperada)
+                errores++;
+        }
+    }
+    return errores;
+}
+
+/**
+ * @brief Serpentina desde la meta en (1,1): cada fila se conecta con la de abajo
+ *        por un solo extremo, alternando el lado
+ * @return Peso esperado de la casilla más lejana
+ */
+static peso_t armar_serpentina(void)
+{
+    laberinto_init();
+    laberinto_limpiar_metas();
+    VERIFICAR(laberinto_agregar_meta(1, 1));
+
+    for (uint8_t fila = 1; fila < FILAS_LABERINTO; fila++)
+    {
+        uint8_t abierta = (fila % 2) ? COLUMNAS_LABERINTO : 1;
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (columna != abierta)
+                laberinto_set_muro(fila, columna, sur);
+        }
+    }
+    return CANTIDAD_CASILLAS - 1;
+}
+
+/**
+ * @brief Indica si los pesos actuales son los mismos que da el Flood Fill completo
+ */
+static bool igual_al_flood_completo(void)
+{
+    static peso_t antes[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    bool iguales = true;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            antes[fila][columna] = laberinto_get_peso(fila, columna);
+        }
+    }
+
+    laberinto_recalcular_pesos();
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            if (laberinto_get_peso(fila, columna) != antes[fila][columna])
+                iguales = false;
+        }
+    }
+    return iguales;
+}
+
+/**
+ * @brief Arranca un laberinto vacío, a veces con una meta extra al azar
+ */
+static void iniciar_laberinto(void)
+{
+    laberinto_init();
+    if (azar(2))
+    {
+        VERIFICAR(laberinto_agregar_meta(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO)));
+    }
+}
+
+/**
+ * @brief Pone muros al azar (la cantidad también es al azar)
+ */
+static void poner_muros_al_azar(void)
+{
+    uint32_t muros = azar(2 * CANTIDAD_CASILLAS + 1);
+    for (uint32_t i = 0; i < muros; i++)
+    {
+        laberinto_set_muro(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO), (brujula)azar(4));
+    }
+}
+
+/**
+ * @brief Revisa las metas que carga laberinto_init() y el tope de MAX_METAS
+ */
+static void verificar_metas(void)
+{
+    laberinto_init();
+
+#ifdef META_CENTRAL
+    uint8_t fila_centro = (FILAS_LABERINTO + 1) / 2, columna_centro = (COLUMNAS_LABERINTO + 1) / 2;
+    uint8_t filas_meta = (FILAS_LABERINTO % 2) ? 1 : 2, columnas_meta = (COLUMNAS_LABERINTO % 2) ? 1 : 2;
+#else
+    uint8_t fila_centro = POSICION_META_FILA, columna_centro = POSICION_META_COLUMNA;
+    uint8_t filas_meta = 1, columnas_meta = 1;
+#endif
+    uint32_t metas = 0;
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            bool esperada = fila >= fila_centro && fila < fila_centro + filas_meta &&
+                            columna >= columna_centro && columna < columna_centro + columnas_meta;
+            VERIFICAR(laberinto_es_meta(fila, columna) == esperada);
+            VERIFICAR((laberinto_get_peso(fila, columna) == 0) == esperada);
+            metas += esperada;
+        }
+    }
+    VERIFICAR(metas == (uint32_t)filas_meta * columnas_meta);
+
+    // Repetir una meta no ocupa lugar; pasado MAX_METAS no se agregan más
+    VERIFICAR(laberinto_agregar_meta(fila_centro, columna_centro));
+    laberinto_limpiar_metas();
+    uint32_t agregadas = 0;
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            agregadas += laberinto_agregar_meta(fila, columna);
+        }
+    }
+    VERIFICAR(agregadas == (CANTIDAD_CASILLAS < MAX_METAS ? CANTIDAD_CASILLAS : MAX_METAS));
+    VERIFICAR(!laberinto_agregar_meta(0, 1));
+    VERIFICAR(diferencias_con_referencia() == 0);
+}
+
+int main(void)
+{
+    prueba_semilla(12345);
+    verificar_metas();
+
+    // Sin muros el peso es la distancia Manhattan a la meta más cercana
+    laberinto_init();
+    VERIFICAR(diferencias_con_referencia() == 0);
+
+    // Un muro puesto desde una casilla se ve desde la vecina
+    laberinto_set_muro(1, 1, este);
+    VERIFICAR(laberinto_hay_muro(1, 2, oeste));
+    laberinto_set_muro(FILAS_LABERINTO, 1, norte);
+    VERIFICAR(laberinto_hay_muro(FILAS_LABERINTO - 1, 1, sur));
+    VERIFICAR(!laberinto_hay_muro(FILAS_LABERINTO, 2, norte));
+    laberinto_set_muro(1, 1, norte);
+    VERIFICAR(laberinto_hay_muro(1, 1, norte));
+    VERIFICAR(!laberinto_hay_muro(1, 2, norte));
+    VERIFICAR(muros_no_compartidos() == 0);
+
+    // Flood Fill completo sobre laberintos aleatorios
+    uint32_t diferencias = 0, no_compartidos = 0, vecinas_mal = 0;
+    for (uint32_t i = 0; i < LABERINTOS; i++)
+    {
+        iniciar_laberinto();
+        poner_muros_al_azar();
+        laberinto_recalcular_pesos();
+        diferencias += diferencias_con_referencia();
+        no_compartidos += muros_no_compartidos();
+        vecinas_mal += errores_de_vecinas();
+    }
+    VERIFICAR(diferencias == 0);
+    VERIFICAR(no_compartidos == 0);
+    VERIFICAR(vecinas_mal == 0);
+
+    // Actualización incremental, muro por muro (repetidos y de borde incluidos)
+    diferencias = 0;
+    uint32_t distintos_al_completo = 0;
+    for (uint32_t i = 0; i < LABERINTOS; i++)
+    {
+        iniciar_laberinto();
+        uint32_t muros = azar(2 * CANTIDAD_CASILLAS + 1);
+        for (uint32_t j = 0; j < muros; j++)
+        {
+            laberinto_set_muro(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO), (brujula)azar(4));
+            diferencias += diferencias_con_referencia();
+            if (!igual_al_flood_completo())
+                distintos_al_completo++;
+        }
+    }
+    VERIFICAR(diferencias == 0);
+    VERIFICAR(distintos_al_completo == 0);
+    VERIFICAR(laberinto_get_fallos_incremental() == 0);
+
+    // Camino que pasa por todas las casillas
+    peso_t maximo = armar_serpentina();
+    uint8_t fila_lejana = FILAS_LABERINTO;
+    uint8_t columna_lejana = (FILAS_LABERINTO % 2) ? COLUMNAS_LABERINTO : 1;
+    VERIFICAR(laberinto_get_peso(fila_lejana, columna_lejana) == maximo);
+    VERIFICAR(diferencias_con_referencia() == 0);
+    laberinto_recalcular_pesos();
+    VERIFICAR(laberinto_get_peso(fila_lejana, columna_lejana) == maximo);
+
+    // Sin metas no se llega a ningún lado
+    laberinto_limpiar_metas();
+    laberinto_recalcular_pesos();
+    VERIFICAR(laberinto_get_peso(1, 1) == PESO_MAXIMO);
+    VERIFICAR(laberinto_get_peso(FILAS_LABERINTO, COLUMNAS_LABERINTO) == PESO_MAXIMO);
+
+    return prueba_resultado();
+}
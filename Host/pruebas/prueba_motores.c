@@ -0,0 +1,110 @@
+/**
+ * @file prueba_motores.c
+ * @brief set_motores(): los dos canales de TIM3 cambian en el mismo período
+ * @author demianmozo
+ *
+ * El HAL simulado puede meter el evento de actualización de TIM3 justo entre
+ * la escritura del compare izquierdo y la del derecho, que es donde en el
+ * micro un período podría quedar con un motor nuevo y el otro viejo. Con
+ * set_motores() ese período tiene que seguir con los dos valores anteriores y
+ * el siguiente tomar los dos nuevos. Escribiendo los compare sueltos, sin
+ * UDIS, la prueba tiene que ver el período mezclado (si no, no prueba nada).
+ * También se revisan los cuatro pines de dirección para cada estado.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "main.h"
+#include "control_motor.h"
+
+/** @brief PWM aplicado en el período actual */
+static uint32_t activo_izq(void)
+{
+    return hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3);
+}
+
+static uint32_t activo_der(void)
+{
+    return hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4);
+}
+
+/** @brief Indica si los pines M0 y M1 de un motor están como pide el estado */
+static bool pines_en(uint16_t pin0, uint16_t pin1, motor_estado_t estado)
+{
+    GPIO_PinState m0 = hal_falso_gpio_get_salida(GPIOB, pin0);
+    GPIO_PinState m1 = hal_falso_gpio_get_salida(GPIOB, pin1);
+
+    switch (estado)
+    {
+    case MOTOR_AVANCE:
+        return m0 == GPIO_PIN_SET && m1 == GPIO_PIN_RESET;
+    case MOTOR_RETROCESO:
+        return m0 == GPIO_PIN_RESET && m1 == GPIO_PIN_SET;
+    default:
+        return m0 == GPIO_PIN_RESET && m1 == GPIO_PIN_RESET;
+    }
+}
+
+int main(void)
+{
+    prueba_semilla(99);
+    hal_falso_reiniciar();
+    control_motor_init();
+    set_motores(MOTOR_AVANCE, 300, MOTOR_AVANCE, 300);
+    hal_falso_avanzar(1);
+    VERIFICAR(activo_izq() == 300 && activo_der() == 300);
+
+    // Sin UDIS el evento entre las dos escrituras deja un período mezclado
+    hal_falso_tim_evento_en_escritura(TIM3, 1);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_3, 500);
+    __HAL_TIM_SET_COMPARE(&htim3, TIM_CHANNEL_4, 500);
+    VERIFICAR(activo_izq() == 500 && activo_der() == 300);
+    hal_falso_avanzar(1);
+    VERIFICAR(activo_izq() == 500 && activo_der() == 500);
+
+    // Con set_motores() nunca: el evento en cualquiera de las escrituras deja
+    // el período con el par anterior y el siguiente toma el par nuevo
+    uint32_t mezclados = 0, pines_mal = 0;
+    uint32_t izq_anterior = 500, der_anterior = 500;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        motor_estado_t estado_izq = (motor_estado_t)azar(3);
+        motor_estado_t estado_der = (motor_estado_t)azar(3);
+        uint16_t pwm_izq = (uint16_t)azar(1001);
+        uint16_t pwm_der = (uint16_t)azar(1001);
+
+        hal_falso_tim_evento_en_escritura(TIM3, 1 + azar(2));
+        set_motores(estado_izq, pwm_izq, estado_der, pwm_der);
+        hal_falso_tim_evento_en_escritura(TIM3, 0);
+        if (activo_izq() != izq_anterior || activo_der() != der_anterior)
+            mezclados++;
+
+        hal_falso_avanzar(1);
+        izq_anterior = (estado_izq == MOTOR_FRENADO) ? 0 : pwm_izq;
+        der_anterior = (estado_der == MOTOR_FRENADO) ? 0 : pwm_der;
+        if (activo_izq() != izq_anterior || activo_der() != der_anterior)
+            mezclados++;
+
+        // Las direcciones cambian enseguida, las dos ruedas juntas
+        if (!pines_en(MI0_Pin, MI1_Pin, estado_izq) || !pines_en(MD0_Pin, MD1_Pin, estado_der))
+            pines_mal++;
+    }
+    VERIFICAR(mezclados == 0);
+    VERIFICAR(pines_mal == 0);
+
+    // Los movimientos pasan por set_motores(): un giro cambia las dos ruedas juntas
+    hal_falso_tim_evento_en_escritura(TIM3, 1);
+    gira90der(norte);
+    VERIFICAR(activo_izq() == izq_anterior && activo_der() == der_anterior);
+    hal_falso_avanzar(1);
+    VERIFICAR(activo_izq() == velocidad_giro_actual_izq && activo_der() == velocidad_giro_actual_der);
+    VERIFICAR(pines_en(MI0_Pin, MI1_Pin, MOTOR_AVANCE) && pines_en(MD0_Pin, MD1_Pin, MOTOR_RETROCESO));
+
+    hal_falso_tim_evento_en_escritura(TIM3, 2);
+    termino();
+    hal_falso_avanzar(1);
+    VERIFICAR(activo_izq() == 0 && activo_der() == 0);
+    VERIFICAR(pines_en(MI0_Pin, MI1_Pin, MOTOR_FRENADO) && pines_en(MD0_Pin, MD1_Pin, MOTOR_FRENADO));
+
+    return prueba_resultado();
+}
@@ -0,0 +1,96 @@
+/**
+ * @file prueba_movimiento.c
+ * @brief Giros, avances y correcciones sin bloquear, sobre el reloj virtual
+ * @author demianmozo
+ *
+ * Arrancar un movimiento no puede consumir tiempo: el reloj virtual solo
+ * avanza con hal_falso_avanzar(). movimiento_actualizar() tiene que terminar
+ * cada movimiento exactamente al cumplirse su plazo, el giro tiene que seguir
+ * avanzando y termino() tiene que cortar todo.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "control_motor.h"
+
+/**
+ * @brief Llama a movimiento_actualizar() en cada ms hasta que termine algo
+ * @return ms transcurridos hasta que terminó (o maximo_ms si no terminó)
+ */
+static uint32_t esperar_fin(estado_movimiento_t esperado, uint32_t maximo_ms)
+{
+    uint32_t inicio = HAL_GetTick();
+
+    while (HAL_GetTick() - inicio < maximo_ms)
+    {
+        estado_movimiento_t terminado = movimiento_actualizar(HAL_GetTick());
+        if (terminado != MOVIMIENTO_LIBRE)
+        {
+            VERIFICAR(terminado == esperado);
+            return HAL_GetTick() - inicio;
+        }
+        hal_falso_avanzar(1);
+    }
+    return maximo_ms;
+}
+
+/** @brief Indica si algún motor tiene PWM aplicado */
+static bool motores_andando(void)
+{
+    return hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3) != 0 ||
+           hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4) != 0;
+}
+
+int main(void)
+{
+    hal_falso_reiniciar();
+    control_motor_init();
+    hal_falso_avanzar(10);
+
+    // Giros: vuelven enseguida con el sentido final y terminan a su plazo
+    uint32_t antes = HAL_GetTick();
+    VERIFICAR(gira90der(norte) == este);
+    VERIFICAR(HAL_GetTick() == antes);
+    VERIFICAR(movimiento_get_estado() == MOVIMIENTO_GIRO);
+    VERIFICAR(movimiento_en_curso());
+    VERIFICAR(esperar_fin(MOVIMIENTO_GIRO, 5000) == tiempo_giro_90_der);
+    VERIFICAR(!movimiento_en_curso());
+    hal_falso_avanzar(2);
+    VERIFICAR(motores_andando()); // Después del giro sigue avanzando
+
+    VERIFICAR(gira90izq(norte) == oeste);
+    VERIFICAR(esperar_fin(MOVIMIENTO_GIRO, 5000) == tiempo_giro_90_izq);
+    VERIFICAR(gira180(este) == oeste);
+    VERIFICAR(esperar_fin(MOVIMIENTO_GIRO, 5000) == tiempo_giro_180);
+
+    // Un tiempo cambiado por UART vale desde el próximo giro
+    tiempo_giro_90_der = 123;
+    gira90der(sur);
+    VERIFICAR(esperar_fin(MOVIMIENTO_GIRO, 5000) == 123);
+
+    // Avance con plazo
+    movimiento_iniciar_avance(250);
+    VERIFICAR(movimiento_get_estado() == MOVIMIENTO_AVANCE);
+    VERIFICAR(esperar_fin(MOVIMIENTO_AVANCE, 5000) == 250);
+
+    // La corrección no cuenta como movimiento en curso y un giro la reemplaza
+    correccion_izquierda();
+    VERIFICAR(movimiento_get_estado() == MOVIMIENTO_CORRECCION);
+    VERIFICAR(!movimiento_en_curso());
+    hal_falso_avanzar(tiempo_correccion / 2);
+    gira90izq(este);
+    VERIFICAR(esperar_fin(MOVIMIENTO_GIRO, 5000) == tiempo_giro_90_izq);
+
+    correccion_derecha();
+    VERIFICAR(esperar_fin(MOVIMIENTO_CORRECCION, 5000) == tiempo_correccion);
+
+    // termino() cancela el giro y frena
+    gira180(norte);
+    hal_falso_avanzar(10);
+    termino();
+    VERIFICAR(movimiento_get_estado() == MOVIMIENTO_LIBRE);
+    VERIFICAR(esperar_fin(MOVIMIENTO_LIBRE, 2000) == 2000);
+    VERIFICAR(!motores_andando());
+
+    return prueba_resultado();
+}
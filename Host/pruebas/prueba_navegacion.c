@@ -0,0 +1,311 @@
+/**
+ * @file prueba_navegacion.c
+ * @brief Ruta de sprint compilada y planificador con costo de giros
+ * @author demianmozo
+ *
+ * La ruta de navegacion_compilar_ruta() se recorre comando por comando sobre
+ * el mapa: no puede atravesar muros, tiene que terminar en una meta, juntar
+ * las rectas y no repetir giros. Sin PLANIFICAR_CON_GIROS avanza tantas
+ * casillas como el peso de la de partida (el camino más corto); con el
+ * planificador, la suma de avances y giros es el tiempo estimado.
+ *
+ * Con PLANIFICAR_CON_GIROS el tiempo estimado de cada estado (casilla,
+ * orientación) tiene que ser el mínimo de avances y giros hasta una meta. La
+ * referencia relaja todos los estados hasta que nada cambia, usando solo
+ * laberinto_hay_muro() y los tiempos de control_motor.h: giros, velocidad de
+ * avance y perfil se cambian al azar en cada laberinto, como haría "set" por
+ * UART (y activar_modo_sprint() con la velocidad).
+ */
+
+#include "prueba.h"
+#include "laberinto.h"
+#include "navegacion.h"
+#include "control_motor.h"
+
+#define LABERINTOS (8000u / CANTIDAD_CASILLAS + 4u) ///< Laberintos aleatorios por prueba
+
+/**
+ * @brief Laberinto vacío con muros al azar y a veces una meta extra
+ */
+static void armar_laberinto_al_azar(void)
+{
+    laberinto_init();
+    if (azar(2))
+    {
+        VERIFICAR(laberinto_agregar_meta(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO)));
+    }
+
+    uint32_t muros = azar(CANTIDAD_CASILLAS + 1);
+    for (uint32_t i = 0; i < muros; i++)
+    {
+        laberinto_set_muro(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO), (brujula)azar(4));
+    }
+}
+
+/**
+ * @brief Tiempo de cruzar una casilla: PERFIL_LARGO_CASILLA_MM a la velocidad actual
+ */
+static costo_t costo_avance_referencia(void)
+{
+    uint32_t mm_por_s_por_1000 = PERFIL_VELOCIDAD_1000_MM_S * velocidad_actual_izq;
+    costo_t costo = PERFIL_LARGO_CASILLA_MM * 1000000u / mm_por_s_por_1000;
+    return costo ? costo : 1;
+}
+
+/**
+ * @brief Tiempo de girar de una orientación a otra, igual que el planificador
+ * @details Con el perfil se suma lo que tarda de más en volver a la base
+ *          acelerando desde PERFIL_VELOCIDAD_INICIAL
+ */
+static costo_t costo_giro_referencia(brujula desde, brujula hacia)
+{
+    costo_t arranque = 0;
+    if (perfil_velocidad && velocidad_actual_izq > PERFIL_VELOCIDAD_INICIAL)
+    {
+        uint32_t diferencia = velocidad_actual_izq - PERFIL_VELOCIDAD_INICIAL;
+        arranque = diferencia * diferencia / (2u * PERFIL_ACELERACION_MAXIMA * velocidad_actual_izq);
+    }
+
+    switch ((hacia - desde + 4) % 4)
+    {
+    case 1:
+        return tiempo_giro_90_der + arranque;
+    case 2:
+        return tiempo_giro_180 + arranque;
+    case 3:
+        return tiempo_giro_90_izq + arranque;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Compila la ruta desde una casilla y orientación y la recorre
+ * @return true si la ruta es válida y tan corta como corresponde
+ */
+static bool ruta_correcta(uint8_t fila, uint8_t columna, brujula sentido)
+{
+    static const int8_t giro_de_comando[] = {0, 1, 3, 2}; // AVANZAR, DER, IZQ, 180 en cuartos de vuelta
+    peso_t peso = laberinto_get_peso(fila, columna);
+    uint16_t cantidad = navegacion_compilar_ruta(fila, columna, sentido);
+
+    if (peso == PESO_MAXIMO || peso == 0)
+        return cantidad == 0;
+    if (cantidad == 0)
+        return false;
+
+#if PLANIFICAR_CON_GIROS
+    costo_t esperado = navegacion_get_costo_estimado(fila, columna, sentido);
+#endif
+    const comando_t *ruta = navegacion_get_ruta();
+    uint32_t casillas = 0;
+    costo_t costo = 0;
+
+    for (uint16_t i = 0; i < cantidad; i++)
+    {
+        comando_t comando = ruta[i];
+        if (comando.tipo > COMANDO_GIRO_180)
+            return false;
+
+        if (comando.tipo != COMANDO_AVANZAR)
+        {
+            // Un giro por vez, y siempre seguido de un avance
+            if (i + 1 >= cantidad || ruta[i + 1].tipo != COMANDO_AVANZAR)
+                return false;
+            brujula nuevo = (brujula)((sentido + giro_de_comando[comando.tipo]) % 4);
+            costo += costo_giro_referencia(sentido, nuevo);
+            sentido = nuevo;
+            continue;
+        }
+
+        // Las rectas van juntas en un solo comando
+        if (comando.casillas == 0 || (i > 0 && ruta[i - 1].tipo == COMANDO_AVANZAR))
+            return false;
+        for (uint8_t paso = 0; paso < comando.casillas; paso++)
+        {
+            if (laberinto_hay_muro(fila, columna, sentido))
+                return false;
+            posicion_t siguiente = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, sentido);
+            if (!laberinto_posicion_valida(siguiente.fila, siguiente.columna))
+                return false;
+            fila = siguiente.fila;
+            columna = siguiente.columna;
+            casillas++;
+            costo += costo_avance_referencia();
+        }
+    }
+
+    if (!laberinto_es_meta(fila, columna))
+        return false;
+#if PLANIFICAR_CON_GIROS
+    return costo == esperado;
+#else
+    return casillas == peso;
+#endif
+}
+
+/**
+ * @brief Cuenta las rutas mal compiladas desde todas las casillas y orientaciones
+ */
+static uint32_t errores_de_rutas(void)
+{
+    uint32_t errores = 0;
+
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula sentido = norte; sentido <= oeste; sentido++)
+            {
+                if (!ruta_correcta(fila, columna, sentido))
+                    errores++;
+            }
+        }
+    }
+    return errores;
+}
+
+#if PLANIFICAR_CON_GIROS
+/**
+ * @brief Tiempo mínimo a la meta de cada estado por Bellman-Ford
+ */
+static void calcular_referencia(costo_t referencia[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1][4])
+{
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula h = norte; h <= oeste; h++)
+            {
+                referencia[fila][columna][h] = laberinto_es_meta(fila, columna) ? 0 : COSTO_INFINITO;
+            }
+        }
+    }
+
+    bool cambio = true;
+    while (cambio)
+    {
+        cambio = false;
+        for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+        {
+            for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+            {
+                for (brujula direccion = norte; direccion <= oeste; direccion++)
+                {
+                    posicion_t vecina = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, direccion);
+                    if (!laberinto_posicion_valida(vecina.fila, vecina.columna) ||
+                        laberinto_hay_muro(fila, columna, direccion) ||
+                        referencia[vecina.fila][vecina.columna][direccion] == COSTO_INFINITO)
+                        continue;
+
+                    for (brujula h = norte; h <= oeste; h++)
+                    {
+                        costo_t costo = costo_giro_referencia(h, direccion) + costo_avance_referencia() +
+                                        referencia[vecina.fila][vecina.columna][direccion];
+                        if (costo < referencia[fila][columna][h])
+                        {
+                            referencia[fila][columna][h] = costo;
+                            cambio = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Cuenta los estados cuyo tiempo estimado no coincide con la referencia
+ *        y las casillas donde la dirección elegida no es la de menor tiempo
+ */
+static uint32_t errores_del_plan(void)
+{
+    static costo_t referencia[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1][4];
+    static const brujula orden[4] = {ORDEN_EVALUACION};
+    uint32_t errores = 0;
+
+    calcular_referencia(referencia);
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            for (brujula h = norte; h <= oeste; h++)
+            {
+                // Cada llamada recalcula el plan, así que después se puede leer el costo
+                brujula elegida = calcular_mejor_direccion_orientada(fila, columna, h);
+                if (navegacion_get_costo_estimado(fila, columna, h) != referencia[fila][columna][h])
+                    errores++;
+
+                if (laberinto_es_meta(fila, columna) || referencia[fila][columna][h] == COSTO_INFINITO)
+                    continue;
+
+                // Primera dirección del orden que logra el mínimo
+                brujula esperada = h;
+                for (int i = 3; i >= 0; i--)
+                {
+                    posicion_t vecina = laberinto_get_posicion_adyacente((posicion_t){fila, columna}, orden[i]);
+                    if (!laberinto_posicion_valida(vecina.fila, vecina.columna) ||
+                        laberinto_hay_muro(fila, columna, orden[i]) ||
+                        referencia[vecina.fila][vecina.columna][orden[i]] == COSTO_INFINITO)
+                        continue;
+
+                    if (costo_giro_referencia(h, orden[i]) + costo_avance_referencia() +
+                            referencia[vecina.fila][vecina.columna][orden[i]] ==
+                        referencia[fila][columna][h])
+                        esperada = orden[i];
+                }
+                if (elegida != esperada)
+                    errores++;
+            }
+        }
+    }
+    return errores;
+}
+#endif
+
+int main(void)
+{
+    prueba_semilla(2024);
+    uint32_t errores_plan = 0, errores_ruta = 0;
+
+    for (uint32_t i = 0; i < LABERINTOS; i++)
+    {
+        armar_laberinto_al_azar();
+
+        // Giros entre 50 y 1000 ms; a veces un giro de 180 más barato que dos de 90
+        tiempo_giro_90_der = 50 + azar(950);
+        tiempo_giro_90_izq = 50 + azar(950);
+        tiempo_giro_180 = 50 + azar(1950);
+        velocidad_actual_izq = 200 + azar(801); // Casillas de 350 a 1750 ms
+        perfil_velocidad = azar(2);
+
+#if PLANIFICAR_CON_GIROS
+        errores_plan += errores_del_plan();
+#endif
+        errores_ruta += errores_de_rutas();
+    }
+    VERIFICAR(errores_plan == 0);
+    VERIFICAR(errores_ruta == 0);
+
+    // Zigzag en escalera: un giro y un avance por casilla, la ruta más larga en comandos
+    laberinto_init();
+    laberinto_limpiar_metas();
+    VERIFICAR(laberinto_agregar_meta(1, 1));
+    uint8_t diagonal = FILAS_LABERINTO < COLUMNAS_LABERINTO ? FILAS_LABERINTO : COLUMNAS_LABERINTO;
+    for (uint8_t k = 2; k <= diagonal; k++)
+    {
+        // Desde (k, k) se baja por el oeste y desde (k, k-1) por el norte
+        laberinto_set_muro(k, k, norte);
+        laberinto_set_muro(k, k - 1, oeste);
+    }
+    uint16_t cantidad = navegacion_compilar_ruta(diagonal, diagonal, este);
+    VERIFICAR(laberinto_get_peso(diagonal, diagonal) == 2 * (diagonal - 1));
+#if !PLANIFICAR_CON_GIROS
+    VERIFICAR(cantidad == 4 * (diagonal - 1)); // Con el planificador puede convenir rodear
+#else
+    VERIFICAR(cantidad > 0);
+#endif
+    VERIFICAR(ruta_correcta(diagonal, diagonal, este));
+
+    return prueba_resultado();
+}
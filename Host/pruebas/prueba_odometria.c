@@ -0,0 +1,162 @@
+/**
+ * @file prueba_odometria.c
+ * @brief Odometría con los contadores simulados de odometria_simular_pulsos()
+ * @author demianmozo
+ *
+ * Distancia y rumbo se comparan con las fórmulas en punto flotante sobre los
+ * pulsos totales: vueltas enteras de rueda, un giro en el lugar de 90 grados,
+ * pasos al azar de hasta medio contador (el de 16 bits da muchas vueltas) y
+ * pulsos de a uno, que no pueden acumular redondeo. Con ODOMETRIA_ENCODERS
+ * además el giro y el avance tienen que terminar por lo medido y, si los
+ * encoders no cuentan, por el plazo multiplicado por ODOMETRIA_FACTOR_PLAZO.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "odometria.h"
+#include "control_motor.h"
+#include <math.h>
+
+#define UM_POR_PULSO (M_PI * ODOMETRIA_DIAMETRO_RUEDA_UM / ODOMETRIA_PULSOS_POR_VUELTA)
+
+/** @brief Pulsos que se mandaron a cada rueda desde odometria_iniciar() */
+static int64_t total_izq = 0, total_der = 0;
+
+/** @brief Mueve las ruedas y lee los contadores, como una ejecución del lazo */
+static void mover(int16_t izq, int16_t der)
+{
+    odometria_simular_pulsos(izq, der);
+    odometria_actualizar();
+    total_izq += izq;
+    total_der += der;
+}
+
+/** @brief Vuelve la odometría a cero, con los contadores donde estén */
+static void reiniciar(void)
+{
+    odometria_iniciar();
+    total_izq = total_der = 0;
+}
+
+/**
+ * @brief Indica si la odometría coincide con la referencia
+ * @details A 1 milésima de grado y a 1 um más el error de pi como 355/113
+ *          (8.5e-8 relativo: 6 um en 70 m)
+ */
+static bool igual_a_referencia(void)
+{
+    int32_t izq, der;
+    double distancia = (total_izq + total_der) / 2.0 * UM_POR_PULSO;
+    double angulo = (total_der - total_izq) * UM_POR_PULSO / ODOMETRIA_TROCHA_UM * 180000.0 / M_PI;
+
+    odometria_get_pulsos(&izq, &der);
+    return izq == total_izq && der == total_der && fabs(odometria_get_distancia_um() - distancia) <= 1.0 + fabs(distancia) * 1e-7 &&
+           fabs(odometria_get_angulo_mgrados() - angulo) <= 1.0;
+}
+
+#if ODOMETRIA_ENCODERS
+/**
+ * @brief Corre el movimiento en curso moviendo las ruedas cada ms
+ * @return ms hasta que terminó
+ */
+static uint32_t correr_movimiento(int16_t izq_por_ms, int16_t der_por_ms)
+{
+    uint32_t inicio = HAL_GetTick();
+
+    for (;;)
+    {
+        hal_falso_avanzar(1);
+        mover(izq_por_ms, der_por_ms);
+        if (movimiento_actualizar(HAL_GetTick()) != MOVIMIENTO_LIBRE || HAL_GetTick() - inicio > 60000)
+            return HAL_GetTick() - inicio;
+    }
+}
+#endif
+
+int main(void)
+{
+    prueba_semilla(1440);
+    hal_falso_reiniciar();
+    reiniciar();
+    VERIFICAR(odometria_get_distancia_um() == 0 && odometria_get_angulo_mgrados() == 0);
+
+    // Diez vueltas de rueda hacia adelante y cinco hacia atrás, sin girar
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        mover(ODOMETRIA_PULSOS_POR_VUELTA / 10, ODOMETRIA_PULSOS_POR_VUELTA / 10);
+    }
+    VERIFICAR(igual_a_referencia());
+    VERIFICAR(fabs(odometria_get_distancia_um() - 10 * M_PI * ODOMETRIA_DIAMETRO_RUEDA_UM) <= 1.0);
+    VERIFICAR(odometria_get_angulo_mgrados() == 0);
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        mover(-ODOMETRIA_PULSOS_POR_VUELTA / 10, -ODOMETRIA_PULSOS_POR_VUELTA / 10);
+    }
+    VERIFICAR(fabs(odometria_get_distancia_um() - 5 * M_PI * ODOMETRIA_DIAMETRO_RUEDA_UM) <= 1.0);
+
+    // Giro en el lugar a la izquierda: 90 grados cuando cada rueda hizo un
+    // cuarto de la circunferencia de la trocha
+    reiniciar();
+    uint32_t pulsos = 0;
+    while (odometria_get_angulo_mgrados() < 90000 && pulsos < 10000)
+    {
+        mover(-1, 1);
+        pulsos++;
+    }
+    VERIFICAR(pulsos == (uint32_t)ceil(M_PI * ODOMETRIA_TROCHA_UM / 4.0 / UM_POR_PULSO));
+    VERIFICAR(odometria_get_distancia_um() == 0);
+    VERIFICAR(igual_a_referencia());
+
+    // Pasos al azar de hasta medio contador: el de 16 bits da vueltas en los dos sentidos
+    reiniciar();
+    uint32_t errores = 0;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        int16_t izq = (int16_t)((int32_t)azar(65535) - 32767);
+        int16_t der = (int16_t)(azar(4) ? izq + (int32_t)azar(201) - 100 : (int32_t)azar(65535) - 32767);
+        mover(izq, der);
+        if (total_izq > INT32_MAX / 2000 || total_izq < -INT32_MAX / 2000 || total_der > INT32_MAX / 2000 ||
+            total_der < -INT32_MAX / 2000)
+            reiniciar(); // Que la distancia siga entrando en 32 bits
+        if (!igual_a_referencia())
+            errores++;
+    }
+    VERIFICAR(errores == 0);
+
+    // De a un pulso por vez, como a baja velocidad: el redondeo no se acumula
+    reiniciar();
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        mover(1, (i % 3) ? 1 : 0);
+    }
+    VERIFICAR(igual_a_referencia());
+
+#if ODOMETRIA_ENCODERS
+    // El giro termina al medir angulo_giro_90, mucho antes del plazo
+    control_motor_init();
+    reiniciar();
+    gira90der(norte);
+    uint32_t ms = correr_movimiento(4, -4);
+    int32_t girado = -odometria_get_angulo_mgrados();
+    VERIFICAR(girado >= angulo_giro_90 * 100 && girado < angulo_giro_90 * 100 + 500);
+    VERIFICAR(ms < tiempo_giro_90_der);
+
+    gira180(este);
+    correr_movimiento(-4, 4);
+    girado = odometria_get_angulo_mgrados() + girado; // Desde el final del giro anterior
+    VERIFICAR(girado >= angulo_giro_180 * 100 && girado < angulo_giro_180 * 100 + 500);
+
+    // El avance termina a los distancia_avance_linea mm
+    int32_t antes = odometria_get_distancia_um();
+    movimiento_iniciar_avance(10000);
+    correr_movimiento(3, 3);
+    int32_t avanzado = odometria_get_distancia_um() - antes;
+    VERIFICAR(avanzado >= distancia_avance_linea * 1000 && avanzado < distancia_avance_linea * 1000 + 300);
+
+    // Si los encoders no cuentan termina igual, por el plazo ampliado
+    gira90izq(norte);
+    VERIFICAR(correr_movimiento(0, 0) == tiempo_giro_90_izq * ODOMETRIA_FACTOR_PLAZO);
+#endif
+
+    return prueba_resultado();
+}
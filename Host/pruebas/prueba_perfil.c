@@ -0,0 +1,205 @@
+/**
+ * @file prueba_perfil.c
+ * @brief Rampas de velocidad de avance sobre el reloj virtual
+ * @author demianmozo
+ *
+ * Se corre control_lazo_paso() una vez por ms, como la interrupción de TIM6, y
+ * se lee el PWM que TIM3 tiene aplicado en cada rueda, con perfil_velocidad
+ * en 1. Desde PERFIL_VELOCIDAD_INICIAL hasta PERFIL_VELOCIDAD_MAXIMA (300 a
+ * 1000 con los valores por defecto) la velocidad tiene que subir sin bajar
+ * nunca, sin cambiar más de PERFIL_ACELERACION_MAXIMA por ms, en alrededor de
+ * medio segundo, y quedar justo en el objetivo. En un tramo planificado con
+ * perfil_planificar_recta(), recorriendo la distancia a la velocidad que
+ * supone el perfil (PERFIL_VELOCIDAD_1000_MM_S), tiene que subir hasta el pico
+ * que da su largo y estar en la base al llegar a la última línea. Al
+ * terminarse la recta baja igual hasta la base, después de un giro vuelve a
+ * arrancar de la inicial y con perfil_velocidad en 0 va directo a la base.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "control_motor.h"
+#include "control_linearecta.h"
+
+#define BASE 700u ///< Velocidad de avance del modo (velocidad_actual_*)
+#define TOLERANCIA_LINEA 10 ///< PWM sobre la base al llegar a la última línea
+
+/** @brief Cómo llegó una rampa */
+typedef struct
+{
+    uint32_t ms;          ///< Hasta quedar en el objetivo (0 si no llegó)
+    bool monotona;        ///< Nunca fue para el otro lado
+    bool sin_pasarse;     ///< Nunca pasó el objetivo
+    bool acelera_poco;    ///< Ningún paso mayor que PERFIL_ACELERACION_MAXIMA
+    bool ruedas_iguales;  ///< Las dos ruedas con el mismo PWM
+} rampa_medida_t;
+
+/** @brief PWM aplicado en cada rueda */
+static uint16_t pwm_izq(void)
+{
+    return (uint16_t)hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3);
+}
+
+static uint16_t pwm_der(void)
+{
+    return (uint16_t)hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4);
+}
+
+/**
+ * @brief Corre el lazo de a 1 ms hasta que el PWM aplicado llega al objetivo
+ */
+static rampa_medida_t medir_rampa(uint16_t objetivo, uint32_t maximo_ms)
+{
+    rampa_medida_t medida = {0, true, true, true, true};
+    uint16_t anterior = pwm_izq();
+    bool sube = objetivo > anterior;
+
+    for (uint32_t ms = 1; ms <= maximo_ms; ms++)
+    {
+        control_lazo_paso(HAL_GetTick());
+        hal_falso_avanzar(1); // El compare nuevo vale desde el período siguiente
+
+        uint16_t actual = pwm_izq();
+        if (actual != pwm_der())
+            medida.ruedas_iguales = false;
+        if (sube ? actual < anterior : actual > anterior)
+            medida.monotona = false;
+        if (sube ? actual > objetivo : actual < objetivo)
+            medida.sin_pasarse = false;
+        if ((actual > anterior ? actual - anterior : anterior - actual) > PERFIL_ACELERACION_MAXIMA)
+            medida.acelera_poco = false;
+        anterior = actual;
+
+        if (actual == objetivo && medida.ms == 0)
+            medida.ms = ms;
+    }
+    return medida;
+}
+
+/** @brief Revisa una rampa completa y devuelve cuánto tardó */
+static uint32_t verificar_rampa(uint16_t objetivo)
+{
+    rampa_medida_t medida = medir_rampa(objetivo, 2000);
+
+    VERIFICAR(medida.ms > 0);
+    VERIFICAR(medida.monotona);
+    VERIFICAR(medida.sin_pasarse);
+    VERIFICAR(medida.acelera_poco);
+    VERIFICAR(medida.ruedas_iguales);
+    VERIFICAR(pwm_izq() == objetivo && pwm_der() == objetivo); // Y se queda ahí
+    return medida.ms;
+}
+
+/** @brief Gira 90 grados y deja el compare del primer avance aplicado */
+static void girar(void)
+{
+    gira90der(norte);
+    while (movimiento_actualizar(HAL_GetTick()) == MOVIMIENTO_LIBRE)
+    {
+        control_lazo_paso(HAL_GetTick());
+        hal_falso_avanzar(1);
+    }
+    hal_falso_avanzar(1);
+}
+
+/** @brief Cómo se recorrió un tramo planificado */
+typedef struct
+{
+    uint16_t pico;       ///< Mayor PWM aplicado
+    uint16_t en_linea;   ///< PWM al llegar a la última línea
+    bool sube_y_baja;    ///< Nunca bajó antes del pico ni subió después
+    bool acelera_poco;   ///< Ningún paso mayor que PERFIL_ACELERACION_MAXIMA
+} tramo_medido_t;
+
+/**
+ * @brief Recorre un tramo desde el centro de una casilla hasta su última línea
+ * @details La distancia se integra con el PWM aplicado y en cada línea
+ *          intermedia se corrige lo que falta, como hace chequeolinea()
+ */
+static tramo_medido_t recorrer_tramo(uint8_t casillas)
+{
+    tramo_medido_t medida = {0, 0, true, true};
+    double hasta_linea = PERFIL_LARGO_CASILLA_MM / 2.0; // Primera línea: media casilla
+    double recorrido = 0.0;
+    uint16_t anterior = pwm_izq();
+    bool bajando = false;
+
+    perfil_planificar_recta(casillas);
+    for (uint8_t restantes = casillas; restantes > 0;)
+    {
+        control_lazo_paso(HAL_GetTick());
+        hal_falso_avanzar(1);
+
+        uint16_t actual = pwm_izq();
+        recorrido += actual * (double)PERFIL_VELOCIDAD_1000_MM_S / 1000000.0;
+        if (actual > medida.pico)
+            medida.pico = actual;
+        if (actual < anterior)
+            bajando = true;
+        else if (actual > anterior && bajando)
+            medida.sube_y_baja = false;
+        if ((actual > anterior ? actual - anterior : anterior - actual) > PERFIL_ACELERACION_MAXIMA)
+            medida.acelera_poco = false;
+        anterior = actual;
+
+        if (recorrido >= hasta_linea)
+        {
+            restantes--;
+            hasta_linea += PERFIL_LARGO_CASILLA_MM;
+            perfil_set_casillas_restantes(restantes);
+        }
+    }
+    medida.en_linea = anterior;
+    return medida;
+}
+
+int main(void)
+{
+    hal_falso_reiniciar();
+    perfil_velocidad = 1;
+    velocidad_actual_izq = velocidad_actual_der = BASE;
+    control_motor_init();
+    hal_falso_avanzar(1);
+    VERIFICAR(pwm_izq() == PERFIL_VELOCIDAD_INICIAL && pwm_der() == PERFIL_VELOCIDAD_INICIAL);
+
+    // Recta larga: de la inicial al tope en cerca de medio segundo
+    perfil_planificar_recta(30);
+    uint32_t subida = verificar_rampa(PERFIL_VELOCIDAD_MAXIMA);
+    uint32_t minimo = (PERFIL_VELOCIDAD_MAXIMA - PERFIL_VELOCIDAD_INICIAL) / PERFIL_ACELERACION_MAXIMA;
+    VERIFICAR(subida >= minimo && subida <= minimo + 200);
+
+    // Se termina la recta: baja hasta la base
+    perfil_set_casillas_restantes(0);
+    verificar_rampa(BASE);
+
+    // Desde la inicial, con el largo del tramo: una casilla apenas pasa la
+    // base, seis llegan al tope, y las dos frenan a tiempo para la última línea
+    for (uint8_t casillas = 1; casillas <= 6; casillas += 5)
+    {
+        girar();
+        VERIFICAR(pwm_izq() == PERFIL_VELOCIDAD_INICIAL && pwm_der() == PERFIL_VELOCIDAD_INICIAL);
+
+        tramo_medido_t tramo = recorrer_tramo(casillas);
+        VERIFICAR(tramo.sube_y_baja);
+        VERIFICAR(tramo.acelera_poco);
+        VERIFICAR(tramo.en_linea >= BASE && tramo.en_linea <= BASE + TOLERANCIA_LINEA);
+        if (casillas == 1)
+            VERIFICAR(tramo.pico > BASE && tramo.pico < PERFIL_VELOCIDAD_MAXIMA);
+        else
+            VERIFICAR(tramo.pico == PERFIL_VELOCIDAD_MAXIMA);
+        VERIFICAR(pwm_izq() == pwm_der());
+    }
+
+    // Después del giro vuelve a arrancar desde la inicial, sin tramo hasta la base
+    girar();
+    VERIFICAR(pwm_izq() == PERFIL_VELOCIDAD_INICIAL && pwm_der() == PERFIL_VELOCIDAD_INICIAL);
+    perfil_set_casillas_restantes(0);
+    verificar_rampa(BASE);
+
+    // Sin perfil, directo a la base
+    perfil_velocidad = 0;
+    girar();
+    VERIFICAR(pwm_izq() == BASE && pwm_der() == BASE);
+
+    return prueba_resultado();
+}
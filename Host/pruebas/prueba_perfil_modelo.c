@@ -0,0 +1,147 @@
+/**
+ * @file prueba_perfil_modelo.c
+ * @brief Tiempo de un tramo recto sobre el modelo del robot, con y sin perfil
+ * @author demianmozo
+ *
+ * El robot del modelo parte quieto del centro de la primera casilla de un
+ * pasillo (como después de un giro) y recorre un tramo de 1 a TRAMO_MAXIMO
+ * casillas como lo hace el sprint: en cada línea intermedia corrige el perfil
+ * con las casillas que faltan y en la última arranca el avance por tiempo
+ * hasta el centro. Sin control lateral (no hay calibración), así lo único que
+ * cambia entre las dos corridas es la velocidad de avance. Con la base y el
+ * avance de exploración, que son los calibrados para el modelo:
+ * - Con o sin perfil el robot termina a menos de ERROR_MAXIMO_MM del centro
+ *   de la última casilla (sin perfil queda unos 9 mm antes), y con perfil a
+ *   menos de DIFERENCIA_MAXIMA_MM de donde queda sin él: llega a la última
+ *   línea a la base, que es con la que se calibró el avance
+ * - Desde TRAMO_MINIMO_MAS_RAPIDO casillas el perfil tarda menos. Con los
+ *   valores por defecto: 1 casilla 568 ms contra 510 (arranca de
+ *   PERFIL_VELOCIDAD_INICIAL en vez de ir directo a la base), 2 casillas 933
+ *   contra 1004, 4 casillas 1624 contra 1993 y 12 casillas 4393 contra 5949
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "modelo_robot.h"
+#include "control_motor.h"
+#include "control_linearecta.h"
+#include "recorrido.h"
+#include <math.h>
+#include <string.h>
+
+extern bool calibrado;
+
+#define TRAMO_MAXIMO 12             ///< Casillas del tramo más largo
+#define TRAMO_MINIMO_MAS_RAPIDO 2   ///< Desde acá el perfil tiene que ganar
+#define ERROR_MAXIMO_MM 15.0        ///< Distancia al centro de la última casilla
+#define DIFERENCIA_MAXIMA_MM 4.0    ///< Entre el final con perfil y sin perfil
+#define PLAZO_MS 20000u             ///< Tope de cada corrida
+
+/** @brief Robot simulado; modelo_paso() lo avanza desde el HAL simulado */
+static modelo_t modelo;
+
+/** @brief Resultado de un tramo */
+typedef struct
+{
+    uint32_t ms;     ///< Desde la largada hasta que terminó el avance al centro
+    double error_mm; ///< Adelante (+) o atrás (-) del centro de la última casilla
+} tramo_t;
+
+static void paso_modelo(uint32_t ahora_ms)
+{
+    (void)ahora_ms;
+    modelo_paso(&modelo);
+}
+
+/** @brief Pasillo de una columna y casillas + 1 filas, inicio abajo */
+static void armar_pasillo(laberinto_modelo_t *laberinto, uint8_t filas)
+{
+    memset(laberinto, 0, sizeof(*laberinto));
+    laberinto->filas = filas;
+    laberinto->columnas = 1;
+    laberinto->horizontal[0][0] = laberinto->horizontal[filas][0] = true;
+    for (uint8_t fila = 0; fila < filas; fila++)
+    {
+        laberinto->vertical[fila][0] = laberinto->vertical[fila][1] = true;
+    }
+}
+
+/**
+ * @brief Corre un tramo recto de casillas casillas
+ * @param perfil Valor de perfil_velocidad
+ */
+static tramo_t correr_tramo(uint8_t casillas, uint16_t perfil)
+{
+    laberinto_modelo_t laberinto;
+    modelo_parametros_t parametros;
+    tramo_t tramo = {0, 0.0};
+
+    armar_pasillo(&laberinto, casillas + 1);
+    modelo_parametros_defecto(&parametros);
+    hal_falso_reiniciar();
+    modelo_iniciar(&modelo, &laberinto, &parametros, casillas + 1, 1, norte);
+    hal_falso_set_paso(paso_modelo);
+    hal_falso_avanzar(1); // Sensores en la pose inicial
+    double x0 = modelo.x, y0 = modelo.y, rumbo0 = modelo.rumbo;
+
+    calibrado = false;
+    terminado = false;
+    perfil_velocidad = perfil;
+    velocidad_actual_izq = VELOCIDAD_AVANCE_IZQ;
+    velocidad_actual_der = VELOCIDAD_AVANCE_DER;
+    control_motor_init();
+    perfil_planificar_recta(casillas);
+
+    uint8_t restantes = casillas;
+    GPIO_PinState anterior = HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin);
+    uint32_t inicio = HAL_GetTick();
+    while (HAL_GetTick() - inicio < PLAZO_MS)
+    {
+        control_lazo_paso(HAL_GetTick());
+        if (movimiento_actualizar(HAL_GetTick()) == MOVIMIENTO_AVANCE)
+        {
+            tramo.ms = HAL_GetTick() - inicio;
+            break;
+        }
+
+        // Flanco de bajada del sensor de línea, como el EXTI de chequeolinea()
+        GPIO_PinState linea = HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin);
+        if (linea == GPIO_PIN_RESET && anterior == GPIO_PIN_SET && !movimiento_en_curso())
+        {
+            if (restantes > 1)
+            {
+                perfil_set_casillas_restantes(--restantes);
+            }
+            else
+            {
+                perfil_set_casillas_restantes(0);
+                movimiento_iniciar_avance(TIEMPO_AVANCE_LINEA_EXPLORACION);
+            }
+        }
+        anterior = linea;
+        hal_falso_avanzar(1);
+    }
+    hal_falso_set_paso(NULL);
+
+    double avanzado = (modelo.x - x0) * cos(rumbo0) + (modelo.y - y0) * sin(rumbo0);
+    tramo.error_mm = avanzado - casillas * parametros.celda_mm;
+    return tramo;
+}
+
+int main(void)
+{
+    for (uint8_t casillas = 1; casillas <= TRAMO_MAXIMO; casillas++)
+    {
+        tramo_t sin_perfil = correr_tramo(casillas, 0);
+        tramo_t con_perfil = correr_tramo(casillas, 1);
+
+        VERIFICAR(sin_perfil.ms > 0 && con_perfil.ms > 0);
+        VERIFICAR(fabs(sin_perfil.error_mm) < ERROR_MAXIMO_MM);
+        VERIFICAR(fabs(con_perfil.error_mm) < ERROR_MAXIMO_MM);
+        VERIFICAR(fabs(con_perfil.error_mm - sin_perfil.error_mm) < DIFERENCIA_MAXIMA_MM);
+        if (casillas >= TRAMO_MINIMO_MAS_RAPIDO)
+            VERIFICAR(con_perfil.ms < sin_perfil.ms);
+    }
+
+    return prueba_resultado();
+}
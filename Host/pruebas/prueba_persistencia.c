@@ -0,0 +1,199 @@
+/**
+ * @file prueba_persistencia.c
+ * @brief Guardado en la flash simulada: ida y vuelta, vuelta del sector y registros rotos
+ * @author demianmozo
+ *
+ * Lo guardado tiene que volver igual después de borrar las variables y el
+ * mapa. Guardando muchas más veces que las ranuras del sector, cada carga
+ * tiene que traer el último guardado aunque el sector se haya borrado y
+ * vuelto a llenar. Un registro cortado a mitad de escritura, o con un bit
+ * cambiado, no pasa el CRC: vale el anterior, y el guardado siguiente no
+ * pisa la ranura rota.
+ */
+
+#include "prueba.h"
+#include "persistencia.h"
+#include "laberinto.h"
+#include "control_motor.h"
+#include "control_linearecta.h"
+#include "recorrido.h"
+#include <string.h>
+
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+extern bool calibrado;
+
+#define MAGIA_REGISTRO 0x3142414Cu ///< "LAB1": comienzo de cada registro escrito
+
+/** @brief Variables que se guardan: calibración y parámetros */
+static uint16_t *const variables[] = {
+    &izq_cerca, &izq_lejos, &izq_centrado, &der_cerca, &der_lejos, &der_centrado,
+    &velocidad_sprint_izq, &velocidad_sprint_der, &velocidad_giro_actual_izq, &velocidad_giro_actual_der,
+    &tiempo_giro_90_izq, &tiempo_giro_90_der, &tiempo_giro_180, &tiempo_correccion, &tiempo_avance_sprint,
+    &pid_kp, &pid_ki, &pid_kd, &pid_salida_maxima, &angulo_giro_90, &angulo_giro_180, &distancia_avance_linea,
+};
+
+#define CANTIDAD_VARIABLES (sizeof(variables) / sizeof(variables[0]))
+
+/** @brief Lo que se guardó por última vez */
+typedef struct
+{
+    uint16_t valores[CANTIDAD_VARIABLES];
+    uint8_t libres[FILAS_LABERINTO + 1][COLUMNAS_LABERINTO + 1];
+    bool explorado;
+} estado_t;
+
+/** @brief Lee las variables y el mapa actuales */
+static void tomar_estado(estado_t *estado, bool explorado)
+{
+    memset(estado, 0, sizeof(*estado));
+    for (uint32_t i = 0; i < CANTIDAD_VARIABLES; i++)
+    {
+        estado->valores[i] = *variables[i];
+    }
+    for (uint8_t fila = 1; fila <= FILAS_LABERINTO; fila++)
+    {
+        for (uint8_t columna = 1; columna <= COLUMNAS_LABERINTO; columna++)
+        {
+            estado->libres[fila][columna] = laberinto_get_direcciones_libres(fila, columna);
+        }
+    }
+    estado->explorado = explorado;
+}
+
+/**
+ * @brief Variables y mapa al azar, y los guarda
+ * @param guardado Lo que quedó guardado
+ */
+static bool guardar_al_azar(estado_t *guardado)
+{
+    for (uint32_t i = 0; i < CANTIDAD_VARIABLES; i++)
+    {
+        *variables[i] = (uint16_t)azar(65536);
+    }
+    laberinto_init();
+    uint32_t muros = azar(CANTIDAD_CASILLAS + 1);
+    for (uint32_t i = 0; i < muros; i++)
+    {
+        laberinto_set_muro(1 + azar(FILAS_LABERINTO), 1 + azar(COLUMNAS_LABERINTO), (brujula)azar(4));
+    }
+
+    bool explorado = azar(2);
+    tomar_estado(guardado, explorado);
+    return persistencia_guardar(explorado);
+}
+
+/**
+ * @brief Borra variables y mapa, como un arranque nuevo, y carga lo guardado
+ * @return true si volvió exactamente lo esperado
+ */
+static bool carga_igual(const estado_t *esperado)
+{
+    estado_t cargado;
+
+    for (uint32_t i = 0; i < CANTIDAD_VARIABLES; i++)
+    {
+        *variables[i] = 0;
+    }
+    calibrado = false;
+    laberinto_init();
+
+    datos_guardados_t datos = persistencia_cargar();
+    tomar_estado(&cargado, datos == DATOS_MAPA);
+    return datos != DATOS_NINGUNO && calibrado && memcmp(&cargado, esperado, sizeof(cargado)) == 0;
+}
+
+/**
+ * @brief Desplazamiento del registro número n del sector (0 es el primero)
+ * @return TAMAÑO_SECTOR_PERSISTENCIA si no hay tantos registros
+ */
+static uint32_t buscar_registro(uint32_t n)
+{
+    const uint8_t *imagen = persistencia_get_imagen();
+
+    for (uint32_t desplazamiento = 0; desplazamiento + 4 <= TAMAÑO_SECTOR_PERSISTENCIA; desplazamiento += 4)
+    {
+        uint32_t palabra;
+        memcpy(&palabra, &imagen[desplazamiento], 4);
+        if (palabra == MAGIA_REGISTRO && n-- == 0)
+        {
+            return desplazamiento;
+        }
+    }
+    return TAMAÑO_SECTOR_PERSISTENCIA;
+}
+
+int main(void)
+{
+    prueba_semilla(31337);
+    estado_t anterior, guardado;
+
+    // Sector vacío: hay que calibrar
+    VERIFICAR(persistencia_borrar());
+    laberinto_init();
+    VERIFICAR(persistencia_cargar() == DATOS_NINGUNO);
+
+    // Ida y vuelta; el tamaño de registro sale de dónde empieza el segundo
+    VERIFICAR(guardar_al_azar(&guardado));
+    VERIFICAR(carga_igual(&guardado));
+    VERIFICAR(guardar_al_azar(&guardado));
+    VERIFICAR(carga_igual(&guardado));
+    uint32_t tamaño_registro = buscar_registro(1);
+    VERIFICAR(buscar_registro(0) == 0 && tamaño_registro < TAMAÑO_SECTOR_PERSISTENCIA);
+    uint32_t ranuras = TAMAÑO_SECTOR_PERSISTENCIA / tamaño_registro;
+    VERIFICAR(ranuras >= 2);
+
+    // Dos vueltas y media al sector; cargar cuesta leer todo el sector, así que
+    // con muchas ranuras se revisa alrededor de cada borrado y algunas al azar
+    uint32_t fallas = 0;
+    uint32_t guardados = 2;
+    for (; guardados < 5 * ranuras / 2; guardados++)
+    {
+        uint32_t ranura = guardados % ranuras;
+        if (!guardar_al_azar(&guardado))
+            fallas++;
+        if (ranuras <= 64 || ranura <= 1 || ranura == ranuras - 1 || azar(64) == 0)
+        {
+            if (!carga_igual(&guardado))
+                fallas++;
+        }
+        // Recién borrado: solo la primera ranura escrita
+        if (ranura == 0 && buscar_registro(1) != TAMAÑO_SECTOR_PERSISTENCIA)
+            fallas++;
+    }
+    VERIFICAR(fallas == 0);
+
+    // Reset a mitad de escritura: las palabras que faltaban quedan borradas
+    anterior = guardado;
+    VERIFICAR(guardar_al_azar(&guardado));
+    uint32_t roto = buscar_registro(guardados % ranuras);
+    VERIFICAR(roto < TAMAÑO_SECTOR_PERSISTENCIA);
+    memset(persistencia_get_imagen() + roto + tamaño_registro / 2, 0xFF, tamaño_registro - tamaño_registro / 2);
+    VERIFICAR(carga_igual(&anterior));
+
+    // El siguiente guardado va a la ranura de después, no a la rota
+    VERIFICAR(guardar_al_azar(&guardado));
+    VERIFICAR(carga_igual(&guardado));
+    VERIFICAR(buscar_registro(guardados % ranuras + 1) == roto + tamaño_registro);
+
+    // Un bit bajado en el medio (la flash solo baja bits) tampoco pasa
+    anterior = guardado;
+    VERIFICAR(guardar_al_azar(&guardado));
+    uint8_t *imagen = persistencia_get_imagen();
+    uint32_t danado = buscar_registro(guardados % ranuras + 2);
+    VERIFICAR(danado < TAMAÑO_SECTOR_PERSISTENCIA);
+    uint32_t byte = danado + 8 + azar(tamaño_registro - 12);
+    while (imagen[byte] == 0)
+    {
+        byte++;
+    }
+    imagen[byte] &= (uint8_t)(imagen[byte] - 1); // Baja el bit en 1 más bajo
+    VERIFICAR(carga_igual(&anterior));
+
+    // Borrado: el próximo arranque calibra
+    VERIFICAR(persistencia_borrar());
+    laberinto_init();
+    VERIFICAR(persistencia_cargar() == DATOS_NINGUNO);
+
+    return prueba_resultado();
+}
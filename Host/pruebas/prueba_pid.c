@@ -0,0 +1,245 @@
+/**
+ * @file prueba_pid.c
+ * @brief PID lateral en lazo cerrado con un modelo de robot en el pasillo
+ * @author demianmozo
+ *
+ * Cada ms el modelo de uniciclo mueve el robot con el PWM que TIM3 tiene
+ * aplicado y deja en el ADC simulado las lecturas de los sensores IR para la
+ * distancia a cada pared (lineales entre la lectura pegado y la de centrado,
+ * como supone la calibración); el PID las toma de los promedios de los
+ * callbacks del ADC, como en el robot. Cada motor llega a su velocidad con
+ * una constante de tiempo de MOTOR_TAU_MS. Desde 20 mm de un lado, a 700 y a
+ * 900 de base, con una o dos paredes y con el ADC a 0.5 y a 1.2 ms por
+ * promedio (el del robot no coincide con el lazo de 1 ms), el robot tiene que
+ * centrarse: a lo sumo un sobrepaso de menos de SOBREPASO_MAXIMO_MM y después
+ * nada de ir y venir. Las ruedas tienen que quedar dentro de base ± pid_max.
+ * Con las ganancias por defecto y el ADC a 0.5 ms el modelo se pasa 1.5 mm a
+ * 700 y 0.7 mm a 900; a los 2 s está a menos de 0.9 mm del centro y se queda
+ * a medio mm o menos (más cerca la salida redondea a 0 PWM). Con el ADC a
+ * 1.2 ms se pasa menos de 0.8 mm.
+ *
+ * Aparte, solo con la derivada y una pared que se acerca a velocidad fija con
+ * un promedio cada 2 ms, la salida tiene que ser la misma en cada ejecución:
+ * la derivada se calcula con cada promedio nuevo, llevada a 1 ms, y se
+ * mantiene en el medio (no vale el doble con el promedio y cero sin él).
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "control_motor.h"
+#include "control_linearecta.h"
+#include <math.h>
+#include <stdlib.h>
+
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+extern bool calibrado;
+
+#define LECTURA_CERCA 400          ///< Lectura pegado a la pared
+#define LECTURA_CENTRADO 2200      ///< Lectura centrado en el pasillo
+#define LECTURA_SIN_PARED 4000     ///< Lectura sin pared de ese lado
+#define HUECO_MM 50.0              ///< Distancia a cada pared centrado
+#define TROCHA_MM 80.0             ///< Distancia entre ruedas
+#define MM_POR_S_POR_PWM 0.5       ///< Velocidad de régimen por unidad de PWM
+#define MOTOR_TAU_MS 30.0          ///< Constante de tiempo de cada motor
+#define DURACION_MS 3000u          ///< Tiempo simulado por caso
+#define ASENTAMIENTO_MS 2000u      ///< Plazo para quedar centrado
+#define TOLERANCIA_MM 1.0          ///< Centrado: a menos de esto del medio
+#define SOBREPASO_MAXIMO_MM 2.0    ///< Lo más que puede cruzarse al otro lado (10 % del desvío)
+
+/** @brief Resultado de una simulación */
+typedef struct
+{
+    double sobrepaso_mm;   ///< Lo más lejos que quedó del lado contrario al de partida
+    double desvio_final_mm; ///< Mayor |y| después de ASENTAMIENTO_MS
+    uint32_t cruces;        ///< Veces que cruzó el centro a más de TOLERANCIA_MM
+    bool ruedas_en_rango;   ///< Cada rueda siempre en base ± pid_salida_maxima
+} resultado_t;
+
+/** @brief Estado del robot simulado y del caso en curso */
+static struct
+{
+    uint16_t base;
+    double y0_mm;
+    bool pared_izq, pared_der;
+    double y, rumbo, v_izq, v_der;
+    int lado; ///< Último lado fuera de la tolerancia: +1 izquierda, -1 derecha
+    uint32_t ms;
+    resultado_t resultado;
+} robot;
+
+/** @brief Lectura de un sensor a una distancia de su pared */
+static uint16_t lectura(double distancia_mm, bool hay_pared)
+{
+    if (!hay_pared)
+        return LECTURA_SIN_PARED;
+    double valor = LECTURA_CERCA + (LECTURA_CENTRADO - LECTURA_CERCA) * distancia_mm / HUECO_MM;
+    return (uint16_t)(valor < 0 ? 0 : valor);
+}
+
+/** @brief Lo que ve el ADC desde la posición actual */
+static void poner_lecturas(void)
+{
+    hal_falso_adc_set_lecturas(lectura(HUECO_MM + robot.y, robot.pared_der), lectura(HUECO_MM - robot.y, robot.pared_izq));
+}
+
+/**
+ * @brief Paso de 1 ms del modelo (hal_falso_set_paso()), antes del ADC
+ */
+static void paso_robot(uint32_t ahora_ms)
+{
+    resultado_t *resultado = &robot.resultado;
+    int32_t pwm_izq = hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3);
+    int32_t pwm_der = hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4);
+
+    if (abs(pwm_izq - robot.base) > pid_salida_maxima || abs(pwm_der - robot.base) > pid_salida_maxima)
+        resultado->ruedas_en_rango = false;
+
+    // Uniciclo con motores de primer orden, paso de 1 ms
+    robot.v_izq += (pwm_izq * MM_POR_S_POR_PWM - robot.v_izq) / MOTOR_TAU_MS;
+    robot.v_der += (pwm_der * MM_POR_S_POR_PWM - robot.v_der) / MOTOR_TAU_MS;
+    robot.rumbo += (robot.v_der - robot.v_izq) / TROCHA_MM * 0.001;
+    robot.y += (robot.v_izq + robot.v_der) / 2 * sin(robot.rumbo) * 0.001;
+    poner_lecturas();
+
+    double contrario = (robot.y0_mm > 0) ? -robot.y : robot.y;
+    if (contrario > resultado->sobrepaso_mm)
+        resultado->sobrepaso_mm = contrario;
+    if (robot.ms >= ASENTAMIENTO_MS && fabs(robot.y) > resultado->desvio_final_mm)
+        resultado->desvio_final_mm = fabs(robot.y);
+    if (fabs(robot.y) > TOLERANCIA_MM)
+    {
+        int nuevo_lado = (robot.y > 0) ? 1 : -1;
+        if (robot.lado != 0 && nuevo_lado != robot.lado)
+            resultado->cruces++;
+        robot.lado = nuevo_lado;
+    }
+}
+
+/**
+ * @brief HAL simulado con el ADC andando, calibrado y con el PID recién
+ *        arrancado (como al salir de un avance, sin derivada vieja)
+ */
+static void preparar(uint32_t periodo_adc_us)
+{
+    hal_falso_reiniciar();
+    control_motor_init();
+    calibrado = true;
+    izq_cerca = der_cerca = LECTURA_CERCA;
+    izq_lejos = der_lejos = LECTURA_CENTRADO;
+    izq_centrado = der_centrado = (LECTURA_CERCA + LECTURA_CENTRADO) / 2;
+    hal_falso_adc_set_periodo_us(periodo_adc_us);
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
+
+    movimiento_iniciar_avance(1);
+    VERIFICAR(!controlar_linea_recta(0, 0));
+    while (movimiento_get_estado() != MOVIMIENTO_LIBRE)
+    {
+        hal_falso_avanzar(1);
+        movimiento_actualizar(HAL_GetTick());
+    }
+}
+
+/**
+ * @brief Corre el lazo cerrado desde un desvío inicial
+ * @param base PWM de avance de las dos ruedas
+ * @param y0_mm Desvío inicial hacia la izquierda (+) o la derecha (-)
+ * @param pared_izq, pared_der Qué paredes hay
+ * @param periodo_adc_us Microsegundos entre promedios del ADC
+ */
+static resultado_t simular(uint16_t base, double y0_mm, bool pared_izq, bool pared_der, uint32_t periodo_adc_us)
+{
+    preparar(periodo_adc_us);
+    robot.base = base;
+    robot.y0_mm = robot.y = y0_mm;
+    robot.pared_izq = pared_izq;
+    robot.pared_der = pared_der;
+    robot.rumbo = 0.0;
+    robot.v_izq = robot.v_der = base * MM_POR_S_POR_PWM;
+    robot.lado = 0;
+    robot.resultado = (resultado_t){0.0, 0.0, 0, true};
+    poner_lecturas();
+    hal_falso_avanzar(2); // Promedios de esta posición antes de la primera ejecución
+    hal_falso_set_paso(paso_robot);
+
+    for (robot.ms = 0; robot.ms < DURACION_MS; robot.ms++)
+    {
+        VERIFICAR(controlar_linea_recta(base, base));
+        hal_falso_avanzar(1); // El compare nuevo vale desde el período siguiente
+    }
+    hal_falso_set_paso(NULL);
+    return robot.resultado;
+}
+
+/** @brief Revisa un caso: centrado a tiempo, sin pasarse y sin oscilar */
+static void probar(uint16_t base, double y0_mm, bool pared_izq, bool pared_der, uint32_t periodo_adc_us)
+{
+    resultado_t resultado = simular(base, y0_mm, pared_izq, pared_der, periodo_adc_us);
+
+    VERIFICAR(resultado.ruedas_en_rango);
+    VERIFICAR(resultado.desvio_final_mm < TOLERANCIA_MM);
+    VERIFICAR(resultado.sobrepaso_mm < SOBREPASO_MAXIMO_MM);
+    VERIFICAR(resultado.cruces <= 1); // Un sobrepaso y de vuelta, sin oscilar
+}
+
+/**
+ * @brief Solo derivada, con la pared izquierda alejándose 4 cuentas por ms y
+ *        un promedio cada 2 ms: la misma salida en todas las ejecuciones
+ */
+static void probar_derivada(void)
+{
+    uint16_t kp = pid_kp, ki = pid_ki;
+    int32_t minima = INT32_MAX, maxima = INT32_MIN;
+    uint16_t izq = 1300;
+
+    pid_kp = pid_ki = 0;
+    preparar(2000);
+    hal_falso_adc_set_lecturas(1300, izq);
+    hal_falso_avanzar(2);
+    for (uint32_t ms = 0; ms < 300; ms++)
+    {
+        VERIFICAR(controlar_linea_recta(500, 500));
+        izq += 4;
+        hal_falso_adc_set_lecturas(1300, izq);
+        hal_falso_avanzar(1);
+
+        int32_t salida = ((int32_t)hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4) -
+                          (int32_t)hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3)) / 2;
+        if (ms >= 4)
+        {
+            minima = salida < minima ? salida : minima;
+            maxima = salida > maxima ? salida : maxima;
+        }
+    }
+
+    // 4 cuentas por ms son 9.1 de distancia normalizada: 44 PWM con kd = 20000
+    int32_t esperada = (int32_t)((double)pid_kd * 4 * PID_ESCALA / (LECTURA_CENTRADO - LECTURA_CERCA) / PID_ESCALA);
+    VERIFICAR(minima >= esperada - 2 && maxima <= esperada + 2);
+    pid_kp = kp;
+    pid_ki = ki;
+}
+
+int main(void)
+{
+    for (uint32_t periodo_adc_us = 500; periodo_adc_us <= 1200; periodo_adc_us += 700)
+    {
+        for (uint16_t base = 700; base <= 900; base += 200)
+        {
+            probar(base, 20.0, true, true, periodo_adc_us);
+            probar(base, -20.0, true, true, periodo_adc_us);
+            probar(base, 20.0, true, false, periodo_adc_us);
+            probar(base, -20.0, false, true, periodo_adc_us);
+        }
+    }
+
+    // Sin paredes va derecho: las dos ruedas a la base
+    resultado_t recto = simular(900, 5.0, false, false, 1200);
+    VERIFICAR(recto.ruedas_en_rango);
+    VERIFICAR(recto.desvio_final_mm == 5.0);
+    VERIFICAR(hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3) == 900);
+    VERIFICAR(hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4) == 900);
+
+    probar_derivada();
+
+    return prueba_resultado();
+}
@@ -0,0 +1,72 @@
+/**
+ * @file prueba_simulador.c
+ * @brief El firmware completo explora la cancha sobre el modelo físico del robot
+ * @author demianmozo
+ *
+ * Con el robot nominal de modelo_parametros_defecto() la exploración tiene
+ * que llegar a la meta sin tocar muros y con la casilla del firmware siempre
+ * igual a la del robot. Con ODOMETRIA_ENCODERS también el sprint: con giros
+ * por tiempo el avance llega al centro de la casilla, pero los tiempos de giro
+ * se calibraron entrando a la velocidad de exploración y a la del sprint el
+ * robot del modelo gira unos grados de más y termina tocando un muro.
+ */
+
+#include "prueba.h"
+#include "simulador.h"
+#include "laberinto.h"
+#include "odometria.h"
+
+/** @brief Cancha de 4x4 con inicio en (4,4) y meta en (1,1), como la de laberinto.h */
+static const char cancha[] =
+    "o---o---o---o---o\n"
+    "|           |   |\n"
+    "o---o   o   o   o\n"
+    "|       |       |\n"
+    "o   o---o---o   o\n"
+    "|   |           |\n"
+    "o   o   o---o   o\n"
+    "|       |   |   |\n"
+    "o---o---o---o---o\n";
+
+int main(void)
+{
+    laberinto_modelo_t laberinto;
+    FILE *archivo = tmpfile();
+    fputs(cancha, archivo);
+    rewind(archivo);
+    VERIFICAR(modelo_leer_laberinto(&laberinto, archivo));
+    fclose(archivo);
+
+    VERIFICAR(laberinto.filas == 4 && laberinto.columnas == 4);
+    VERIFICAR(modelo_hay_muro(&laberinto, 4, 4, oeste));
+    VERIFICAR(!modelo_hay_muro(&laberinto, 4, 4, norte));
+    VERIFICAR(modelo_hay_muro(&laberinto, 1, 1, norte));
+
+    modelo_parametros_t parametros;
+    modelo_parametros_defecto(&parametros);
+
+    simulador_resultado_t resultado;
+    VERIFICAR(simulador_correr(&laberinto, &parametros, ODOMETRIA_ENCODERS, &resultado));
+
+    const simulador_etapa_t *exploracion = &resultado.exploracion;
+    VERIFICAR(exploracion->llego);
+    VERIFICAR(exploracion->choques == 0);
+    VERIFICAR(exploracion->errores_posicion == 0);
+    VERIFICAR(exploracion->casillas >= 6); // El camino más corto tiene 6 casillas
+    VERIFICAR(exploracion->tiempo_ms < 60000);
+
+    // El robot quedó en la meta
+    uint8_t fila, columna;
+    modelo_get_casilla(simulador_get_modelo(), &fila, &columna);
+    VERIFICAR(laberinto_es_meta(fila, columna));
+
+#if ODOMETRIA_ENCODERS
+    const simulador_etapa_t *sprint = &resultado.sprint;
+    VERIFICAR(sprint->llego);
+    VERIFICAR(sprint->choques == 0);
+    VERIFICAR(sprint->errores_posicion == 0);
+    VERIFICAR(sprint->tiempo_ms < exploracion->tiempo_ms);
+#endif
+
+    return prueba_resultado();
+}
@@ -0,0 +1,294 @@
+/**
+ * @file prueba_telemetria.c
+ * @brief Cola de transmisión de UART5 y tramas COBS + CRC16 de ida y vuelta
+ * @author demianmozo
+ *
+ * Con el DMA del HAL simulado a velocidad de 115200 baudios la cola se llena
+ * de verdad: lo que no entra se descarta entero y se cuenta, y lo aceptado
+ * sale en orden aunque la cola dé la vuelta. Las tramas se decodifican acá con
+ * un COBS y un CRC16 propios (el CRC se comprueba contra el valor conocido de
+ * "123456789"); tienen que salir iguales, con la secuencia de a uno y sin
+ * ceros adentro. Con TELEMETRIA_BINARIA (por defecto) también las de la
+ * corrida.
+ */
+
+#include "prueba.h"
+#include "hal_falso.h"
+#include "uart.h"
+#include "telemetria.h"
+#include <string.h>
+
+#define BYTES_POR_MS 11u  ///< 115200 baudios con 10 bits por byte
+#define MAX_CAPTURA 65536u ///< Bytes de salida que se revisan por vez
+
+/** @brief Lo que salió por la UART */
+static uint8_t captura[MAX_CAPTURA];
+static size_t largo_captura = 0;
+
+/** @brief Deja correr el DMA hasta vaciar la cola y junta la salida */
+static void vaciar(void)
+{
+    for (uint32_t ms = 0; ms < 1000 && uart_get_espacio_libre() < TAMAÑO_COLA_TX; ms++)
+    {
+        hal_falso_avanzar(1);
+    }
+    largo_captura += hal_falso_uart_tomar(&captura[largo_captura], MAX_CAPTURA - largo_captura);
+}
+
+/** @brief CRC16-CCITT (0x1021, inicial 0xFFFF), bit por bit */
+static uint16_t crc16_referencia(const uint8_t *datos, size_t largo)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < largo; i++)
+    {
+        crc ^= (uint16_t)(datos[i] << 8);
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Decodifica un bloque COBS (sin el 0x00 final)
+ * @return Largo decodificado, 0 si el bloque no es COBS válido
+ */
+static size_t cobs_decodificar(const uint8_t *entrada, size_t largo, uint8_t *salida)
+{
+    size_t escritos = 0, i = 0;
+    while (i < largo)
+    {
+        uint8_t codigo = entrada[i++];
+        if (codigo == 0 || i + codigo - 1 > largo)
+            return 0;
+        for (uint8_t j = 1; j < codigo; j++)
+        {
+            salida[escritos++] = entrada[i++];
+        }
+        if (codigo != 0xFF && i < largo)
+            salida[escritos++] = 0;
+    }
+    return escritos;
+}
+
+/** @brief Una trama decodificada */
+typedef struct
+{
+    uint8_t tipo;
+    uint8_t secuencia;
+    uint32_t tiempo_ms;
+    uint8_t datos[32];
+    uint8_t largo; ///< Bytes de datos
+} trama_t;
+
+/**
+ * @brief Saca la próxima trama de la captura
+ * @param posicion Dónde seguir leyendo; se actualiza
+ * @return false si no quedan tramas completas o la siguiente está rota
+ */
+static bool leer_trama(size_t *posicion, trama_t *trama)
+{
+    while (*posicion < largo_captura)
+    {
+        size_t inicio = *posicion, fin = inicio;
+        while (fin < largo_captura && captura[fin] != 0)
+            fin++;
+        if (fin == largo_captura)
+            return false; // Trama sin terminar
+        *posicion = fin + 1;
+        if (fin == inicio)
+            continue; // 0x00 suelto
+
+        uint8_t cruda[64];
+        size_t largo = (fin - inicio <= sizeof(cruda)) ? cobs_decodificar(&captura[inicio], fin - inicio, cruda) : 0;
+        bool valida = largo >= 8 && largo - 8 <= sizeof(trama->datos) &&
+                      crc16_referencia(cruda, largo - 2) == (uint16_t)(cruda[largo - 2] | cruda[largo - 1] << 8);
+        VERIFICAR(valida);
+        if (!valida)
+            return false;
+
+        trama->tipo = cruda[0];
+        trama->secuencia = cruda[1];
+        trama->tiempo_ms = cruda[2] | cruda[3] << 8 | cruda[4] << 16 | (uint32_t)cruda[5] << 24;
+        trama->largo = (uint8_t)(largo - 8);
+        memcpy(trama->datos, &cruda[6], trama->largo);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Llena la cola con mensajes de largo al azar y revisa que salga lo aceptado
+ */
+static void probar_cola(void)
+{
+    static uint8_t esperado[MAX_CAPTURA];
+    size_t largo_esperado = 0;
+    uint32_t descartados = uart_get_bytes_descartados();
+    uint32_t rechazados = 0;
+    uint8_t valor = 0;
+
+    largo_captura = 0;
+    for (uint32_t vuelta = 0; vuelta < 200; vuelta++)
+    {
+        // Ráfaga: más de lo que el DMA saca en ese tiempo
+        for (uint32_t i = 0; i < 8; i++)
+        {
+            uint8_t mensaje_prueba[100];
+            uint16_t largo = 1 + azar(sizeof(mensaje_prueba));
+            for (uint16_t j = 0; j < largo; j++)
+            {
+                mensaje_prueba[j] = valor + j;
+            }
+
+            uint16_t libre = uart_get_espacio_libre();
+            bool aceptado = uart_encolar(mensaje_prueba, largo);
+            VERIFICAR(aceptado == (largo <= libre));
+            if (aceptado)
+            {
+                memcpy(&esperado[largo_esperado], mensaje_prueba, largo);
+                largo_esperado += largo;
+                valor += largo;
+            }
+            else
+            {
+                rechazados += largo;
+            }
+        }
+        hal_falso_avanzar(1 + azar(20));
+        largo_captura += hal_falso_uart_tomar(&captura[largo_captura], MAX_CAPTURA - largo_captura);
+    }
+    vaciar();
+
+    VERIFICAR(rechazados > 0); // La cola tiene que haberse llenado
+    VERIFICAR(uart_get_bytes_descartados() - descartados == rechazados);
+    VERIFICAR(largo_esperado > 4 * TAMAÑO_COLA_TX); // Y dado la vuelta varias veces
+    VERIFICAR(largo_captura == largo_esperado);
+    VERIFICAR(memcmp(captura, esperado, largo_esperado) == 0);
+    VERIFICAR(uart_get_espacio_libre() == TAMAÑO_COLA_TX);
+}
+
+/**
+ * @brief Entradas del registro al azar como tramas; las que no entran se reintentan
+ */
+static void probar_tramas_registro(void)
+{
+    static registro_t enviados[2000];
+    uint32_t cantidad = sizeof(enviados) / sizeof(enviados[0]);
+    uint32_t rechazos = 0;
+
+    largo_captura = 0;
+    VERIFICAR(telemetria_volcado(false, (uint16_t)cantidad));
+    for (uint32_t i = 0; i < cantidad; i++)
+    {
+        // Muchos ceros y 0xFF para que COBS tenga trabajo
+        registro_t *registro = &enviados[i];
+        registro->tiempo_ms = azar(4) ? azar(1u << 31) : 0;
+        registro->tipo = azar(5);
+        registro->extra = azar(2) ? 0 : azar(256);
+        registro->a = azar(3) ? azar(65536) : 0;
+        registro->b = azar(3) ? 0xFFFF : 0;
+
+        while (!telemetria_registro(registro))
+        {
+            rechazos++;
+            hal_falso_avanzar(1);
+            largo_captura += hal_falso_uart_tomar(&captura[largo_captura], MAX_CAPTURA - largo_captura);
+        }
+    }
+    while (!telemetria_volcado(true, (uint16_t)cantidad))
+    {
+        hal_falso_avanzar(1);
+    }
+    vaciar();
+    VERIFICAR(rechazos > 0); // Sin reintentos no se probó la cola llena
+
+    size_t posicion = 0;
+    trama_t trama;
+    VERIFICAR(captura[0] == 0); // El 0x00 suelto antes del volcado
+    VERIFICAR(leer_trama(&posicion, &trama));
+    VERIFICAR(trama.tipo == TELEMETRIA_VOLCADO && trama.largo == 3 && trama.datos[0] == 0);
+    VERIFICAR((trama.datos[1] | trama.datos[2] << 8) == cantidad);
+    uint8_t secuencia = trama.secuencia;
+
+    uint32_t distintos = 0;
+    for (uint32_t i = 0; i < cantidad; i++)
+    {
+        const registro_t *registro = &enviados[i];
+        if (!leer_trama(&posicion, &trama))
+        {
+            distintos++;
+            break;
+        }
+        if (trama.tipo != TELEMETRIA_REGISTRO || trama.secuencia != (uint8_t)(secuencia + 1) ||
+            trama.tiempo_ms != registro->tiempo_ms || trama.largo != 6 || trama.datos[0] != registro->tipo ||
+            trama.datos[1] != registro->extra || (trama.datos[2] | trama.datos[3] << 8) != registro->a ||
+            (trama.datos[4] | trama.datos[5] << 8) != registro->b)
+            distintos++;
+        secuencia = trama.secuencia;
+    }
+    VERIFICAR(distintos == 0);
+
+    VERIFICAR(leer_trama(&posicion, &trama));
+    VERIFICAR(trama.tipo == TELEMETRIA_VOLCADO && trama.datos[0] == 1 && trama.secuencia == (uint8_t)(secuencia + 1));
+    VERIFICAR(!leer_trama(&posicion, &trama));
+}
+
+#if TELEMETRIA_BINARIA
+/**
+ * @brief Tramas de la corrida: campos y tiempo de la cabecera
+ */
+static void probar_tramas_corrida(void)
+{
+    largo_captura = 0;
+    hal_falso_avanzar(5);
+    uint32_t ahora = HAL_GetTick();
+
+    telemetria_casilla(3, 4, oeste, 0x0100);
+    telemetria_muro(2, 1, sur, 0x00FF0000u);
+    telemetria_giro(norte, este);
+    telemetria_tiempo(ETAPA_DECISION, 123456);
+    telemetria_evento(EVENTO_META);
+    vaciar();
+
+    static const uint8_t esperados[][9] = {
+        {TELEMETRIA_CASILLA, 5, 3, 4, oeste, 0x00, 0x01},
+        {TELEMETRIA_MURO, 7, 2, 1, sur, 0x00, 0x00, 0xFF, 0x00},
+        {TELEMETRIA_GIRO, 2, norte, este},
+        {TELEMETRIA_TIEMPO, 5, ETAPA_DECISION, 0x40, 0xE2, 0x01, 0x00},
+        {TELEMETRIA_EVENTO, 1, EVENTO_META},
+    };
+
+    size_t posicion = 0;
+    trama_t trama;
+    uint8_t secuencia = 0;
+    for (size_t i = 0; i < sizeof(esperados) / sizeof(esperados[0]); i++)
+    {
+        VERIFICAR(leer_trama(&posicion, &trama));
+        VERIFICAR(trama.tipo == esperados[i][0] && trama.largo == esperados[i][1]);
+        VERIFICAR(memcmp(trama.datos, &esperados[i][2], esperados[i][1]) == 0);
+        VERIFICAR(trama.tiempo_ms == ahora);
+        VERIFICAR(i == 0 || trama.secuencia == (uint8_t)(secuencia + 1));
+        secuencia = trama.secuencia;
+    }
+    VERIFICAR(!leer_trama(&posicion, &trama));
+}
+#endif
+
+int main(void)
+{
+    prueba_semilla(777);
+    VERIFICAR(crc16_referencia((const uint8_t *)"123456789", 9) == 0x29B1);
+
+    hal_falso_reiniciar();
+    hal_falso_uart_set_bytes_por_ms(BYTES_POR_MS);
+
+    probar_cola();
+    probar_tramas_registro();
+#if TELEMETRIA_BINARIA
+    probar_tramas_corrida();
+#endif
+
+    return prueba_resultado();
+}
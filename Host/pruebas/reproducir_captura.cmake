@@ -0,0 +1,27 @@
+# Captura una corrida de simular, la decodifica y la reproduce: reproducir
+# tiene que registrar lo mismo que el simulador, comandos de motor incluidos
+set(captura ${DIRECTORIO}/reproducir_captura.bin)
+set(csv ${DIRECTORIO}/reproducir_captura.csv)
+
+# Un choque en el sprint hace que simular termine con 1: lo que importa acá
+# es que las dos etapas lleguen y queden en la captura
+execute_process(COMMAND ${SIMULAR} ${LABERINTO} --captura ${captura} RESULT_VARIABLE resultado OUTPUT_VARIABLE salida)
+if(resultado GREATER 1 OR NOT salida MATCHES "exploracion_llego=1" OR NOT salida MATCHES "sprint_llego=1")
+    message(FATAL_ERROR "simular terminó con ${resultado}:\n${salida}")
+endif()
+
+execute_process(COMMAND ${DECODIFICAR} ${captura} --salida ${csv} RESULT_VARIABLE resultado)
+if(NOT resultado EQUAL 0)
+    message(FATAL_ERROR "decodificar terminó con ${resultado}")
+endif()
+
+execute_process(COMMAND ${REPRODUCIR} ${csv} RESULT_VARIABLE resultado OUTPUT_VARIABLE salida)
+message("${salida}")
+if(NOT resultado EQUAL 0)
+    message(FATAL_ERROR "reproducir terminó con ${resultado}")
+endif()
+foreach(clave exploracion_motores sprint_motores)
+    if(NOT salida MATCHES "${clave}=[1-9]")
+        message(FATAL_ERROR "sin comandos de motor en ${clave}")
+    endif()
+endforeach()
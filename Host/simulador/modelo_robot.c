@@ -0,0 +1,551 @@
+/**
+ * @file modelo_robot.c
+ * @brief Modelo físico del robot y del laberinto
+ * @author demianmozo
+ */
+
+#include "modelo_robot.h"
+#include "hal_falso.h"
+#include "main.h"
+#include "odometria.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Parámetros nominales
+ * @details Con PWM 700 una rueda va a 364 mm/s: el avance de exploración
+ *          (250 ms) recorre los 90 mm de la línea al centro. Con las ruedas
+ *          opuestas el arrastre deja carga_giro de esa velocidad, así un giro
+ *          de 90 grados a PWM 700 dura unos 525 ms (entre TIEMPO_GIRO_90_IZQ y
+ *          TIEMPO_GIRO_90_DER). Las lecturas de los IR son las de los valores
+ *          por defecto de control_linearecta.c: 400 pegado, unas 2200 centrado
+ */
+void modelo_parametros_defecto(modelo_parametros_t *parametros)
+{
+    parametros->celda_mm = 180.0f;
+    parametros->espesor_muro_mm = 12.0f;
+    parametros->ancho_linea_mm = 20.0f;
+    parametros->radio_robot_mm = 45.0f;
+    parametros->velocidad_maxima_mm_s = 520.0f;
+    parametros->pwm_minimo = 50.0f;
+    parametros->tau_ms = 40.0f;
+    parametros->carga_giro = 0.35f;
+    parametros->ganancia_izq = 1.0f;
+    parametros->ganancia_der = 1.0f;
+    parametros->sensor_lateral_adelante_mm = 30.0f;
+    parametros->sensor_lateral_costado_mm = 35.0f;
+    parametros->adc_pegado = 400.0f;
+    parametros->adc_por_mm = 37.0f;
+    parametros->ruido_adc = 0.0f;
+    parametros->sensor_muro_adelante_mm = 50.0f;
+    parametros->alcance_muro_mm = 60.0f;
+    parametros->sensor_linea_adelante_mm = 0.0f;
+    parametros->semilla = 1;
+}
+
+/* Laberinto ---------------------------------------------------------------- */
+
+/**
+ * @brief Indica si el carácter de una posición de muro marca un muro
+ */
+static bool caracter_muro(const char *linea, size_t posicion)
+{
+    return posicion < strlen(linea) && linea[posicion] != ' ' && linea[posicion] != '\n' && linea[posicion] != '\r';
+}
+
+bool modelo_leer_laberinto(laberinto_modelo_t *laberinto, FILE *archivo)
+{
+    char lineas[2 * MODELO_MAXIMO_LADO + 1][8 * MODELO_MAXIMO_LADO];
+    size_t cantidad = 0;
+    size_t ancho = 0;
+
+    memset(laberinto, 0, sizeof(*laberinto));
+
+    while (cantidad < 2 * MODELO_MAXIMO_LADO + 1 && fgets(lineas[cantidad], sizeof(lineas[cantidad]), archivo) != NULL)
+    {
+        size_t largo = strcspn(lineas[cantidad], "\r\n");
+        lineas[cantidad][largo] = '\0';
+        if (largo == 0)
+        {
+            if (cantidad == 0)
+                continue; // Líneas vacías antes del laberinto
+            break;        // Fin del laberinto
+        }
+        if (largo > ancho)
+            ancho = largo;
+        cantidad++;
+    }
+
+    if (cantidad < 3 || cantidad % 2 == 0 || ancho < 5)
+    {
+        return false;
+    }
+
+    laberinto->filas = (uint8_t)((cantidad - 1) / 2);
+    laberinto->columnas = (uint8_t)((ancho - 1) / 4);
+    if (laberinto->columnas == 0 || laberinto->columnas > MODELO_MAXIMO_LADO)
+    {
+        return false;
+    }
+
+    for (uint8_t n = 0; n <= laberinto->filas; n++)
+    {
+        for (uint8_t c = 0; c < laberinto->columnas; c++)
+        {
+            laberinto->horizontal[n][c] = caracter_muro(lineas[2 * n], 4u * c + 2u);
+        }
+    }
+    for (uint8_t f = 0; f < laberinto->filas; f++)
+    {
+        for (uint8_t l = 0; l <= laberinto->columnas; l++)
+        {
+            laberinto->vertical[f][l] = caracter_muro(lineas[2 * f + 1], 4u * l);
+        }
+    }
+
+    // Bordes siempre cerrados
+    for (uint8_t c = 0; c < laberinto->columnas; c++)
+    {
+        laberinto->horizontal[0][c] = true;
+        laberinto->horizontal[laberinto->filas][c] = true;
+    }
+    for (uint8_t f = 0; f < laberinto->filas; f++)
+    {
+        laberinto->vertical[f][0] = true;
+        laberinto->vertical[f][laberinto->columnas] = true;
+    }
+
+    return true;
+}
+
+void modelo_escribir_laberinto(const laberinto_modelo_t *laberinto, FILE *archivo)
+{
+    for (uint8_t n = 0; n <= laberinto->filas; n++)
+    {
+        for (uint8_t c = 0; c < laberinto->columnas; c++)
+        {
+            fputs(laberinto->horizontal[n][c] ? "o---" : "o   ", archivo);
+        }
+        fputs("o\n", archivo);
+
+        if (n == laberinto->filas)
+            break;
+
+        for (uint8_t l = 0; l <= laberinto->columnas; l++)
+        {
+            fputs(laberinto->vertical[n][l] ? "|" : " ", archivo);
+            if (l < laberinto->columnas)
+                fputs("   ", archivo);
+        }
+        fputs("\n", archivo);
+    }
+}
+
+bool modelo_hay_muro(const laberinto_modelo_t *laberinto, uint8_t fila, uint8_t columna, brujula direccion)
+{
+    switch (direccion)
+    {
+    case norte:
+        return laberinto->horizontal[fila - 1][columna - 1];
+    case sur:
+        return laberinto->horizontal[fila][columna - 1];
+    case oeste:
+        return laberinto->vertical[fila - 1][columna - 1];
+    case este:
+    default:
+        return laberinto->vertical[fila - 1][columna];
+    }
+}
+
+/* Robot -------------------------------------------------------------------- */
+
+/**
+ * @brief Rumbo en radianes de un punto cardinal
+ */
+static double rumbo_de(brujula sentido)
+{
+    switch (sentido)
+    {
+    case norte:
+        return M_PI / 2;
+    case oeste:
+        return M_PI;
+    case sur:
+        return -M_PI / 2;
+    case este:
+    default:
+        return 0.0;
+    }
+}
+
+void modelo_iniciar(modelo_t *modelo, const laberinto_modelo_t *laberinto, const modelo_parametros_t *parametros,
+                    uint8_t fila, uint8_t columna, brujula sentido)
+{
+    memset(modelo, 0, sizeof(*modelo));
+    modelo->laberinto = laberinto;
+    modelo->parametros = *parametros;
+    modelo->aleatorio = parametros->semilla ? parametros->semilla : 1;
+    modelo_colocar(modelo, fila, columna, sentido);
+}
+
+void modelo_colocar(modelo_t *modelo, uint8_t fila, uint8_t columna, brujula sentido)
+{
+    const double celda = modelo->parametros.celda_mm;
+
+    modelo->x = (columna - 0.5) * celda;
+    modelo->y = (modelo->laberinto->filas - fila + 0.5) * celda;
+    modelo->rumbo = rumbo_de(sentido);
+    modelo->velocidad_izq = 0.0;
+    modelo->velocidad_der = 0.0;
+    modelo->en_contacto = false;
+}
+
+void modelo_get_casilla(const modelo_t *modelo, uint8_t *fila, uint8_t *columna)
+{
+    modelo_get_casilla_adelante(modelo, 0.0f, fila, columna);
+}
+
+void modelo_get_casilla_adelante(const modelo_t *modelo, float adelante_mm, uint8_t *fila, uint8_t *columna)
+{
+    const double celda = modelo->parametros.celda_mm;
+    int i = (int)floor((modelo->x + cos(modelo->rumbo) * adelante_mm) / celda);
+    int j = (int)floor((modelo->y + sin(modelo->rumbo) * adelante_mm) / celda);
+
+    *columna = (uint8_t)(i + 1);
+    *fila = (uint8_t)(modelo->laberinto->filas - j);
+}
+
+uint16_t modelo_lectura_ir(const modelo_parametros_t *parametros, float distancia_mm)
+{
+    float lectura = parametros->adc_pegado + parametros->adc_por_mm * distancia_mm;
+    return (uint16_t)(lectura > 4095.0f ? 4095.0f : (lectura < 0.0f ? 0.0f : lectura));
+}
+
+float modelo_distancia_centrado(const modelo_parametros_t *parametros)
+{
+    return (parametros->celda_mm - parametros->espesor_muro_mm) / 2 - parametros->sensor_lateral_costado_mm;
+}
+
+float modelo_distancia_pegado(const modelo_parametros_t *parametros)
+{
+    return parametros->radio_robot_mm - parametros->sensor_lateral_costado_mm;
+}
+
+/**
+ * @brief Número aleatorio normal (media 0, desvío 1), con xorshift y Box-Muller
+ */
+static double aleatorio_normal(modelo_t *modelo)
+{
+    double u[2];
+
+    for (int i = 0; i < 2; i++)
+    {
+        uint32_t x = modelo->aleatorio;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        modelo->aleatorio = x;
+        u[i] = (x + 1.0) / 4294967297.0;
+    }
+
+    return sqrt(-2.0 * log(u[0])) * cos(2.0 * M_PI * u[1]);
+}
+
+/**
+ * @brief Sentido de giro de un motor según sus pines M0/M1 (tabla de control_motor.h)
+ * @return 1 avance, -1 retroceso, 0 frenado
+ */
+static int sentido_motor(uint16_t pin0, uint16_t pin1)
+{
+    GPIO_PinState m0 = hal_falso_gpio_get_salida(MI0_GPIO_Port, pin0);
+    GPIO_PinState m1 = hal_falso_gpio_get_salida(MI0_GPIO_Port, pin1);
+
+    if (m0 == GPIO_PIN_SET && m1 == GPIO_PIN_RESET)
+        return 1;
+    if (m0 == GPIO_PIN_RESET && m1 == GPIO_PIN_SET)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Velocidad a la que va una rueda con un PWM y sentido sostenidos
+ */
+static double velocidad_objetivo(const modelo_parametros_t *p, int sentido, uint32_t pwm, float ganancia)
+{
+    if (pwm > 1000)
+        pwm = 1000;
+    if (sentido == 0 || pwm < p->pwm_minimo)
+        return 0.0;
+    return sentido * (pwm / 1000.0) * p->velocidad_maxima_mm_s * ganancia;
+}
+
+/**
+ * @brief Saca el círculo del robot de un rectángulo (muro o poste) si lo toca
+ * @return true si lo tocaba
+ */
+static bool empujar_fuera(modelo_t *modelo, double x0, double y0, double x1, double y1)
+{
+    const double radio = modelo->parametros.radio_robot_mm;
+    double cx = modelo->x < x0 ? x0 : (modelo->x > x1 ? x1 : modelo->x);
+    double cy = modelo->y < y0 ? y0 : (modelo->y > y1 ? y1 : modelo->y);
+    double dx = modelo->x - cx;
+    double dy = modelo->y - cy;
+    double d2 = dx * dx + dy * dy;
+
+    if (d2 >= radio * radio)
+        return false;
+
+    double d = sqrt(d2);
+    if (d < 1e-9)
+    {
+        return true; // Centro dentro del muro: no hay dirección para sacarlo
+    }
+    modelo->x = cx + dx / d * radio;
+    modelo->y = cy + dy / d * radio;
+    return true;
+}
+
+/**
+ * @brief Resuelve los choques con los muros y postes alrededor del robot
+ * @return true si toca alguno
+ */
+static bool resolver_choques(modelo_t *modelo)
+{
+    const laberinto_modelo_t *lab = modelo->laberinto;
+    const double celda = modelo->parametros.celda_mm;
+    const double medio = modelo->parametros.espesor_muro_mm / 2;
+    const int filas = lab->filas;
+    const int columnas = lab->columnas;
+    int i = (int)floor(modelo->x / celda);
+    int j = (int)floor(modelo->y / celda);
+    bool toca = false;
+
+    for (int k = j - 1; k <= j + 2; k++) // Líneas horizontales (desde el sur)
+    {
+        for (int c = i - 1; c <= i + 1; c++)
+        {
+            if (k < 0 || k > filas || c < 0 || c >= columnas || !lab->horizontal[filas - k][c])
+                continue;
+            toca |= empujar_fuera(modelo, c * celda, k * celda - medio, (c + 1) * celda, k * celda + medio);
+        }
+    }
+    for (int l = i - 1; l <= i + 2; l++) // Líneas verticales
+    {
+        for (int r = j - 1; r <= j + 1; r++)
+        {
+            if (l < 0 || l > columnas || r < 0 || r >= filas || !lab->vertical[filas - 1 - r][l])
+                continue;
+            toca |= empujar_fuera(modelo, l * celda - medio, r * celda, l * celda + medio, (r + 1) * celda);
+        }
+    }
+    for (int l = i - 1; l <= i + 2; l++) // Postes
+    {
+        for (int k = j - 1; k <= j + 2; k++)
+        {
+            if (l < 0 || l > columnas || k < 0 || k > filas)
+                continue;
+            toca |= empujar_fuera(modelo, l * celda - medio, k * celda - medio, l * celda + medio, k * celda + medio);
+        }
+    }
+
+    return toca;
+}
+
+/**
+ * @brief Distancia desde un punto hasta la cara del primer muro en una dirección
+ * @details Recorre las casillas que cruza el rayo (DDA) mirando el muro de
+ *          cada borde que atraviesa
+ * @return Distancia en mm, o alcance si no hay muro antes
+ */
+static double distancia_rayo(const modelo_t *modelo, double x0, double y0, double angulo, double alcance)
+{
+    const laberinto_modelo_t *lab = modelo->laberinto;
+    const double celda = modelo->parametros.celda_mm;
+    const double medio = modelo->parametros.espesor_muro_mm / 2;
+    const double dx = cos(angulo);
+    const double dy = sin(angulo);
+    int i = (int)floor(x0 / celda);
+    int j = (int)floor(y0 / celda);
+
+    if (i < 0 || i >= lab->columnas || j < 0 || j >= lab->filas)
+        return 0.0; // Fuera del laberinto
+
+    for (;;)
+    {
+        double tx = INFINITY, ty = INFINITY;
+        int linea_x = 0, linea_y = 0;
+
+        if (dx > 1e-12)
+        {
+            linea_x = i + 1;
+            tx = (linea_x * celda - x0) / dx;
+        }
+        else if (dx < -1e-12)
+        {
+            linea_x = i;
+            tx = (linea_x * celda - x0) / dx;
+        }
+        if (dy > 1e-12)
+        {
+            linea_y = j + 1;
+            ty = (linea_y * celda - y0) / dy;
+        }
+        else if (dy < -1e-12)
+        {
+            linea_y = j;
+            ty = (linea_y * celda - y0) / dy;
+        }
+
+        double t = (tx < ty) ? tx : ty;
+        if (t - medio > alcance)
+            return alcance;
+
+        if (tx < ty)
+        {
+            if (lab->vertical[lab->filas - 1 - j][linea_x])
+            {
+                double cara = tx - medio / fabs(dx);
+                return cara < 0.0 ? 0.0 : (cara > alcance ? alcance : cara);
+            }
+            i += (dx > 0) ? 1 : -1;
+        }
+        else
+        {
+            if (lab->horizontal[lab->filas - linea_y][i])
+            {
+                double cara = ty - medio / fabs(dy);
+                return cara < 0.0 ? 0.0 : (cara > alcance ? alcance : cara);
+            }
+            j += (dy > 0) ? 1 : -1;
+        }
+    }
+}
+
+/**
+ * @brief Lectura de un IR lateral montado en (adelante, costado) mirando hacia ese costado
+ * @param lado 1 = izquierdo, -1 = derecho
+ */
+static uint16_t leer_ir(modelo_t *modelo, int lado)
+{
+    const modelo_parametros_t *p = &modelo->parametros;
+    double c = cos(modelo->rumbo);
+    double s = sin(modelo->rumbo);
+    double x = modelo->x + c * p->sensor_lateral_adelante_mm - s * lado * p->sensor_lateral_costado_mm;
+    double y = modelo->y + s * p->sensor_lateral_adelante_mm + c * lado * p->sensor_lateral_costado_mm;
+    double distancia = distancia_rayo(modelo, x, y, modelo->rumbo + lado * M_PI / 2, 4095.0 / p->adc_por_mm);
+    double lectura = p->adc_pegado + p->adc_por_mm * distancia;
+
+    if (p->ruido_adc > 0.0f)
+    {
+        lectura += p->ruido_adc * aleatorio_normal(modelo);
+    }
+    return (uint16_t)(lectura > 4095.0 ? 4095.0 : (lectura < 0.0 ? 0.0 : lectura));
+}
+
+/**
+ * @brief Indica si el sensor de línea está sobre una línea del piso
+ */
+static bool sobre_linea(const modelo_t *modelo)
+{
+    const modelo_parametros_t *p = &modelo->parametros;
+    const double celda = p->celda_mm;
+    double x = modelo->x + cos(modelo->rumbo) * p->sensor_linea_adelante_mm;
+    double y = modelo->y + sin(modelo->rumbo) * p->sensor_linea_adelante_mm;
+    double resto_x = fmod(x, celda);
+    double resto_y = fmod(y, celda);
+
+    return resto_x < p->ancho_linea_mm / 2 || celda - resto_x < p->ancho_linea_mm / 2 ||
+           resto_y < p->ancho_linea_mm / 2 || celda - resto_y < p->ancho_linea_mm / 2;
+}
+
+/**
+ * @brief Pone las entradas del firmware según la pose
+ */
+static void actualizar_sensores(modelo_t *modelo)
+{
+    const modelo_parametros_t *p = &modelo->parametros;
+
+    hal_falso_adc_set_lecturas(leer_ir(modelo, -1), leer_ir(modelo, 1)); // Canal 8 derecho, 9 izquierdo
+
+    double x = modelo->x + cos(modelo->rumbo) * p->sensor_muro_adelante_mm;
+    double y = modelo->y + sin(modelo->rumbo) * p->sensor_muro_adelante_mm;
+    bool muro = distancia_rayo(modelo, x, y, modelo->rumbo, p->alcance_muro_mm) < p->alcance_muro_mm;
+    hal_falso_gpio_set_entrada(WallSensor_GPIO_Port, WallSensor_Pin, muro ? GPIO_PIN_RESET : GPIO_PIN_SET);
+
+    // Solo los cambios, así el EXTI ve un flanco por línea
+    GPIO_PinState linea = sobre_linea(modelo) ? GPIO_PIN_RESET : GPIO_PIN_SET;
+    if (HAL_GPIO_ReadPin(LineSensor_GPIO_Port, LineSensor_Pin) != linea)
+    {
+        hal_falso_gpio_set_entrada(LineSensor_GPIO_Port, LineSensor_Pin, linea);
+    }
+}
+
+/**
+ * @brief Entrega a los contadores simulados los pulsos enteros que giró cada rueda
+ */
+static void mover_encoders(modelo_t *modelo, double avance_izq_mm, double avance_der_mm)
+{
+    const double pulsos_por_mm = ODOMETRIA_PULSOS_POR_VUELTA / (M_PI * ODOMETRIA_DIAMETRO_RUEDA_UM / 1000.0);
+
+    modelo->pulsos_izq += avance_izq_mm * pulsos_por_mm;
+    modelo->pulsos_der += avance_der_mm * pulsos_por_mm;
+    double izq = trunc(modelo->pulsos_izq);
+    double der = trunc(modelo->pulsos_der);
+    modelo->pulsos_izq -= izq;
+    modelo->pulsos_der -= der;
+
+    odometria_simular_pulsos((int16_t)(ODOMETRIA_SIGNO_IZQ * izq), (int16_t)(ODOMETRIA_SIGNO_DER * der));
+}
+
+void modelo_paso(modelo_t *modelo)
+{
+    const modelo_parametros_t *p = &modelo->parametros;
+    const double dt = 0.001;
+    const double trocha = ODOMETRIA_TROCHA_UM / 1000.0;
+
+    // Lo que el firmware mandó a los motores (el compare que ya está usando el PWM)
+    int sentido_izq = sentido_motor(MI0_Pin, MI1_Pin);
+    int sentido_der = sentido_motor(MD0_Pin, MD1_Pin);
+    double objetivo_izq = velocidad_objetivo(p, sentido_izq, hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_3), p->ganancia_izq);
+    double objetivo_der = velocidad_objetivo(p, sentido_der, hal_falso_tim_get_compare_activo(TIM3, TIM_CHANNEL_4), p->ganancia_der);
+    if (sentido_izq * sentido_der < 0)
+    {
+        objetivo_izq *= p->carga_giro; // Girando en el lugar las ruedas arrastran
+        objetivo_der *= p->carga_giro;
+    }
+
+    // Motores de primer orden
+    double alfa = 1.0 - exp(-1.0 / p->tau_ms);
+    modelo->velocidad_izq += (objetivo_izq - modelo->velocidad_izq) * alfa;
+    modelo->velocidad_der += (objetivo_der - modelo->velocidad_der) * alfa;
+
+    // Cinemática diferencial (punto medio del rumbo)
+    double avance_izq = modelo->velocidad_izq * dt;
+    double avance_der = modelo->velocidad_der * dt;
+    double giro = (avance_der - avance_izq) / trocha;
+    double rumbo_medio = modelo->rumbo + giro / 2;
+    double avance = (avance_izq + avance_der) / 2;
+    modelo->x += avance * cos(rumbo_medio);
+    modelo->y += avance * sin(rumbo_medio);
+    modelo->rumbo = remainder(modelo->rumbo + giro, 2 * M_PI);
+
+    // Choques: el robot queda apoyado contra lo que tocó
+    bool toca = resolver_choques(modelo);
+    if (toca)
+    {
+        toca = resolver_choques(modelo) || toca; // Esquinas: dos muros a la vez
+        modelo->ms_en_contacto++;
+        if (!modelo->en_contacto)
+        {
+            modelo->choques++;
+        }
+    }
+    modelo->en_contacto = toca;
+
+    mover_encoders(modelo, avance_izq, avance_der);
+    actualizar_sensores(modelo);
+}
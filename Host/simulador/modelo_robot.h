@@ -0,0 +1,166 @@
+/**
+ * @file modelo_robot.h
+ * @brief Modelo físico del robot y del laberinto para correr el firmware en la PC
+ * @author demianmozo
+ *
+ * En cada ms virtual (como paso de hal_falso_set_paso()) modelo_paso():
+ * 1. Lee lo que el firmware mandó a los motores: el compare activo de TIM3
+ *    CH3 (izquierdo) y CH4 (derecho) y los pines MI0/MI1/MD0/MD1 de GPIOB
+ * 2. Lleva la velocidad de cada rueda hacia la que corresponde a ese PWM con
+ *    un modelo de primer orden (constante de tiempo tau_ms)
+ * 3. Integra la cinemática diferencial (trocha ODOMETRIA_TROCHA_UM) y
+ *    resuelve los choques contra muros y postes (el robot es un círculo)
+ * 4. Mueve los encoders con odometria_simular_pulsos()
+ * 5. Genera lo que leen los sensores: el ADC de los IR laterales
+ *    (hal_falso_adc_set_lecturas()), el sensor de línea en PC7 (con su flanco
+ *    para el EXTI) y el de muro en PC6
+ *
+ * Coordenadas en mm: x hacia el este desde el borde oeste, y hacia el norte
+ * desde el borde sur; el rumbo en radianes desde el este, antihorario. Las
+ * casillas se numeran como en laberinto.h: fila 1 al norte, columna 1 al oeste.
+ * Hay una línea en el piso sobre cada borde entre casillas.
+ */
+
+#ifndef __MODELO_ROBOT_H
+#define __MODELO_ROBOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "brujula.h"
+
+#define MODELO_MAXIMO_LADO 32 ///< Filas o columnas como máximo (igual que laberinto.h)
+
+/**
+ * @brief Muros reales del laberinto (los que el robot todavía no conoce)
+ */
+typedef struct
+{
+    uint8_t filas;
+    uint8_t columnas;
+    bool horizontal[MODELO_MAXIMO_LADO + 1][MODELO_MAXIMO_LADO]; ///< [línea][columna - 1]; línea 0 = borde norte
+    bool vertical[MODELO_MAXIMO_LADO][MODELO_MAXIMO_LADO + 1];   ///< [fila - 1][línea]; línea 0 = borde oeste
+} laberinto_modelo_t;
+
+/**
+ * @brief Parámetros físicos
+ * @details modelo_parametros_defecto() deja un robot con el que los tiempos de
+ *          control_motor.h dan giros de unos 90 grados y el avance de
+ *          exploración llega al centro de la casilla
+ */
+typedef struct
+{
+    float celda_mm;              ///< Lado de una casilla (de eje a eje de los muros)
+    float espesor_muro_mm;       ///< Espesor de muros y postes
+    float ancho_linea_mm;        ///< Ancho de las líneas del piso
+    float radio_robot_mm;        ///< Radio del círculo que choca
+    float velocidad_maxima_mm_s; ///< Velocidad de una rueda con PWM 1000 en recta
+    float pwm_minimo;            ///< Debajo de esto el motor no vence el rozamiento
+    float tau_ms;                ///< Constante de tiempo de los motores
+    float carga_giro;            ///< Fracción de la velocidad con las ruedas en sentidos opuestos (arrastre)
+    float ganancia_izq;          ///< Desparejo de los motores (1 = nominal)
+    float ganancia_der;
+    float sensor_lateral_adelante_mm; ///< Sensores IR: adelante del centro
+    float sensor_lateral_costado_mm;  ///< Sensores IR: hacia cada costado del centro
+    float adc_pegado;            ///< Lectura del IR con la pared a 0 mm
+    float adc_por_mm;            ///< Aumento de la lectura por mm (más lejos = más alto)
+    float ruido_adc;             ///< Desvío estándar del ruido de los IR
+    float sensor_muro_adelante_mm; ///< Sensor de muro: adelante del centro
+    float alcance_muro_mm;       ///< Distancia a la que el sensor de muro detecta
+    float sensor_linea_adelante_mm; ///< Sensor de línea: adelante del centro
+    uint32_t semilla;            ///< Semilla del ruido
+} modelo_parametros_t;
+
+/**
+ * @brief Estado del robot simulado
+ */
+typedef struct
+{
+    const laberinto_modelo_t *laberinto;
+    modelo_parametros_t parametros;
+    double x, y, rumbo;         ///< Pose (mm, mm, rad)
+    double velocidad_izq;       ///< Velocidad de la rueda (mm/s)
+    double velocidad_der;
+    double pulsos_izq;          ///< Pulsos de encoder todavía sin entregar (fracción)
+    double pulsos_der;
+    uint32_t aleatorio;         ///< Estado del generador del ruido
+    bool en_contacto;           ///< Tocando un muro o poste en el último paso
+    uint32_t choques;           ///< Veces que empezó a tocar un muro o poste
+    uint32_t ms_en_contacto;    ///< ms tocando algo
+} modelo_t;
+
+/**
+ * @brief Parámetros nominales
+ */
+void modelo_parametros_defecto(modelo_parametros_t *parametros);
+
+/**
+ * @brief Lee un laberinto en el formato de texto habitual de micromouse
+ * @details Una línea de postes y muros horizontales y una de muros verticales
+ *          por fila, por ejemplo:
+ * @code
+ * o---o---o
+ * |       |
+ * o   o---o
+ * |   |   |
+ * o---o---o
+ * @endcode
+ *          Cualquier carácter distinto de espacio en la posición de un muro
+ *          cuenta como muro; los bordes se cierran siempre
+ * @return false si el formato o el tamaño no sirven
+ */
+bool modelo_leer_laberinto(laberinto_modelo_t *laberinto, FILE *archivo);
+
+/**
+ * @brief Escribe un laberinto en el mismo formato que lee modelo_leer_laberinto()
+ */
+void modelo_escribir_laberinto(const laberinto_modelo_t *laberinto, FILE *archivo);
+
+/**
+ * @brief Indica si hay muro en un borde de una casilla (1 a filas, 1 a columnas)
+ */
+bool modelo_hay_muro(const laberinto_modelo_t *laberinto, uint8_t fila, uint8_t columna, brujula direccion);
+
+/**
+ * @brief Deja el robot quieto en el centro de una casilla
+ */
+void modelo_iniciar(modelo_t *modelo, const laberinto_modelo_t *laberinto, const modelo_parametros_t *parametros,
+                    uint8_t fila, uint8_t columna, brujula sentido);
+
+/**
+ * @brief Lleva el robot quieto al centro de una casilla (como levantarlo con la mano)
+ */
+void modelo_colocar(modelo_t *modelo, uint8_t fila, uint8_t columna, brujula sentido);
+
+/**
+ * @brief Un ms de simulación: motores, movimiento, choques, encoders y sensores
+ */
+void modelo_paso(modelo_t *modelo);
+
+/**
+ * @brief Casilla en la que está el centro del robot
+ */
+void modelo_get_casilla(const modelo_t *modelo, uint8_t *fila, uint8_t *columna);
+
+/**
+ * @brief Casilla del punto que está adelante_mm delante del centro del robot
+ */
+void modelo_get_casilla_adelante(const modelo_t *modelo, float adelante_mm, uint8_t *fila, uint8_t *columna);
+
+/**
+ * @brief Lectura sin ruido de un IR lateral con la pared a una distancia
+ * @note Para cargar la calibración como la dejaría auto_calibracion()
+ */
+uint16_t modelo_lectura_ir(const modelo_parametros_t *parametros, float distancia_mm);
+
+/**
+ * @brief Distancia de un IR lateral a la pared con el robot centrado en el pasillo
+ */
+float modelo_distancia_centrado(const modelo_parametros_t *parametros);
+
+/**
+ * @brief Distancia de un IR lateral a la pared con el robot tocándola
+ */
+float modelo_distancia_pegado(const modelo_parametros_t *parametros);
+
+#endif /* __MODELO_ROBOT_H */
@@ -0,0 +1,282 @@
+/**
+ * @file simulador.c
+ * @brief Corrida completa del firmware sobre el modelo del robot
+ * @author demianmozo
+ */
+
+#include "simulador.h"
+#include "hal_falso.h"
+#include "main.h"
+#include "control_linearecta.h"
+#include "control_motor.h"
+#include "laberinto.h"
+#include "persistencia.h"
+#include "recorrido.h"
+#include "registro.h"
+#include <string.h>
+
+#define ESPERA_ANTES_DEL_SPRINT_MS 1000u ///< Robot quieto en la meta antes de llevarlo al inicio
+#define BOTON_APRETADO_MAXIMO_MS 1000u   ///< Tope para que el firmware vea el botón
+#define VOLCADO_MAXIMO_MS 30000u         ///< Tope para que termine de salir el registro al final
+
+extern uint16_t izq_cerca, izq_lejos, izq_centrado;
+extern uint16_t der_cerca, der_lejos, der_centrado;
+
+/**
+ * @brief Parámetros de ajuste, con los nombres de comandos.c
+ * @details Los de exploración (vel_*, avance) no se guardan en la flash pero
+ *          tampoco los pisa el arranque: se cambian antes de correr y listo
+ */
+static const simulador_ajuste_t ajustes[] = {
+    {"vel_izq", "VELOCIDAD_AVANCE_IZQ", &velocidad_actual_izq, 1000},
+    {"vel_der", "VELOCIDAD_AVANCE_DER", &velocidad_actual_der, 1000},
+    {"vel_sprint_izq", "VELOCIDAD_SPRINT_IZQ", &velocidad_sprint_izq, 1000},
+    {"vel_sprint_der", "VELOCIDAD_SPRINT_DER", &velocidad_sprint_der, 1000},
+    {"vel_giro_izq", "VELOCIDAD_GIRO_IZQ", &velocidad_giro_actual_izq, 1000},
+    {"vel_giro_der", "VELOCIDAD_GIRO_DER", &velocidad_giro_actual_der, 1000},
+    {"giro_izq", "TIEMPO_GIRO_90_IZQ", &tiempo_giro_90_izq, 5000},
+    {"giro_der", "TIEMPO_GIRO_90_DER", &tiempo_giro_90_der, 5000},
+    {"giro_180", "TIEMPO_GIRO_180", &tiempo_giro_180, 5000},
+    {"correccion", "TIEMPO_CORRECCION", &tiempo_correccion, 1000},
+    {"avance", "TIEMPO_AVANCE_LINEA_EXPLORACION", &TIEMPO_AVANCE_LINEA, 5000},
+    {"avance_sprint", "TIEMPO_AVANCE_LINEA_SPRINT", &tiempo_avance_sprint, 5000},
+    {"angulo_90", "ANGULO_GIRO_90", &angulo_giro_90, 3600},
+    {"angulo_180", "ANGULO_GIRO_180", &angulo_giro_180, 3600},
+    {"avance_mm", "DISTANCIA_AVANCE_LINEA", &distancia_avance_linea, 1000},
+    {"pid_kp", "PID_KP", &pid_kp, 10000},
+    {"pid_ki", "PID_KI", &pid_ki, 1000},
+    {"pid_kd", "PID_KD", &pid_kd, 60000},
+    {"pid_max", "PID_SALIDA_MAXIMA", &pid_salida_maxima, 1000},
+    {"perfil", "PERFIL_VELOCIDAD", &perfil_velocidad, 1},
+};
+
+#define CANTIDAD_AJUSTES (sizeof(ajustes) / sizeof(ajustes[0]))
+
+/** @brief Robot simulado; modelo_paso() lo avanza desde el HAL simulado */
+static modelo_t modelo;
+
+/** @brief Destino de la traza de eventos (NULL = sin traza) */
+static FILE *traza = NULL;
+
+/** @brief Destino de lo transmitido por UART5 (NULL = se descarta) */
+static FILE *captura = NULL;
+
+/**
+ * @brief Una línea de traza: tiempo, evento, casilla y sentido del firmware y pose del robot
+ */
+static void trazar(const char *evento)
+{
+    static const char letras[] = "NESO";
+
+    if (traza == NULL)
+        return;
+    fprintf(traza, "%7lu %-8s fw=(%u,%u)%c robot=(%.0f,%.0f) %.0f°\n", (unsigned long)HAL_GetTick(), evento,
+            fila_actual, columna_actual, letras[sentido_actual & 3], modelo.x, modelo.y, modelo.rumbo * 57.2957795);
+}
+
+/**
+ * @brief Paso de cada ms para hal_falso_set_paso()
+ */
+static void paso_modelo(uint32_t ahora_ms)
+{
+    (void)ahora_ms;
+    modelo_paso(&modelo);
+}
+
+/**
+ * @brief Deja en la flash la calibración que mediría auto_calibracion() con este robot
+ * @details Pegado a cada pared para *_cerca y centrado en el pasillo para
+ *          *_lejos, igual que las etapas de auto_calibracion()
+ */
+static void guardar_calibracion(const modelo_parametros_t *parametros)
+{
+    uint16_t pegado = modelo_lectura_ir(parametros, modelo_distancia_pegado(parametros));
+    uint16_t centrado = modelo_lectura_ir(parametros, modelo_distancia_centrado(parametros));
+
+    izq_cerca = der_cerca = pegado;
+    izq_lejos = der_lejos = centrado;
+    izq_centrado = der_centrado = (uint16_t)((pegado + centrado) / 2);
+
+    laberinto_init();
+    persistencia_borrar();
+    persistencia_guardar(false);
+}
+
+/**
+ * @brief Una vuelta del bucle principal y un ms del reloj virtual
+ */
+static void paso_firmware(void)
+{
+    uint32_t choques = modelo.choques;
+
+    recorrido_paso();
+    hal_falso_avanzar(1);
+    if (captura == NULL)
+    {
+        hal_falso_uart_tomar(NULL, 0); // Telemetría: nadie la lee
+    }
+    else
+    {
+        uint8_t bloque[1024];
+        size_t largo;
+        while ((largo = hal_falso_uart_tomar(bloque, sizeof(bloque))) > 0)
+        {
+            fwrite(bloque, 1, largo, captura);
+        }
+    }
+
+    if (modelo.choques != choques)
+        trazar("choque");
+}
+
+/**
+ * @brief Corre el bucle principal hasta que el robot se detiene o vence el tope
+ */
+static void correr_etapa(simulador_etapa_t *etapa)
+{
+    static bool visitadas[FILAS_LABERINTO][COLUMNAS_LABERINTO];
+    uint32_t inicio = HAL_GetTick();
+    uint32_t choques_inicio = modelo.choques;
+    uint8_t fila = fila_actual;
+    uint8_t columna = columna_actual;
+    brujula sentido = sentido_actual;
+
+    memset(etapa, 0, sizeof(*etapa));
+    memset(visitadas, 0, sizeof(visitadas));
+    visitadas[fila - 1][columna - 1] = true;
+    etapa->casillas_distintas = 1;
+
+    while (!terminado && HAL_GetTick() - inicio < SIMULADOR_LIMITE_MS)
+    {
+        paso_firmware();
+
+        if (sentido_actual != sentido)
+        {
+            sentido = sentido_actual;
+            etapa->giros++;
+            trazar("giro");
+        }
+        if (fila_actual != fila || columna_actual != columna)
+        {
+            fila = fila_actual;
+            columna = columna_actual;
+            etapa->casillas++;
+            trazar("casilla");
+
+            // El firmware cree que llegó a una casilla: el robot tiene que estar ahí. En
+            // las líneas intermedias del sprint cambia de casilla al pisar la línea, con
+            // el centro del robot todavía sobre el borde: cuenta la casilla de un
+            // ancho de línea más adelante del sensor
+            const modelo_parametros_t *p = &modelo.parametros;
+            uint8_t fila_real, columna_real;
+            modelo_get_casilla_adelante(&modelo, p->sensor_linea_adelante_mm + p->ancho_linea_mm, &fila_real, &columna_real);
+            if (fila != fila_real || columna != columna_real || !laberinto_posicion_valida(fila, columna))
+            {
+                etapa->errores_posicion++;
+                trazar("error");
+            }
+            else if (!visitadas[fila - 1][columna - 1])
+            {
+                visitadas[fila - 1][columna - 1] = true;
+                etapa->casillas_distintas++;
+            }
+        }
+    }
+
+    etapa->llego = terminado && laberinto_es_meta(fila_actual, columna_actual);
+    etapa->tiempo_ms = HAL_GetTick() - inicio;
+    etapa->choques = modelo.choques - choques_inicio;
+}
+
+/**
+ * @brief Lleva el robot al inicio y aprieta el botón de sprint hasta que el firmware arranca
+ * @return false si el firmware no tomó el botón
+ */
+static bool largar_sprint(void)
+{
+    for (uint32_t i = 0; i < ESPERA_ANTES_DEL_SPRINT_MS; i++)
+    {
+        paso_firmware();
+    }
+    modelo_colocar(&modelo, POSICION_INICIO_FILA, POSICION_INICIO_COLUMNA, norte);
+
+    hal_falso_gpio_set_entrada(i_am_speed_GPIO_Port, i_am_speed_Pin, GPIO_PIN_RESET);
+    for (uint32_t i = 0; terminado && i < BOTON_APRETADO_MAXIMO_MS; i++)
+    {
+        paso_firmware();
+    }
+    hal_falso_gpio_set_entrada(i_am_speed_GPIO_Port, i_am_speed_Pin, GPIO_PIN_SET);
+
+    return !terminado;
+}
+
+bool simulador_correr(const laberinto_modelo_t *laberinto, const modelo_parametros_t *parametros, bool con_sprint,
+                      simulador_resultado_t *resultado)
+{
+    memset(resultado, 0, sizeof(*resultado));
+    if (laberinto->filas != FILAS_LABERINTO || laberinto->columnas != COLUMNAS_LABERINTO)
+    {
+        return false;
+    }
+
+    hal_falso_reiniciar();
+    HAL_ADC_Start_DMA(&hadc1, (uint32_t *)dma_buffer, BUFFER_TOTAL);
+    modelo_iniciar(&modelo, laberinto, parametros, POSICION_INICIO_FILA, POSICION_INICIO_COLUMNA, norte);
+    hal_falso_set_paso(paso_modelo);
+
+    guardar_calibracion(parametros);
+    recorrido_iniciar(); // Carga la calibración y espera la largada
+
+    trazar("largada");
+    correr_etapa(&resultado->exploracion);
+    trazar("fin");
+
+    if (con_sprint && resultado->exploracion.llego && largar_sprint())
+    {
+        trazar("sprint");
+        correr_etapa(&resultado->sprint);
+        trazar("fin");
+    }
+
+    // Lo que falte del volcado del registro de la última etapa
+    for (uint32_t i = 0; i < VOLCADO_MAXIMO_MS && registro_volcar_paso(); i++)
+    {
+        paso_firmware();
+    }
+
+    return true;
+}
+
+const simulador_ajuste_t *simulador_get_ajustes(size_t *cantidad)
+{
+    *cantidad = CANTIDAD_AJUSTES;
+    return ajustes;
+}
+
+bool simulador_ajustar(const char *nombre, uint16_t valor)
+{
+    for (size_t i = 0; i < CANTIDAD_AJUSTES; i++)
+    {
+        if (strcmp(ajustes[i].nombre, nombre) == 0 && valor <= ajustes[i].maximo)
+        {
+            *ajustes[i].valor = valor;
+            return true;
+        }
+    }
+    return false;
+}
+
+void simulador_set_traza(FILE *archivo)
+{
+    traza = archivo;
+}
+
+void simulador_set_captura(FILE *archivo)
+{
+    captura = archivo;
+}
+
+const modelo_t *simulador_get_modelo(void)
+{
+    return &modelo;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file simulador.h
+ * @brief Corrida completa del firmware (exploración y sprint) sobre el modelo del robot
+ * @author demianmozo
+ *
+ * simulador_correr() arranca el firmware con recorrido_iniciar() y corre el
+ * bucle principal con recorrido_paso() sobre el HAL simulado, con
+ * modelo_paso() como paso de cada ms. Lo mismo que haría el robot en la mesa:
+ * 1. Una calibración guardada como la dejaría auto_calibracion() con el
+ *    robot del modelo (así el arranque solo espera ESPERA_LARGADA_MS)
+ * 2. Exploración desde la casilla de inicio hasta una meta
+ * 3. Si se pide, el robot vuelve a mano al inicio, se aprieta el botón de
+ *    sprint y corre la ruta compilada hasta la meta
+ *
+ * El estado del firmware son variables globales: una corrida por proceso.
+ */
+
+#ifndef __SIMULADOR_H
+#define __SIMULADOR_H
+
+#include "modelo_robot.h"
+
+#ifndef SIMULADOR_LIMITE_MS
+#define SIMULADOR_LIMITE_MS 600000u ///< Tope de cada etapa (exploración o sprint) en ms simulados
+#endif
+
+/**
+ * @brief Resultado de una etapa (exploración o sprint)
+ */
+typedef struct
+{
+    bool llego;                  ///< Terminó en una meta antes del tope
+    uint32_t tiempo_ms;          ///< Desde la largada hasta que se detuvo en la meta
+    uint32_t choques;            ///< Veces que tocó un muro o poste
+    uint32_t casillas;           ///< Casillas por las que pasó (cada paso cuenta)
+    uint32_t casillas_distintas; ///< Casillas distintas que visitó
+    uint32_t giros;              ///< Cambios de sentido (un giro de 180 cuenta uno)
+    uint32_t errores_posicion;   ///< Veces que la casilla del firmware no era la del robot
+} simulador_etapa_t;
+
+/**
+ * @brief Resultado de una corrida
+ */
+typedef struct
+{
+    simulador_etapa_t exploracion;
+    simulador_etapa_t sprint;
+} simulador_resultado_t;
+
+/**
+ * @brief Un parámetro de ajuste del firmware
+ */
+typedef struct
+{
+    const char *nombre;  ///< Nombre del comando "set" por UART (comandos.h)
+    const char *simbolo; ///< Símbolo de compilación que le da el valor inicial
+    uint16_t *valor;     ///< Variable del firmware
+    uint16_t maximo;     ///< Mayor valor aceptado
+} simulador_ajuste_t;
+
+/**
+ * @brief Parámetros de ajuste que se pueden cambiar antes de simulador_correr()
+ * @param cantidad Destino de la cantidad de elementos
+ */
+const simulador_ajuste_t *simulador_get_ajustes(size_t *cantidad);
+
+/**
+ * @brief Cambia un parámetro de ajuste, como "set nombre valor" por UART antes de largar
+ * @return false si no existe o el valor se pasa del máximo
+ */
+bool simulador_ajustar(const char *nombre, uint16_t valor);
+
+/**
+ * @brief Corre el firmware sobre el modelo
+ * @param laberinto Laberinto real; tiene que tener FILAS_LABERINTO x COLUMNAS_LABERINTO casillas
+ * @param parametros Robot del modelo
+ * @param con_sprint true = después de la exploración corre el sprint
+ * @param resultado Destino
+ * @return false si el laberinto no coincide con el tamaño compilado
+ * @note Los parámetros del firmware (velocidades, tiempos, PID) se toman de
+ *       sus variables globales al llamar: se guardan junto con la calibración
+ */
+bool simulador_correr(const laberinto_modelo_t *laberinto, const modelo_parametros_t *parametros, bool con_sprint,
+                      simulador_resultado_t *resultado);
+
+/**
+ * @brief Archivo donde escribir una línea por evento de la corrida (NULL = ninguno)
+ * @details Cambios de casilla o sentido del firmware y choques, con el tiempo
+ *          y la pose del robot; para ver por qué una corrida salió mal
+ */
+void simulador_set_traza(FILE *archivo);
+
+/**
+ * @brief Archivo donde copiar todo lo que el firmware transmite por UART5 (NULL = descartarlo)
+ * @details Crudo, como lo grabaría una terminal serie: se decodifica con
+ *          Host/herramientas/decodificar
+ */
+void simulador_set_captura(FILE *archivo);
+
+/**
+ * @brief Estado del robot simulado de la última corrida (para inspeccionarlo)
+ */
+const modelo_t *simulador_get_modelo(void);
+
+#endif /* __SIMULADOR_H */